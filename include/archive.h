@@ -0,0 +1,47 @@
+#ifndef ARCHIVE_H
+#define ARCHIVE_H
+
+#include <stddef.h>
+#include <sqlite3.h>
+
+// Attendance retention: a hot table of recent visits and yearly archives.
+//
+// Visits older than [archive] horizon_days are moved out of Attendance into
+// one SQLite file per calendar year, kept in a directory next to the branch
+// database (database/gym.db -> database/gym.archive/attendance-2023.db).
+// archive_run() walks the old rows in date order, batch_rows at a
+// time, each batch one short write transaction on its own connection, so
+// check-ins only ever wait for a single batch.
+//
+// A batch copies rows with INSERT OR IGNORE and then deletes them from the
+// hot table. Attached databases do not commit atomically together in WAL
+// mode; after a crash between the two a row can exist in both, and the next
+// run removes the hot copy.
+//
+// Reports call archive_attach() with the date range they cover. Only the
+// yearly files overlapping the range are attached, and the TEMP view
+// AttendanceAll unions them with the hot table; a range inside the horizon
+// attaches nothing and reads Attendance alone. archive_detach() undoes it.
+
+#define ARCHIVE_HORIZON_DAYS 365
+#define ARCHIVE_BATCH_ROWS 20000
+#define ARCHIVE_BATCH_SLEEP_MS 5
+#define ARCHIVE_INTERVAL_HOURS 24
+#define ARCHIVE_MAX_YEARS 64
+
+typedef struct {
+    long rows;
+    int batches;
+    int years;
+    double seconds;
+    char cutoff[16];                        // Rows dated before this were moved
+} ArchiveReport;
+
+int archive_run(const char *db_path, int horizon_days, int batch_rows, ArchiveReport *report);
+int archive_start_background();
+
+void archive_path(const char *db_path, int year, char *path, size_t size);
+int archive_attach(sqlite3 *conn, const char *db_path, const char *from_date, const char *to_date);
+void archive_detach(sqlite3 *conn);
+
+#endif
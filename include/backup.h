@@ -0,0 +1,30 @@
+#ifndef BACKUP_H
+#define BACKUP_H
+
+#include <stddef.h>
+
+// Online backup and verified restore using the SQLite backup API.
+// Backups copy a bounded number of pages per step and sleep between steps,
+// so writers are never stalled for longer than one step.
+
+#define BACKUP_STEP_PAGES 64
+#define BACKUP_STEP_SLEEP_MS 5
+#define BACKUP_INTERVAL_HOURS 24
+
+typedef struct {
+    int pages;
+    int steps;
+    long long bytes;
+    double seconds;
+    double mb_per_s;
+    char path[256];
+} BackupReport;
+
+int backup_run(const char *src_path, const char *dest_path, int step_pages, BackupReport *report);
+int backup_verify(const char *path);
+int backup_restore(const char *backup_path, BackupReport *report);
+
+void backup_default_path(char *path, size_t size);
+int backup_start_background();
+
+#endif
@@ -0,0 +1,22 @@
+#ifndef BALANCE_H
+#define BALANCE_H
+
+// Load-balanced trainer assignment: spreads members with a plan across
+// approved trainers so every trainer carries an even share of each time
+// slot, keeping existing assignments wherever they already fit.
+
+#define MAX_BALANCE_TRAINERS 1000
+
+typedef struct {
+    int members;
+    int trainers;
+    int moved;
+    int min_load;
+    int max_load;
+    double solve_ms;
+    double commit_ms;
+} BalanceResult;
+
+int balance_trainers(BalanceResult *result);
+
+#endif
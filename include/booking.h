@@ -0,0 +1,59 @@
+#ifndef BOOKING_H
+#define BOOKING_H
+
+#include <sqlite3.h>
+
+// Capacity-limited classes with a waitlist.
+//
+// A reservation is one short BEGIN IMMEDIATE transaction: a conditional
+// "UPDATE Classes SET booked=booked+1 WHERE booked<capacity" either takes a
+// seat or falls through to the waitlist, so the seat count can never pass
+// the capacity however many members book at once (a CHECK constraint backs
+// this up). Statements are prepared before the write lock is taken. When
+// the lock is busy the transaction is retried with jittered exponential
+// backoff, which lets callers run with a zero busy timeout instead of
+// SQLite's coarse sleeps. Cancelling a seat hands it to the head of the
+// waitlist in the same transaction.
+//
+// Every function takes the connection to use, so worker threads and the
+// stress tool can book through their own connections.
+
+#define BOOKING_MAX_RETRIES 100
+#define BOOKING_BACKOFF_MIN_US 100
+#define BOOKING_BACKOFF_MAX_US 20000
+#define BOOKING_MAX_CLASSES 50          // Upcoming classes listed at once
+#define BOOKING_NAME_LEN 50
+
+typedef enum {
+    BOOKING_BOOKED,
+    BOOKING_WAITLISTED,
+    BOOKING_ALREADY,        // Member already holds a seat or waitlist place
+    BOOKING_CLOSED,         // Unknown class, or it has started
+    BOOKING_BUSY,           // Still locked after BOOKING_MAX_RETRIES
+    BOOKING_ERROR
+} BookingResult;
+
+typedef struct {
+    int class_id;
+    char name[BOOKING_NAME_LEN];
+    int trainer_id;
+    char trainer_name[BOOKING_NAME_LEN];
+    long long starts_at;            // Unix time
+    int duration_minutes;
+    int capacity;
+    int booked;
+    int waitlisted;
+    int my_status;                  // For the member listed: 0 none, 1 booked, 2 waitlisted
+    int my_position;                // Waitlist position (1 = next)
+} ClassInfo;
+
+int booking_create_class(sqlite3 *conn, const char *name, int trainer_id, long long starts_at,
+                         int duration_minutes, int capacity, int *class_id);
+BookingResult booking_reserve(sqlite3 *conn, int class_id, int member_id, int *position, int *retries);
+BookingResult booking_cancel(sqlite3 *conn, int class_id, int member_id, int *promoted_member, int *retries);
+int booking_release_member(sqlite3 *conn, int member_id);     // Inside the caller's transaction
+int booking_list_upcoming(sqlite3 *conn, int member_id, ClassInfo *classes, int *count);
+
+const char* booking_result_name(BookingResult result);
+
+#endif
@@ -0,0 +1,32 @@
+#ifndef BRANCH_H
+#define BRANCH_H
+
+#include "database.h"
+
+#define MAX_REPORT_PLANS 10
+
+// Member count and monthly revenue (cents) of one plan
+typedef struct {
+    char name[100];
+    int members;
+    long long revenue_cents;
+} PlanTotal;
+
+// Aggregated figures of one branch database (or of all branches combined)
+typedef struct {
+    char branch[BRANCH_NAME_LEN];
+    int members;
+    int active_members;
+    int trainers;
+    int pending_trainers;
+    long long monthly_revenue_cents;
+    PlanTotal plans[MAX_REPORT_PLANS];
+    int plan_count;
+    int error;
+} BranchReport;
+
+// Cross-branch report: every branch is queried in parallel on its own
+// read-only connection and merged into `total` as the workers finish.
+int branch_report_all(BranchReport *reports, int *count, BranchReport *total);
+
+#endif
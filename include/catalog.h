@@ -0,0 +1,28 @@
+#ifndef CATALOG_H
+#define CATALOG_H
+
+#include "models.h"
+
+#define MAX_PLANS 10
+
+// Process-wide plan and time-slot catalog. Built from the compiled-in
+// defaults plus the Plans table on first use, then served from memory until
+// catalog_bump_version() is called (e.g. after switching branch).
+typedef struct {
+    const Plan *plans;
+    int plan_count;
+    const TimeSlot *slots;
+    int slot_count;
+    unsigned version;
+} Catalog;
+
+const Catalog* catalog_get();
+void catalog_bump_version();
+
+const Plan* catalog_find_plan(int plan_id);
+const TimeSlot* catalog_find_slot(const char *label);
+
+// Compiled-in defaults (also used to seed new databases)
+const Plan* catalog_default_plans(int *count);
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef CHANGES_H
+#define CHANGES_H
+
+#include <sqlite3.h>
+
+// Change detection across app instances sharing one database file.
+//
+// Temporary triggers on the app's connection bump a per-table sequence in
+// ChangeSeq once per writing transaction. changes_poll() first asks SQLite
+// for PRAGMA data_version, which only moves when another connection
+// committed, so an idle poll runs no query at all. When it moved, the few
+// ChangeSeq rows are compared with the last values seen, less the values
+// this instance wrote itself, and only subscribers of tables another
+// instance changed are called back. Connections that did not call
+// changes_attach() have no triggers: the archive thread bumps Attendance
+// itself with changes_bump(), and writes from the sqlite3 shell are not
+// reported.
+
+typedef enum {
+    CHANGE_USERS = 1 << 0,
+    CHANGE_MEMBERS = 1 << 1,
+    CHANGE_TRAINERS = 1 << 2,
+    CHANGE_PLANS = 1 << 3,
+    CHANGE_ATTENDANCE = 1 << 4,
+    CHANGE_PROGRAMS = 1 << 5,       // Member program assignments
+    CHANGE_CLASSES = 1 << 6,        // Class schedule and seat counts
+    CHANGE_PAYMENTS = 1 << 7,       // Payments ledger
+    CHANGE_CARDS = 1 << 8           // Turnstile cards
+} ChangeTable;
+
+// Tracked tables, in ChangeTable bit order
+#define CHANGE_TABLE_NAMES { "Users", "Members", "Trainers", "Plans", "Attendance", "MemberPrograms", "Classes", \
+                            "Payments", "MemberCards" }
+#define CHANGE_TABLE_COUNT 9
+
+#define CHANGES_MAX_SUBSCRIBERS 16
+#define CHANGES_MAX_OWN 32              // Own commits per table remembered between polls
+#define CHANGES_POLL_MS 500
+
+typedef void (*ChangeCallback)(unsigned changed, void *ctx);
+
+int changes_attach(sqlite3 *conn);
+int changes_bump(sqlite3 *conn, unsigned tables);
+int changes_subscribe(unsigned tables, ChangeCallback callback, void *ctx);
+void changes_unsubscribe(int id);
+unsigned changes_poll();
+
+#endif
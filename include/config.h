@@ -0,0 +1,81 @@
+#ifndef CONFIG_H
+#define CONFIG_H
+
+// Runtime settings read from an INI file (gym.conf by default):
+//
+//   [section]
+//   key = value     ; comments start with ';' or '#'
+//
+// Missing keys keep their compiled-in defaults, and out-of-range values are
+// clamped. Sending SIGHUP makes the app re-read the file. The new values are
+// applied when the main loop next calls config_poll_reload().
+
+#define CONFIG_DEFAULT_PATH "gym.conf"
+#define CONFIG_PATH_LEN 256
+
+typedef struct {
+    // [database]
+    char db_path[CONFIG_PATH_LEN];          // Default branch database
+    char branches_dir[CONFIG_PATH_LEN];
+    int busy_timeout_ms;
+    int cache_size_kb;
+    int mmap_size_mb;
+    char synchronous[16];                   // OFF, NORMAL, FULL or EXTRA
+
+    // [limits]
+    int page_size;                          // Admin member/trainer list pages
+    int pending_trainers_max;
+    int trainer_choices_max;                // Trainers offered to a member
+    int roster_max;                         // Members shown on a trainer roster
+
+    // [threads]
+    int report_threads;                     // Cross-branch report workers
+
+    // [batching]
+    int eventlog_flush_seconds;
+    int scheduler_batch_size;
+    int occupancy_checkpoint_seconds;
+    int occupancy_max_fps;
+    int change_poll_ms;                     // Check for other instances' writes
+
+    // [backup]
+    char backup_dir[CONFIG_PATH_LEN];
+    int backup_step_pages;
+    int backup_interval_hours;
+
+    // [archive]
+    int archive_horizon_days;               // Visits older than this leave the hot table
+    int archive_batch_rows;                 // Rows moved per transaction
+    int archive_interval_hours;
+
+    // [security]
+    int login_burst;                        // Attempts per email before throttling
+    int login_refill_seconds;               // One more email attempt per interval
+    int terminal_burst;                     // Attempts per terminal before throttling
+    int terminal_refill_seconds;
+    int lockout_failures;                   // Consecutive failures that lock an email
+    int lockout_minutes;                    // First lockout; doubles on each repeat
+
+    // [mail]
+    char mail_transport[16];                // "file" (append to sink_path) or "smtp"
+    char mail_sink_path[CONFIG_PATH_LEN];
+    char smtp_host[128];
+    int smtp_port;
+    char mail_from[128];
+    int mail_batch_size;                    // Messages per delivery batch
+    int code_minutes;                       // Verification code lifetime
+    int codes_per_hour;                     // Codes sent to one email per hour
+
+    // [instrumentation]
+    int slow_query_ms;                      // Log statements slower than this (0 = off)
+    int trace_sql;                          // Log every statement
+    int frame_stats;                        // Log window frame and refresh times
+} Config;
+
+const Config* config_get();
+int config_load(const char *path);
+
+void config_install_reload_signal();
+int config_poll_reload();
+
+#endif
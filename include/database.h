@@ -1,27 +1,129 @@
 #ifndef DATABASE_H
 #define DATABASE_H
 
+#include <stddef.h>
 #include <sqlite3.h>
 #include "models.h"
 
 int db_init();
 sqlite3* db_get_handle();
 void db_close();
+void db_apply_settings();
+
+// Branches (one database file per gym branch)
+#define DEFAULT_BRANCH "Main"
+#define BRANCH_NAME_LEN 50
+#define MAX_BRANCHES 32
+
+int db_open_branch(const char *branch);
+const char* db_get_branch();
+const char* db_get_path();
+int db_branch_path(const char *branch, char *path, size_t size);
+int db_list_branches(char branches[][BRANCH_NAME_LEN], int *count);
+void db_make_dir(const char *path);
 
 // User Management
 int db_create_user(User *user);
 int db_get_user_by_email(const char *email, User *user);
+int db_get_user(int user_id, User *user);
 int db_verify_user(const char *email);
 int db_login_user(const char *email, const char *password, User *user);
 
+// Verification Codes (expires_at is a Unix timestamp)
+int db_save_verification(const char *email, const char *salt, const char *code_hash, long long expires_at);
+int db_use_verification(const char *email, char *salt, size_t salt_size, char *code_hash, size_t hash_size,
+                        long long *expires_at, int *attempts);
+int db_delete_verification(const char *email);
+
+// Login Lockouts (locked_until is a Unix timestamp)
+typedef void (*LockoutCallback)(const char *key, int failures, long long locked_until, void *ctx);
+int db_for_each_lockout(LockoutCallback callback, void *ctx);
+int db_get_lockout(const char *key, int *failures, long long *locked_until);
+int db_save_lockout(const char *key, int failures, long long locked_until);
+int db_clear_lockout(const char *key);
+
 // Member Management
 int db_get_member(int user_id, Member *member);
 int db_create_member(int user_id);
 int db_update_member_plan(int member_id, int plan_id, const char *time_slot);
 int db_assign_trainer(int member_id, int trainer_id);
+long long db_get_member_renewal(int member_id);
+typedef void (*PlanMemberCallback)(int member_id, int trainer_id, const char *time_slot, void *ctx);
+int db_for_each_plan_member(PlanMemberCallback callback, void *ctx);
+int db_assign_trainers_bulk(const int *member_ids, const int *trainer_ids, int count);
+int db_merge_members(int keep_id, int drop_id);
+
+// Membership Renewals (renews_at is a Unix timestamp)
+#define MEMBERSHIP_PERIOD_DAYS 30
+typedef void (*RenewalCallback)(int member_id, long long renews_at, void *ctx);
+int db_for_each_renewal(RenewalCallback callback, void *ctx);
+int db_renew_membership(int member_id, long long due_at, int *plan_id, long long *next_due);
+int db_expire_membership(int member_id, long long due_at);
+
+// Transactions
+int db_begin();
+int db_commit();
+void db_rollback();
+
+// Attendance
+int db_check_in(int member_id, const char *zone);
+int db_check_out(int member_id, char *zone, size_t size);
+int db_is_checked_in_today(int member_id);
+int db_is_in_building(int member_id);
+int db_count_visits(const char *from_date, const char *to_date, long *visits, long *members);
+int db_get_occupancy(int visits[7][24], int days[7]);
+
+// Live Occupancy
+typedef struct {
+    const char *time_slot;
+    const char *zone;
+    int present;
+} OccupancyCount;
+typedef void (*PresentGroupCallback)(const char *time_slot, const char *zone, int count, void *ctx);
+int db_for_each_present_group(PresentGroupCallback callback, void *ctx);
+int db_save_live_occupancy(const OccupancyCount *counts, int count);
 
 // Trainer Management
 int db_create_trainer(int user_id, const char *specialization);
+int db_get_trainer(int trainer_id, Trainer *trainer);
+int db_get_trainer_roster(int trainer_id, RosterEntry *entries, int *count);
+
+// Workout Programs (weekday is ISO: 1 = Monday)
+typedef void (*ProgramRowCallback)(int template_id, const char *template_name, int weekday, const char *focus,
+    const char *exercise, int sets, int reps, void *ctx);
+int db_for_each_program_row(ProgramRowCallback callback, void *ctx);
+int db_get_member_program(int member_id, int *template_id);
+int db_assign_program(int member_id, int template_id, int assigned_by);
+
+// Payments (amounts in cents; day = local days since 1970-01-01)
+typedef void (*PaymentDayCallback)(int plan_id, int day, long long cents, int payments, void *ctx);
+int db_insert_payment(int member_id, int plan_id, int amount_cents, int day, long long paid_at, const char *kind);
+int db_for_each_payment_day(long long after_id, PaymentDayCallback callback, void *ctx, long long *last_id);
+
+// Attendance Bitmaps (day = local days since 1970-01-01; first_word = day / 64)
+typedef void (*VisitDayCallback)(int member_id, int day, void *ctx);
+typedef void (*VisitMapCallback)(int member_id, int first_word, const void *bits, int size, void *ctx);
+typedef struct {
+    int member_id;
+    int first_word;
+    const void *bits;
+    int size;               // 0 deletes the member's map
+} VisitMapRow;
+
+int db_for_each_visit(long long after_id, int with_archives, VisitDayCallback callback, void *ctx, long long *last_id);
+int db_load_visit_maps(VisitMapCallback callback, void *ctx, long long *last_id);
+int db_save_visit_maps(const VisitMapRow *rows, int count, long long last_id);
+
+// Member Cards (issued_at / revoked_at / renews_at are Unix timestamps)
+#define MAX_CARD_ROWS 500
+typedef void (*CardCallback)(const char *card_id, int member_id, int revoked, void *ctx);
+typedef void (*GateMemberCallback)(int member_id, int plan_id, const char *time_slot, int active,
+                                   long long renews_at, int auto_renew, void *ctx);
+int db_issue_card(const char *card_id, int member_id, long long issued_at);
+int db_revoke_card(const char *card_id, long long revoked_at);
+int db_get_cards(CardDetail *cards, int *count);
+int db_for_each_card(long long after_seq, CardCallback callback, void *ctx, long long *last_seq);
+int db_for_each_gate_member(int member_id, GateMemberCallback callback, void *ctx);
 
 // Data Retrieval
 int db_get_plans(Plan *plans, int *count); // Assumes caller allocates enough or we use dynamic array
@@ -36,4 +138,29 @@ int db_get_all_trainers_detail(TrainerDetail *trainers, int *count);
 int db_delete_member(int member_id);
 int db_delete_trainer(int trainer_id);
 
+// Paginated Listings (keyset: each page resumes after the last row seen)
+typedef enum {
+    LIST_SORT_NAME,
+    LIST_SORT_PLAN,    // Plan for members, specialization for trainers
+    LIST_SORT_STATUS,
+    LIST_SORT_JOINED
+} ListSort;
+
+typedef enum {
+    PAGE_NEXT,  // Rows after the anchor (or the first page if no anchor)
+    PAGE_PREV,  // Rows before the anchor
+    PAGE_FROM   // Rows starting at the anchor (re-load current page)
+} PageDirection;
+
+typedef struct {
+    int valid;
+    char key[100];
+    int id;
+} PageCursor;
+
+int db_get_members_page(ListSort sort, PageDirection dir, const PageCursor *anchor,
+                        MemberDetail *members, int *count, PageCursor *first, PageCursor *last);
+int db_get_trainers_page(ListSort sort, PageDirection dir, const PageCursor *anchor,
+                         TrainerDetail *trainers, int *count, PageCursor *first, PageCursor *last);
+
 #endif
@@ -0,0 +1,46 @@
+#ifndef DEDUP_H
+#define DEDUP_H
+
+// Near-duplicate member detection.
+//
+// Emails and names are normalized (case, dots and +tags in the local part,
+// punctuation and spaces in names), then sorted by several blocking keys:
+// email prefix, reversed email local part and name prefix. Within a block
+// each account is compared with its next DEDUP_WINDOW neighbours using a
+// bit-parallel edit distance, so the cost is linear in the number of users.
+// A pair matches when the normalized emails are equal, or when the email and
+// name distances together are at most DEDUP_MAX_DISTANCE.
+//
+// dedup_start() runs the scan on a background thread with its own read-only
+// connection; the UI polls dedup_get_result() until it is done.
+
+#define DEDUP_MAX_LEN 64
+#define DEDUP_BLOCK_BYTES 4
+#define DEDUP_WINDOW 12
+#define DEDUP_MAX_DISTANCE 3    // Email + name edit distance for a match
+#define MAX_DUPLICATES 500
+
+typedef struct {
+    int keep_id;   // Older account (lower id), suggested to keep
+    int drop_id;
+    char keep_name[100];
+    char keep_email[100];
+    char drop_name[100];
+    char drop_email[100];
+    int email_distance;
+    int name_distance;
+} DuplicatePair;
+
+typedef struct {
+    int users;
+    long comparisons;
+    int pairs;
+    double ms;
+} DedupStats;
+
+int dedup_find(DuplicatePair *pairs, int *count, DedupStats *stats);
+int dedup_start();
+int dedup_get_result(DuplicatePair *pairs, int *count, DedupStats *stats);
+int dedup_edit_distance(const char *a, int a_len, const char *b, int b_len);
+
+#endif
@@ -0,0 +1,59 @@
+#ifndef EVENTLOG_H
+#define EVENTLOG_H
+
+// Append-only binary audit log of membership changes.
+//
+// Record layout (little-endian):
+//   u32 payload length | u32 CRC-32 of payload | payload
+// Payload:
+//   u8 type | i64 timestamp | i32 subject id | i32 argument | text (rest)
+//
+// Records are buffered in memory and written in batches; a torn or
+// corrupted tail is detected by the length/CRC check and ignored on replay.
+//
+// App instances sharing a database also share its log. Each batch is one
+// append under an exclusive file lock, and the tail repair and compaction
+// in eventlog_open() run under the same lock. Writers reopen the log when
+// compaction has replaced the file.
+
+#define EVENTLOG_BUFFER_SIZE (64 * 1024)
+#define EVENTLOG_FLUSH_BATCH 64
+#define EVENTLOG_COMPACT_BYTES (8L * 1024 * 1024)
+#define EVENTLOG_MAX_TEXT 255
+
+typedef enum {
+    EVENT_PLAN_CHANGED = 1,     // subject = member, arg = plan, text = time slot
+    EVENT_TRAINER_ASSIGNED,     // subject = member, arg = trainer
+    EVENT_TRAINER_APPROVED,     // subject = trainer
+    EVENT_TRAINER_REJECTED,     // subject = trainer
+    EVENT_MEMBER_DELETED,       // subject = member
+    EVENT_TRAINER_DELETED,      // subject = trainer
+    EVENT_MEMBERSHIP_RENEWED,   // subject = member, arg = plan
+    EVENT_MEMBERSHIP_EXPIRED,   // subject = member
+    EVENT_MEMBER_MERGED,        // subject = removed duplicate, arg = member kept (ends the subject's history)
+    EVENT_LOGIN_LOCKED,         // subject = user (0 if unknown), arg = minutes, text = email
+    EVENT_PROGRAM_ASSIGNED,     // subject = member, arg = workout template
+    EVENT_TYPE_COUNT
+} EventType;
+
+typedef struct {
+    int type;
+    long long timestamp;
+    int subject_id;
+    int arg;
+    char text[EVENTLOG_MAX_TEXT + 1];
+} Event;
+
+// Return non-zero from the visitor to stop the replay early
+typedef int (*EventVisitor)(const Event *event, void *ctx);
+
+int eventlog_open(const char *path);
+void eventlog_close();
+void eventlog_append(EventType type, int subject_id, int arg, const char *text);
+int eventlog_flush();
+
+int eventlog_replay(const char *path, EventVisitor visit, void *ctx, long *valid_bytes);
+int eventlog_compact(const char *path, long *kept, long *dropped);
+const char* eventlog_type_name(int type);
+
+#endif
@@ -0,0 +1,29 @@
+#ifndef EXPORT_H
+#define EXPORT_H
+
+// Background export of members, trainers and attendance. Each table is read
+// on its own read-only snapshot connection and encoded/written by a worker
+// thread, so the UI only polls export_get_progress().
+
+typedef enum {
+    EXPORT_CSV,
+    EXPORT_COLUMNAR     // .gcol: chunked columns, delta/varint ints, dictionary+RLE text
+} ExportFormat;
+
+typedef struct {
+    long rows_done;
+    long rows_total;
+    long bytes_written;
+    int running;
+    int failed;
+    double seconds;
+    char directory[256];
+} ExportProgress;
+
+#define EXPORT_CHUNK_ROWS 65536
+#define EXPORT_WRITE_BUFFER (1 << 20)
+
+int export_start(ExportFormat format);
+void export_get_progress(ExportProgress *progress);
+
+#endif
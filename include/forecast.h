@@ -0,0 +1,23 @@
+#ifndef FORECAST_H
+#define FORECAST_H
+
+#include "models.h"
+
+// Predicted occupancy from the seasonal (weekday x hour) check-in
+// statistics that db_check_in maintains incrementally. Loading a forecast
+// reads at most 7 * 24 + 7 rows, so it is cheap enough to do on every redraw.
+
+#define FORECAST_DAYS 7     // 0 = Sunday, as in strftime('%w')
+#define FORECAST_HOURS 24
+
+typedef struct {
+    double hourly[FORECAST_DAYS][FORECAST_HOURS];  // Expected check-ins
+    int days_observed[FORECAST_DAYS];
+    long total_visits;
+} OccupancyForecast;
+
+int forecast_load(OccupancyForecast *forecast);
+double forecast_slot(const OccupancyForecast *forecast, int dow, const TimeSlot *slot);
+double forecast_peak(const OccupancyForecast *forecast, int dow, int *peak_hour);
+
+#endif
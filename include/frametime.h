@@ -0,0 +1,27 @@
+#ifndef FRAMETIME_H
+#define FRAMETIME_H
+
+// Frame-time measurement for the dashboard windows, switched on with
+// [instrumentation] frame_stats = 1.
+//
+// frametime_watch() times every frame a window draws on its frame clock,
+// from before-paint to after-paint (update, layout and drawing).
+// frametime_begin()/frametime_end() time the app's own work, such as a
+// refresh function filling in labels. When the window goes away both
+// series are summarised on stderr:
+//
+//   [frames member] 212 frames  mean 0.84 ms  p50 0.71 ms  p99 3.90 ms  max 6.02 ms
+//   [refresh member] 14 calls  mean 0.12 ms  p50 0.10 ms  p99 0.31 ms  max 0.31 ms
+//
+// With frame_stats = 0 the calls do nothing.
+
+#define FRAMETIME_SAMPLES 1024          // Most recent samples kept for percentiles
+
+typedef struct _GtkWidget GtkWidget;
+
+void frametime_watch(GtkWidget *window, const char *name);
+
+long long frametime_begin();
+void frametime_end(GtkWidget *window, long long started);
+
+#endif
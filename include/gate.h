@@ -0,0 +1,50 @@
+#ifndef GATE_H
+#define GATE_H
+
+// Turnstile card lookups served from memory.
+//
+// Cards live in MemberCards. The gate keeps an open-addressing hash table
+// (linear probing, at most half full) from card id to member, plus the
+// membership fields a gate decision needs per member: plan, time-slot
+// hours, status and renewal deadline. gate_check() only hashes the card
+// and reads those fields, so it takes microseconds and never touches
+// SQLite while the index is current.
+//
+// The index is updated incrementally. Every MemberCards write bumps its
+// seq, so after gate_mark_stale() only rows above the last seq seen are
+// read. gate_member_changed() re-reads a single membership after a local
+// plan change, renewal, expiry, merge or delete. Membership changes made by
+// another instance (gate_mark_members_stale()) re-read the members holding
+// cards. gate_refresh() applies pending changes ahead of the next check.
+
+#define GATE_CARD_MAX 32
+#define GATE_INITIAL_SLOTS 1024
+#define GATE_MAX_PENDING 256
+
+typedef enum {
+    GATE_ALLOW = 0,
+    GATE_UNKNOWN_CARD,          // Never issued or revoked
+    GATE_NO_PLAN,
+    GATE_EXPIRED,
+    GATE_WRONG_TIME,            // Outside the member's time slot
+    GATE_UNAVAILABLE            // The index could not be loaded
+} GateResult;
+
+typedef struct {
+    GateResult result;
+    int member_id;
+    int plan_id;
+    long long renews_at;
+} GateDecision;
+
+int gate_card_valid(const char *card_id);
+GateResult gate_check(const char *card_id, long long now, GateDecision *decision);
+const char* gate_result_name(GateResult result);
+
+int gate_refresh();
+void gate_mark_stale();
+void gate_mark_members_stale();
+void gate_member_changed(int member_id);
+void gate_bump_version();
+
+#endif
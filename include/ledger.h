@@ -0,0 +1,51 @@
+#ifndef LEDGER_H
+#define LEDGER_H
+
+#include <stddef.h>
+#include "catalog.h"
+
+// Payments ledger and revenue index.
+//
+// Every charge is appended to Payments in integer cents, tagged with its
+// plan and the local calendar day it was paid on. For reports the ledger
+// keeps Fenwick (binary indexed) trees of cents and payment counts by day,
+// one per plan plus one for all plans, so revenue between any two dates is
+// two O(log days) prefix sums with no query, however many years of
+// payments there are.
+//
+// The trees are built from Payments on first use and after
+// ledger_bump_version() (branch switch). Once a charge has committed, or
+// when another instance wrote payments, ledger_mark_stale() makes the next
+// query read only the rows above the last payment id seen. Payments is
+// append-only and AUTOINCREMENT, so that range is exactly the new rows.
+// ledger_charge() runs inside the caller's transaction and leaves marking
+// to the caller, so a charge that is rolled back never reaches the trees.
+
+#define LEDGER_MAX_PLANS MAX_PLANS
+#define LEDGER_INITIAL_DAYS 1024
+#define LEDGER_KIND_SIGNUP "SIGNUP"
+#define LEDGER_KIND_RENEWAL "RENEWAL"
+
+typedef struct {
+    long long cents;
+    long payments;
+} RevenueTotal;
+
+// Charge a member one period of a plan at its catalog price
+int ledger_charge(int member_id, int plan_id, const char *kind, long long paid_at);
+// Scheduler billing hook (runs inside the renewal transaction)
+int ledger_charge_renewal(int member_id, int plan_id, long long period_start);
+
+void ledger_mark_stale();
+void ledger_bump_version();
+
+// Revenue on days from..to inclusive; plan_id 0 = all plans
+int ledger_revenue(int plan_id, int from_day, int to_day, RevenueTotal *total);
+
+// Day numbers: local calendar days since 1970-01-01
+int ledger_day(long long unix_time);
+int ledger_parse_day(const char *date, int *day);
+void ledger_format_day(int day, char *buf, size_t size);
+void ledger_format_cents(long long cents, char *buf, size_t size);
+
+#endif
@@ -27,10 +27,17 @@ typedef struct {
 typedef struct {
     int plan_id;
     char name[100];
-    double price;
+    int price_cents;    // Minor units: 3000 = $30.00
     char time_slot[50];
 } Plan;
 
+typedef struct {
+    char name[50];   // Matches Plans.time_slot, e.g. "Morning"
+    char label[50];  // Shown to members and stored in Members.time_slot
+    int start_hour;
+    int end_hour;
+} TimeSlot;
+
 typedef struct {
     int member_id;
     char name[100];
@@ -47,4 +54,24 @@ typedef struct {
     char status[50];
 } TrainerDetail;
 
+typedef struct {
+    int member_id;
+    char name[100];
+    char email[100];
+    char plan_name[100];
+    char time_slot[50];
+    char status[50];
+    int checked_in_today;
+    int template_id;        // Assigned workout program, 0 = default
+} RosterEntry;
+
+typedef struct {
+    char card_id[33];
+    int member_id;
+    char name[100];
+    char email[100];
+    long long issued_at;
+    int revoked;
+} CardDetail;
+
 #endif
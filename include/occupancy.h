@@ -0,0 +1,34 @@
+#ifndef OCCUPANCY_H
+#define OCCUPANCY_H
+
+// Live "people in the building" counters per (time slot, zone).
+//
+// The counters are a count of today's open Attendance rows, recounted after
+// every check-in or check-out, whichever app instance made it, and on
+// startup or branch switch. Reading the current occupancy uses lock-free
+// atomic loads and never touches the database. occupancy_checkpoint()
+// writes the counters to the LiveOccupancy table.
+
+#define OCCUPANCY_MAX_SLOTS 8           // Catalog slots; one more row for "Other"
+#define OCCUPANCY_ZONE_COUNT 3
+#define OCCUPANCY_MAX_FPS 10            // Cap for UI refresh timers
+#define OCCUPANCY_CHECKPOINT_SECONDS 30
+
+typedef struct {
+    int slot_count;                                         // Rows used, incl. "Other"
+    const char *slot_labels[OCCUPANCY_MAX_SLOTS + 1];
+    int present[OCCUPANCY_MAX_SLOTS + 1][OCCUPANCY_ZONE_COUNT];
+    int total;
+    unsigned version;
+} OccupancySnapshot;
+
+int occupancy_init();
+int occupancy_reload();
+
+unsigned occupancy_version();
+void occupancy_snapshot(OccupancySnapshot *snapshot);
+int occupancy_checkpoint();
+
+const char* occupancy_zone_name(int zone);
+
+#endif
@@ -0,0 +1,36 @@
+#ifndef OUTBOX_H
+#define OUTBOX_H
+
+// Durable mail outbox. Messages are inserted into the Outbox table by the
+// caller's transaction and delivered later by a background sender with its
+// own database connection. The sender claims due messages in batches
+// (a lease keeps other app instances off them), delivers each batch over
+// one SMTP session or appends it to a local mbox sink, and retries
+// failures with exponential backoff.
+
+#define OUTBOX_BATCH_SIZE 50
+#define OUTBOX_IDLE_SECONDS 5           // Re-check for retries and other instances' mail
+#define OUTBOX_LEASE_SECONDS 120        // Claimed messages are skipped this long
+#define OUTBOX_RETRY_SECONDS 30         // First retry; doubles per attempt
+#define OUTBOX_MAX_ATTEMPTS 8
+#define OUTBOX_IO_TIMEOUT_SECONDS 10
+
+typedef struct {
+    long queued;            // Waiting in the current branch's outbox
+    long sent;              // Since startup
+    long failed;            // Attempts that failed (will be retried)
+    long dropped;           // Given up after OUTBOX_MAX_ATTEMPTS
+    long batches;
+    double messages_per_s;  // Sent / time spent delivering
+    int running;
+    char last_error[128];
+} OutboxStats;
+
+int outbox_enqueue(const char *recipient, const char *subject, const char *body);
+
+int outbox_start();
+void outbox_notify();
+void outbox_stop();
+void outbox_get_stats(OutboxStats *stats);
+
+#endif
@@ -0,0 +1,34 @@
+#ifndef PROGRAM_H
+#define PROGRAM_H
+
+// Weekly workout programs. The templates (WorkoutTemplates, TemplateDays,
+// TemplateExercises) are compiled once into ProgramWeek entries with each
+// day's exercises already formatted, and served from memory until
+// program_bump_version() (branch switch). A member's week is then one
+// primary-key lookup in MemberPrograms plus a scan of a few templates.
+
+#define PROGRAM_DAYS 7                  // Monday first
+#define PROGRAM_MAX_TEMPLATES 32
+#define PROGRAM_FOCUS_LEN 32
+#define PROGRAM_DETAIL_LEN 160
+#define PROGRAM_DEFAULT_TEMPLATE 1      // Followed by members without an assignment
+
+typedef struct {
+    int template_id;
+    char name[50];
+    char focus[PROGRAM_DAYS][PROGRAM_FOCUS_LEN];    // "" = rest day
+    char detail[PROGRAM_DAYS][PROGRAM_DETAIL_LEN];  // "Bench Press 4x8, Push-Up 3x15"
+} ProgramWeek;
+
+// Returned pointers stay valid until the next rebuild
+const ProgramWeek* program_list(int *count);
+const ProgramWeek* program_find(int template_id);
+const ProgramWeek* program_for_member(int member_id);
+void program_bump_version();
+
+int program_assign(int member_id, int template_id, int assigned_by);
+
+const char* program_day_name(int day);
+int program_today();
+
+#endif
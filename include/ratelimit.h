@@ -0,0 +1,45 @@
+#ifndef RATELIMIT_H
+#define RATELIMIT_H
+
+// Login throttling, checked before a login attempt reaches the database.
+//
+// Each email and this terminal get a token bucket (burst, then one attempt
+// per refill interval). Consecutive failures on an email from this terminal
+// lock that email here for lockout_minutes, doubling on every repeat; other
+// terminals are not affected. The email's bucket also counts the
+// verification codes sent to it, at most codes_per_hour per hour.
+// Buckets live in a fixed open-addressing table: a lookup probes at most
+// RATELIMIT_MAX_PROBE slots and reuses idle ones, so the cost per attempt is
+// constant. A bucket still counting failures, codes or a lockout is never
+// reused for another key before it goes idle. Lockouts are also stored in
+// the LoginLockouts table, reloaded by ratelimit_init() and re-read on every
+// attempt, so app instances on one terminal share them.
+
+#define RATELIMIT_SLOTS 4096            // Power of two
+#define RATELIMIT_MAX_PROBE 16
+#define RATELIMIT_EMAIL_LEN 100         // As User.email
+#define RATELIMIT_KEY_LEN 176           // Fits "lockout:<host>/<email>"
+#define RATELIMIT_IDLE_SECONDS 3600     // Unlocked buckets idle this long are forgotten
+
+// Defaults for the [security] settings
+#define RATELIMIT_LOGIN_BURST 5
+#define RATELIMIT_LOGIN_REFILL_SECONDS 60
+#define RATELIMIT_TERMINAL_BURST 20
+#define RATELIMIT_TERMINAL_REFILL_SECONDS 3
+#define RATELIMIT_LOCKOUT_FAILURES 10
+#define RATELIMIT_LOCKOUT_MINUTES 15
+#define RATELIMIT_MAX_LOCKOUT_MINUTES (24 * 60)
+#define RATELIMIT_CODES_PER_HOUR 3
+
+typedef enum {
+    RATELIMIT_ALLOWED,
+    RATELIMIT_THROTTLED,    // Out of tokens; retry after a short wait
+    RATELIMIT_LOCKED        // Too many failures on this email from this terminal
+} RateLimitResult;
+
+int ratelimit_init();
+RateLimitResult ratelimit_check(const char *email, int *retry_after);
+void ratelimit_record(const char *email, int success);
+RateLimitResult ratelimit_check_code(const char *email, int *retry_after);
+
+#endif
@@ -0,0 +1,27 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+// Membership renewal/expiry scheduler. Every active membership's renewal
+// deadline sits in a min-heap; the host only needs to wake up when
+// scheduler_next_deadline() passes and call scheduler_run_due(). Changes
+// made in this process are passed in with scheduler_track(); the host calls
+// scheduler_reload() when another instance changed Members.
+
+#define SCHEDULER_BATCH_SIZE 500
+
+// Called inside the renewal transaction for every period charged; a
+// non-zero return rolls the batch back
+typedef int (*BillingHook)(int member_id, int plan_id, long long period_start);
+// Called whenever the earliest deadline changes (0 = nothing scheduled)
+typedef void (*WakeupHook)(long long next_deadline);
+
+int scheduler_init();
+int scheduler_reload();
+void scheduler_track(int member_id, long long due_at);
+long long scheduler_next_deadline();
+int scheduler_run_due(long long now);
+
+void scheduler_set_billing_hook(BillingHook hook);
+void scheduler_set_wakeup_hook(WakeupHook hook);
+
+#endif
@@ -0,0 +1,15 @@
+#ifndef SHA256_H
+#define SHA256_H
+
+#include <stddef.h>
+
+// SHA-256 (FIPS 180-4), used to store one-time codes without keeping them
+// in clear text
+
+#define SHA256_DIGEST_SIZE 32
+#define SHA256_HEX_SIZE (SHA256_DIGEST_SIZE * 2 + 1)
+
+void sha256(const void *data, size_t len, unsigned char digest[SHA256_DIGEST_SIZE]);
+void sha256_hex(const void *data, size_t len, char hex[SHA256_HEX_SIZE]);
+
+#endif
@@ -0,0 +1,8 @@
+#ifndef TRAINER_H
+#define TRAINER_H
+
+#include "models.h"
+
+void show_trainer_dashboard(User *user);
+
+#endif
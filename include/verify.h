@@ -0,0 +1,23 @@
+#ifndef VERIFY_H
+#define VERIFY_H
+
+// One-time email verification codes. A random code is stored only as a
+// salted SHA-256 hash with an expiry, and the email carrying it is queued
+// in the outbox in the same transaction, so registration never waits for
+// mail delivery. Each email gets a few codes per hour (ratelimit.h), so the
+// guesses per code cannot be renewed without limit.
+
+#define VERIFY_CODE_DIGITS 6
+#define VERIFY_CODE_MINUTES 15
+#define VERIFY_MAX_ATTEMPTS 5
+
+typedef enum {
+    VERIFY_OK,
+    VERIFY_WRONG,       // Wrong code; more guesses left
+    VERIFY_EXPIRED,     // Expired, used up or never issued: request a new one
+} VerifyResult;
+
+int verify_issue(const char *email, const char *name);
+VerifyResult verify_check(const char *email, const char *code);
+
+#endif
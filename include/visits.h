@@ -0,0 +1,49 @@
+#ifndef VISITS_H
+#define VISITS_H
+
+// Per-member attendance bitmaps.
+//
+// Each member who has checked in gets one bit per local calendar day (the
+// ledger's day numbers). In memory the bits are kept as 64-day words,
+// starting at the first word with a visit. "Days attended this month" is a
+// popcount over masked words. The current streak counts trailing ones. The
+// "inactive for N days" sweep tests at most two words per member. None of
+// them read Attendance.
+//
+// The bitmaps are stored in VisitMaps using word-aligned run-length
+// encoding: each non-empty word is preceded by the number of empty words
+// (days with no visit) before it. VisitMapState records the last
+// attendance_id folded in. On first use the stored maps are loaded and
+// topped up with the Attendance rows above that id. The first time there is
+// no state, so the whole history is read, archived years included.
+//
+// visits_record() sets a check-in's bit directly. Check-ins made by other
+// instances come in through visits_mark_stale(), and the next query reads
+// them. visits_checkpoint() writes the maps changed since the last
+// checkpoint.
+
+#define VISITS_INACTIVE_DAYS 30
+
+typedef struct {
+    int this_month;                 // Days attended in the current calendar month
+    int last_30_days;
+    int streak;                     // Consecutive days up to today (or yesterday)
+    int last_day;                   // Most recent visit, -1 if never
+} VisitSummary;
+
+void visits_record(int member_id, int day);
+void visits_forget(int member_id);
+void visits_merge(int keep_id, int drop_id);
+void visits_mark_stale();
+void visits_bump_version();
+int visits_checkpoint();
+
+int visits_count(int member_id, int from_day, int to_day);
+int visits_streak(int member_id, int today);
+int visits_summary(int member_id, int today, VisitSummary *summary);
+
+// Members who have visited before but not in the `days` ending today.
+// Fills up to `max` ids and returns the total count, -1 on error.
+int visits_inactive(int days, int today, int *member_ids, int max);
+
+#endif
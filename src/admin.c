@@ -1,8 +1,25 @@
 #include <gtk/gtk.h>
 #include <stdio.h>
+#include <string.h>
+#include <time.h>
 #include "admin.h"
 #include "database.h"
+#include "branch.h"
+#include "balance.h"
+#include "export.h"
+#include "dedup.h"
+#include "scheduler.h"
+#include "forecast.h"
+#include "occupancy.h"
+#include "catalog.h"
+#include "config.h"
 #include "login.h"
+#include "changes.h"
+#include "frametime.h"
+#include "ledger.h"
+#include "outbox.h"
+#include "visits.h"
+#include "gate.h"
 
 // ============================================
 // Global State
@@ -12,7 +29,44 @@ static GtkWidget *window;
 static GtkWidget *notebook;
 static GtkWidget *trainers_list;
 static GtkWidget *members_list;
+static GtkWidget *inactive_label;
 static GtkWidget *pending_trainers_list;
+static GtkWidget *branches_list;
+static GtkWidget *export_format_combo;
+static GtkWidget *export_progress_bar;
+static GtkWidget *export_status_label;
+static GtkWidget *export_button;
+static guint export_timer = 0;
+static guint dedup_timer = 0;
+static GtkWidget *duplicates_list;
+static GtkWidget *duplicates_status_label;
+static GtkWidget *occupancy_chart;
+static GtkWidget *occupancy_day_combo;
+static GtkWidget *occupancy_summary_label;
+static OccupancyForecast occupancy_forecast;
+static GtkWidget *live_cells[OCCUPANCY_MAX_SLOTS + 1][OCCUPANCY_ZONE_COUNT + 1];
+static GtkWidget *live_total_label;
+static guint live_timer = 0;
+static unsigned live_version = 0;
+static int changes_subscription = 0;
+static GtkWidget *mail_status_label;
+static GtkWidget *revenue_from_entry;
+static GtkWidget *revenue_to_entry;
+static GtkWidget *revenue_list;
+static GtkWidget *revenue_status_label;
+static guint mail_timer = 0;
+static GtkWidget *cards_list;
+static GtkWidget *card_email_entry;
+static GtkWidget *card_id_entry;
+static GtkWidget *card_test_entry;
+static GtkWidget *cards_status_label;
+
+// Paging State (keyset cursors of the rows currently shown; page size
+// comes from the config file)
+static ListSort members_sort = LIST_SORT_NAME;
+static PageCursor members_first, members_last;
+static ListSort trainers_sort = LIST_SORT_NAME;
+static PageCursor trainers_first, trainers_last;
 
 // ============================================
 // Helper Functions
@@ -25,6 +79,17 @@ void add_column(GtkWidget *treeview, const char *title, int columnId) {
     gtk_tree_view_append_column(GTK_TREE_VIEW(treeview), column);
 }
 
+// Show an informational dialog over the admin window
+static void show_info(const char *msg) {
+    GtkWidget *dialog = gtk_message_dialog_new(GTK_WINDOW(window),
+                                           GTK_DIALOG_DESTROY_WITH_PARENT,
+                                           GTK_MESSAGE_INFO,
+                                           GTK_BUTTONS_OK,
+                                           "%s", msg);
+    gtk_dialog_run(GTK_DIALOG(dialog));
+    gtk_widget_destroy(dialog);
+}
+
 // ============================================
 // Data Refresh Functions
 // ============================================
@@ -34,8 +99,8 @@ void refresh_pending_trainers() {
     GtkListStore *store = GTK_LIST_STORE(gtk_tree_view_get_model(GTK_TREE_VIEW(pending_trainers_list)));
     gtk_list_store_clear(store);
     
-    TrainerDetail trainers[20];
-    int count = 20;
+    int count = config_get()->pending_trainers_max;
+    TrainerDetail *trainers = g_new0(TrainerDetail, count);
     db_get_pending_trainers(trainers, &count);
     
     for (int i = 0; i < count; i++) {
@@ -43,38 +108,357 @@ void refresh_pending_trainers() {
         gtk_list_store_append(store, &iter);
         gtk_list_store_set(store, &iter, 0, trainers[i].trainer_id, 1, trainers[i].name, 2, trainers[i].specialization, -1);
     }
+    g_free(trainers);
 }
 
-// Refresh members list
-void refresh_members() {
+// Load a page of members; an empty result leaves the current page in place
+static int load_members_page(PageDirection dir, const PageCursor *anchor) {
+    int count = config_get()->page_size;
+    MemberDetail *members = g_new0(MemberDetail, count);
+    PageCursor first, last;
+    db_get_members_page(members_sort, dir, anchor, members, &count, &first, &last);
+    if (count == 0) {
+        g_free(members);
+        return 0;
+    }
+
     GtkListStore *store = GTK_LIST_STORE(gtk_tree_view_get_model(GTK_TREE_VIEW(members_list)));
     gtk_list_store_clear(store);
-    
-    MemberDetail members[50];
-    int count = 50;
-    db_get_all_members_detail(members, &count);
-    
     for (int i = 0; i < count; i++) {
         GtkTreeIter iter;
         gtk_list_store_append(store, &iter);
         gtk_list_store_set(store, &iter, 0, members[i].member_id, 1, members[i].name, 2, members[i].plan_name, 3, members[i].status, -1);
     }
+    g_free(members);
+    members_first = first;
+    members_last = last;
+    return count;
 }
 
-// Refresh trainers list
-void refresh_trainers() {
+// Members who used to come in but have stayed away, from the attendance bitmaps
+static void refresh_inactive() {
+    gint64 started = g_get_monotonic_time();
+    int inactive = visits_inactive(VISITS_INACTIVE_DAYS, ledger_day(time(NULL)), NULL, 0);
+    gint64 elapsed = g_get_monotonic_time() - started;
+
+    char buf[128];
+    if (inactive < 0) {
+        snprintf(buf, sizeof(buf), "Could not read attendance.");
+    } else {
+        snprintf(buf, sizeof(buf), "%d members have not visited in %d days (%lld us)",
+            inactive, VISITS_INACTIVE_DAYS, (long long)elapsed);
+    }
+    gtk_label_set_text(GTK_LABEL(inactive_label), buf);
+}
+
+// Refresh members list (re-load the page currently shown)
+void refresh_members() {
+    refresh_inactive();
+    if (load_members_page(PAGE_FROM, &members_first) > 0) return;
+    // Current page emptied out (e.g. last rows deleted): step back a page
+    if (members_first.valid && load_members_page(PAGE_PREV, &members_first) > 0) return;
+
+    gtk_list_store_clear(GTK_LIST_STORE(gtk_tree_view_get_model(GTK_TREE_VIEW(members_list))));
+    members_first.valid = members_last.valid = 0;
+}
+
+// Load a page of trainers; an empty result leaves the current page in place
+static int load_trainers_page(PageDirection dir, const PageCursor *anchor) {
+    int count = config_get()->page_size;
+    TrainerDetail *trainers = g_new0(TrainerDetail, count);
+    PageCursor first, last;
+    db_get_trainers_page(trainers_sort, dir, anchor, trainers, &count, &first, &last);
+    if (count == 0) {
+        g_free(trainers);
+        return 0;
+    }
+
     GtkListStore *store = GTK_LIST_STORE(gtk_tree_view_get_model(GTK_TREE_VIEW(trainers_list)));
     gtk_list_store_clear(store);
-    
-    TrainerDetail trainers[20];
-    int count = 20;
-    db_get_all_trainers_detail(trainers, &count);
-    
     for (int i = 0; i < count; i++) {
         GtkTreeIter iter;
         gtk_list_store_append(store, &iter);
         gtk_list_store_set(store, &iter, 0, trainers[i].trainer_id, 1, trainers[i].name, 2, trainers[i].specialization, 3, trainers[i].status, -1);
     }
+    g_free(trainers);
+    trainers_first = first;
+    trainers_last = last;
+    return count;
+}
+
+// Refresh trainers list (re-load the page currently shown)
+void refresh_trainers() {
+    if (load_trainers_page(PAGE_FROM, &trainers_first) > 0) return;
+    if (trainers_first.valid && load_trainers_page(PAGE_PREV, &trainers_first) > 0) return;
+
+    gtk_list_store_clear(GTK_LIST_STORE(gtk_tree_view_get_model(GTK_TREE_VIEW(trainers_list))));
+    trainers_first.valid = trainers_last.valid = 0;
+}
+
+// Refresh cross-branch report
+void refresh_branches() {
+    GtkListStore *store = GTK_LIST_STORE(gtk_tree_view_get_model(GTK_TREE_VIEW(branches_list)));
+    gtk_list_store_clear(store);
+
+    BranchReport reports[MAX_BRANCHES];
+    int count = MAX_BRANCHES;
+    BranchReport total;
+    branch_report_all(reports, &count, &total);
+
+    for (int i = 0; i <= count; i++) {
+        const BranchReport *r = i < count ? &reports[i] : &total;
+        if (r->error) continue;
+        char revenue[32];
+        ledger_format_cents(r->monthly_revenue_cents, revenue, sizeof(revenue));
+        GtkTreeIter iter;
+        gtk_list_store_append(store, &iter);
+        gtk_list_store_set(store, &iter, 0, r->branch, 1, r->members, 2, r->active_members,
+            3, r->trainers, 4, r->pending_trainers, 5, revenue, -1);
+    }
+}
+
+// Revenue per plan between the two dates, from the ledger's day index,
+// and the visits over the same range
+void refresh_revenue() {
+    GtkListStore *store = GTK_LIST_STORE(gtk_tree_view_get_model(GTK_TREE_VIEW(revenue_list)));
+    gtk_list_store_clear(store);
+
+    int from, to;
+    if (ledger_parse_day(gtk_entry_get_text(GTK_ENTRY(revenue_from_entry)), &from) != 0 ||
+        ledger_parse_day(gtk_entry_get_text(GTK_ENTRY(revenue_to_entry)), &to) != 0) {
+        gtk_label_set_text(GTK_LABEL(revenue_status_label), "Dates must be YYYY-MM-DD.");
+        return;
+    }
+
+    gint64 started = g_get_monotonic_time();
+    const Catalog *catalog = catalog_get();
+    RevenueTotal totals[MAX_PLANS + 1];
+    int failed = 0;
+    for (int i = 0; i <= catalog->plan_count; i++) {
+        int plan_id = i < catalog->plan_count ? catalog->plans[i].plan_id : 0;
+        failed |= ledger_revenue(plan_id, from, to, &totals[i]);
+    }
+    gint64 elapsed = g_get_monotonic_time() - started;
+
+    char revenue[32], buf[256];
+    for (int i = 0; i <= catalog->plan_count; i++) {
+        ledger_format_cents(totals[i].cents, revenue, sizeof(revenue));
+        GtkTreeIter iter;
+        gtk_list_store_append(store, &iter);
+        gtk_list_store_set(store, &iter, 0, i < catalog->plan_count ? catalog->plans[i].name : "All plans",
+            1, (int)totals[i].payments, 2, revenue, -1);
+    }
+    if (failed) {
+        snprintf(buf, sizeof(buf), "Could not read the payments ledger.");
+    } else {
+        ledger_format_cents(totals[catalog->plan_count].cents, revenue, sizeof(revenue));
+        int len = snprintf(buf, sizeof(buf), "%s from %ld payments (%lld us)", revenue,
+            totals[catalog->plan_count].payments, (long long)elapsed);
+
+        // Visits over the same range, reading archived years only if needed
+        long visits, members;
+        if (db_count_visits(gtk_entry_get_text(GTK_ENTRY(revenue_from_entry)),
+                            gtk_entry_get_text(GTK_ENTRY(revenue_to_entry)), &visits, &members) == 0) {
+            snprintf(buf + len, sizeof(buf) - len, "; %ld visits by %ld members", visits, members);
+        }
+    }
+    gtk_label_set_text(GTK_LABEL(revenue_status_label), buf);
+}
+
+// List the background duplicate scan's suggestions once it finishes
+static gboolean on_dedup_tick(gpointer data) {
+    DuplicatePair *pairs = g_new0(DuplicatePair, MAX_DUPLICATES);
+    int count = MAX_DUPLICATES;
+    DedupStats stats;
+    int rc = dedup_get_result(pairs, &count, &stats);
+    if (rc > 0) {
+        g_free(pairs);
+        return G_SOURCE_CONTINUE;
+    }
+    dedup_timer = 0;
+    if (rc < 0) {
+        gtk_label_set_text(GTK_LABEL(duplicates_status_label), "Duplicate scan failed.");
+        g_free(pairs);
+        return G_SOURCE_REMOVE;
+    }
+
+    GtkListStore *store = GTK_LIST_STORE(gtk_tree_view_get_model(GTK_TREE_VIEW(duplicates_list)));
+    gtk_list_store_clear(store);
+    for (int i = 0; i < count; i++) {
+        GtkTreeIter iter;
+        gtk_list_store_append(store, &iter);
+        gtk_list_store_set(store, &iter, 0, pairs[i].keep_id, 1, pairs[i].keep_name, 2, pairs[i].keep_email,
+            3, pairs[i].drop_id, 4, pairs[i].drop_name, 5, pairs[i].drop_email,
+            6, pairs[i].email_distance, 7, pairs[i].name_distance, -1);
+    }
+    char buf[256];
+    snprintf(buf, sizeof(buf), "%d likely duplicates among %d members (%ld comparisons, %.0f ms)%s",
+        stats.pairs, stats.users, stats.comparisons, stats.ms,
+        stats.pairs > count ? "; showing the closest matches" : "");
+    gtk_label_set_text(GTK_LABEL(duplicates_status_label), buf);
+    g_free(pairs);
+    return G_SOURCE_REMOVE;
+}
+
+// Re-run duplicate detection in the background and list merge suggestions
+void refresh_duplicates() {
+    if (dedup_timer) return;        // A scan is already running
+    if (dedup_start() != 0) {
+        gtk_label_set_text(GTK_LABEL(duplicates_status_label), "Could not start the duplicate scan.");
+        return;
+    }
+    gtk_label_set_text(GTK_LABEL(duplicates_status_label), "Scanning for duplicates...");
+    dedup_timer = g_timeout_add(100, on_dedup_tick, NULL);
+}
+
+// Reload the most recently issued cards
+void refresh_cards() {
+    GtkListStore *store = GTK_LIST_STORE(gtk_tree_view_get_model(GTK_TREE_VIEW(cards_list)));
+    gtk_list_store_clear(store);
+
+    CardDetail *cards = g_new0(CardDetail, MAX_CARD_ROWS);
+    int count = MAX_CARD_ROWS;
+    if (db_get_cards(cards, &count) == 0) {
+        for (int i = 0; i < count; i++) {
+            char issued[16];
+            ledger_format_day(ledger_day(cards[i].issued_at), issued, sizeof(issued));
+            GtkTreeIter iter;
+            gtk_list_store_append(store, &iter);
+            gtk_list_store_set(store, &iter, 0, cards[i].card_id, 1, cards[i].member_id, 2, cards[i].name,
+                3, cards[i].email, 4, issued, 5, cards[i].revoked ? "Revoked" : "Active", -1);
+        }
+    }
+    g_free(cards);
+}
+
+// Reload the occupancy forecast and redraw the chart
+void refresh_occupancy() {
+    forecast_load(&occupancy_forecast);
+    int dow = gtk_combo_box_get_active(GTK_COMBO_BOX(occupancy_day_combo));
+
+    // Per-slot totals from the catalog's slot hours
+    char buf[512];
+    int len = 0;
+    const Catalog *catalog = catalog_get();
+    for (int i = 0; i < catalog->slot_count && len < (int)sizeof(buf); i++) {
+        len += snprintf(buf + len, sizeof(buf) - len, "%s%s: %.1f", i ? "  |  " : "",
+            catalog->slots[i].label, forecast_slot(&occupancy_forecast, dow, &catalog->slots[i]));
+    }
+    if (len < (int)sizeof(buf)) {
+        int peak_hour;
+        double peak = forecast_peak(&occupancy_forecast, dow, &peak_hour);
+        snprintf(buf + len, sizeof(buf) - len, "\nPeak %02d:00 (%.1f check-ins), based on %d days of history",
+            peak_hour, peak, occupancy_forecast.days_observed[dow]);
+    }
+    gtk_label_set_text(GTK_LABEL(occupancy_summary_label), buf);
+    gtk_widget_queue_draw(occupancy_chart);
+}
+
+// Draw expected check-ins per hour for the selected weekday
+static gboolean on_occupancy_draw(GtkWidget *widget, cairo_t *cr, gpointer data) {
+    const double left = 40, bottom = 25, top = 10;
+    double width = gtk_widget_get_allocated_width(widget);
+    double height = gtk_widget_get_allocated_height(widget);
+    double plot_w = width - left - 10, plot_h = height - top - bottom;
+    int dow = gtk_combo_box_get_active(GTK_COMBO_BOX(occupancy_day_combo));
+    if (dow < 0 || plot_w <= 0 || plot_h <= 0) return FALSE;
+
+    int peak_hour;
+    double peak = forecast_peak(&occupancy_forecast, dow, &peak_hour);
+    double scale = peak > 0 ? plot_h / peak : 0;
+    double bar_w = plot_w / FORECAST_HOURS;
+
+    // Shade the hours of each catalog time slot except all-day ones
+    const Catalog *catalog = catalog_get();
+    cairo_set_source_rgba(cr, 0.2, 0.5, 0.9, 0.08);
+    for (int i = 0; i < catalog->slot_count; i++) {
+        const TimeSlot *slot = &catalog->slots[i];
+        if (slot->end_hour - slot->start_hour >= 12) continue;
+        cairo_rectangle(cr, left + slot->start_hour * bar_w, top,
+            (slot->end_hour - slot->start_hour) * bar_w, plot_h);
+        cairo_fill(cr);
+    }
+
+    cairo_set_source_rgb(cr, 0.2, 0.5, 0.9);
+    for (int h = 0; h < FORECAST_HOURS; h++) {
+        double bar_h = occupancy_forecast.hourly[dow][h] * scale;
+        cairo_rectangle(cr, left + h * bar_w + 1, top + plot_h - bar_h, bar_w - 2, bar_h);
+    }
+    cairo_fill(cr);
+
+    // Axes and labels
+    char label[16];
+    cairo_set_source_rgb(cr, 0.3, 0.3, 0.3);
+    cairo_set_line_width(cr, 1);
+    cairo_move_to(cr, left, top);
+    cairo_line_to(cr, left, top + plot_h);
+    cairo_line_to(cr, left + plot_w, top + plot_h);
+    cairo_stroke(cr);
+    cairo_set_font_size(cr, 10);
+    for (int h = 0; h < FORECAST_HOURS; h += 3) {
+        snprintf(label, sizeof(label), "%02d", h);
+        cairo_move_to(cr, left + h * bar_w, top + plot_h + 15);
+        cairo_show_text(cr, label);
+    }
+    snprintf(label, sizeof(label), "%.1f", peak);
+    cairo_move_to(cr, 2, top + 10);
+    cairo_show_text(cr, label);
+    return FALSE;
+}
+
+// Redraw the live occupancy grid if any counter changed. Runs on a timer
+// capped at the configured frame rate and reads only in-memory counters.
+static gboolean on_live_tick(gpointer data) {
+    if (occupancy_version() == live_version) return G_SOURCE_CONTINUE;
+
+    OccupancySnapshot snapshot;
+    occupancy_snapshot(&snapshot);
+    live_version = snapshot.version;
+
+    char buf[64];
+    for (int s = 0; s < snapshot.slot_count; s++) {
+        int row_total = 0;
+        for (int z = 0; z < OCCUPANCY_ZONE_COUNT; z++) {
+            row_total += snapshot.present[s][z];
+            snprintf(buf, sizeof(buf), "%d", snapshot.present[s][z]);
+            if (live_cells[s][z]) gtk_label_set_text(GTK_LABEL(live_cells[s][z]), buf);
+        }
+        snprintf(buf, sizeof(buf), "%d", row_total);
+        if (live_cells[s][OCCUPANCY_ZONE_COUNT]) gtk_label_set_text(GTK_LABEL(live_cells[s][OCCUPANCY_ZONE_COUNT]), buf);
+    }
+    snprintf(buf, sizeof(buf), "In the building now: %d", snapshot.total);
+    gtk_label_set_text(GTK_LABEL(live_total_label), buf);
+    return G_SOURCE_CONTINUE;
+}
+
+// Show the mail sender's queue depth and throughput
+static gboolean on_mail_tick(gpointer data) {
+    OutboxStats stats;
+    outbox_get_stats(&stats);
+
+    char buf[512];
+    snprintf(buf, sizeof(buf),
+        "Sender: %s\nQueued: %ld\nSent: %ld (%.1f msg/s while delivering, %ld batches)\n"
+        "Failed attempts: %ld\nGiven up: %ld\nLast error: %s",
+        stats.running ? "running" : "stopped", stats.queued, stats.sent, stats.messages_per_s,
+        stats.batches, stats.failed, stats.dropped, stats.last_error[0] ? stats.last_error : "none");
+    gtk_label_set_text(GTK_LABEL(mail_status_label), buf);
+    return G_SOURCE_CONTINUE;
+}
+
+// Reload the views whose tables another app instance changed
+static void on_data_changed(unsigned changed, void *ctx) {
+    if (changed & (CHANGE_USERS | CHANGE_TRAINERS)) {
+        refresh_pending_trainers();
+        refresh_trainers();
+    }
+    if (changed & (CHANGE_USERS | CHANGE_MEMBERS | CHANGE_PLANS)) refresh_members();
+    if (changed & CHANGE_ATTENDANCE) {
+        refresh_occupancy();
+        refresh_inactive();
+    }
+    if (changed & CHANGE_PAYMENTS) refresh_revenue();
+    if (changed & (CHANGE_USERS | CHANGE_CARDS)) refresh_cards();
 }
 
 // ============================================
@@ -119,7 +503,11 @@ void on_delete_member(GtkButton *button, gpointer data) {
     if (gtk_tree_selection_get_selected(selection, &model, &iter)) {
         int id;
         gtk_tree_model_get(model, &iter, 0, &id, -1);
-        db_delete_member(id);
+        if (db_delete_member(id) == 0) {
+            visits_forget(id);
+            gate_mark_stale();      // Their cards were revoked
+            gate_member_changed(id);
+        }
         refresh_members();
     }
 }
@@ -139,8 +527,243 @@ void on_fire_trainer(GtkButton *button, gpointer data) {
     }
 }
 
+// Switch the forecast to another weekday
+static void on_occupancy_day_changed(GtkComboBox *combo, gpointer data) {
+    refresh_occupancy();
+}
+
+static void on_refresh_occupancy(GtkButton *button, gpointer data) {
+    refresh_occupancy();
+}
+
+// Scan for duplicate member accounts
+static void on_scan_duplicates(GtkButton *button, gpointer data) {
+    refresh_duplicates();
+}
+
+// Merge the selected duplicate into the account being kept
+void on_merge_duplicate(GtkButton *button, gpointer data) {
+    GtkTreeSelection *selection = gtk_tree_view_get_selection(GTK_TREE_VIEW(duplicates_list));
+    GtkTreeModel *model;
+    GtkTreeIter iter;
+
+    if (gtk_tree_selection_get_selected(selection, &model, &iter)) {
+        int keep_id, drop_id;
+        gtk_tree_model_get(model, &iter, 0, &keep_id, 3, &drop_id, -1);
+        if (db_merge_members(keep_id, drop_id) != 0) {
+            show_info("Merge failed; neither account was changed.");
+            return;
+        }
+        // The kept account may have taken over the duplicate's membership
+        scheduler_track(keep_id, db_get_member_renewal(keep_id));
+        visits_merge(keep_id, drop_id);
+        gate_mark_stale();          // The duplicate's cards moved over
+        gate_member_changed(keep_id);
+        gate_member_changed(drop_id);
+        gtk_list_store_remove(GTK_LIST_STORE(model), &iter);
+        refresh_members();
+    }
+}
+
+// Rebalance members across approved trainers
+void on_auto_balance(GtkButton *button, gpointer data) {
+    BalanceResult result;
+    char buf[512];
+    if (balance_trainers(&result) != 0) {
+        show_info("Auto-balance failed; no assignments were changed.");
+        return;
+    }
+    if (result.trainers == 0) {
+        show_info("No approved trainers to balance across.");
+        return;
+    }
+    snprintf(buf, sizeof(buf),
+        "Balanced %d members across %d trainers.\n"
+        "Reassigned: %d\nLoad per trainer: %d - %d\n"
+        "Solve time: %.1f ms | Commit time: %.1f ms",
+        result.members, result.trainers, result.moved, result.min_load, result.max_load,
+        result.solve_ms, result.commit_ms);
+    show_info(buf);
+}
+
+// Poll the background export and update the progress bar
+static gboolean on_export_tick(gpointer data) {
+    ExportProgress progress;
+    export_get_progress(&progress);
+
+    double fraction = progress.rows_total > 0 ? (double)progress.rows_done / progress.rows_total : 0.0;
+    gtk_progress_bar_set_fraction(GTK_PROGRESS_BAR(export_progress_bar), progress.running ? fraction : 1.0);
+
+    char buf[512];
+    if (progress.running) {
+        snprintf(buf, sizeof(buf), "Exporting... %ld / %ld rows", progress.rows_done, progress.rows_total);
+        gtk_label_set_text(GTK_LABEL(export_status_label), buf);
+        return G_SOURCE_CONTINUE;
+    }
+
+    if (progress.failed) {
+        snprintf(buf, sizeof(buf), "Export failed. Partial output in %s", progress.directory);
+    } else {
+        snprintf(buf, sizeof(buf), "Exported %ld rows (%.1f MB) to %s in %.2f s",
+            progress.rows_done, progress.bytes_written / 1e6, progress.directory, progress.seconds);
+    }
+    gtk_label_set_text(GTK_LABEL(export_status_label), buf);
+    gtk_widget_set_sensitive(export_button, TRUE);
+    export_timer = 0;
+    return G_SOURCE_REMOVE;
+}
+
+// Start an export without blocking the UI
+void on_export_clicked(GtkButton *button, gpointer data) {
+    ExportFormat format = gtk_combo_box_get_active(GTK_COMBO_BOX(export_format_combo)) == 1 ? EXPORT_COLUMNAR : EXPORT_CSV;
+    if (export_start(format) != 0) {
+        show_info("Could not start the export.");
+        return;
+    }
+    gtk_widget_set_sensitive(export_button, FALSE);
+    gtk_progress_bar_set_fraction(GTK_PROGRESS_BAR(export_progress_bar), 0.0);
+    export_timer = g_timeout_add(100, on_export_tick, NULL);
+}
+
+// Members paging and sorting
+static void on_members_next(GtkButton *button, gpointer data) {
+    load_members_page(PAGE_NEXT, &members_last);
+}
+
+static void on_members_prev(GtkButton *button, gpointer data) {
+    load_members_page(PAGE_PREV, &members_first);
+}
+
+static void on_members_sort_changed(GtkComboBox *combo, gpointer data) {
+    members_sort = (ListSort)gtk_combo_box_get_active(combo);
+    members_first.valid = members_last.valid = 0;
+    refresh_members();
+}
+
+// Trainers paging and sorting
+static void on_trainers_next(GtkButton *button, gpointer data) {
+    load_trainers_page(PAGE_NEXT, &trainers_last);
+}
+
+static void on_trainers_prev(GtkButton *button, gpointer data) {
+    load_trainers_page(PAGE_PREV, &trainers_first);
+}
+
+static void on_trainers_sort_changed(GtkComboBox *combo, gpointer data) {
+    trainers_sort = (ListSort)gtk_combo_box_get_active(combo);
+    trainers_first.valid = trainers_last.valid = 0;
+    refresh_trainers();
+}
+
+// Re-run the cross-branch report
+static void on_show_revenue(GtkButton *button, gpointer data) {
+    refresh_revenue();
+}
+
+// Preset ranges ending today: GPOINTER_TO_INT(data) is 'm' (this month) or
+// 'y' (this year)
+static void on_revenue_preset(GtkButton *button, gpointer data) {
+    time_t now = time(NULL);
+    struct tm *local = localtime(&now);
+    char from[16], to[16];
+    snprintf(from, sizeof(from), "%04d-%02d-01", local->tm_year + 1900,
+        GPOINTER_TO_INT(data) == 'y' ? 1 : local->tm_mon + 1);
+    ledger_format_day(ledger_day((long long)now), to, sizeof(to));
+    gtk_entry_set_text(GTK_ENTRY(revenue_from_entry), from);
+    gtk_entry_set_text(GTK_ENTRY(revenue_to_entry), to);
+    refresh_revenue();
+}
+
+// Issue the typed card number to the member with the typed email
+static void on_issue_card(GtkButton *button, gpointer data) {
+    const char *card_id = gtk_entry_get_text(GTK_ENTRY(card_id_entry));
+    User user;
+    if (!gate_card_valid(card_id)) {
+        gtk_label_set_text(GTK_LABEL(cards_status_label), "Card numbers are 1-32 letters, digits or dashes.");
+        return;
+    }
+    if (db_get_user_by_email(gtk_entry_get_text(GTK_ENTRY(card_email_entry)), &user) != 0 ||
+        strcmp(user.role, "Member") != 0) {
+        gtk_label_set_text(GTK_LABEL(cards_status_label), "No member with that email.");
+        return;
+    }
+    if (db_issue_card(card_id, user.user_id, (long long)time(NULL)) != 0) {
+        gtk_label_set_text(GTK_LABEL(cards_status_label), "That card is already active.");
+        return;
+    }
+    gate_mark_stale();
+    gate_refresh();
+
+    char buf[256];
+    snprintf(buf, sizeof(buf), "Card %s issued to %s.", card_id, user.name);
+    gtk_label_set_text(GTK_LABEL(cards_status_label), buf);
+    gtk_entry_set_text(GTK_ENTRY(card_id_entry), "");
+    refresh_cards();
+}
+
+// Revoke the selected card (e.g. reported lost)
+static void on_revoke_card(GtkButton *button, gpointer data) {
+    GtkTreeSelection *selection = gtk_tree_view_get_selection(GTK_TREE_VIEW(cards_list));
+    GtkTreeModel *model;
+    GtkTreeIter iter;
+
+    if (gtk_tree_selection_get_selected(selection, &model, &iter)) {
+        char *card_id;
+        gtk_tree_model_get(model, &iter, 0, &card_id, -1);
+        if (db_revoke_card(card_id, (long long)time(NULL)) == 0) {
+            gate_mark_stale();
+            gate_refresh();
+        }
+        g_free(card_id);
+        refresh_cards();
+    }
+}
+
+// Run the typed card through the same check a turnstile makes
+static void on_test_card(GtkButton *button, gpointer data) {
+    GateDecision decision;
+    long long now = (long long)time(NULL);
+    gate_refresh();
+    gint64 started = g_get_monotonic_time();
+    gate_check(gtk_entry_get_text(GTK_ENTRY(card_test_entry)), now, &decision);
+    gint64 elapsed = g_get_monotonic_time() - started;
+
+    char buf[256];
+    User user;
+    if (decision.member_id > 0 && db_get_user(decision.member_id, &user) == 0) {
+        snprintf(buf, sizeof(buf), "%s: %s (%lld us)", gate_result_name(decision.result), user.name,
+            (long long)elapsed);
+    } else {
+        snprintf(buf, sizeof(buf), "%s (%lld us)", gate_result_name(decision.result), (long long)elapsed);
+    }
+    gtk_label_set_text(GTK_LABEL(cards_status_label), buf);
+}
+
+static void on_refresh_branches(GtkButton *button, gpointer data) {
+    refresh_branches();
+}
+
 // Handle logout
 static void on_logout_clicked(GtkButton *button, gpointer data) {
+    // The export keeps running; only stop polling widgets that are going away
+    if (export_timer) {
+        g_source_remove(export_timer);
+        export_timer = 0;
+    }
+    if (dedup_timer) {
+        g_source_remove(dedup_timer);
+        dedup_timer = 0;
+    }
+    if (live_timer) {
+        g_source_remove(live_timer);
+        live_timer = 0;
+    }
+    if (mail_timer) {
+        g_source_remove(mail_timer);
+        mail_timer = 0;
+    }
+    changes_unsubscribe(changes_subscription);
+    changes_subscription = 0;
     gtk_widget_destroy(window);
     return_to_login();
 }
@@ -175,6 +798,31 @@ GtkWidget* create_pending_trainers_tab() {
     return vbox;
 }
 
+// Create sort selector and Prev/Next buttons for a paginated list
+static GtkWidget* create_paging_bar(const char *plan_label, ListSort active,
+                                    GCallback on_sort, GCallback on_prev, GCallback on_next) {
+    GtkWidget *hbox = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 5);
+
+    // Entry order must follow the ListSort enum
+    GtkWidget *combo = gtk_combo_box_text_new();
+    gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(combo), "Sort by Name");
+    gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(combo), plan_label);
+    gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(combo), "Sort by Status");
+    gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(combo), "Sort by Join Date");
+    gtk_combo_box_set_active(GTK_COMBO_BOX(combo), active);
+    g_signal_connect(combo, "changed", on_sort, NULL);
+
+    GtkWidget *btn_prev = gtk_button_new_with_label("< Prev");
+    g_signal_connect(btn_prev, "clicked", on_prev, NULL);
+    GtkWidget *btn_next = gtk_button_new_with_label("Next >");
+    g_signal_connect(btn_next, "clicked", on_next, NULL);
+
+    gtk_box_pack_start(GTK_BOX(hbox), combo, FALSE, FALSE, 0);
+    gtk_box_pack_end(GTK_BOX(hbox), btn_next, FALSE, FALSE, 0);
+    gtk_box_pack_end(GTK_BOX(hbox), btn_prev, FALSE, FALSE, 0);
+    return hbox;
+}
+
 // Create members management tab
 GtkWidget* create_members_tab() {
     GtkWidget *vbox = gtk_box_new(GTK_ORIENTATION_VERTICAL, 5);
@@ -186,7 +834,12 @@ GtkWidget* create_members_tab() {
     add_column(members_list, "Plan", 2);
     add_column(members_list, "Status", 3);
     
+    gtk_box_pack_start(GTK_BOX(vbox), create_paging_bar("Sort by Plan", members_sort,
+        G_CALLBACK(on_members_sort_changed), G_CALLBACK(on_members_prev), G_CALLBACK(on_members_next)), FALSE, FALSE, 0);
     gtk_box_pack_start(GTK_BOX(vbox), members_list, TRUE, TRUE, 0);
+
+    inactive_label = gtk_label_new("");
+    gtk_box_pack_start(GTK_BOX(vbox), inactive_label, FALSE, FALSE, 0);
     
     GtkWidget *btn_delete = gtk_button_new_with_label("Cancel Membership");
     g_signal_connect(btn_delete, "clicked", G_CALLBACK(on_delete_member), NULL);
@@ -207,22 +860,300 @@ GtkWidget* create_trainers_tab() {
     add_column(trainers_list, "Specialization", 2);
     add_column(trainers_list, "Status", 3);
     
+    gtk_box_pack_start(GTK_BOX(vbox), create_paging_bar("Sort by Specialization", trainers_sort,
+        G_CALLBACK(on_trainers_sort_changed), G_CALLBACK(on_trainers_prev), G_CALLBACK(on_trainers_next)), FALSE, FALSE, 0);
     gtk_box_pack_start(GTK_BOX(vbox), trainers_list, TRUE, TRUE, 0);
     
+    GtkWidget *hbox = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 5);
     GtkWidget *btn_fire = gtk_button_new_with_label("Fire Trainer");
     g_signal_connect(btn_fire, "clicked", G_CALLBACK(on_fire_trainer), NULL);
-    gtk_box_pack_start(GTK_BOX(vbox), btn_fire, FALSE, FALSE, 0);
+    GtkWidget *btn_balance = gtk_button_new_with_label("Auto-Balance Members");
+    g_signal_connect(btn_balance, "clicked", G_CALLBACK(on_auto_balance), NULL);
+    gtk_box_pack_start(GTK_BOX(hbox), btn_fire, TRUE, TRUE, 0);
+    gtk_box_pack_start(GTK_BOX(hbox), btn_balance, TRUE, TRUE, 0);
+    gtk_box_pack_start(GTK_BOX(vbox), hbox, FALSE, FALSE, 0);
     
     refresh_trainers();
     return vbox;
 }
 
+// Create cross-branch report tab
+GtkWidget* create_branches_tab() {
+    GtkWidget *vbox = gtk_box_new(GTK_ORIENTATION_VERTICAL, 5);
+
+    GtkListStore *store = gtk_list_store_new(6, G_TYPE_STRING, G_TYPE_INT, G_TYPE_INT, G_TYPE_INT, G_TYPE_INT, G_TYPE_STRING);
+    branches_list = gtk_tree_view_new_with_model(GTK_TREE_MODEL(store));
+    add_column(branches_list, "Branch", 0);
+    add_column(branches_list, "Members", 1);
+    add_column(branches_list, "With Plan", 2);
+    add_column(branches_list, "Trainers", 3);
+    add_column(branches_list, "Pending", 4);
+    add_column(branches_list, "Monthly Revenue", 5);
+
+    gtk_box_pack_start(GTK_BOX(vbox), branches_list, TRUE, TRUE, 0);
+
+    GtkWidget *btn_refresh = gtk_button_new_with_label("Refresh Report");
+    g_signal_connect(btn_refresh, "clicked", G_CALLBACK(on_refresh_branches), NULL);
+    gtk_box_pack_start(GTK_BOX(vbox), btn_refresh, FALSE, FALSE, 0);
+
+    refresh_branches();
+    return vbox;
+}
+
+// Create live occupancy tab (time slot x zone)
+GtkWidget* create_live_tab() {
+    GtkWidget *vbox = gtk_box_new(GTK_ORIENTATION_VERTICAL, 10);
+    gtk_widget_set_valign(vbox, GTK_ALIGN_CENTER);
+
+    live_total_label = gtk_label_new("");
+    gtk_box_pack_start(GTK_BOX(vbox), live_total_label, FALSE, FALSE, 0);
+
+    GtkWidget *grid = gtk_grid_new();
+    gtk_grid_set_row_spacing(GTK_GRID(grid), 8);
+    gtk_grid_set_column_spacing(GTK_GRID(grid), 20);
+    gtk_widget_set_halign(grid, GTK_ALIGN_CENTER);
+
+    OccupancySnapshot snapshot;
+    occupancy_snapshot(&snapshot);
+    memset(live_cells, 0, sizeof(live_cells));
+    for (int z = 0; z <= OCCUPANCY_ZONE_COUNT; z++) {
+        const char *title = z < OCCUPANCY_ZONE_COUNT ? occupancy_zone_name(z) : "Total";
+        gtk_grid_attach(GTK_GRID(grid), gtk_label_new(title), z + 1, 0, 1, 1);
+    }
+    for (int s = 0; s < snapshot.slot_count; s++) {
+        gtk_grid_attach(GTK_GRID(grid), gtk_label_new(snapshot.slot_labels[s]), 0, s + 1, 1, 1);
+        for (int z = 0; z <= OCCUPANCY_ZONE_COUNT; z++) {
+            live_cells[s][z] = gtk_label_new("0");
+            gtk_grid_attach(GTK_GRID(grid), live_cells[s][z], z + 1, s + 1, 1, 1);
+        }
+    }
+    gtk_box_pack_start(GTK_BOX(vbox), grid, FALSE, FALSE, 0);
+
+    live_version = snapshot.version - 1;
+    on_live_tick(NULL);
+    live_timer = g_timeout_add(1000 / config_get()->occupancy_max_fps, on_live_tick, NULL);
+    return vbox;
+}
+
+// Create revenue tab (payments ledger by plan and date range)
+GtkWidget* create_revenue_tab() {
+    GtkWidget *vbox = gtk_box_new(GTK_ORIENTATION_VERTICAL, 5);
+
+    GtkWidget *hbox = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 5);
+    revenue_from_entry = gtk_entry_new();
+    revenue_to_entry = gtk_entry_new();
+    gtk_entry_set_width_chars(GTK_ENTRY(revenue_from_entry), 10);
+    gtk_entry_set_width_chars(GTK_ENTRY(revenue_to_entry), 10);
+    GtkWidget *btn_show = gtk_button_new_with_label("Show");
+    GtkWidget *btn_month = gtk_button_new_with_label("This Month");
+    GtkWidget *btn_year = gtk_button_new_with_label("This Year");
+    g_signal_connect(btn_show, "clicked", G_CALLBACK(on_show_revenue), NULL);
+    g_signal_connect(revenue_to_entry, "activate", G_CALLBACK(on_show_revenue), NULL);
+    g_signal_connect(btn_month, "clicked", G_CALLBACK(on_revenue_preset), GINT_TO_POINTER('m'));
+    g_signal_connect(btn_year, "clicked", G_CALLBACK(on_revenue_preset), GINT_TO_POINTER('y'));
+    gtk_box_pack_start(GTK_BOX(hbox), gtk_label_new("From"), FALSE, FALSE, 0);
+    gtk_box_pack_start(GTK_BOX(hbox), revenue_from_entry, FALSE, FALSE, 0);
+    gtk_box_pack_start(GTK_BOX(hbox), gtk_label_new("to"), FALSE, FALSE, 0);
+    gtk_box_pack_start(GTK_BOX(hbox), revenue_to_entry, FALSE, FALSE, 0);
+    gtk_box_pack_start(GTK_BOX(hbox), btn_show, FALSE, FALSE, 0);
+    gtk_box_pack_end(GTK_BOX(hbox), btn_year, FALSE, FALSE, 0);
+    gtk_box_pack_end(GTK_BOX(hbox), btn_month, FALSE, FALSE, 0);
+    gtk_box_pack_start(GTK_BOX(vbox), hbox, FALSE, FALSE, 0);
+
+    GtkListStore *store = gtk_list_store_new(3, G_TYPE_STRING, G_TYPE_INT, G_TYPE_STRING);
+    revenue_list = gtk_tree_view_new_with_model(GTK_TREE_MODEL(store));
+    add_column(revenue_list, "Plan", 0);
+    add_column(revenue_list, "Payments", 1);
+    add_column(revenue_list, "Revenue", 2);
+    gtk_box_pack_start(GTK_BOX(vbox), revenue_list, TRUE, TRUE, 0);
+
+    revenue_status_label = gtk_label_new("");
+    gtk_box_pack_start(GTK_BOX(vbox), revenue_status_label, FALSE, FALSE, 0);
+
+    on_revenue_preset(NULL, GINT_TO_POINTER('m'));
+    return vbox;
+}
+
+// Create mail outbox status tab
+GtkWidget* create_mail_tab() {
+    GtkWidget *vbox = gtk_box_new(GTK_ORIENTATION_VERTICAL, 10);
+    gtk_widget_set_valign(vbox, GTK_ALIGN_CENTER);
+
+    mail_status_label = gtk_label_new("");
+    gtk_box_pack_start(GTK_BOX(vbox), mail_status_label, FALSE, FALSE, 0);
+
+    on_mail_tick(NULL);
+    mail_timer = g_timeout_add_seconds(1, on_mail_tick, NULL);
+    return vbox;
+}
+
+// Create occupancy forecast tab
+GtkWidget* create_occupancy_tab() {
+    GtkWidget *vbox = gtk_box_new(GTK_ORIENTATION_VERTICAL, 5);
+
+    static const char *day_names[FORECAST_DAYS] = {
+        "Sunday", "Monday", "Tuesday", "Wednesday", "Thursday", "Friday", "Saturday"
+    };
+    occupancy_day_combo = gtk_combo_box_text_new();
+    for (int d = 0; d < FORECAST_DAYS; d++) {
+        gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(occupancy_day_combo), day_names[d]);
+    }
+    time_t now = time(NULL);
+    gtk_combo_box_set_active(GTK_COMBO_BOX(occupancy_day_combo), localtime(&now)->tm_wday);
+
+    GtkWidget *hbox = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 5);
+    gtk_box_pack_start(GTK_BOX(hbox), gtk_label_new("Predicted check-ins per hour on"), FALSE, FALSE, 0);
+    gtk_box_pack_start(GTK_BOX(hbox), occupancy_day_combo, FALSE, FALSE, 0);
+    GtkWidget *btn_refresh = gtk_button_new_with_label("Refresh");
+    g_signal_connect(btn_refresh, "clicked", G_CALLBACK(on_refresh_occupancy), NULL);
+    gtk_box_pack_end(GTK_BOX(hbox), btn_refresh, FALSE, FALSE, 0);
+    gtk_box_pack_start(GTK_BOX(vbox), hbox, FALSE, FALSE, 0);
+
+    occupancy_chart = gtk_drawing_area_new();
+    gtk_widget_set_size_request(occupancy_chart, 600, 250);
+    g_signal_connect(occupancy_chart, "draw", G_CALLBACK(on_occupancy_draw), NULL);
+    gtk_box_pack_start(GTK_BOX(vbox), occupancy_chart, TRUE, TRUE, 0);
+
+    occupancy_summary_label = gtk_label_new("");
+    gtk_box_pack_start(GTK_BOX(vbox), occupancy_summary_label, FALSE, FALSE, 0);
+
+    g_signal_connect(occupancy_day_combo, "changed", G_CALLBACK(on_occupancy_day_changed), NULL);
+    refresh_occupancy();
+    return vbox;
+}
+
+// Create duplicate members tab
+GtkWidget* create_duplicates_tab() {
+    GtkWidget *vbox = gtk_box_new(GTK_ORIENTATION_VERTICAL, 5);
+
+    GtkListStore *store = gtk_list_store_new(8, G_TYPE_INT, G_TYPE_STRING, G_TYPE_STRING,
+        G_TYPE_INT, G_TYPE_STRING, G_TYPE_STRING, G_TYPE_INT, G_TYPE_INT);
+    duplicates_list = gtk_tree_view_new_with_model(GTK_TREE_MODEL(store));
+    add_column(duplicates_list, "Keep ID", 0);
+    add_column(duplicates_list, "Name", 1);
+    add_column(duplicates_list, "Email", 2);
+    add_column(duplicates_list, "Duplicate ID", 3);
+    add_column(duplicates_list, "Name", 4);
+    add_column(duplicates_list, "Email", 5);
+    add_column(duplicates_list, "Email Edits", 6);
+    add_column(duplicates_list, "Name Edits", 7);
+
+    GtkWidget *scroll = gtk_scrolled_window_new(NULL, NULL);
+    gtk_container_add(GTK_CONTAINER(scroll), duplicates_list);
+    gtk_box_pack_start(GTK_BOX(vbox), scroll, TRUE, TRUE, 0);
+
+    duplicates_status_label = gtk_label_new("Scan to find member accounts that look like duplicates.");
+    gtk_box_pack_start(GTK_BOX(vbox), duplicates_status_label, FALSE, FALSE, 0);
+
+    GtkWidget *hbox = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 5);
+    GtkWidget *btn_scan = gtk_button_new_with_label("Scan for Duplicates");
+    g_signal_connect(btn_scan, "clicked", G_CALLBACK(on_scan_duplicates), NULL);
+    GtkWidget *btn_merge = gtk_button_new_with_label("Merge Selected");
+    g_signal_connect(btn_merge, "clicked", G_CALLBACK(on_merge_duplicate), NULL);
+    gtk_box_pack_start(GTK_BOX(hbox), btn_scan, TRUE, TRUE, 0);
+    gtk_box_pack_start(GTK_BOX(hbox), btn_merge, TRUE, TRUE, 0);
+    gtk_box_pack_start(GTK_BOX(vbox), hbox, FALSE, FALSE, 0);
+
+    return vbox;
+}
+
+// Create turnstile cards tab
+GtkWidget* create_cards_tab() {
+    GtkWidget *vbox = gtk_box_new(GTK_ORIENTATION_VERTICAL, 5);
+
+    GtkWidget *hbox = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 5);
+    card_email_entry = gtk_entry_new();
+    card_id_entry = gtk_entry_new();
+    gtk_entry_set_placeholder_text(GTK_ENTRY(card_email_entry), "Member email");
+    gtk_entry_set_placeholder_text(GTK_ENTRY(card_id_entry), "Card number");
+    gtk_entry_set_max_length(GTK_ENTRY(card_id_entry), GATE_CARD_MAX);
+    GtkWidget *btn_issue = gtk_button_new_with_label("Issue Card");
+    g_signal_connect(btn_issue, "clicked", G_CALLBACK(on_issue_card), NULL);
+    g_signal_connect(card_id_entry, "activate", G_CALLBACK(on_issue_card), NULL);
+    gtk_box_pack_start(GTK_BOX(hbox), card_email_entry, TRUE, TRUE, 0);
+    gtk_box_pack_start(GTK_BOX(hbox), card_id_entry, TRUE, TRUE, 0);
+    gtk_box_pack_start(GTK_BOX(hbox), btn_issue, FALSE, FALSE, 0);
+    gtk_box_pack_start(GTK_BOX(vbox), hbox, FALSE, FALSE, 0);
+
+    GtkListStore *store = gtk_list_store_new(6, G_TYPE_STRING, G_TYPE_INT, G_TYPE_STRING, G_TYPE_STRING,
+        G_TYPE_STRING, G_TYPE_STRING);
+    cards_list = gtk_tree_view_new_with_model(GTK_TREE_MODEL(store));
+    add_column(cards_list, "Card", 0);
+    add_column(cards_list, "Member ID", 1);
+    add_column(cards_list, "Name", 2);
+    add_column(cards_list, "Email", 3);
+    add_column(cards_list, "Issued", 4);
+    add_column(cards_list, "Status", 5);
+
+    GtkWidget *scroll = gtk_scrolled_window_new(NULL, NULL);
+    gtk_container_add(GTK_CONTAINER(scroll), cards_list);
+    gtk_box_pack_start(GTK_BOX(vbox), scroll, TRUE, TRUE, 0);
+
+    GtkWidget *test_box = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 5);
+    card_test_entry = gtk_entry_new();
+    gtk_entry_set_placeholder_text(GTK_ENTRY(card_test_entry), "Card number");
+    GtkWidget *btn_test = gtk_button_new_with_label("Test at Gate");
+    g_signal_connect(btn_test, "clicked", G_CALLBACK(on_test_card), NULL);
+    g_signal_connect(card_test_entry, "activate", G_CALLBACK(on_test_card), NULL);
+    GtkWidget *btn_revoke = gtk_button_new_with_label("Revoke Selected");
+    g_signal_connect(btn_revoke, "clicked", G_CALLBACK(on_revoke_card), NULL);
+    gtk_box_pack_start(GTK_BOX(test_box), card_test_entry, TRUE, TRUE, 0);
+    gtk_box_pack_start(GTK_BOX(test_box), btn_test, FALSE, FALSE, 0);
+    gtk_box_pack_end(GTK_BOX(test_box), btn_revoke, FALSE, FALSE, 0);
+    gtk_box_pack_start(GTK_BOX(vbox), test_box, FALSE, FALSE, 0);
+
+    cards_status_label = gtk_label_new("");
+    gtk_box_pack_start(GTK_BOX(vbox), cards_status_label, FALSE, FALSE, 0);
+
+    refresh_cards();
+    return vbox;
+}
+
+// Create data export tab
+GtkWidget* create_export_tab() {
+    GtkWidget *vbox = gtk_box_new(GTK_ORIENTATION_VERTICAL, 10);
+    gtk_widget_set_valign(vbox, GTK_ALIGN_CENTER);
+
+    gtk_box_pack_start(GTK_BOX(vbox), gtk_label_new("Export members, trainers and attendance of this branch."), FALSE, FALSE, 0);
+
+    export_format_combo = gtk_combo_box_text_new();
+    gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(export_format_combo), "CSV");
+    gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(export_format_combo), "Compressed columnar (.gcol)");
+    gtk_combo_box_set_active(GTK_COMBO_BOX(export_format_combo), 0);
+    gtk_box_pack_start(GTK_BOX(vbox), export_format_combo, FALSE, FALSE, 0);
+
+    export_button = gtk_button_new_with_label("Start Export");
+    g_signal_connect(export_button, "clicked", G_CALLBACK(on_export_clicked), NULL);
+    gtk_box_pack_start(GTK_BOX(vbox), export_button, FALSE, FALSE, 0);
+
+    export_progress_bar = gtk_progress_bar_new();
+    gtk_box_pack_start(GTK_BOX(vbox), export_progress_bar, FALSE, FALSE, 0);
+
+    export_status_label = gtk_label_new("");
+    gtk_box_pack_start(GTK_BOX(vbox), export_status_label, FALSE, FALSE, 0);
+
+    // An export started before logging out may still be running
+    ExportProgress progress;
+    export_get_progress(&progress);
+    if (progress.running) {
+        gtk_widget_set_sensitive(export_button, FALSE);
+        export_timer = g_timeout_add(100, on_export_tick, NULL);
+    }
+    return vbox;
+}
+
 // Initialize and show admin dashboard
 void show_admin_dashboard(User *user) {
+    members_first.valid = members_last.valid = 0;
+    trainers_first.valid = trainers_last.valid = 0;
+
     window = gtk_window_new(GTK_WINDOW_TOPLEVEL);
-    gtk_window_set_title(GTK_WINDOW(window), "Admin Dashboard");
+    char title[100];
+    snprintf(title, sizeof(title), "Admin Dashboard - %s", db_get_branch());
+    gtk_window_set_title(GTK_WINDOW(window), title);
     gtk_window_set_default_size(GTK_WINDOW(window), 800, 600);
     g_signal_connect(window, "destroy", G_CALLBACK(on_logout_clicked), NULL);
+    frametime_watch(window, "admin");
     
     // Create main container
     GtkWidget *vbox = gtk_box_new(GTK_ORIENTATION_VERTICAL, 5);
@@ -232,6 +1163,14 @@ void show_admin_dashboard(User *user) {
     gtk_notebook_append_page(GTK_NOTEBOOK(notebook), create_pending_trainers_tab(), gtk_label_new("Pending Trainers"));
     gtk_notebook_append_page(GTK_NOTEBOOK(notebook), create_members_tab(), gtk_label_new("Members"));
     gtk_notebook_append_page(GTK_NOTEBOOK(notebook), create_trainers_tab(), gtk_label_new("All Trainers"));
+    gtk_notebook_append_page(GTK_NOTEBOOK(notebook), create_branches_tab(), gtk_label_new("Branches"));
+    gtk_notebook_append_page(GTK_NOTEBOOK(notebook), create_revenue_tab(), gtk_label_new("Revenue"));
+    gtk_notebook_append_page(GTK_NOTEBOOK(notebook), create_live_tab(), gtk_label_new("Live"));
+    gtk_notebook_append_page(GTK_NOTEBOOK(notebook), create_occupancy_tab(), gtk_label_new("Occupancy"));
+    gtk_notebook_append_page(GTK_NOTEBOOK(notebook), create_duplicates_tab(), gtk_label_new("Duplicates"));
+    gtk_notebook_append_page(GTK_NOTEBOOK(notebook), create_cards_tab(), gtk_label_new("Cards"));
+    gtk_notebook_append_page(GTK_NOTEBOOK(notebook), create_export_tab(), gtk_label_new("Export"));
+    gtk_notebook_append_page(GTK_NOTEBOOK(notebook), create_mail_tab(), gtk_label_new("Mail"));
     
     gtk_box_pack_start(GTK_BOX(vbox), notebook, TRUE, TRUE, 0);
     
@@ -242,4 +1181,7 @@ void show_admin_dashboard(User *user) {
     
     gtk_container_add(GTK_CONTAINER(window), vbox);
     gtk_widget_show_all(window);
+
+    changes_subscription = changes_subscribe(CHANGE_USERS | CHANGE_MEMBERS | CHANGE_TRAINERS |
+        CHANGE_PLANS | CHANGE_ATTENDANCE | CHANGE_PAYMENTS | CHANGE_CARDS, on_data_changed, NULL);
 }
@@ -0,0 +1,346 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sqlite3.h>
+#include "archive.h"
+#include "database.h"
+#include "config.h"
+#include "changes.h"
+
+#define ATTENDANCE_COLUMNS "attendance_id, member_id, date, status, checked_in_at, checked_out_at, zone"
+
+// ============================================
+// Archive Files
+// ============================================
+
+static atomic_int background_running;
+
+// database/gym.db -> database/gym.archive
+static void archive_dir(const char *db_path, char *dir, size_t size) {
+    size_t len = strlen(db_path);
+    if (len > 3 && strcmp(db_path + len - 3, ".db") == 0) len -= 3;
+    snprintf(dir, size, "%.*s.archive", (int)len, db_path);
+}
+
+// File holding the archived visits of one calendar year
+void archive_path(const char *db_path, int year, char *path, size_t size) {
+    char dir[256];
+    archive_dir(db_path, dir, sizeof(dir));
+    snprintf(path, size, "%s/attendance-%04d.db", dir, year);
+}
+
+static int compare_int(const void *a, const void *b) {
+    return *(const int*)a - *(const int*)b;
+}
+
+// Years with an archive file between from_year and to_year, oldest first
+static int list_years(const char *db_path, int from_year, int to_year, int *years, int max) {
+    char dir_path[256];
+    archive_dir(db_path, dir_path, sizeof(dir_path));
+    DIR *dir = opendir(dir_path);
+    if (!dir) return 0;
+
+    int count = 0;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL && count < max) {
+        int year;
+        char extra;
+        if (sscanf(entry->d_name, "attendance-%4d.db%c", &year, &extra) != 1) continue;
+        if (strlen(entry->d_name) != strlen("attendance-0000.db")) continue;
+        if (year >= from_year && year <= to_year) years[count++] = year;
+    }
+    closedir(dir);
+    qsort(years, count, sizeof(int), compare_int);
+    return count;
+}
+
+static int exec_sql(sqlite3 *conn, const char *sql, const char *what) {
+    char *errMsg = 0;
+    if (sqlite3_exec(conn, sql, 0, 0, &errMsg) != SQLITE_OK) {
+        fprintf(stderr, "Archive: %s failed: %s\n", what, errMsg);
+        sqlite3_free(errMsg);
+        return 1;
+    }
+    return 0;
+}
+
+static int attach_year(sqlite3 *conn, const char *db_path, int year) {
+    char path[300];
+    archive_path(db_path, year, path, sizeof(path));
+    char *sql = sqlite3_mprintf("ATTACH DATABASE %Q AS archive_%04d;", path, year);
+    int rc = exec_sql(conn, sql, "attach");
+    sqlite3_free(sql);
+    return rc;
+}
+
+// ============================================
+// Moving Rows
+// ============================================
+
+// Year of the oldest visit still due for archiving: 0 when none is, -1 on error
+static int oldest_due_year(sqlite3 *conn, const char *cutoff) {
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(conn, "SELECT CAST(substr(MIN(date), 1, 4) AS INTEGER) FROM main.Attendance "
+                           "WHERE date < ?1;", -1, &stmt, 0) != SQLITE_OK) {
+        return -1;
+    }
+    sqlite3_bind_text(stmt, 1, cutoff, -1, SQLITE_STATIC);
+    int rc = sqlite3_step(stmt);
+    int year = rc == SQLITE_ROW ? sqlite3_column_int(stmt, 0) : rc == SQLITE_DONE ? 0 : -1;
+    sqlite3_finalize(stmt);
+    return year;
+}
+
+// Open (creating if needed) the archive of a year for writing as
+// archive_YYYY. It is in WAL mode while batches go in, so a commit does not
+// pay for a rollback journal and a super-journal across both files.
+static int open_year_for_write(sqlite3 *conn, const char *db_path, int year) {
+    char dir[256];
+    archive_dir(db_path, dir, sizeof(dir));
+    db_make_dir(dir);
+    if (attach_year(conn, db_path, year) != 0) return 1;
+
+    char sql[640];
+    snprintf(sql, sizeof(sql),
+        "PRAGMA archive_%04d.journal_mode=WAL;"
+        "PRAGMA archive_%04d.synchronous=%s;"
+        "CREATE TABLE IF NOT EXISTS archive_%04d.Attendance ("
+        "attendance_id INTEGER PRIMARY KEY,"
+        "member_id INTEGER,"
+        "date TEXT,"
+        "status TEXT,"
+        "checked_in_at INTEGER,"
+        "checked_out_at INTEGER,"
+        "zone TEXT);"
+        "CREATE INDEX IF NOT EXISTS archive_%04d.idx_attendance_member_date ON Attendance(member_id, date);"
+        "CREATE INDEX IF NOT EXISTS archive_%04d.idx_attendance_date ON Attendance(date);",
+        year, year, config_get()->synchronous, year, year, year);
+    return exec_sql(conn, sql, "archive schema");
+}
+
+// Fold the archive's WAL back in and detach it, leaving one plain file
+static int close_year(sqlite3 *conn, int year) {
+    char sql[128];
+    snprintf(sql, sizeof(sql), "PRAGMA archive_%04d.journal_mode=DELETE; DETACH DATABASE archive_%04d;", year, year);
+    return exec_sql(conn, sql, "detach");
+}
+
+// One batch: copy up to batch_rows of the year's due visits, oldest first
+// along idx_attendance_date, then delete them from the hot table. Returns
+// the rows moved, -1 on error.
+static int move_batch(sqlite3 *conn, int year, const char *cutoff, int batch_rows) {
+    char first_day[24], next_year[24], insert_sql[512];
+    snprintf(first_day, sizeof(first_day), "%04d-01-01", year);
+    snprintf(next_year, sizeof(next_year), "%04d-01-01", year + 1);
+    snprintf(insert_sql, sizeof(insert_sql),
+        "INSERT OR IGNORE INTO archive_%04d.Attendance (" ATTENDANCE_COLUMNS ") "
+        "SELECT " ATTENDANCE_COLUMNS " FROM main.Attendance "
+        "WHERE date < ?1 AND date >= ?2 AND date < ?3 ORDER BY date, attendance_id LIMIT ?4;", year);
+    static const char *delete_sql =
+        "DELETE FROM main.Attendance WHERE attendance_id IN ("
+        "SELECT attendance_id FROM main.Attendance "
+        "WHERE date < ?1 AND date >= ?2 AND date < ?3 ORDER BY date, attendance_id LIMIT ?4);";
+
+    // IMMEDIATE: both statements see the same rows, no check-in can slip in between
+    if (exec_sql(conn, "BEGIN IMMEDIATE;", "begin") != 0) return -1;
+    const char *sqls[2] = { insert_sql, delete_sql };
+    int moved = -1;
+    for (int i = 0; i < 2; i++) {
+        sqlite3_stmt *stmt;
+        if (sqlite3_prepare_v2(conn, sqls[i], -1, &stmt, 0) != SQLITE_OK) {
+            fprintf(stderr, "Archive: %s\n", sqlite3_errmsg(conn));
+            moved = -1;
+            break;
+        }
+        sqlite3_bind_text(stmt, 1, cutoff, -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 2, first_day, -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 3, next_year, -1, SQLITE_STATIC);
+        sqlite3_bind_int(stmt, 4, batch_rows);
+        int rc = sqlite3_step(stmt);
+        sqlite3_finalize(stmt);
+        if (rc != SQLITE_DONE) {
+            fprintf(stderr, "Archive: %s\n", sqlite3_errmsg(conn));
+            moved = -1;
+            break;
+        }
+        moved = sqlite3_changes(conn);
+    }
+    // This connection has no change triggers: tell every instance, this one
+    // included, that visits left the hot table
+    if (moved > 0 && changes_bump(conn, CHANGE_ATTENDANCE) != 0) {
+        fprintf(stderr, "Archive: %s\n", sqlite3_errmsg(conn));
+        moved = -1;
+    }
+    if (moved < 0) {
+        sqlite3_exec(conn, "ROLLBACK;", 0, 0, 0);
+        return -1;
+    }
+    return exec_sql(conn, "COMMIT;", "commit") == 0 ? moved : -1;
+}
+
+// ============================================
+// Archiving
+// ============================================
+
+// Move every visit dated more than horizon_days ago into its year's archive
+int archive_run(const char *db_path, int horizon_days, int batch_rows, ArchiveReport *report) {
+    memset(report, 0, sizeof(*report));
+    if (batch_rows < 1) batch_rows = ARCHIVE_BATCH_ROWS;
+
+    // Attached databases inherit the open flags: CREATE lets a new year's file be made
+    sqlite3 *conn = NULL;
+    if (sqlite3_open_v2(db_path, &conn, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, NULL) != SQLITE_OK) {
+        fprintf(stderr, "Archive: can't open %s: %s\n", db_path, sqlite3_errmsg(conn));
+        sqlite3_close(conn);
+        return 1;
+    }
+    sqlite3_busy_timeout(conn, config_get()->busy_timeout_ms);
+    char pragma[64];
+    snprintf(pragma, sizeof(pragma), "PRAGMA synchronous=%s;", config_get()->synchronous);
+    sqlite3_exec(conn, pragma, 0, 0, 0);
+
+    struct timespec start;
+    timespec_get(&start, TIME_UTC);
+
+    // Cut-off in the same local-date form the rows are stored in
+    sqlite3_stmt *stmt;
+    char modifier[32];
+    snprintf(modifier, sizeof(modifier), "-%d days", horizon_days);
+    if (sqlite3_prepare_v2(conn, "SELECT date('now', 'localtime', ?);", -1, &stmt, 0) == SQLITE_OK) {
+        sqlite3_bind_text(stmt, 1, modifier, -1, SQLITE_STATIC);
+        if (sqlite3_step(stmt) == SQLITE_ROW) {
+            snprintf(report->cutoff, sizeof(report->cutoff), "%s", (const char*)sqlite3_column_text(stmt, 0));
+        }
+        sqlite3_finalize(stmt);
+    }
+
+    int rc = report->cutoff[0] ? 0 : 1;
+    int attached = 0;
+    while (rc == 0) {
+        int year = oldest_due_year(conn, report->cutoff);
+        if (year < 0) rc = 1;
+        if (year <= 0) break;
+
+        if (year != attached) {
+            if (attached && close_year(conn, attached) != 0) { rc = 1; break; }
+            attached = 0;
+            if (open_year_for_write(conn, db_path, year) != 0) { rc = 1; break; }
+            attached = year;
+            report->years++;
+        }
+
+        int moved = move_batch(conn, year, report->cutoff, batch_rows);
+        if (moved < 0) { rc = 1; break; }
+        report->rows += moved;
+        report->batches++;
+        sqlite3_sleep(ARCHIVE_BATCH_SLEEP_MS);
+    }
+    if (attached && close_year(conn, attached) != 0) rc = 1;
+
+    sqlite3_close(conn);
+    struct timespec now;
+    timespec_get(&now, TIME_UTC);
+    report->seconds = (now.tv_sec - start.tv_sec) + (now.tv_nsec - start.tv_nsec) / 1e9;
+    return rc;
+}
+
+static char background_path[256];
+
+static void* archive_thread(void *arg) {
+    const Config *config = config_get();
+    ArchiveReport report;
+    if (archive_run(background_path, config->archive_horizon_days, config->archive_batch_rows, &report) == 0 &&
+        report.rows > 0) {
+        printf("Archived %ld visits before %s (%d batches, %d years, %.2f s)\n",
+            report.rows, report.cutoff, report.batches, report.years, report.seconds);
+    }
+    atomic_store(&background_running, 0);
+    return NULL;
+}
+
+// Archive the open branch on a background thread (skipped if one is running)
+int archive_start_background() {
+    int expected = 0;
+    if (!atomic_compare_exchange_strong(&background_running, &expected, 1)) return 1;
+
+    snprintf(background_path, sizeof(background_path), "%s", db_get_path());
+
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, archive_thread, NULL) != 0) {
+        atomic_store(&background_running, 0);
+        return 1;
+    }
+    pthread_detach(thread);
+    return 0;
+}
+
+// ============================================
+// Reading Archives
+// ============================================
+
+// Attach the archives overlapping from_date..to_date (either may be NULL for
+// an open end) and create the TEMP view AttendanceAll over them and the hot
+// table. Returns the number of archives attached, -1 on error.
+int archive_attach(sqlite3 *conn, const char *db_path, const char *from_date, const char *to_date) {
+    archive_detach(conn);
+
+    int from_year = from_date ? atoi(from_date) : 0;
+    int to_year = to_date ? atoi(to_date) : 9999;
+    int years[ARCHIVE_MAX_YEARS];
+    int count = list_years(db_path, from_year, to_year, years, ARCHIVE_MAX_YEARS);
+
+    // SQLite caps attached databases per connection (10 by default)
+    int limit = sqlite3_limit(conn, SQLITE_LIMIT_ATTACHED, -1);
+    if (count > limit) {
+        fprintf(stderr, "Archive: range spans %d archived years, at most %d can be attached\n", count, limit);
+        return -1;
+    }
+
+    size_t size = 256 + (size_t)count * 160;
+    char *view = malloc(size);
+    if (!view) return -1;
+    // Oldest archive first, the hot table last
+    int len = snprintf(view, size, "CREATE TEMP VIEW AttendanceAll AS ");
+    for (int i = 0; i < count; i++) {
+        if (attach_year(conn, db_path, years[i]) != 0) {
+            free(view);
+            archive_detach(conn);
+            return -1;
+        }
+        len += snprintf(view + len, size - len, "SELECT " ATTENDANCE_COLUMNS " FROM archive_%04d.Attendance UNION ALL ",
+            years[i]);
+    }
+    snprintf(view + len, size - len, "SELECT " ATTENDANCE_COLUMNS " FROM main.Attendance;");
+    int rc = exec_sql(conn, view, "archive view");
+    free(view);
+    if (rc != 0) {
+        archive_detach(conn);
+        return -1;
+    }
+    return count;
+}
+
+// Drop AttendanceAll and detach every archive
+void archive_detach(sqlite3 *conn) {
+    sqlite3_exec(conn, "DROP VIEW IF EXISTS temp.AttendanceAll;", 0, 0, 0);
+
+    char names[ARCHIVE_MAX_YEARS][32];
+    int count = 0;
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(conn, "PRAGMA database_list;", -1, &stmt, 0) != SQLITE_OK) return;
+    while (sqlite3_step(stmt) == SQLITE_ROW && count < ARCHIVE_MAX_YEARS) {
+        const char *name = (const char*)sqlite3_column_text(stmt, 1);
+        if (name && strncmp(name, "archive_", 8) == 0) snprintf(names[count++], sizeof(names[0]), "%s", name);
+    }
+    sqlite3_finalize(stmt);
+
+    for (int i = 0; i < count; i++) {
+        char sql[64];
+        snprintf(sql, sizeof(sql), "DETACH DATABASE %.31s;", names[i]);
+        sqlite3_exec(conn, sql, 0, 0, 0);
+    }
+}
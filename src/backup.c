@@ -0,0 +1,234 @@
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sqlite3.h>
+#include "backup.h"
+#include "database.h"
+#include "config.h"
+
+// ============================================
+// Helpers
+// ============================================
+
+static atomic_int background_running;
+
+static double seconds_since(const struct timespec *start) {
+    struct timespec now;
+    timespec_get(&now, TIME_UTC);
+    return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static void finish_report(BackupReport *report, sqlite3 *dest, const struct timespec *start) {
+    int page_size = 4096;
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(dest, "PRAGMA page_size;", -1, &stmt, 0) == SQLITE_OK) {
+        if (sqlite3_step(stmt) == SQLITE_ROW) page_size = sqlite3_column_int(stmt, 0);
+        sqlite3_finalize(stmt);
+    }
+    report->bytes = (long long)report->pages * page_size;
+    report->seconds = seconds_since(start);
+    report->mb_per_s = report->seconds > 0 ? report->bytes / report->seconds / 1e6 : 0;
+}
+
+// Delete a database file with its -wal and -shm sidecars, so a stale WAL
+// can never be replayed into a new file of the same name
+static void remove_database(const char *path) {
+    char sidecar[320];
+    remove(path);
+    snprintf(sidecar, sizeof(sidecar), "%s-wal", path);
+    remove(sidecar);
+    snprintf(sidecar, sizeof(sidecar), "%s-shm", path);
+    remove(sidecar);
+}
+
+// ============================================
+// Backup
+// ============================================
+
+// Copy src_path to dest_path while the app keeps writing. The copy is built
+// as <dest>.partial, switched out of WAL mode so it is one self-contained
+// file, verified, and only then renamed into place.
+int backup_run(const char *src_path, const char *dest_path, int step_pages, BackupReport *report) {
+    memset(report, 0, sizeof(*report));
+    snprintf(report->path, sizeof(report->path), "%s", dest_path);
+
+    char partial[300];
+    snprintf(partial, sizeof(partial), "%s.partial", dest_path);
+    remove_database(partial);
+
+    sqlite3 *src = NULL, *dest = NULL;
+    if (sqlite3_open_v2(src_path, &src, SQLITE_OPEN_READONLY, NULL) != SQLITE_OK ||
+        sqlite3_open(partial, &dest) != SQLITE_OK) {
+        fprintf(stderr, "Backup: can't open databases: %s\n", sqlite3_errmsg(src));
+        sqlite3_close(src);
+        sqlite3_close(dest);
+        return 1;
+    }
+
+    struct timespec start;
+    timespec_get(&start, TIME_UTC);
+
+    // Pin a WAL read snapshot for the whole copy. Writers carry on against
+    // the WAL, and the backup never restarts because the source changed.
+    sqlite3_busy_timeout(src, 5000);
+    sqlite3_exec(src, "BEGIN; SELECT COUNT(*) FROM sqlite_master;", 0, 0, 0);
+
+    sqlite3_backup *backup = sqlite3_backup_init(dest, "main", src, "main");
+    int rc = backup ? SQLITE_OK : SQLITE_ERROR;
+    while (backup) {
+        rc = sqlite3_backup_step(backup, step_pages);
+        report->steps++;
+        if (rc == SQLITE_DONE) break;
+        if (rc != SQLITE_OK && rc != SQLITE_BUSY && rc != SQLITE_LOCKED) break;
+        // Give writers the database between steps
+        sqlite3_sleep(BACKUP_STEP_SLEEP_MS);
+    }
+    if (backup) {
+        report->pages = sqlite3_backup_pagecount(backup);
+        sqlite3_backup_finish(backup);
+    }
+    sqlite3_exec(src, "COMMIT;", 0, 0, 0);
+
+    // The copy inherits WAL mode from the source; checkpoint it into the
+    // main file and switch to a rollback journal, which leaves no sidecars
+    if (rc == SQLITE_DONE && sqlite3_exec(dest, "PRAGMA journal_mode=DELETE;", 0, 0, 0) != SQLITE_OK) {
+        rc = SQLITE_ERROR;
+    }
+    finish_report(report, dest, &start);
+    sqlite3_close(dest);
+    sqlite3_close(src);
+
+    if (rc != SQLITE_DONE || backup_verify(partial) != 0) {
+        fprintf(stderr, "Backup failed (%s).\n", rc == SQLITE_DONE ? "verification" : sqlite3_errstr(rc));
+        remove_database(partial);
+        return 1;
+    }
+
+    remove_database(dest_path);
+    if (rename(partial, dest_path) != 0) {
+        fprintf(stderr, "Backup: can't move %s into place.\n", partial);
+        remove_database(partial);
+        return 1;
+    }
+    // Opening the partial file for the check may have left sidecars
+    remove_database(partial);
+    return 0;
+}
+
+// Check a database file with SQLite's integrity check
+int backup_verify(const char *path) {
+    sqlite3 *conn = NULL;
+    if (sqlite3_open_v2(path, &conn, SQLITE_OPEN_READONLY, NULL) != SQLITE_OK) {
+        sqlite3_close(conn);
+        return 1;
+    }
+
+    int ok = 0;
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(conn, "PRAGMA integrity_check;", -1, &stmt, 0) == SQLITE_OK) {
+        ok = sqlite3_step(stmt) == SQLITE_ROW && strcmp((const char*)sqlite3_column_text(stmt, 0), "ok") == 0;
+        sqlite3_finalize(stmt);
+    }
+    // Must look like one of our databases, not just any SQLite file
+    if (ok && sqlite3_prepare_v2(conn, "SELECT COUNT(*) FROM Users;", -1, &stmt, 0) == SQLITE_OK) {
+        ok = sqlite3_step(stmt) == SQLITE_ROW;
+        sqlite3_finalize(stmt);
+    } else {
+        ok = 0;
+    }
+    sqlite3_close(conn);
+    return ok ? 0 : 1;
+}
+
+// ============================================
+// Restore
+// ============================================
+
+// Replace the open branch database with a verified backup. Runs as one
+// backup step (all pages at once): restores are offline, so speed wins.
+int backup_restore(const char *backup_path, BackupReport *report) {
+    memset(report, 0, sizeof(*report));
+    snprintf(report->path, sizeof(report->path), "%s", db_get_path());
+
+    if (backup_verify(backup_path) != 0) {
+        fprintf(stderr, "Restore: %s failed verification.\n", backup_path);
+        return 1;
+    }
+
+    sqlite3 *src = NULL;
+    if (sqlite3_open_v2(backup_path, &src, SQLITE_OPEN_READONLY, NULL) != SQLITE_OK) {
+        sqlite3_close(src);
+        return 1;
+    }
+
+    struct timespec start;
+    timespec_get(&start, TIME_UTC);
+
+    sqlite3 *dest = db_get_handle();
+    sqlite3_backup *backup = sqlite3_backup_init(dest, "main", src, "main");
+    int rc = SQLITE_ERROR;
+    if (backup) {
+        rc = sqlite3_backup_step(backup, -1);
+        report->pages = sqlite3_backup_pagecount(backup);
+        report->steps = 1;
+        sqlite3_backup_finish(backup);
+    }
+    finish_report(report, dest, &start);
+    sqlite3_close(src);
+
+    if (rc != SQLITE_DONE) {
+        fprintf(stderr, "Restore failed: %s\n", sqlite3_errmsg(dest));
+        return 1;
+    }
+    return 0;
+}
+
+// ============================================
+// Scheduled Backups
+// ============================================
+
+// <backup dir>/<branch>-<timestamp>.db (database/backups by default)
+void backup_default_path(char *path, size_t size) {
+    time_t now = time(NULL);
+    char stamp[32];
+    strftime(stamp, sizeof(stamp), "%Y%m%d-%H%M%S", localtime(&now));
+    const char *dir = config_get()->backup_dir;
+    db_make_dir(dir);
+    snprintf(path, size, "%s/%s-%s.db", dir, db_get_branch(), stamp);
+}
+
+typedef struct {
+    char src[256];
+    char dest[256];
+} BackupJob;
+
+static BackupJob background_job;
+
+static void* backup_thread(void *arg) {
+    BackupReport report;
+    if (backup_run(background_job.src, background_job.dest, config_get()->backup_step_pages, &report) == 0) {
+        printf("Backup written to %s (%d pages, %.2f s, %.1f MB/s)\n",
+            report.path, report.pages, report.seconds, report.mb_per_s);
+    }
+    atomic_store(&background_running, 0);
+    return NULL;
+}
+
+// Back up the open branch on a background thread (skipped if one is running)
+int backup_start_background() {
+    int expected = 0;
+    if (!atomic_compare_exchange_strong(&background_running, &expected, 1)) return 1;
+
+    snprintf(background_job.src, sizeof(background_job.src), "%s", db_get_path());
+    backup_default_path(background_job.dest, sizeof(background_job.dest));
+
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, backup_thread, NULL) != 0) {
+        atomic_store(&background_running, 0);
+        return 1;
+    }
+    pthread_detach(thread);
+    return 0;
+}
@@ -0,0 +1,206 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "balance.h"
+#include "database.h"
+#include "catalog.h"
+
+// ============================================
+// Solver State
+// ============================================
+
+typedef struct {
+    int member_id;
+    int trainer_id;     // Current assignment (0 = none)
+    int slot;           // Catalog slot index; slot_count = unknown slot
+    int assigned;       // Index into trainers[] chosen by the solver (-1 = pending)
+} BalanceMember;
+
+typedef struct {
+    BalanceMember *items;
+    int count;
+    int capacity;
+    int failed;             // A member could not be stored
+} MemberArray;
+
+static double elapsed_ms(const struct timespec *start) {
+    struct timespec now;
+    timespec_get(&now, TIME_UTC);
+    return (now.tv_sec - start->tv_sec) * 1000.0 + (now.tv_nsec - start->tv_nsec) / 1e6;
+}
+
+static void collect_member(int member_id, int trainer_id, const char *time_slot, void *ctx) {
+    MemberArray *arr = ctx;
+    if (arr->count == arr->capacity) {
+        int capacity = arr->capacity ? arr->capacity * 2 : 1024;
+        BalanceMember *grown = realloc(arr->items, sizeof(BalanceMember) * capacity);
+        if (!grown) {
+            arr->failed = 1;
+            return;
+        }
+        arr->items = grown;
+        arr->capacity = capacity;
+    }
+
+    const Catalog *catalog = catalog_get();
+    int slot = catalog->slot_count;
+    for (int s = 0; s < catalog->slot_count; s++) {
+        if (strcmp(catalog->slots[s].label, time_slot) == 0) slot = s;
+    }
+
+    BalanceMember *m = &arr->items[arr->count++];
+    m->member_id = member_id;
+    m->trainer_id = trainer_id;
+    m->slot = slot;
+    m->assigned = -1;
+}
+
+static int compare_trainer_id(const void *a, const void *b) {
+    return ((const Trainer*)a)->trainer_id - ((const Trainer*)b)->trainer_id;
+}
+
+// ============================================
+// Trainer Heap (min slot load, then min total load)
+// ============================================
+
+static int *slot_load;      // [trainer] load in the slot being solved
+static int *total_load;     // [trainer] load across all slots
+
+static int trainer_less(int a, int b) {
+    if (slot_load[a] != slot_load[b]) return slot_load[a] < slot_load[b];
+    if (total_load[a] != total_load[b]) return total_load[a] < total_load[b];
+    return a < b;
+}
+
+static void heap_sift_down(int *heap, int size, int i) {
+    for (;;) {
+        int best = i, left = 2 * i + 1, right = 2 * i + 2;
+        if (left < size && trainer_less(heap[left], heap[best])) best = left;
+        if (right < size && trainer_less(heap[right], heap[best])) best = right;
+        if (best == i) return;
+        int tmp = heap[i]; heap[i] = heap[best]; heap[best] = tmp;
+        i = best;
+    }
+}
+
+// ============================================
+// Solver
+// ============================================
+
+// Assign every member to a trainer, slot by slot. Returns the number of
+// members whose trainer changes, listed in moved_ids/moved_trainers.
+static int solve(MemberArray *members, Trainer *trainer_rows, int trainer_count, int slot_count,
+                 int *heap, int *slot_size, int *moved_ids, int *moved_trainers) {
+    for (int i = 0; i < members->count; i++) slot_size[members->items[i].slot]++;
+    int total_cap = (members->count + trainer_count - 1) / trainer_count;
+
+    // Sorted by id so current assignments can be mapped with a binary search
+    qsort(trainer_rows, trainer_count, sizeof(Trainer), compare_trainer_id);
+
+    for (int s = 0; s < slot_count; s++) {
+        if (slot_size[s] == 0) continue;
+        int slot_cap = (slot_size[s] + trainer_count - 1) / trainer_count;
+        memset(slot_load, 0, sizeof(int) * trainer_count);
+
+        // Pass 1: keep current assignments that fit within both caps
+        for (int i = 0; i < members->count; i++) {
+            BalanceMember *m = &members->items[i];
+            if (m->slot != s || m->trainer_id == 0) continue;
+            Trainer key = { .trainer_id = m->trainer_id };
+            Trainer *found = bsearch(&key, trainer_rows, trainer_count, sizeof(Trainer), compare_trainer_id);
+            if (!found) continue;
+            int t = (int)(found - trainer_rows);
+            if (slot_load[t] < slot_cap && total_load[t] < total_cap) {
+                m->assigned = t;
+                slot_load[t]++;
+                total_load[t]++;
+            }
+        }
+
+        // Pass 2: hand the rest to the least-loaded trainer
+        for (int t = 0; t < trainer_count; t++) heap[t] = t;
+        for (int t = trainer_count / 2 - 1; t >= 0; t--) heap_sift_down(heap, trainer_count, t);
+        for (int i = 0; i < members->count; i++) {
+            BalanceMember *m = &members->items[i];
+            if (m->slot != s || m->assigned >= 0) continue;
+            int t = heap[0];
+            m->assigned = t;
+            slot_load[t]++;
+            total_load[t]++;
+            heap_sift_down(heap, trainer_count, 0);
+        }
+    }
+
+    int moved = 0;
+    for (int i = 0; i < members->count; i++) {
+        BalanceMember *m = &members->items[i];
+        int trainer_id = trainer_rows[m->assigned].trainer_id;
+        if (trainer_id != m->trainer_id) {
+            moved_ids[moved] = m->member_id;
+            moved_trainers[moved] = trainer_id;
+            moved++;
+        }
+    }
+    return moved;
+}
+
+// Compute and commit a balanced assignment in one transaction. Returns 1
+// on a database error or when memory runs out.
+int balance_trainers(BalanceResult *result) {
+    memset(result, 0, sizeof(*result));
+    struct timespec start;
+    timespec_get(&start, TIME_UTC);
+
+    Trainer *trainer_rows = malloc(sizeof(Trainer) * MAX_BALANCE_TRAINERS);
+    int trainer_count = MAX_BALANCE_TRAINERS;
+    MemberArray members = { NULL, 0, 0, 0 };
+    if (!trainer_rows || db_get_available_trainers("", trainer_rows, &trainer_count) != 0 ||
+        db_for_each_plan_member(collect_member, &members) != 0 || members.failed) {
+        free(trainer_rows);
+        free(members.items);
+        return 1;
+    }
+    result->members = members.count;
+    result->trainers = trainer_count;
+    if (trainer_count == 0) {
+        free(trainer_rows);
+        free(members.items);
+        return 0;
+    }
+
+    int slot_count = catalog_get()->slot_count + 1;
+    slot_load = calloc(trainer_count, sizeof(int));
+    total_load = calloc(trainer_count, sizeof(int));
+    int *heap = malloc(sizeof(int) * trainer_count);
+    int *slot_size = calloc(slot_count, sizeof(int));
+    int *moved_ids = malloc(sizeof(int) * (members.count + 1));
+    int *moved_trainers = malloc(sizeof(int) * (members.count + 1));
+
+    int rc = 1;
+    if (slot_load && total_load && heap && slot_size && moved_ids && moved_trainers) {
+        int moved = solve(&members, trainer_rows, trainer_count, slot_count, heap, slot_size, moved_ids, moved_trainers);
+        result->moved = moved;
+        result->min_load = result->max_load = total_load[0];
+        for (int t = 1; t < trainer_count; t++) {
+            if (total_load[t] < result->min_load) result->min_load = total_load[t];
+            if (total_load[t] > result->max_load) result->max_load = total_load[t];
+        }
+        result->solve_ms = elapsed_ms(&start);
+
+        struct timespec commit_start;
+        timespec_get(&commit_start, TIME_UTC);
+        rc = moved > 0 ? db_assign_trainers_bulk(moved_ids, moved_trainers, moved) : 0;
+        result->commit_ms = elapsed_ms(&commit_start);
+    }
+
+    free(slot_load);
+    free(total_load);
+    free(heap);
+    free(slot_size);
+    free(moved_ids);
+    free(moved_trainers);
+    free(trainer_rows);
+    free(members.items);
+    return rc;
+}
@@ -0,0 +1,321 @@
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "booking.h"
+
+// ============================================
+// Write Transactions with Backoff
+// ============================================
+
+// xorshift32; one state per caller so threads never share it
+static unsigned next_random(unsigned *state) {
+    unsigned x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *state = x ? x : 0x9e3779b9u;
+}
+
+// Sleep for a random time in [delay/2, delay], doubling delay per attempt
+static void backoff(int attempt, unsigned *seed) {
+    long delay = BOOKING_BACKOFF_MIN_US;
+    for (int i = 0; i < attempt && delay < BOOKING_BACKOFF_MAX_US; i++) delay *= 2;
+    if (delay > BOOKING_BACKOFF_MAX_US) delay = BOOKING_BACKOFF_MAX_US;
+    usleep((useconds_t)(delay / 2 + next_random(seed) % (delay / 2 + 1)));
+}
+
+static int is_busy(int rc) {
+    rc &= 0xff;
+    return rc == SQLITE_BUSY || rc == SQLITE_LOCKED;
+}
+
+// Take the write lock, retrying with backoff. Returns SQLITE_OK or the
+// last error; *retries counts the failed attempts.
+static int begin_immediate(sqlite3 *conn, unsigned *seed, int *retries) {
+    int rc = SQLITE_BUSY;
+    for (int attempt = 0; attempt <= BOOKING_MAX_RETRIES; attempt++) {
+        rc = sqlite3_exec(conn, "BEGIN IMMEDIATE;", 0, 0, 0);
+        if (!is_busy(rc)) return rc;
+        (*retries)++;
+        backoff(attempt, seed);
+    }
+    return rc;
+}
+
+// Commit; a busy COMMIT keeps the transaction open and can be retried
+static int commit(sqlite3 *conn, unsigned *seed, int *retries) {
+    int rc = SQLITE_BUSY;
+    for (int attempt = 0; attempt <= BOOKING_MAX_RETRIES; attempt++) {
+        rc = sqlite3_exec(conn, "COMMIT;", 0, 0, 0);
+        if (!is_busy(rc)) break;
+        (*retries)++;
+        backoff(attempt, seed);
+    }
+    if (rc != SQLITE_OK) sqlite3_exec(conn, "ROLLBACK;", 0, 0, 0);
+    return rc;
+}
+
+static unsigned seed_for(int class_id, int member_id) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    unsigned seed = (unsigned)ts.tv_nsec ^ ((unsigned)member_id * 2654435761u) ^ (unsigned)class_id;
+    return seed ? seed : 1;
+}
+
+// Run a statement that returns at most one integer row; -1 if no row
+static int step_int(sqlite3_stmt *stmt, int *rc) {
+    *rc = sqlite3_step(stmt);
+    int value = *rc == SQLITE_ROW ? sqlite3_column_int(stmt, 0) : -1;
+    if (*rc == SQLITE_ROW) *rc = sqlite3_step(stmt);     // Finish RETURNING
+    sqlite3_reset(stmt);
+    return value;
+}
+
+static void finalize_all(sqlite3_stmt **stmts, int count) {
+    for (int i = 0; i < count; i++) sqlite3_finalize(stmts[i]);
+}
+
+// ============================================
+// Public API
+// ============================================
+
+// Schedule a class; *class_id receives the new id
+int booking_create_class(sqlite3 *conn, const char *name, int trainer_id, long long starts_at,
+                         int duration_minutes, int capacity, int *class_id) {
+    if (capacity < 1 || duration_minutes < 1 || !name[0]) return 1;
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(conn,
+        "INSERT INTO Classes (name, trainer_id, starts_at, duration_minutes, capacity) VALUES (?, ?, ?, ?, ?);",
+        -1, &stmt, 0) != SQLITE_OK) return 1;
+    sqlite3_bind_text(stmt, 1, name, -1, SQLITE_STATIC);
+    if (trainer_id > 0) sqlite3_bind_int(stmt, 2, trainer_id);
+    sqlite3_bind_int64(stmt, 3, starts_at);
+    sqlite3_bind_int(stmt, 4, duration_minutes);
+    sqlite3_bind_int(stmt, 5, capacity);
+    int rc = sqlite3_step(stmt) == SQLITE_DONE ? 0 : 1;
+    sqlite3_finalize(stmt);
+    if (rc == 0 && class_id) *class_id = (int)sqlite3_last_insert_rowid(conn);
+    return rc;
+}
+
+// Take a seat in a class, or a place on its waitlist when it is full.
+// *position is the waitlist position (0 when booked); *retries (optional)
+// counts lock retries.
+BookingResult booking_reserve(sqlite3 *conn, int class_id, int member_id, int *position, int *retries) {
+    enum { TAKE_SEAT, ADD_SEAT_ROW, JOIN_WAITLIST, ADD_WAIT_ROW, ALREADY_HELD, STMT_COUNT };
+    static const char *sql[STMT_COUNT] = {
+        "UPDATE Classes SET booked=booked+1 WHERE class_id=?1 AND booked<capacity AND starts_at>?2 "
+        "AND NOT EXISTS (SELECT 1 FROM Bookings WHERE class_id=?1 AND member_id=?3);",
+        "INSERT INTO Bookings (class_id, member_id, status, seq, booked_at) VALUES (?1, ?3, 'BOOKED', 0, ?2);",
+        "UPDATE Classes SET waitlisted=waitlisted+1, waitlist_seq=waitlist_seq+1 WHERE class_id=?1 AND starts_at>?2 "
+        "AND NOT EXISTS (SELECT 1 FROM Bookings WHERE class_id=?1 AND member_id=?3) RETURNING waitlist_seq, waitlisted;",
+        "INSERT INTO Bookings (class_id, member_id, status, seq, booked_at) VALUES (?1, ?3, 'WAITLISTED', ?4, ?2);",
+        "SELECT 1 FROM Bookings WHERE class_id=?1 AND member_id=?3;",
+    };
+    int local_retries = 0;
+    if (!retries) retries = &local_retries;
+    *position = 0;
+
+    // Prepare and bind everything before taking the write lock
+    sqlite3_stmt *stmts[STMT_COUNT] = {0};
+    long long now = (long long)time(NULL);
+    for (int i = 0; i < STMT_COUNT; i++) {
+        if (sqlite3_prepare_v2(conn, sql[i], -1, &stmts[i], 0) != SQLITE_OK) {
+            finalize_all(stmts, STMT_COUNT);
+            return BOOKING_ERROR;
+        }
+        sqlite3_bind_int(stmts[i], 1, class_id);
+        sqlite3_bind_int64(stmts[i], 2, now);
+        sqlite3_bind_int(stmts[i], 3, member_id);
+    }
+
+    unsigned seed = seed_for(class_id, member_id);
+    int rc = begin_immediate(conn, &seed, retries);
+    if (rc != SQLITE_OK) {
+        finalize_all(stmts, STMT_COUNT);
+        return is_busy(rc) ? BOOKING_BUSY : BOOKING_ERROR;
+    }
+
+    BookingResult result = BOOKING_ERROR;
+    if (sqlite3_step(stmts[TAKE_SEAT]) != SQLITE_DONE) {
+        result = BOOKING_ERROR;
+    } else if (sqlite3_changes(conn) == 1) {
+        if (sqlite3_step(stmts[ADD_SEAT_ROW]) == SQLITE_DONE) result = BOOKING_BOOKED;
+    } else if (sqlite3_step(stmts[JOIN_WAITLIST]) == SQLITE_ROW) {
+        int seq = sqlite3_column_int(stmts[JOIN_WAITLIST], 0);
+        *position = sqlite3_column_int(stmts[JOIN_WAITLIST], 1);
+        sqlite3_step(stmts[JOIN_WAITLIST]);
+        sqlite3_bind_int(stmts[ADD_WAIT_ROW], 4, seq);
+        if (sqlite3_step(stmts[ADD_WAIT_ROW]) == SQLITE_DONE) result = BOOKING_WAITLISTED;
+    } else {
+        result = sqlite3_step(stmts[ALREADY_HELD]) == SQLITE_ROW ? BOOKING_ALREADY : BOOKING_CLOSED;
+    }
+    finalize_all(stmts, STMT_COUNT);
+
+    if (result == BOOKING_BOOKED || result == BOOKING_WAITLISTED) {
+        rc = commit(conn, &seed, retries);
+        if (rc != SQLITE_OK) result = is_busy(rc) ? BOOKING_BUSY : BOOKING_ERROR;
+    } else {
+        sqlite3_exec(conn, "ROLLBACK;", 0, 0, 0);
+    }
+    if (result != BOOKING_WAITLISTED) *position = 0;
+    return result;
+}
+
+// Statements shared by single cancellations and booking_release_member
+enum { DROP_ROW, PROMOTE, FREE_SEAT, LEAVE_WAITLIST, CANCEL_STMTS };
+
+static const char *cancel_sql[CANCEL_STMTS] = {
+    "DELETE FROM Bookings WHERE class_id=?1 AND member_id=?2 RETURNING status='BOOKED';",
+    "UPDATE Bookings SET status='BOOKED' WHERE class_id=?1 AND member_id=("
+    "SELECT member_id FROM Bookings WHERE class_id=?1 AND status='WAITLISTED' ORDER BY seq LIMIT 1) "
+    "RETURNING member_id;",
+    "UPDATE Classes SET booked=booked-1 WHERE class_id=?1;",
+    "UPDATE Classes SET waitlisted=waitlisted-1 WHERE class_id=?1;",
+};
+
+static int prepare_cancel(sqlite3 *conn, sqlite3_stmt **stmts) {
+    for (int i = 0; i < CANCEL_STMTS; i++) {
+        if (sqlite3_prepare_v2(conn, cancel_sql[i], -1, &stmts[i], 0) != SQLITE_OK) {
+            finalize_all(stmts, CANCEL_STMTS);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void bind_cancel(sqlite3_stmt **stmts, int class_id, int member_id) {
+    for (int i = 0; i < CANCEL_STMTS; i++) {
+        sqlite3_bind_int(stmts[i], 1, class_id);
+        sqlite3_bind_int(stmts[i], 2, member_id);
+    }
+}
+
+// Drop the booking and pass a freed seat on; the caller holds the write
+// lock and commits or rolls back
+static BookingResult cancel_steps(sqlite3_stmt **stmts, int *promoted_member) {
+    int step_rc;
+    *promoted_member = 0;
+    int was_booked = step_int(stmts[DROP_ROW], &step_rc);
+    if (was_booked < 0) return step_rc == SQLITE_DONE ? BOOKING_CLOSED : BOOKING_ERROR;
+    if (!was_booked) {
+        step_int(stmts[LEAVE_WAITLIST], &step_rc);
+        return step_rc == SQLITE_DONE ? BOOKING_WAITLISTED : BOOKING_ERROR;
+    }
+
+    // The seat passes to the next in line, or becomes free
+    int promoted = step_int(stmts[PROMOTE], &step_rc);
+    if (promoted > 0) {
+        *promoted_member = promoted;
+        step_int(stmts[LEAVE_WAITLIST], &step_rc);
+    } else if (step_rc == SQLITE_DONE) {
+        step_int(stmts[FREE_SEAT], &step_rc);
+    }
+    if (step_rc == SQLITE_DONE) return BOOKING_BOOKED;
+    *promoted_member = 0;
+    return BOOKING_ERROR;
+}
+
+// Give up a seat or waitlist place. A freed seat goes to the head of the
+// waitlist (*promoted_member, else 0). Returns BOOKING_BOOKED when a seat
+// was released, BOOKING_WAITLISTED when a waitlist place was, and
+// BOOKING_CLOSED when the member held neither.
+BookingResult booking_cancel(sqlite3 *conn, int class_id, int member_id, int *promoted_member, int *retries) {
+    int local_retries = 0;
+    if (!retries) retries = &local_retries;
+    *promoted_member = 0;
+
+    sqlite3_stmt *stmts[CANCEL_STMTS] = {0};
+    if (prepare_cancel(conn, stmts) != 0) return BOOKING_ERROR;
+    bind_cancel(stmts, class_id, member_id);
+
+    unsigned seed = seed_for(class_id, member_id);
+    int rc = begin_immediate(conn, &seed, retries);
+    if (rc != SQLITE_OK) {
+        finalize_all(stmts, CANCEL_STMTS);
+        return is_busy(rc) ? BOOKING_BUSY : BOOKING_ERROR;
+    }
+
+    BookingResult result = cancel_steps(stmts, promoted_member);
+    finalize_all(stmts, CANCEL_STMTS);
+
+    if (result == BOOKING_BOOKED || result == BOOKING_WAITLISTED) {
+        rc = commit(conn, &seed, retries);
+        if (rc != SQLITE_OK) result = is_busy(rc) ? BOOKING_BUSY : BOOKING_ERROR;
+    } else {
+        sqlite3_exec(conn, "ROLLBACK;", 0, 0, 0);
+    }
+    if (result != BOOKING_BOOKED) *promoted_member = 0;
+    return result;
+}
+
+// Cancel every booking the member holds, passing each seat down its
+// waitlist. Runs inside the caller's transaction and takes no lock of its
+// own; returns 0 on success, 1 on error (the caller rolls back).
+int booking_release_member(sqlite3 *conn, int member_id) {
+    sqlite3_stmt *next, *stmts[CANCEL_STMTS] = {0};
+    if (sqlite3_prepare_v2(conn, "SELECT class_id FROM Bookings WHERE member_id=? LIMIT 1;", -1, &next, 0) != SQLITE_OK)
+        return 1;
+    if (prepare_cancel(conn, stmts) != 0) {
+        sqlite3_finalize(next);
+        return 1;
+    }
+    sqlite3_bind_int(next, 1, member_id);
+
+    int rc, failed = 0, promoted;
+    while (!failed && (rc = sqlite3_step(next)) == SQLITE_ROW) {
+        int class_id = sqlite3_column_int(next, 0);
+        sqlite3_reset(next);
+        bind_cancel(stmts, class_id, member_id);
+        BookingResult result = cancel_steps(stmts, &promoted);
+        failed = result != BOOKING_BOOKED && result != BOOKING_WAITLISTED;
+    }
+    if (!failed && rc != SQLITE_DONE) failed = 1;
+    sqlite3_finalize(next);
+    finalize_all(stmts, CANCEL_STMTS);
+    return failed;
+}
+
+// Classes that have not started yet, soonest first, with the member's own
+// booking state. *count is the capacity of classes on entry.
+int booking_list_upcoming(sqlite3 *conn, int member_id, ClassInfo *classes, int *count) {
+    const char *sql =
+        "SELECT c.class_id, c.name, IFNULL(c.trainer_id, 0), IFNULL(u.name, ''), c.starts_at, c.duration_minutes, "
+        "c.capacity, c.booked, c.waitlisted, "
+        "CASE b.status WHEN 'BOOKED' THEN 1 WHEN 'WAITLISTED' THEN 2 ELSE 0 END, "
+        "CASE WHEN b.status='WAITLISTED' THEN (SELECT COUNT(*) FROM Bookings w "
+        "WHERE w.class_id=c.class_id AND w.status='WAITLISTED' AND w.seq<=b.seq) ELSE 0 END "
+        "FROM Classes c LEFT JOIN Users u ON u.user_id=c.trainer_id "
+        "LEFT JOIN Bookings b ON b.class_id=c.class_id AND b.member_id=?2 "
+        "WHERE c.starts_at>?1 ORDER BY c.starts_at LIMIT ?3;";
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(conn, sql, -1, &stmt, 0) != SQLITE_OK) return 1;
+    sqlite3_bind_int64(stmt, 1, (long long)time(NULL));
+    sqlite3_bind_int(stmt, 2, member_id);
+    sqlite3_bind_int(stmt, 3, *count);
+
+    int i = 0;
+    while (i < *count && sqlite3_step(stmt) == SQLITE_ROW) {
+        ClassInfo *info = &classes[i++];
+        info->class_id = sqlite3_column_int(stmt, 0);
+        snprintf(info->name, sizeof(info->name), "%s", sqlite3_column_text(stmt, 1));
+        info->trainer_id = sqlite3_column_int(stmt, 2);
+        snprintf(info->trainer_name, sizeof(info->trainer_name), "%s", sqlite3_column_text(stmt, 3));
+        info->starts_at = sqlite3_column_int64(stmt, 4);
+        info->duration_minutes = sqlite3_column_int(stmt, 5);
+        info->capacity = sqlite3_column_int(stmt, 6);
+        info->booked = sqlite3_column_int(stmt, 7);
+        info->waitlisted = sqlite3_column_int(stmt, 8);
+        info->my_status = sqlite3_column_int(stmt, 9);
+        info->my_position = sqlite3_column_int(stmt, 10);
+    }
+    *count = i;
+    sqlite3_finalize(stmt);
+    return 0;
+}
+
+const char* booking_result_name(BookingResult result) {
+    static const char *names[] = { "BOOKED", "WAITLISTED", "ALREADY", "CLOSED", "BUSY", "ERROR" };
+    return result >= BOOKING_BOOKED && result <= BOOKING_ERROR ? names[result] : "ERROR";
+}
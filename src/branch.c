@@ -0,0 +1,157 @@
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include <sqlite3.h>
+#include "branch.h"
+#include "config.h"
+
+// ============================================
+// Fan-out State
+// ============================================
+
+#define MAX_REPORT_THREADS 32    // Upper bound for threads.report_threads
+
+typedef struct {
+    BranchReport *reports;
+    int count;
+    int next;               // Next branch to pick up (guarded by lock)
+    BranchReport *total;
+    pthread_mutex_t lock;
+} ReportJob;
+
+// ============================================
+// Per-Branch Queries
+// ============================================
+
+// Run a single-value COUNT query
+static int query_int(sqlite3 *conn, const char *sql) {
+    sqlite3_stmt *stmt;
+    int value = 0;
+    if (sqlite3_prepare_v2(conn, sql, -1, &stmt, 0) != SQLITE_OK) return -1;
+    if (sqlite3_step(stmt) == SQLITE_ROW) value = sqlite3_column_int(stmt, 0);
+    sqlite3_finalize(stmt);
+    return value;
+}
+
+// Collect the figures of one branch on a private read-only connection
+static void report_branch(BranchReport *report) {
+    char path[256];
+    sqlite3 *conn = NULL;
+    report->error = 1;
+    if (db_branch_path(report->branch, path, sizeof(path)) != 0) return;
+    if (sqlite3_open_v2(path, &conn, SQLITE_OPEN_READONLY, NULL) != SQLITE_OK) {
+        sqlite3_close(conn);
+        return;
+    }
+    sqlite3_busy_timeout(conn, 2000);
+
+    // One read transaction so all figures come from the same snapshot
+    sqlite3_exec(conn, "BEGIN;", 0, 0, 0);
+    report->members = query_int(conn, "SELECT COUNT(*) FROM Members;");
+    report->active_members = query_int(conn, "SELECT COUNT(*) FROM Members WHERE plan_id > 0;");
+    report->trainers = query_int(conn, "SELECT COUNT(*) FROM Trainers WHERE status='APPROVED';");
+    report->pending_trainers = query_int(conn, "SELECT COUNT(*) FROM Trainers WHERE status='PENDING_APPROVAL';");
+
+    // Reads the legacy price column: branches this build has not opened yet
+    // have no price_cents. It is rounded to cents before summing.
+    const char *sql_plans =
+        "SELECT p.name, COUNT(m.member_id), COUNT(m.member_id) * CAST(ROUND(IFNULL(p.price, 0) * 100) AS INTEGER) "
+        "FROM Plans p LEFT JOIN Members m ON m.plan_id = p.plan_id GROUP BY p.plan_id ORDER BY p.plan_id;";
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(conn, sql_plans, -1, &stmt, 0) == SQLITE_OK) {
+        report->plan_count = 0;
+        report->monthly_revenue_cents = 0;
+        while (report->plan_count < MAX_REPORT_PLANS && sqlite3_step(stmt) == SQLITE_ROW) {
+            PlanTotal *plan = &report->plans[report->plan_count++];
+            snprintf(plan->name, sizeof(plan->name), "%s", sqlite3_column_text(stmt, 0));
+            plan->members = sqlite3_column_int(stmt, 1);
+            plan->revenue_cents = sqlite3_column_int64(stmt, 2);
+            report->monthly_revenue_cents += plan->revenue_cents;
+        }
+        sqlite3_finalize(stmt);
+        report->error = report->members < 0 || report->trainers < 0;
+    }
+    sqlite3_exec(conn, "COMMIT;", 0, 0, 0);
+    sqlite3_close(conn);
+}
+
+// Fold one branch into the combined report (plans are matched by name)
+static void merge_report(BranchReport *total, const BranchReport *report) {
+    total->members += report->members;
+    total->active_members += report->active_members;
+    total->trainers += report->trainers;
+    total->pending_trainers += report->pending_trainers;
+    total->monthly_revenue_cents += report->monthly_revenue_cents;
+
+    for (int i = 0; i < report->plan_count; i++) {
+        int j = 0;
+        while (j < total->plan_count && strcmp(total->plans[j].name, report->plans[i].name) != 0) j++;
+        if (j == total->plan_count) {
+            if (j == MAX_REPORT_PLANS) continue;
+            total->plans[j] = report->plans[i];
+            total->plan_count++;
+        } else {
+            total->plans[j].members += report->plans[i].members;
+            total->plans[j].revenue_cents += report->plans[i].revenue_cents;
+        }
+    }
+}
+
+// Worker: claim branches until none are left, merging each as it completes
+static void* report_worker(void *arg) {
+    ReportJob *job = arg;
+    for (;;) {
+        pthread_mutex_lock(&job->lock);
+        int i = job->next++;
+        pthread_mutex_unlock(&job->lock);
+        if (i >= job->count) break;
+
+        report_branch(&job->reports[i]);
+
+        if (!job->reports[i].error) {
+            pthread_mutex_lock(&job->lock);
+            merge_report(job->total, &job->reports[i]);
+            pthread_mutex_unlock(&job->lock);
+        }
+    }
+    return NULL;
+}
+
+// ============================================
+// Public API
+// ============================================
+
+// Build a report for every branch in parallel plus the combined total
+int branch_report_all(BranchReport *reports, int *count, BranchReport *total) {
+    char branches[MAX_BRANCHES][BRANCH_NAME_LEN];
+    int branch_count = MAX_BRANCHES < *count ? MAX_BRANCHES : *count;
+    db_list_branches(branches, &branch_count);
+
+    memset(reports, 0, sizeof(BranchReport) * branch_count);
+    memset(total, 0, sizeof(BranchReport));
+    snprintf(total->branch, sizeof(total->branch), "All Branches");
+    for (int i = 0; i < branch_count; i++) {
+        snprintf(reports[i].branch, sizeof(reports[i].branch), "%s", branches[i]);
+    }
+
+    ReportJob job = { reports, branch_count, 0, total };
+    pthread_mutex_init(&job.lock, NULL);
+
+    int threads = config_get()->report_threads;
+    if (threads > MAX_REPORT_THREADS) threads = MAX_REPORT_THREADS;
+    if (threads > branch_count) threads = branch_count;
+    pthread_t workers[MAX_REPORT_THREADS];
+    int started = 0;
+    for (int i = 0; i < threads; i++) {
+        if (pthread_create(&workers[started], NULL, report_worker, &job) == 0) started++;
+    }
+    // If no thread could be started, do the work on the calling thread
+    if (started == 0) report_worker(&job);
+    for (int i = 0; i < started; i++) {
+        pthread_join(workers[i], NULL);
+    }
+
+    pthread_mutex_destroy(&job.lock);
+    *count = branch_count;
+    return 0;
+}
@@ -0,0 +1,105 @@
+#include <stdio.h>
+#include <string.h>
+#include "catalog.h"
+#include "database.h"
+
+// ============================================
+// Compiled-in Defaults
+// ============================================
+
+static const Plan default_plans[] = {
+    {1, "Basic (Morning)",    3000, "Morning"},
+    {2, "Standard (Evening)", 5000, "Evening"},
+    {3, "Premium (Anytime)",  8000, "Full Day"},
+};
+
+static const TimeSlot default_slots[] = {
+    {"Morning",  "Morning (6-10)", 6,  10},
+    {"Evening",  "Evening (5-9)",  17, 21},
+    {"Full Day", "Full Day",       6,  22},
+};
+
+#define DEFAULT_PLAN_COUNT ((int)(sizeof(default_plans) / sizeof(default_plans[0])))
+#define DEFAULT_SLOT_COUNT ((int)(sizeof(default_slots) / sizeof(default_slots[0])))
+
+// ============================================
+// Catalog State
+// ============================================
+
+// Two buffers: a rebuild fills the idle one and then flips, so pointers
+// handed out from the previous version stay valid until the next rebuild.
+static Plan plan_buffers[2][MAX_PLANS];
+static Catalog catalogs[2];
+static int active = -1;
+static unsigned version = 1;
+
+// Rebuild the catalog: defaults first, then rows from Plans override by id
+static void catalog_load() {
+    int next = active == 0 ? 1 : 0;
+    Plan *plans = plan_buffers[next];
+
+    int count = DEFAULT_PLAN_COUNT;
+    memcpy(plans, default_plans, sizeof(default_plans));
+
+    Plan rows[MAX_PLANS];
+    int row_count = MAX_PLANS;
+    if (db_get_handle() && db_get_plans(rows, &row_count) == 0) {
+        for (int i = 0; i < row_count; i++) {
+            int j = 0;
+            while (j < count && plans[j].plan_id != rows[i].plan_id) j++;
+            if (j == count) {
+                if (count == MAX_PLANS) continue;
+                count++;
+            }
+            plans[j] = rows[i];
+        }
+    }
+
+    catalogs[next].plans = plans;
+    catalogs[next].plan_count = count;
+    catalogs[next].slots = default_slots;
+    catalogs[next].slot_count = DEFAULT_SLOT_COUNT;
+    catalogs[next].version = version;
+    active = next;
+}
+
+// ============================================
+// Public API
+// ============================================
+
+// Get the current catalog, rebuilding it only after a version bump
+const Catalog* catalog_get() {
+    if (active < 0 || catalogs[active].version != version) {
+        catalog_load();
+    }
+    return &catalogs[active];
+}
+
+// Invalidate the catalog; the next catalog_get() reloads it
+void catalog_bump_version() {
+    version++;
+}
+
+// Find a plan by id (NULL if unknown)
+const Plan* catalog_find_plan(int plan_id) {
+    const Catalog *catalog = catalog_get();
+    for (int i = 0; i < catalog->plan_count; i++) {
+        if (catalog->plans[i].plan_id == plan_id) return &catalog->plans[i];
+    }
+    return NULL;
+}
+
+// Find a time slot by its display label (NULL if unknown)
+const TimeSlot* catalog_find_slot(const char *label) {
+    const Catalog *catalog = catalog_get();
+    for (int i = 0; i < catalog->slot_count; i++) {
+        if (strcmp(catalog->slots[i].label, label) == 0) return &catalog->slots[i];
+    }
+    return NULL;
+}
+
+// Compiled-in default plans
+const Plan* catalog_default_plans(int *count) {
+    *count = DEFAULT_PLAN_COUNT;
+    return default_plans;
+}
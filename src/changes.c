@@ -0,0 +1,255 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "changes.h"
+#include "database.h"
+#include "catalog.h"
+#include "ledger.h"
+#include "gate.h"
+
+// ============================================
+// State
+// ============================================
+
+typedef struct {
+    unsigned tables;
+    ChangeCallback callback;
+    void *ctx;
+} Subscriber;
+
+static Subscriber subscribers[CHANGES_MAX_SUBSCRIBERS];
+static const char *table_names[CHANGE_TABLE_COUNT] = CHANGE_TABLE_NAMES;
+static long long seen_seq[CHANGE_TABLE_COUNT];
+static long long seen_data_version = -1;
+static char loaded_path[256] = "";
+
+// Sequence values this instance's own commits wrote and no poll has
+// accounted for yet. A full list is dropped and the table reported as
+// changed on the next poll, which is always safe.
+static long long own_seq[CHANGE_TABLE_COUNT][CHANGES_MAX_OWN];
+static int own_count[CHANGE_TABLE_COUNT];
+static unsigned own_overflow = 0;
+
+static int read_data_version(long long *version) {
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(db_get_handle(), "PRAGMA data_version;", -1, &stmt, 0) != SQLITE_OK) return 1;
+    int rc = 1;
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        *version = sqlite3_column_int64(stmt, 0);
+        rc = 0;
+    }
+    sqlite3_finalize(stmt);
+    return rc;
+}
+
+// Did this instance write every sequence value in (seen, seq]? Drops the
+// values a poll has now accounted for.
+static int only_own_writes(int table, long long seen, long long seq) {
+    int own = 0, kept = 0;
+    for (int i = 0; i < own_count[table]; i++) {
+        long long value = own_seq[table][i];
+        if (value > seen && value <= seq) own++;
+        if (value > seq) own_seq[table][kept++] = value;
+    }
+    own_count[table] = kept;
+    if (own_overflow & (1u << table)) {
+        own_overflow &= ~(1u << table);
+        return 0;
+    }
+    return own == seq - seen;
+}
+
+// Read the current sequences and return the tables that another instance
+// changed since the last poll
+static unsigned read_changes() {
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(db_get_handle(), "SELECT tbl, seq FROM ChangeSeq;", -1, &stmt, 0) != SQLITE_OK) return 0;
+    unsigned changed = 0;
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        const char *name = (const char*)sqlite3_column_text(stmt, 0);
+        long long seq = sqlite3_column_int64(stmt, 1);
+        for (int i = 0; name && i < CHANGE_TABLE_COUNT; i++) {
+            if (strcmp(name, table_names[i]) != 0) continue;
+            if (seq != seen_seq[i] && !only_own_writes(i, seen_seq[i], seq)) changed |= 1u << i;
+            seen_seq[i] = seq;
+            break;
+        }
+    }
+    sqlite3_finalize(stmt);
+    return changed;
+}
+
+// ============================================
+// Write Tracking
+// ============================================
+
+// The write transaction open on a tracked connection
+typedef struct {
+    unsigned bumped;                            // Tables whose sequence moved
+    long long seq[CHANGE_TABLE_COUNT];          // The value each one moved to
+} Transaction;
+
+// changeseq_noted(table): the value this transaction moved the sequence
+// to, or NULL. The triggers only bump a row that does not hold it yet, so
+// a bump undone by a failed statement is made again.
+static void sql_noted(sqlite3_context *context, int argc, sqlite3_value **argv) {
+    Transaction *txn = sqlite3_user_data(context);
+    int table = sqlite3_value_int(argv[0]);
+    if (table >= 0 && table < CHANGE_TABLE_COUNT && (txn->bumped & (1u << table))) {
+        sqlite3_result_int64(context, txn->seq[table]);
+    } else {
+        sqlite3_result_null(context);
+    }
+}
+
+// changeseq_note(table, seq): remember the value the sequence moves to,
+// and return it
+static void sql_note(sqlite3_context *context, int argc, sqlite3_value **argv) {
+    Transaction *txn = sqlite3_user_data(context);
+    int table = sqlite3_value_int(argv[0]);
+    if (table >= 0 && table < CHANGE_TABLE_COUNT) {
+        txn->bumped |= 1u << table;
+        txn->seq[table] = sqlite3_value_int64(argv[1]);
+    }
+    sqlite3_result_value(context, argv[1]);
+}
+
+// The transaction's sequence values become this instance's own writes
+static int on_commit(void *ctx) {
+    Transaction *txn = ctx;
+    for (int t = 0; t < CHANGE_TABLE_COUNT; t++) {
+        if (!(txn->bumped & (1u << t))) continue;
+        if (own_count[t] < CHANGES_MAX_OWN) {
+            own_seq[t][own_count[t]++] = txn->seq[t];
+        } else {
+            own_count[t] = 0;
+            own_overflow |= 1u << t;
+        }
+    }
+    txn->bumped = 0;
+    return 0;
+}
+
+static void on_rollback(void *ctx) {
+    ((Transaction*)ctx)->bumped = 0;
+}
+
+// ============================================
+// Public API
+// ============================================
+
+// Track writes on a connection: temporary triggers move each table's
+// ChangeSeq row once per transaction, not once per row, and remember the
+// value so that changes_poll() can tell this instance's own commits from
+// other instances'. Call on the UI thread's connection after the schema
+// exists; changes_poll() runs on the same thread.
+int changes_attach(sqlite3 *conn) {
+    Transaction *txn = calloc(1, sizeof(Transaction));
+    if (!txn) return 1;
+    if (sqlite3_create_function_v2(conn, "changeseq_noted", 1, SQLITE_UTF8, txn, sql_noted, NULL, NULL, free)
+            != SQLITE_OK) {
+        free(txn);
+        return 1;
+    }
+    if (sqlite3_create_function_v2(conn, "changeseq_note", 2, SQLITE_UTF8, txn, sql_note, NULL, NULL, NULL)
+            != SQLITE_OK) return 1;
+    sqlite3_commit_hook(conn, on_commit, txn);
+    sqlite3_rollback_hook(conn, on_rollback, txn);
+
+    static const char *operations[] = { "INSERT", "UPDATE", "DELETE" };
+    for (int t = 0; t < CHANGE_TABLE_COUNT; t++) {
+        for (int o = 0; o < 3; o++) {
+            char sql[512];
+            snprintf(sql, sizeof(sql),
+                "CREATE TEMP TRIGGER IF NOT EXISTS changeseq_%s_%s AFTER %s ON main.%s BEGIN "
+                "UPDATE ChangeSeq SET seq=changeseq_note(%d, seq+1) "
+                "WHERE tbl='%s' AND seq IS NOT changeseq_noted(%d); END;",
+                table_names[t], operations[o], operations[o], table_names[t], t, table_names[t], t);
+            char *errMsg = 0;
+            if (sqlite3_exec(conn, sql, 0, 0, &errMsg) != SQLITE_OK) {
+                fprintf(stderr, "SQL error (ChangeSeq triggers): %s\n", errMsg);
+                sqlite3_free(errMsg);
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+// Bump the sequences of the given ChangeTable bits inside the write
+// transaction open on conn. For connections without the triggers (the
+// archive thread); every instance, this one included, reports the change.
+int changes_bump(sqlite3 *conn, unsigned tables) {
+    for (int t = 0; t < CHANGE_TABLE_COUNT; t++) {
+        if (!(tables & (1u << t))) continue;
+        char sql[128];
+        snprintf(sql, sizeof(sql), "UPDATE ChangeSeq SET seq=seq+1 WHERE tbl='%s';", table_names[t]);
+        if (sqlite3_exec(conn, sql, 0, 0, 0) != SQLITE_OK) return 1;
+    }
+    return 0;
+}
+
+// Call back when any of the given ChangeTable bits changed. Returns an id
+// for changes_unsubscribe(), or 0 if all slots are taken.
+int changes_subscribe(unsigned tables, ChangeCallback callback, void *ctx) {
+    for (int i = 0; i < CHANGES_MAX_SUBSCRIBERS; i++) {
+        if (subscribers[i].callback) continue;
+        subscribers[i] = (Subscriber){ tables, callback, ctx };
+        return i + 1;
+    }
+    return 0;
+}
+
+void changes_unsubscribe(int id) {
+    if (id > 0 && id <= CHANGES_MAX_SUBSCRIBERS) {
+        memset(&subscribers[id - 1], 0, sizeof(Subscriber));
+    }
+}
+
+// Check for commits by other connections and notify the subscribers of
+// the tables they touched. Returns the changed ChangeTable bits.
+unsigned changes_poll() {
+    if (!db_get_handle()) return 0;
+
+    // A newly opened branch only sets the baseline
+    if (strcmp(loaded_path, db_get_path()) != 0) {
+        if (read_data_version(&seen_data_version) != 0) return 0;
+        memset(own_count, 0, sizeof(own_count));
+        own_overflow = 0;
+        read_changes();
+        snprintf(loaded_path, sizeof(loaded_path), "%s", db_get_path());
+        return 0;
+    }
+
+    // Nobody else committed, so every sequence value written since the last
+    // poll is our own: take the latest as seen
+    long long version;
+    if (read_data_version(&version) != 0) return 0;
+    if (version == seen_data_version) {
+        for (int t = 0; t < CHANGE_TABLE_COUNT; t++) {
+            if (own_count[t] > 0 && !(own_overflow & (1u << t))) seen_seq[t] = own_seq[t][own_count[t] - 1];
+            own_count[t] = 0;
+        }
+        return 0;
+    }
+    seen_data_version = version;
+
+    unsigned changed = read_changes();
+    if (!changed) return 0;
+
+    // Plans edited elsewhere invalidate the cached catalog
+    if (changed & CHANGE_PLANS) catalog_bump_version();
+    // Payments written elsewhere are folded into the revenue index lazily
+    if (changed & CHANGE_PAYMENTS) ledger_mark_stale();
+    // Cards and memberships changed elsewhere are re-read by the gate index
+    if (changed & CHANGE_CARDS) gate_mark_stale();
+    if (changed & CHANGE_MEMBERS) gate_mark_members_stale();
+
+    for (int i = 0; i < CHANGES_MAX_SUBSCRIBERS; i++) {
+        Subscriber subscriber = subscribers[i];
+        if (subscriber.callback && (subscriber.tables & changed)) {
+            subscriber.callback(subscriber.tables & changed, subscriber.ctx);
+        }
+    }
+    return changed;
+}
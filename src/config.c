@@ -0,0 +1,293 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <stddef.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include "config.h"
+#include "scheduler.h"
+#include "backup.h"
+#include "archive.h"
+#include "occupancy.h"
+#include "ratelimit.h"
+#include "changes.h"
+#include "outbox.h"
+#include "verify.h"
+
+// ============================================
+// Defaults and Field Table
+// ============================================
+
+static const Config default_config = {
+    .db_path = "database/gym.db",
+    .branches_dir = "database/branches",
+    .busy_timeout_ms = 5000,
+    .cache_size_kb = 8192,
+    .mmap_size_mb = 0,
+    .synchronous = "NORMAL",
+
+    .page_size = 25,
+    .pending_trainers_max = 20,
+    .trainer_choices_max = 10,
+    .roster_max = 1000,
+
+    .report_threads = 4,
+
+    .eventlog_flush_seconds = 2,
+    .scheduler_batch_size = SCHEDULER_BATCH_SIZE,
+    .occupancy_checkpoint_seconds = OCCUPANCY_CHECKPOINT_SECONDS,
+    .occupancy_max_fps = OCCUPANCY_MAX_FPS,
+    .change_poll_ms = CHANGES_POLL_MS,
+
+    .backup_dir = "database/backups",
+    .backup_step_pages = BACKUP_STEP_PAGES,
+    .backup_interval_hours = BACKUP_INTERVAL_HOURS,
+
+    .archive_horizon_days = ARCHIVE_HORIZON_DAYS,
+    .archive_batch_rows = ARCHIVE_BATCH_ROWS,
+    .archive_interval_hours = ARCHIVE_INTERVAL_HOURS,
+
+    .login_burst = RATELIMIT_LOGIN_BURST,
+    .login_refill_seconds = RATELIMIT_LOGIN_REFILL_SECONDS,
+    .terminal_burst = RATELIMIT_TERMINAL_BURST,
+    .terminal_refill_seconds = RATELIMIT_TERMINAL_REFILL_SECONDS,
+    .lockout_failures = RATELIMIT_LOCKOUT_FAILURES,
+    .lockout_minutes = RATELIMIT_LOCKOUT_MINUTES,
+
+    .mail_transport = "file",
+    .mail_sink_path = "database/outbox.mbox",
+    .smtp_host = "127.0.0.1",
+    .smtp_port = 25,
+    .mail_from = "gym@localhost",
+    .mail_batch_size = OUTBOX_BATCH_SIZE,
+    .code_minutes = VERIFY_CODE_MINUTES,
+    .codes_per_hour = RATELIMIT_CODES_PER_HOUR,
+
+    .slow_query_ms = 0,
+    .trace_sql = 0,
+    .frame_stats = 0,
+};
+
+typedef enum { FIELD_INT, FIELD_STRING } FieldType;
+
+typedef struct {
+    const char *section;
+    const char *key;
+    FieldType type;
+    size_t offset;
+    int min;        // Range for ints, minimum length for strings
+    int max;
+} ConfigField;
+
+#define INT_FIELD(section, key, member, min, max) \
+    { section, key, FIELD_INT, offsetof(Config, member), min, max }
+#define STRING_FIELD(section, key, member) \
+    { section, key, FIELD_STRING, offsetof(Config, member), 1, sizeof(((Config*)0)->member) - 1 }
+
+// Upper bounds match the fixed-size buffers that hold these values
+static const ConfigField fields[] = {
+    STRING_FIELD("database", "path", db_path),
+    STRING_FIELD("database", "branches_dir", branches_dir),
+    INT_FIELD("database", "busy_timeout_ms", busy_timeout_ms, 0, 600000),
+    INT_FIELD("database", "cache_size_kb", cache_size_kb, 64, 4 * 1024 * 1024),
+    INT_FIELD("database", "mmap_size_mb", mmap_size_mb, 0, 64 * 1024),
+    STRING_FIELD("database", "synchronous", synchronous),
+
+    INT_FIELD("limits", "page_size", page_size, 5, 1000),
+    INT_FIELD("limits", "pending_trainers", pending_trainers_max, 1, 10000),
+    INT_FIELD("limits", "trainer_choices", trainer_choices_max, 1, 1000),
+    INT_FIELD("limits", "roster_max", roster_max, 10, 100000),
+
+    INT_FIELD("threads", "report_threads", report_threads, 1, 32),
+
+    INT_FIELD("batching", "eventlog_flush_seconds", eventlog_flush_seconds, 1, 3600),
+    INT_FIELD("batching", "scheduler_batch_size", scheduler_batch_size, 1, SCHEDULER_BATCH_SIZE),
+    INT_FIELD("batching", "occupancy_checkpoint_seconds", occupancy_checkpoint_seconds, 1, 3600),
+    INT_FIELD("batching", "occupancy_max_fps", occupancy_max_fps, 1, 60),
+    INT_FIELD("batching", "change_poll_ms", change_poll_ms, 50, 60000),
+
+    STRING_FIELD("backup", "dir", backup_dir),
+    INT_FIELD("backup", "step_pages", backup_step_pages, 1, 1 << 20),
+    INT_FIELD("backup", "interval_hours", backup_interval_hours, 1, 24 * 365),
+
+    INT_FIELD("archive", "horizon_days", archive_horizon_days, 30, 100 * 365),
+    INT_FIELD("archive", "batch_rows", archive_batch_rows, 100, 1000000),
+    INT_FIELD("archive", "interval_hours", archive_interval_hours, 1, 24 * 365),
+
+    INT_FIELD("security", "login_burst", login_burst, 1, 1000),
+    INT_FIELD("security", "login_refill_seconds", login_refill_seconds, 1, 86400),
+    INT_FIELD("security", "terminal_burst", terminal_burst, 1, 10000),
+    INT_FIELD("security", "terminal_refill_seconds", terminal_refill_seconds, 1, 86400),
+    INT_FIELD("security", "lockout_failures", lockout_failures, 1, 1000),
+    INT_FIELD("security", "lockout_minutes", lockout_minutes, 1, 24 * 60),
+
+    STRING_FIELD("mail", "transport", mail_transport),
+    STRING_FIELD("mail", "sink_path", mail_sink_path),
+    STRING_FIELD("mail", "smtp_host", smtp_host),
+    INT_FIELD("mail", "smtp_port", smtp_port, 1, 65535),
+    STRING_FIELD("mail", "from", mail_from),
+    INT_FIELD("mail", "batch_size", mail_batch_size, 1, OUTBOX_BATCH_SIZE * 10),
+    INT_FIELD("mail", "code_minutes", code_minutes, 1, 24 * 60),
+    INT_FIELD("mail", "codes_per_hour", codes_per_hour, 1, 100),
+
+    INT_FIELD("instrumentation", "slow_query_ms", slow_query_ms, 0, 600000),
+    INT_FIELD("instrumentation", "trace_sql", trace_sql, 0, 1),
+    INT_FIELD("instrumentation", "frame_stats", frame_stats, 0, 1),
+};
+
+#define FIELD_COUNT ((int)(sizeof(fields) / sizeof(fields[0])))
+
+// ============================================
+// Config State
+// ============================================
+
+// Each load fills a new heap copy and publishes it with one atomic store.
+// Published copies are read-only and never freed: the outbox, archive and
+// backup threads may still be reading an older one, and reloads are rare.
+static _Atomic(Config*) active = NULL;
+static char loaded_path[CONFIG_PATH_LEN] = CONFIG_DEFAULT_PATH;
+static volatile sig_atomic_t reload_requested = 0;
+
+static char* trim(char *s) {
+    while (isspace((unsigned char)*s)) s++;
+    char *end = s + strlen(s);
+    while (end > s && isspace((unsigned char)end[-1])) *--end = '\0';
+    return s;
+}
+
+static void set_field(Config *config, const ConfigField *field, const char *value,
+                      const char *path, int line) {
+    char *target = (char*)config + field->offset;
+    if (field->type == FIELD_STRING) {
+        int len = (int)strlen(value);
+        if (len < field->min || len > field->max) {
+            fprintf(stderr, "%s:%d: %s.%s must be 1-%d characters, keeping default\n",
+                path, line, field->section, field->key, field->max);
+            return;
+        }
+        memcpy(target, value, len + 1);
+        return;
+    }
+
+    char *end;
+    long n = strtol(value, &end, 10);
+    if (end == value || *end != '\0') {
+        fprintf(stderr, "%s:%d: %s.%s is not a number, keeping default\n", path, line, field->section, field->key);
+        return;
+    }
+    if (n < field->min) n = field->min;
+    if (n > field->max) n = field->max;
+    *(int*)target = (int)n;
+}
+
+// Reject combinations the rest of the app cannot work with
+static void validate(Config *config, const char *path) {
+    size_t len = strlen(config->db_path);
+    if (len < 4 || strcmp(config->db_path + len - 3, ".db") != 0) {
+        fprintf(stderr, "%s: database.path must end in .db, using %s\n", path, default_config.db_path);
+        strcpy(config->db_path, default_config.db_path);
+    }
+
+    static const char *sync_modes[] = { "OFF", "NORMAL", "FULL", "EXTRA" };
+    int known = 0;
+    for (char *p = config->synchronous; *p; p++) *p = (char)toupper((unsigned char)*p);
+    for (int i = 0; i < 4; i++) known |= strcmp(config->synchronous, sync_modes[i]) == 0;
+    if (!known) {
+        fprintf(stderr, "%s: unknown database.synchronous, using %s\n", path, default_config.synchronous);
+        strcpy(config->synchronous, default_config.synchronous);
+    }
+
+    for (char *p = config->mail_transport; *p; p++) *p = (char)tolower((unsigned char)*p);
+    if (strcmp(config->mail_transport, "file") != 0 && strcmp(config->mail_transport, "smtp") != 0) {
+        fprintf(stderr, "%s: mail.transport must be file or smtp, using %s\n", path, default_config.mail_transport);
+        strcpy(config->mail_transport, default_config.mail_transport);
+    }
+}
+
+// ============================================
+// Public API
+// ============================================
+
+// Current settings (compiled-in defaults until a file is loaded)
+const Config* config_get() {
+    Config *config = atomic_load_explicit(&active, memory_order_acquire);
+    return config ? config : &default_config;
+}
+
+// Parse an INI file over the defaults. A missing file is not an error.
+int config_load(const char *path) {
+    Config *config = malloc(sizeof(Config));
+    if (!config) {
+        fprintf(stderr, "%s: out of memory, keeping the current settings\n", path);
+        return 1;
+    }
+    *config = default_config;
+    if (path != loaded_path) snprintf(loaded_path, sizeof(loaded_path), "%s", path);
+
+    FILE *fp = fopen(path, "r");
+    if (fp) {
+        char buf[512], section[64] = "";
+        int line = 0;
+        while (fgets(buf, sizeof(buf), fp)) {
+            line++;
+            char *s = trim(buf);
+            if (*s == '\0' || *s == ';' || *s == '#') continue;
+
+            if (*s == '[') {
+                char *close = strchr(s, ']');
+                if (!close) {
+                    fprintf(stderr, "%s:%d: unterminated section\n", path, line);
+                    continue;
+                }
+                *close = '\0';
+                snprintf(section, sizeof(section), "%s", trim(s + 1));
+                continue;
+            }
+
+            char *eq = strchr(s, '=');
+            if (!eq) {
+                fprintf(stderr, "%s:%d: expected key = value\n", path, line);
+                continue;
+            }
+            *eq = '\0';
+            char *key = trim(s), *value = eq + 1;
+            char *comment = strpbrk(value, ";#");
+            if (comment) *comment = '\0';
+            value = trim(value);
+
+            int i = 0;
+            while (i < FIELD_COUNT && (strcmp(fields[i].section, section) != 0 || strcmp(fields[i].key, key) != 0)) i++;
+            if (i == FIELD_COUNT) {
+                fprintf(stderr, "%s:%d: unknown setting %s.%s\n", path, line, section, key);
+                continue;
+            }
+            set_field(config, &fields[i], value, path, line);
+        }
+        fclose(fp);
+    }
+
+    validate(config, path);
+    atomic_store_explicit(&active, config, memory_order_release);
+    return 0;
+}
+
+static void on_reload_signal(int sig) {
+    reload_requested = 1;
+}
+
+// Re-read the config file on SIGHUP (where the platform has it)
+void config_install_reload_signal() {
+#ifdef SIGHUP
+    signal(SIGHUP, on_reload_signal);
+#endif
+}
+
+// Reload if a SIGHUP arrived since the last call; returns 1 after a reload
+int config_poll_reload() {
+    if (!reload_requested) return 0;
+    reload_requested = 0;
+    config_load(loaded_path);
+    printf("Reloaded settings from %s\n", loaded_path);
+    return 1;
+}
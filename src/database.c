@@ -1,25 +1,110 @@
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <ctype.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <time.h>
 #include <sqlite3.h>
+#ifdef _WIN32
+#include <direct.h>
+#endif
 #include "database.h"
+#include "catalog.h"
+#include "program.h"
+#include "booking.h"
+#include "ledger.h"
+#include "archive.h"
+#include "visits.h"
+#include "gate.h"
+#include "eventlog.h"
+#include "config.h"
+#include "changes.h"
 
 // ============================================
 // Global Database Handle
 // ============================================
 
 static sqlite3 *db = NULL;
+static char current_branch[BRANCH_NAME_LEN] = DEFAULT_BRANCH;
+static char current_path[256] = "database/gym.db";
+
+// Next MemberCards change sequence, evaluated inside the writing statement
+#define CARD_NEXT_SEQ "(SELECT IFNULL(MAX(seq), 0) + 1 FROM MemberCards)"
 
 // ============================================
 // Database Initialization
 // ============================================
 
-// Initialize database and create tables
-int db_init() {
-    int rc = sqlite3_open("database/gym.db", &db);
-    if (rc) {
-        fprintf(stderr, "Can't open database: %s\n", sqlite3_errmsg(db));
+// Add a column to an existing table unless it is already there
+static int db_ensure_column(const char *table, const char *column, const char *type) {
+    char sql[256];
+    snprintf(sql, sizeof(sql), "PRAGMA table_info(%s);", table);
+
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, 0) != SQLITE_OK) return 1;
+
+    int found = 0;
+    while (!found && sqlite3_step(stmt) == SQLITE_ROW) {
+        found = strcmp((const char*)sqlite3_column_text(stmt, 1), column) == 0;
+    }
+    sqlite3_finalize(stmt);
+    if (found) return 0;
+
+    snprintf(sql, sizeof(sql), "ALTER TABLE %s ADD COLUMN %s %s;", table, column, type);
+    char *errMsg = 0;
+    if (sqlite3_exec(db, sql, 0, 0, &errMsg) != SQLITE_OK) {
+        fprintf(stderr, "SQL error (Add %s.%s): %s\n", table, column, errMsg);
+        sqlite3_free(errMsg);
         return 1;
     }
+    return 0;
+}
+
+// Does the database already have an index of this name?
+static int db_has_index(const char *name) {
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(db, "SELECT 1 FROM sqlite_master WHERE type='index' AND name=?;", -1, &stmt, 0) != SQLITE_OK)
+        return 0;
+    sqlite3_bind_text(stmt, 1, name, -1, SQLITE_STATIC);
+    int found = sqlite3_step(stmt) == SQLITE_ROW;
+    sqlite3_finalize(stmt);
+    return found;
+}
+
+// Log statements that ran longer than the configured threshold
+static int db_trace(unsigned type, void *ctx, void *p, void *x) {
+    const Config *config = config_get();
+    long long ns = *(sqlite3_int64*)x;
+    if (!config->trace_sql && ns < (long long)config->slow_query_ms * 1000000) return 0;
+
+    char *sql = sqlite3_expanded_sql((sqlite3_stmt*)p);
+    fprintf(stderr, "[sql %.3f ms] %s\n", ns / 1e6, sql ? sql : sqlite3_sql((sqlite3_stmt*)p));
+    sqlite3_free(sql);
+    return 0;
+}
+
+// Apply the tuning pragmas and instrumentation from the config file.
+// Safe to call again after a reload.
+void db_apply_settings() {
+    if (!db) return;
+    const Config *config = config_get();
+    char sql[256];
+    sqlite3_busy_timeout(db, config->busy_timeout_ms);
+    snprintf(sql, sizeof(sql), "PRAGMA cache_size=-%d; PRAGMA mmap_size=%lld; PRAGMA synchronous=%s;",
+        config->cache_size_kb, (long long)config->mmap_size_mb * 1024 * 1024, config->synchronous);
+    sqlite3_exec(db, sql, 0, 0, 0);
+
+    int tracing = config->trace_sql || config->slow_query_ms > 0;
+    sqlite3_trace_v2(db, tracing ? SQLITE_TRACE_PROFILE : 0, tracing ? db_trace : NULL, NULL);
+}
+
+// Create tables, indexes and seed data on the open connection
+static int db_create_schema() {
+    // WAL lets background readers (exports, reports, backups) work from a
+    // consistent snapshot without blocking the UI's writes
+    sqlite3_exec(db, "PRAGMA journal_mode=WAL;", 0, 0, 0);
+    db_apply_settings();
 
     const char *sql_users = 
         "CREATE TABLE IF NOT EXISTS Users ("
@@ -38,6 +123,9 @@ int db_init() {
         "trainer_id INTEGER,"
         "time_slot TEXT,"
         "status TEXT,"
+        "joined_at TEXT,"
+        "renews_at INTEGER,"
+        "auto_renew INTEGER DEFAULT 1,"
         "FOREIGN KEY(member_id) REFERENCES Users(user_id));"
     ;
 
@@ -46,6 +134,7 @@ int db_init() {
         "trainer_id INTEGER PRIMARY KEY,"
         "specialization TEXT,"
         "status TEXT,"
+        "joined_at TEXT,"
         "FOREIGN KEY(trainer_id) REFERENCES Users(user_id));"
     ;
 
@@ -53,7 +142,7 @@ int db_init() {
         "CREATE TABLE IF NOT EXISTS Plans ("
         "plan_id INTEGER PRIMARY KEY AUTOINCREMENT,"
         "name TEXT NOT NULL,"
-        "price REAL,"
+        "price REAL,"                   // Legacy; price_cents is authoritative
         "time_slot TEXT);"
     ;
 
@@ -95,15 +184,347 @@ int db_init() {
         return 1;
     }
 
-    // Seed default plans
-    const char *sql_seed_plans = 
-        "INSERT OR IGNORE INTO Plans (plan_id, name, price, time_slot) VALUES "
-        "(1, 'Basic (Morning)', 30.0, 'Morning'),"
-        "(2, 'Standard (Evening)', 50.0, 'Evening'),"
-        "(3, 'Premium (Anytime)', 80.0, 'Full Day');";
-        
-    if (sqlite3_exec(db, sql_seed_plans, 0, 0, &errMsg) != SQLITE_OK) {
-        fprintf(stderr, "SQL error (Seed Plans): %s\n", errMsg);
+    // Schema upgrades for databases created by older builds
+    if (db_ensure_column("Members", "joined_at", "TEXT") != 0 ||
+        db_ensure_column("Members", "renews_at", "INTEGER") != 0 ||
+        db_ensure_column("Members", "auto_renew", "INTEGER DEFAULT 1") != 0 ||
+        db_ensure_column("Trainers", "joined_at", "TEXT") != 0 ||
+        db_ensure_column("Attendance", "checked_in_at", "INTEGER") != 0 ||
+        db_ensure_column("Attendance", "checked_out_at", "INTEGER") != 0 ||
+        db_ensure_column("Attendance", "zone", "TEXT") != 0 ||
+        db_ensure_column("Plans", "price_cents", "INTEGER") != 0) {
+        return 1;
+    }
+    sqlite3_exec(db, "UPDATE Members SET joined_at=datetime('now') WHERE joined_at IS NULL;", 0, 0, 0);
+    sqlite3_exec(db, "UPDATE Trainers SET joined_at=datetime('now') WHERE joined_at IS NULL;", 0, 0, 0);
+
+    // One check-in per member per day, enforced by a unique index. Databases
+    // from older builds can hold duplicates from terminals that raced; the
+    // first check-in of each day is kept.
+    if (!db_has_index("idx_attendance_member_day")) {
+        const char *sql_unique =
+            "BEGIN IMMEDIATE;"
+            "DELETE FROM Attendance WHERE attendance_id NOT IN "
+            "(SELECT MIN(attendance_id) FROM Attendance GROUP BY member_id, date);"
+            "DROP INDEX IF EXISTS idx_attendance_member_date;"
+            "CREATE UNIQUE INDEX IF NOT EXISTS idx_attendance_member_day ON Attendance(member_id, date);"
+            "COMMIT;";
+        if (sqlite3_exec(db, sql_unique, 0, 0, &errMsg) != SQLITE_OK) {
+            fprintf(stderr, "SQL error (Attendance index): %s\n", errMsg);
+            sqlite3_free(errMsg);
+            sqlite3_exec(db, "ROLLBACK;", 0, 0, 0);
+            return 1;
+        }
+    }
+
+    // Indexes backing the sorted/paginated listings. Each one matches the
+    // (sort key, id) pair used by the keyset queries below exactly.
+    const char *sql_indexes[] = {
+        "CREATE INDEX IF NOT EXISTS idx_users_name ON Users(name, user_id);",
+        "CREATE INDEX IF NOT EXISTS idx_users_trainer_name ON Users(name, user_id) WHERE role='Trainer';",
+        "CREATE INDEX IF NOT EXISTS idx_members_plan ON Members(IFNULL(plan_id, 0), member_id);",
+        "CREATE INDEX IF NOT EXISTS idx_members_status ON Members(IFNULL(status, ''), member_id);",
+        "CREATE INDEX IF NOT EXISTS idx_members_joined ON Members(IFNULL(joined_at, ''), member_id);",
+        "CREATE INDEX IF NOT EXISTS idx_trainers_spec ON Trainers(IFNULL(specialization, ''), trainer_id);",
+        "CREATE INDEX IF NOT EXISTS idx_trainers_status ON Trainers(IFNULL(status, ''), trainer_id);",
+        "CREATE INDEX IF NOT EXISTS idx_trainers_joined ON Trainers(IFNULL(joined_at, ''), trainer_id);",
+        "CREATE INDEX IF NOT EXISTS idx_members_renewal ON Members(renews_at) WHERE status='ACTIVE';",
+        "CREATE INDEX IF NOT EXISTS idx_members_trainer ON Members(trainer_id, member_id);",
+        "CREATE INDEX IF NOT EXISTS idx_attendance_present ON Attendance(date) WHERE checked_out_at IS NULL;",
+        "CREATE INDEX IF NOT EXISTS idx_attendance_date ON Attendance(date);",
+    };
+    for (size_t i = 0; i < sizeof(sql_indexes) / sizeof(sql_indexes[0]); i++) {
+        if (sqlite3_exec(db, sql_indexes[i], 0, 0, &errMsg) != SQLITE_OK) {
+            fprintf(stderr, "SQL error (Indexes): %s\n", errMsg);
+            sqlite3_free(errMsg);
+            return 1;
+        }
+    }
+
+    // Occupancy statistics: check-ins per (day of week, local hour), and the
+    // number of distinct days seen per weekday. Maintained by db_check_in.
+    const char *sql_occupancy =
+        "CREATE TABLE IF NOT EXISTS OccupancyStats ("
+        "dow INTEGER NOT NULL,"
+        "hour INTEGER NOT NULL,"
+        "visits INTEGER NOT NULL DEFAULT 0,"
+        "PRIMARY KEY(dow, hour)) WITHOUT ROWID;"
+        "CREATE TABLE IF NOT EXISTS OccupancyDays ("
+        "dow INTEGER PRIMARY KEY,"
+        "days INTEGER NOT NULL DEFAULT 0,"
+        "last_date TEXT);"
+        // One-time bootstrap from existing timestamped attendance
+        "INSERT INTO OccupancyStats (dow, hour, visits) "
+        "SELECT CAST(strftime('%w', checked_in_at, 'unixepoch', 'localtime') AS INTEGER),"
+        "CAST(strftime('%H', checked_in_at, 'unixepoch', 'localtime') AS INTEGER), COUNT(*) "
+        "FROM Attendance WHERE checked_in_at IS NOT NULL "
+        "AND NOT EXISTS (SELECT 1 FROM OccupancyStats) GROUP BY 1, 2;"
+        "INSERT INTO OccupancyDays (dow, days, last_date) "
+        "SELECT CAST(strftime('%w', checked_in_at, 'unixepoch', 'localtime') AS INTEGER),"
+        "COUNT(DISTINCT date), MAX(date) "
+        "FROM Attendance WHERE checked_in_at IS NOT NULL "
+        "AND NOT EXISTS (SELECT 1 FROM OccupancyDays) GROUP BY 1;";
+    if (sqlite3_exec(db, sql_occupancy, 0, 0, &errMsg) != SQLITE_OK) {
+        fprintf(stderr, "SQL error (Occupancy): %s\n", errMsg);
+        sqlite3_free(errMsg);
+        return 1;
+    }
+
+    // Last checkpoint of the live in-building counters (see occupancy.c)
+    const char *sql_live =
+        "CREATE TABLE IF NOT EXISTS LiveOccupancy ("
+        "time_slot TEXT NOT NULL,"
+        "zone TEXT NOT NULL,"
+        "present INTEGER NOT NULL,"
+        "updated_at INTEGER NOT NULL,"
+        "PRIMARY KEY(time_slot, zone)) WITHOUT ROWID;";
+    if (sqlite3_exec(db, sql_live, 0, 0, &errMsg) != SQLITE_OK) {
+        fprintf(stderr, "SQL error (LiveOccupancy): %s\n", errMsg);
+        sqlite3_free(errMsg);
+        return 1;
+    }
+
+    // Login lockouts that must survive a restart (see ratelimit.c)
+    const char *sql_lockouts =
+        "CREATE TABLE IF NOT EXISTS LoginLockouts ("
+        "key TEXT PRIMARY KEY,"
+        "failures INTEGER NOT NULL,"
+        "locked_until INTEGER NOT NULL) WITHOUT ROWID;";
+    if (sqlite3_exec(db, sql_lockouts, 0, 0, &errMsg) != SQLITE_OK) {
+        fprintf(stderr, "SQL error (LoginLockouts): %s\n", errMsg);
+        sqlite3_free(errMsg);
+        return 1;
+    }
+
+    // One-time verification codes (stored as salted SHA-256) and the mail
+    // outbox drained by the background sender (see verify.c, outbox.c)
+    const char *sql_mail =
+        "CREATE TABLE IF NOT EXISTS VerificationCodes ("
+        "email TEXT PRIMARY KEY,"
+        "salt TEXT NOT NULL,"
+        "code_hash TEXT NOT NULL,"
+        "expires_at INTEGER NOT NULL,"
+        "attempts INTEGER NOT NULL DEFAULT 0) WITHOUT ROWID;"
+        "CREATE TABLE IF NOT EXISTS Outbox ("
+        "id INTEGER PRIMARY KEY AUTOINCREMENT,"
+        "recipient TEXT NOT NULL,"
+        "subject TEXT NOT NULL,"
+        "body TEXT NOT NULL,"
+        "status TEXT NOT NULL DEFAULT 'QUEUED',"   // QUEUED, SENT or FAILED
+        "attempts INTEGER NOT NULL DEFAULT 0,"
+        "created_at INTEGER NOT NULL,"
+        "next_attempt_at INTEGER NOT NULL,"
+        "sent_at INTEGER,"
+        "last_error TEXT);"
+        "CREATE INDEX IF NOT EXISTS idx_outbox_due ON Outbox(next_attempt_at) WHERE status='QUEUED';";
+    if (sqlite3_exec(db, sql_mail, 0, 0, &errMsg) != SQLITE_OK) {
+        fprintf(stderr, "SQL error (Outbox): %s\n", errMsg);
+        sqlite3_free(errMsg);
+        return 1;
+    }
+
+    // Workout programs: an exercise library, weekly templates (a focus per
+    // training day plus its exercises) and each member's assigned template.
+    // Weekdays are ISO (1 = Monday). Compiled into memory by program.c.
+    const char *sql_programs =
+        "CREATE TABLE IF NOT EXISTS Exercises ("
+        "exercise_id INTEGER PRIMARY KEY,"
+        "name TEXT UNIQUE NOT NULL,"
+        "muscle_group TEXT NOT NULL);"
+        "CREATE TABLE IF NOT EXISTS WorkoutTemplates ("
+        "template_id INTEGER PRIMARY KEY,"
+        "name TEXT UNIQUE NOT NULL);"
+        "CREATE TABLE IF NOT EXISTS TemplateDays ("
+        "template_id INTEGER NOT NULL REFERENCES WorkoutTemplates(template_id),"
+        "weekday INTEGER NOT NULL CHECK (weekday BETWEEN 1 AND 7),"
+        "focus TEXT NOT NULL,"
+        "PRIMARY KEY (template_id, weekday)) WITHOUT ROWID;"
+        "CREATE TABLE IF NOT EXISTS TemplateExercises ("
+        "template_id INTEGER NOT NULL,"
+        "weekday INTEGER NOT NULL,"
+        "position INTEGER NOT NULL,"
+        "exercise_id INTEGER NOT NULL REFERENCES Exercises(exercise_id),"
+        "sets INTEGER NOT NULL,"
+        "reps INTEGER NOT NULL,"
+        "PRIMARY KEY (template_id, weekday, position),"
+        "FOREIGN KEY (template_id, weekday) REFERENCES TemplateDays(template_id, weekday)) WITHOUT ROWID;"
+        "CREATE TABLE IF NOT EXISTS MemberPrograms ("
+        "member_id INTEGER PRIMARY KEY REFERENCES Members(member_id),"
+        "template_id INTEGER NOT NULL REFERENCES WorkoutTemplates(template_id),"
+        "assigned_by INTEGER,"
+        "assigned_at INTEGER NOT NULL);";
+    if (sqlite3_exec(db, sql_programs, 0, 0, &errMsg) != SQLITE_OK) {
+        fprintf(stderr, "SQL error (Programs): %s\n", errMsg);
+        sqlite3_free(errMsg);
+        return 1;
+    }
+
+    // Capacity-limited classes; booked and waitlisted are kept in step with
+    // Bookings by booking.c, and the CHECK refuses any overbooking
+    const char *sql_classes =
+        "CREATE TABLE IF NOT EXISTS Classes ("
+        "class_id INTEGER PRIMARY KEY AUTOINCREMENT,"
+        "name TEXT NOT NULL,"
+        "trainer_id INTEGER,"
+        "starts_at INTEGER NOT NULL,"
+        "duration_minutes INTEGER NOT NULL,"
+        "capacity INTEGER NOT NULL CHECK (capacity > 0),"
+        "booked INTEGER NOT NULL DEFAULT 0,"
+        "waitlisted INTEGER NOT NULL DEFAULT 0,"
+        "waitlist_seq INTEGER NOT NULL DEFAULT 0,"   // Last waitlist number handed out
+        "CHECK (booked BETWEEN 0 AND capacity));"
+        "CREATE TABLE IF NOT EXISTS Bookings ("
+        "class_id INTEGER NOT NULL REFERENCES Classes(class_id),"
+        "member_id INTEGER NOT NULL,"
+        "status TEXT NOT NULL,"                      // BOOKED or WAITLISTED
+        "seq INTEGER NOT NULL,"                      // Waitlist order
+        "booked_at INTEGER NOT NULL,"
+        "PRIMARY KEY (class_id, member_id)) WITHOUT ROWID;"
+        "CREATE INDEX IF NOT EXISTS idx_classes_start ON Classes(starts_at);"
+        "CREATE INDEX IF NOT EXISTS idx_bookings_member ON Bookings(member_id);"
+        "CREATE INDEX IF NOT EXISTS idx_bookings_waitlist ON Bookings(class_id, seq) WHERE status='WAITLISTED';";
+    if (sqlite3_exec(db, sql_classes, 0, 0, &errMsg) != SQLITE_OK) {
+        fprintf(stderr, "SQL error (Classes): %s\n", errMsg);
+        sqlite3_free(errMsg);
+        return 1;
+    }
+
+    // Append-only payments ledger in integer cents; day is the local
+    // calendar day (days since 1970-01-01) the ledger indexes revenue by
+    const char *sql_payments =
+        "CREATE TABLE IF NOT EXISTS Payments ("
+        "payment_id INTEGER PRIMARY KEY AUTOINCREMENT,"
+        "member_id INTEGER NOT NULL REFERENCES Members(member_id),"
+        "plan_id INTEGER NOT NULL REFERENCES Plans(plan_id),"
+        "amount_cents INTEGER NOT NULL,"
+        "day INTEGER NOT NULL,"
+        "paid_at INTEGER NOT NULL,"
+        "kind TEXT NOT NULL);"                       // SIGNUP or RENEWAL
+        "CREATE INDEX IF NOT EXISTS idx_payments_member ON Payments(member_id);"
+        "CREATE TRIGGER IF NOT EXISTS payments_no_update BEFORE UPDATE ON Payments "
+        "BEGIN SELECT RAISE(ABORT, 'Payments are append-only'); END;"
+        "CREATE TRIGGER IF NOT EXISTS payments_no_delete BEFORE DELETE ON Payments "
+        "BEGIN SELECT RAISE(ABORT, 'Payments are append-only'); END;";
+    if (sqlite3_exec(db, sql_payments, 0, 0, &errMsg) != SQLITE_OK) {
+        fprintf(stderr, "SQL error (Payments): %s\n", errMsg);
+        sqlite3_free(errMsg);
+        return 1;
+    }
+
+    // Per-member attendance bitmaps (see visits.c) and the last
+    // attendance_id folded into them
+    const char *sql_visit_maps =
+        "CREATE TABLE IF NOT EXISTS VisitMaps ("
+        "member_id INTEGER PRIMARY KEY,"
+        "first_word INTEGER NOT NULL,"
+        "bits BLOB NOT NULL);"
+        "CREATE TABLE IF NOT EXISTS VisitMapState ("
+        "id INTEGER PRIMARY KEY CHECK (id = 1),"
+        "last_attendance_id INTEGER NOT NULL);";
+    if (sqlite3_exec(db, sql_visit_maps, 0, 0, &errMsg) != SQLITE_OK) {
+        fprintf(stderr, "SQL error (VisitMaps): %s\n", errMsg);
+        sqlite3_free(errMsg);
+        return 1;
+    }
+
+    // Turnstile cards (see gate.c). A revoked card keeps its row so it is
+    // not silently handed to someone else; seq is bumped on every change
+    // so the gate index only reads rows above the last seq it saw
+    const char *sql_cards =
+        "CREATE TABLE IF NOT EXISTS MemberCards ("
+        "card_id TEXT PRIMARY KEY,"                  // Card number or QR payload
+        "member_id INTEGER NOT NULL,"
+        "issued_at INTEGER NOT NULL,"
+        "revoked_at INTEGER,"
+        "seq INTEGER NOT NULL);"
+        "CREATE INDEX IF NOT EXISTS idx_cards_member ON MemberCards(member_id);"
+        "CREATE INDEX IF NOT EXISTS idx_cards_seq ON MemberCards(seq);";
+    if (sqlite3_exec(db, sql_cards, 0, 0, &errMsg) != SQLITE_OK) {
+        fprintf(stderr, "SQL error (MemberCards): %s\n", errMsg);
+        sqlite3_free(errMsg);
+        return 1;
+    }
+
+    // Per-table change sequences, bumped once per writing transaction so
+    // other app instances can see what changed (changes.c). Older builds
+    // bumped them from permanent triggers on every row.
+    if (sqlite3_exec(db, "CREATE TABLE IF NOT EXISTS ChangeSeq ("
+            "tbl TEXT PRIMARY KEY,"
+            "seq INTEGER NOT NULL DEFAULT 0) WITHOUT ROWID;", 0, 0, &errMsg) != SQLITE_OK) {
+        fprintf(stderr, "SQL error (ChangeSeq): %s\n", errMsg);
+        sqlite3_free(errMsg);
+        return 1;
+    }
+    static const char *tracked[CHANGE_TABLE_COUNT] = CHANGE_TABLE_NAMES;
+    static const char *operations[] = { "INSERT", "UPDATE", "DELETE" };
+    for (int t = 0; t < CHANGE_TABLE_COUNT; t++) {
+        char sql[512];
+        snprintf(sql, sizeof(sql), "INSERT OR IGNORE INTO ChangeSeq (tbl, seq) VALUES ('%s', 0);", tracked[t]);
+        int rc = sqlite3_exec(db, sql, 0, 0, &errMsg);
+        for (int o = 0; o < 3 && rc == SQLITE_OK; o++) {
+            snprintf(sql, sizeof(sql), "DROP TRIGGER IF EXISTS main.changeseq_%s_%s;", tracked[t], operations[o]);
+            rc = sqlite3_exec(db, sql, 0, 0, &errMsg);
+        }
+        if (rc != SQLITE_OK) {
+            fprintf(stderr, "SQL error (ChangeSeq): %s\n", errMsg);
+            sqlite3_free(errMsg);
+            return 1;
+        }
+    }
+    if (changes_attach(db) != 0) return 1;
+
+    // Seed default plans from the compiled-in catalog
+    int default_count;
+    const Plan *defaults = catalog_default_plans(&default_count);
+    sqlite3_stmt *seed;
+    if (sqlite3_prepare_v2(db, "INSERT OR IGNORE INTO Plans (plan_id, name, price, price_cents, time_slot) "
+                               "VALUES (?, ?, ?, ?, ?);", -1, &seed, 0) == SQLITE_OK) {
+        for (int i = 0; i < default_count; i++) {
+            sqlite3_bind_int(seed, 1, defaults[i].plan_id);
+            sqlite3_bind_text(seed, 2, defaults[i].name, -1, SQLITE_STATIC);
+            sqlite3_bind_double(seed, 3, defaults[i].price_cents / 100.0);
+            sqlite3_bind_int(seed, 4, defaults[i].price_cents);
+            sqlite3_bind_text(seed, 5, defaults[i].time_slot, -1, SQLITE_STATIC);
+            if (sqlite3_step(seed) != SQLITE_DONE) {
+                fprintf(stderr, "SQL error (Seed Plans): %s\n", sqlite3_errmsg(db));
+            }
+            sqlite3_reset(seed);
+        }
+        sqlite3_finalize(seed);
+    }
+    sqlite3_exec(db, "UPDATE Plans SET price_cents=CAST(ROUND(price * 100) AS INTEGER) "
+                     "WHERE price_cents IS NULL;", 0, 0, 0);
+
+    // Seed the default workout programs (template 1 is what members
+    // without an assignment follow)
+    const char *sql_seed_programs =
+        "INSERT OR IGNORE INTO Exercises (exercise_id, name, muscle_group) VALUES "
+        "(1, 'Bench Press', 'Chest'), (2, 'Incline Dumbbell Press', 'Chest'), (3, 'Push-Up', 'Chest'),"
+        "(4, 'Deadlift', 'Back'), (5, 'Pull-Up', 'Back'), (6, 'Barbell Row', 'Back'),"
+        "(7, 'Back Squat', 'Legs'), (8, 'Romanian Deadlift', 'Legs'), (9, 'Walking Lunge', 'Legs'),"
+        "(10, 'Overhead Press', 'Shoulders'), (11, 'Lateral Raise', 'Shoulders'),"
+        "(12, 'Barbell Curl', 'Arms'), (13, 'Triceps Dip', 'Arms'), (14, 'Hanging Leg Raise', 'Core');"
+        "INSERT OR IGNORE INTO WorkoutTemplates (template_id, name) VALUES "
+        "(1, 'Classic Split'), (2, 'Full Body 3-Day'), (3, 'Upper/Lower');"
+        "INSERT OR IGNORE INTO TemplateDays (template_id, weekday, focus) VALUES "
+        "(1, 1, 'Chest'), (1, 2, 'Back'), (1, 3, 'Legs'), (1, 4, 'Shoulders'), (1, 5, 'Arms & Core'),"
+        "(2, 1, 'Full Body A'), (2, 3, 'Full Body B'), (2, 5, 'Full Body C'),"
+        "(3, 1, 'Upper'), (3, 2, 'Lower'), (3, 4, 'Upper'), (3, 5, 'Lower');"
+        "INSERT OR IGNORE INTO TemplateExercises (template_id, weekday, position, exercise_id, sets, reps) VALUES "
+        "(1, 1, 1, 1, 4, 8), (1, 1, 2, 2, 3, 10), (1, 1, 3, 3, 3, 15),"
+        "(1, 2, 1, 4, 3, 5), (1, 2, 2, 5, 3, 8), (1, 2, 3, 6, 3, 10),"
+        "(1, 3, 1, 7, 4, 8), (1, 3, 2, 8, 3, 10), (1, 3, 3, 9, 3, 12),"
+        "(1, 4, 1, 10, 4, 8), (1, 4, 2, 11, 3, 15),"
+        "(1, 5, 1, 12, 3, 12), (1, 5, 2, 13, 3, 12), (1, 5, 3, 14, 3, 12),"
+        "(2, 1, 1, 7, 3, 8), (2, 1, 2, 1, 3, 8), (2, 1, 3, 6, 3, 8),"
+        "(2, 3, 1, 4, 3, 5), (2, 3, 2, 10, 3, 8), (2, 3, 3, 5, 3, 8),"
+        "(2, 5, 1, 8, 3, 10), (2, 5, 2, 2, 3, 10), (2, 5, 3, 9, 3, 12), (2, 5, 4, 14, 3, 12),"
+        "(3, 1, 1, 1, 4, 6), (3, 1, 2, 6, 4, 6), (3, 1, 3, 10, 3, 8), (3, 1, 4, 12, 3, 10),"
+        "(3, 2, 1, 7, 4, 6), (3, 2, 2, 8, 3, 8), (3, 2, 3, 14, 3, 12),"
+        "(3, 4, 1, 2, 3, 10), (3, 4, 2, 5, 3, 8), (3, 4, 3, 11, 3, 15), (3, 4, 4, 13, 3, 12),"
+        "(3, 5, 1, 4, 3, 5), (3, 5, 2, 9, 3, 12), (3, 5, 3, 14, 3, 12);";
+    if (sqlite3_exec(db, sql_seed_programs, 0, 0, &errMsg) != SQLITE_OK) {
+        fprintf(stderr, "SQL error (Seed Programs): %s\n", errMsg);
         sqlite3_free(errMsg);
     }
 
@@ -120,6 +541,11 @@ int db_init() {
     return 0;
 }
 
+// Initialize database (default branch) and create tables
+int db_init() {
+    return db_open_branch(DEFAULT_BRANCH);
+}
+
 // Get database handle
 sqlite3* db_get_handle() {
     return db;
@@ -127,12 +553,111 @@ sqlite3* db_get_handle() {
 
 // Close database connection
 void db_close() {
+    eventlog_close();
     if (db) {
         sqlite3_close(db);
         db = NULL;
     }
 }
 
+// ============================================
+// Branch Functions
+// ============================================
+
+// Create a directory if it does not exist yet
+void db_make_dir(const char *path) {
+#ifdef _WIN32
+    _mkdir(path);
+#else
+    mkdir(path, 0755);
+#endif
+}
+
+// Resolve the database file of a branch. Branch names are restricted to
+// letters, digits, '-' and '_' so they are always safe file names.
+int db_branch_path(const char *branch, char *path, size_t size) {
+    size_t len = strlen(branch);
+    if (len == 0 || len >= BRANCH_NAME_LEN) return 1;
+    for (size_t i = 0; i < len; i++) {
+        if (!isalnum((unsigned char)branch[i]) && branch[i] != '-' && branch[i] != '_') return 1;
+    }
+
+    const Config *config = config_get();
+    if (strcmp(branch, DEFAULT_BRANCH) == 0) {
+        snprintf(path, size, "%s", config->db_path);
+    } else {
+        snprintf(path, size, "%s/%s.db", config->branches_dir, branch);
+    }
+    return 0;
+}
+
+// Switch the global connection to a branch, creating its database if needed
+int db_open_branch(const char *branch) {
+    char path[256];
+    if (db_branch_path(branch, path, sizeof(path)) != 0) {
+        fprintf(stderr, "Invalid branch name: %s\n", branch);
+        return 1;
+    }
+    if (db && strcmp(path, current_path) == 0) return 0;
+
+    if (strcmp(branch, DEFAULT_BRANCH) != 0) db_make_dir(config_get()->branches_dir);
+
+    sqlite3 *conn = NULL;
+    if (sqlite3_open(path, &conn) != SQLITE_OK) {
+        fprintf(stderr, "Can't open database: %s\n", sqlite3_errmsg(conn));
+        sqlite3_close(conn);
+        return 1;
+    }
+
+    db_close();
+    db = conn;
+    snprintf(current_branch, sizeof(current_branch), "%s", branch);
+    snprintf(current_path, sizeof(current_path), "%s", path);
+    catalog_bump_version();
+    program_bump_version();
+    ledger_bump_version();
+    visits_bump_version();
+    gate_bump_version();
+
+    // Audit log lives next to the database: gym.db -> gym.events
+    char log_path[256];
+    snprintf(log_path, sizeof(log_path), "%.*s.events", (int)(strlen(path) - 3), path);
+    eventlog_open(log_path);
+
+    return db_create_schema();
+}
+
+// Name of the branch the global connection points at
+const char* db_get_branch() {
+    return current_branch;
+}
+
+// File path of the open branch database
+const char* db_get_path() {
+    return current_path;
+}
+
+// List all known branches: the default one plus every file in database/branches
+int db_list_branches(char branches[][BRANCH_NAME_LEN], int *count) {
+    int i = 0;
+    if (*count > 0) snprintf(branches[i++], BRANCH_NAME_LEN, "%s", DEFAULT_BRANCH);
+
+    DIR *dir = opendir(config_get()->branches_dir);
+    if (dir) {
+        struct dirent *entry;
+        while (i < *count && (entry = readdir(dir)) != NULL) {
+            size_t len = strlen(entry->d_name);
+            if (len <= 3 || len - 3 >= BRANCH_NAME_LEN || strcmp(entry->d_name + len - 3, ".db") != 0) continue;
+            snprintf(branches[i], BRANCH_NAME_LEN, "%.*s", (int)(len - 3), entry->d_name);
+            char path[256];
+            if (db_branch_path(branches[i], path, sizeof(path)) == 0) i++;
+        }
+        closedir(dir);
+    }
+    *count = i;
+    return 0;
+}
+
 // ============================================
 // User Management Functions
 // ============================================
@@ -179,6 +704,29 @@ int db_get_user_by_email(const char *email, User *user) {
     return result;
 }
 
+// Get a user by id
+int db_get_user(int user_id, User *user) {
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(db, "SELECT user_id, name, email, password, role, verified FROM Users WHERE user_id=?;",
+                           -1, &stmt, 0) != SQLITE_OK) {
+        return 1;
+    }
+    sqlite3_bind_int(stmt, 1, user_id);
+
+    int result = 1;
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        user->user_id = sqlite3_column_int(stmt, 0);
+        snprintf(user->name, sizeof(user->name), "%s", sqlite3_column_text(stmt, 1));
+        snprintf(user->email, sizeof(user->email), "%s", sqlite3_column_text(stmt, 2));
+        snprintf(user->password, sizeof(user->password), "%s", sqlite3_column_text(stmt, 3));
+        snprintf(user->role, sizeof(user->role), "%s", sqlite3_column_text(stmt, 4));
+        user->verified = sqlite3_column_int(stmt, 5);
+        result = 0;
+    }
+    sqlite3_finalize(stmt);
+    return result;
+}
+
 // Mark user as verified
 int db_verify_user(const char *email) {
     char sql[256];
@@ -204,6 +752,105 @@ int db_login_user(const char *email, const char *password, User *user) {
     return 2; // Wrong password
 }
 
+// Store a new verification code for an email, replacing any earlier one
+int db_save_verification(const char *email, const char *salt, const char *code_hash, long long expires_at) {
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(db, "INSERT INTO VerificationCodes (email, salt, code_hash, expires_at, attempts) "
+        "VALUES (?, ?, ?, ?, 0) ON CONFLICT(email) DO UPDATE SET salt=excluded.salt, "
+        "code_hash=excluded.code_hash, expires_at=excluded.expires_at, attempts=0;", -1, &stmt, 0) != SQLITE_OK) return 1;
+    sqlite3_bind_text(stmt, 1, email, -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 2, salt, -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 3, code_hash, -1, SQLITE_STATIC);
+    sqlite3_bind_int64(stmt, 4, expires_at);
+    int rc = sqlite3_step(stmt) == SQLITE_DONE ? 0 : 1;
+    sqlite3_finalize(stmt);
+    return rc;
+}
+
+// Count one more guess against an email's code and return what is stored
+// (before this guess). Returns 1 if there is no code.
+int db_use_verification(const char *email, char *salt, size_t salt_size, char *code_hash, size_t hash_size,
+                        long long *expires_at, int *attempts) {
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(db, "UPDATE VerificationCodes SET attempts=attempts+1 WHERE email=? "
+        "RETURNING salt, code_hash, expires_at, attempts-1;", -1, &stmt, 0) != SQLITE_OK) return 1;
+    sqlite3_bind_text(stmt, 1, email, -1, SQLITE_STATIC);
+    int result = 1;
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        snprintf(salt, salt_size, "%s", sqlite3_column_text(stmt, 0));
+        snprintf(code_hash, hash_size, "%s", sqlite3_column_text(stmt, 1));
+        *expires_at = sqlite3_column_int64(stmt, 2);
+        *attempts = sqlite3_column_int(stmt, 3);
+        result = 0;
+    }
+    sqlite3_finalize(stmt);
+    return result;
+}
+
+// Remove an email's code (used, expired or out of attempts)
+int db_delete_verification(const char *email) {
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(db, "DELETE FROM VerificationCodes WHERE email=?;", -1, &stmt, 0) != SQLITE_OK) return 1;
+    sqlite3_bind_text(stmt, 1, email, -1, SQLITE_STATIC);
+    int rc = sqlite3_step(stmt) == SQLITE_DONE ? 0 : 1;
+    sqlite3_finalize(stmt);
+    return rc;
+}
+
+// Visit the lockouts still in force, dropping the expired ones first
+int db_for_each_lockout(LockoutCallback callback, void *ctx) {
+    sqlite3_exec(db, "DELETE FROM LoginLockouts WHERE locked_until <= strftime('%s','now');", 0, 0, 0);
+
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(db, "SELECT key, failures, locked_until FROM LoginLockouts;", -1, &stmt, 0) != SQLITE_OK) return 1;
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        callback((const char*)sqlite3_column_text(stmt, 0), sqlite3_column_int(stmt, 1),
+            sqlite3_column_int64(stmt, 2), ctx);
+    }
+    sqlite3_finalize(stmt);
+    return 0;
+}
+
+// Read one stored lockout. Returns 0 if found, 2 if there is none and 1 on
+// a database error.
+int db_get_lockout(const char *key, int *failures, long long *locked_until) {
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(db, "SELECT failures, locked_until FROM LoginLockouts WHERE key=?;", -1, &stmt, 0)
+            != SQLITE_OK) return 1;
+    sqlite3_bind_text(stmt, 1, key, -1, SQLITE_STATIC);
+    int rc = sqlite3_step(stmt);
+    if (rc == SQLITE_ROW) {
+        *failures = sqlite3_column_int(stmt, 0);
+        *locked_until = sqlite3_column_int64(stmt, 1);
+    }
+    sqlite3_finalize(stmt);
+    return rc == SQLITE_ROW ? 0 : rc == SQLITE_DONE ? 2 : 1;
+}
+
+// Record (or extend) a lockout
+int db_save_lockout(const char *key, int failures, long long locked_until) {
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(db, "INSERT INTO LoginLockouts (key, failures, locked_until) VALUES (?, ?, ?) "
+        "ON CONFLICT(key) DO UPDATE SET failures=excluded.failures, locked_until=excluded.locked_until;",
+        -1, &stmt, 0) != SQLITE_OK) return 1;
+    sqlite3_bind_text(stmt, 1, key, -1, SQLITE_STATIC);
+    sqlite3_bind_int(stmt, 2, failures);
+    sqlite3_bind_int64(stmt, 3, locked_until);
+    int rc = sqlite3_step(stmt) == SQLITE_DONE ? 0 : 1;
+    sqlite3_finalize(stmt);
+    return rc;
+}
+
+// Remove a lockout after a successful login
+int db_clear_lockout(const char *key) {
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(db, "DELETE FROM LoginLockouts WHERE key=?;", -1, &stmt, 0) != SQLITE_OK) return 1;
+    sqlite3_bind_text(stmt, 1, key, -1, SQLITE_STATIC);
+    int rc = sqlite3_step(stmt) == SQLITE_DONE ? 0 : 1;
+    sqlite3_finalize(stmt);
+    return rc;
+}
+
 // ============================================
 // Member Management Functions
 // ============================================
@@ -232,22 +879,414 @@ int db_get_member(int user_id, Member *member) {
 // Create a new member record
 int db_create_member(int user_id) {
     char sql[256];
-    snprintf(sql, sizeof(sql), "INSERT OR IGNORE INTO Members (member_id) VALUES (%d);", user_id);
+    snprintf(sql, sizeof(sql), "INSERT OR IGNORE INTO Members (member_id, joined_at) VALUES (%d, datetime('now'));", user_id);
     return sqlite3_exec(db, sql, 0, 0, 0);
 }
 
-// Update member's plan and time slot
+// Update member's plan and time slot (starts a new membership period). The
+// caller logs EVENT_PLAN_CHANGED once its transaction commits.
 int db_update_member_plan(int member_id, int plan_id, const char *time_slot) {
-    char sql[256];
-    snprintf(sql, sizeof(sql), "UPDATE Members SET plan_id=%d, time_slot='%s' WHERE member_id=%d;", plan_id, time_slot, member_id);
+    char sql[512];
+    snprintf(sql, sizeof(sql),
+        "UPDATE Members SET plan_id=%d, time_slot='%s', status='ACTIVE', "
+        "renews_at=CAST(strftime('%%s','now') AS INTEGER) + %d WHERE member_id=%d;",
+        plan_id, time_slot, MEMBERSHIP_PERIOD_DAYS * 86400, member_id);
     return sqlite3_exec(db, sql, 0, 0, 0);
 }
 
+// Get the renewal deadline of an active member (0 if none)
+long long db_get_member_renewal(int member_id) {
+    char sql[256];
+    snprintf(sql, sizeof(sql), "SELECT renews_at FROM Members WHERE member_id=%d AND status='ACTIVE';", member_id);
+
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, 0) != SQLITE_OK) return 0;
+    long long due = 0;
+    if (sqlite3_step(stmt) == SQLITE_ROW) due = sqlite3_column_int64(stmt, 0);
+    sqlite3_finalize(stmt);
+    return due;
+}
+
+// Visit every member with a live plan: (member, current trainer, time slot)
+int db_for_each_plan_member(PlanMemberCallback callback, void *ctx) {
+    const char *sql =
+        "SELECT member_id, IFNULL(trainer_id, 0), IFNULL(time_slot, '') FROM Members "
+        "WHERE plan_id > 0 AND IFNULL(status, '') != 'EXPIRED';";
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, 0) != SQLITE_OK) return 1;
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        callback(sqlite3_column_int(stmt, 0), sqlite3_column_int(stmt, 1),
+            (const char*)sqlite3_column_text(stmt, 2), ctx);
+    }
+    sqlite3_finalize(stmt);
+    return 0;
+}
+
+// Cancel all of a member's class bookings, passing each seat down its
+// waitlist
+static void db_release_bookings(int member_id) {
+    if (db_begin() != 0) return;
+    if (booking_release_member(db, member_id) != 0 || db_commit() != 0) db_rollback();
+}
+
+// Fold a duplicate member account into the one being kept: attendance moves
+// over (one row per day), the membership moves over if the kept account has
+// none, and the duplicate's Members and Users rows are deleted. Class
+// bookings move over too, except where the kept account already has one,
+// and so do the duplicate's turnstile cards.
+int db_merge_members(int keep_id, int drop_id) {
+    if (keep_id == drop_id) return 1;
+    char sql[2048];
+    if (db_begin() != 0) return 1;
+    Member kept;
+    int had_plan = db_get_member(keep_id, &kept) == 0 && kept.plan_id > 0;
+
+    snprintf(sql, sizeof(sql),
+        "INSERT OR IGNORE INTO Members (member_id, joined_at) VALUES (%d, datetime('now'));"
+        "UPDATE Attendance SET member_id=%d WHERE member_id=%d "
+        "AND date NOT IN (SELECT date FROM Attendance WHERE member_id=%d);"
+        "DELETE FROM Attendance WHERE member_id=%d;"
+        "UPDATE Members SET "
+        "plan_id=(SELECT plan_id FROM Members WHERE member_id=%d),"
+        "trainer_id=(SELECT trainer_id FROM Members WHERE member_id=%d),"
+        "time_slot=(SELECT time_slot FROM Members WHERE member_id=%d),"
+        "status=(SELECT status FROM Members WHERE member_id=%d),"
+        "renews_at=(SELECT renews_at FROM Members WHERE member_id=%d) "
+        "WHERE member_id=%d AND IFNULL(plan_id, 0)=0 "
+        "AND EXISTS (SELECT 1 FROM Members WHERE member_id=%d AND IFNULL(plan_id, 0) > 0);"
+        "INSERT OR IGNORE INTO MemberPrograms (member_id, template_id, assigned_by, assigned_at) "
+        "SELECT %d, template_id, assigned_by, assigned_at FROM MemberPrograms WHERE member_id=%d;"
+        "DELETE FROM MemberPrograms WHERE member_id=%d;"
+        "UPDATE Bookings SET member_id=%d WHERE member_id=%d "
+        "AND class_id NOT IN (SELECT class_id FROM Bookings WHERE member_id=%d);"
+        "UPDATE MemberCards SET member_id=%d, seq=" CARD_NEXT_SEQ " WHERE member_id=%d;"
+        "DELETE FROM Members WHERE member_id=%d;"
+        "DELETE FROM Users WHERE user_id=%d AND role='Member';",
+        keep_id, keep_id, drop_id, keep_id, drop_id,
+        drop_id, drop_id, drop_id, drop_id, drop_id, keep_id, drop_id,
+        keep_id, drop_id, drop_id,
+        keep_id, drop_id, keep_id,
+        keep_id, drop_id,
+        drop_id, drop_id);
+
+    char *errMsg = 0;
+    if (sqlite3_exec(db, sql, 0, 0, &errMsg) != SQLITE_OK) {
+        fprintf(stderr, "SQL error (Merge Members): %s\n", errMsg);
+        sqlite3_free(errMsg);
+        db_rollback();
+        return 1;
+    }
+    // Classes both accounts had booked: the duplicate's place is given up
+    if (booking_release_member(db, drop_id) != 0 || db_commit() != 0) {
+        db_rollback();
+        return 1;
+    }
+    eventlog_append(EVENT_MEMBER_MERGED, drop_id, keep_id, NULL);
+
+    // Log the membership the kept account took over under its own id, so it
+    // survives compaction dropping the duplicate's history
+    if (!had_plan && db_get_member(keep_id, &kept) == 0 && kept.plan_id > 0) {
+        eventlog_append(EVENT_PLAN_CHANGED, keep_id, kept.plan_id, kept.time_slot);
+        if (kept.trainer_id > 0) eventlog_append(EVENT_TRAINER_ASSIGNED, keep_id, kept.trainer_id, NULL);
+        if (strcmp(kept.status, "EXPIRED") == 0) eventlog_append(EVENT_MEMBERSHIP_EXPIRED, keep_id, 0, NULL);
+    }
+    return 0;
+}
+
+// Apply many trainer assignments in a single transaction
+int db_assign_trainers_bulk(const int *member_ids, const int *trainer_ids, int count) {
+    if (db_begin() != 0) return 1;
+
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(db, "UPDATE Members SET trainer_id=?2 WHERE member_id=?1;", -1, &stmt, 0) != SQLITE_OK) {
+        db_rollback();
+        return 1;
+    }
+    for (int i = 0; i < count; i++) {
+        sqlite3_bind_int(stmt, 1, member_ids[i]);
+        sqlite3_bind_int(stmt, 2, trainer_ids[i]);
+        if (sqlite3_step(stmt) != SQLITE_DONE) {
+            sqlite3_finalize(stmt);
+            db_rollback();
+            return 1;
+        }
+        sqlite3_reset(stmt);
+    }
+    sqlite3_finalize(stmt);
+
+    if (db_commit() != 0) {
+        db_rollback();
+        return 1;
+    }
+    for (int i = 0; i < count; i++) {
+        eventlog_append(EVENT_TRAINER_ASSIGNED, member_ids[i], trainer_ids[i], NULL);
+    }
+    return 0;
+}
+
+// ============================================
+// Membership Renewal Functions
+// ============================================
+
+// Visit every active membership with its renewal deadline
+int db_for_each_renewal(RenewalCallback callback, void *ctx) {
+    const char *sql = "SELECT member_id, renews_at FROM Members WHERE status='ACTIVE' AND renews_at IS NOT NULL;";
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, 0) != SQLITE_OK) return 1;
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        callback(sqlite3_column_int(stmt, 0), sqlite3_column_int64(stmt, 1), ctx);
+    }
+    sqlite3_finalize(stmt);
+    return 0;
+}
+
+// Roll a membership into its next period if it is still due at `due_at`
+// and set to auto-renew. Returns 0 if renewed, 2 if it is not eligible
+// (changed since, or not auto-renewing) and 1 on a database error. Runs in
+// the caller's transaction, which logs EVENT_MEMBERSHIP_RENEWED once it
+// commits.
+int db_renew_membership(int member_id, long long due_at, int *plan_id, long long *next_due) {
+    const char *sql =
+        "UPDATE Members SET renews_at = renews_at + ?3 "
+        "WHERE member_id=?1 AND renews_at=?2 AND status='ACTIVE' AND auto_renew=1 AND plan_id > 0 "
+        "RETURNING plan_id, renews_at;";
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, 0) != SQLITE_OK) return 1;
+    sqlite3_bind_int(stmt, 1, member_id);
+    sqlite3_bind_int64(stmt, 2, due_at);
+    sqlite3_bind_int(stmt, 3, MEMBERSHIP_PERIOD_DAYS * 86400);
+
+    int rc = sqlite3_step(stmt);
+    int result = rc == SQLITE_ROW ? 0 : rc == SQLITE_DONE ? 2 : 1;
+    if (result == 0) {
+        *plan_id = sqlite3_column_int(stmt, 0);
+        *next_due = sqlite3_column_int64(stmt, 1);
+    }
+    sqlite3_finalize(stmt);
+    return result;
+}
+
+// Expire a membership that is still due at `due_at`. Returns 0 if expired,
+// 2 if it is no longer due and 1 on a database error. Like
+// db_renew_membership, the caller logs the event after its commit.
+int db_expire_membership(int member_id, long long due_at) {
+    const char *sql = "UPDATE Members SET status='EXPIRED' WHERE member_id=?1 AND renews_at=?2 AND status='ACTIVE';";
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, 0) != SQLITE_OK) return 1;
+    sqlite3_bind_int(stmt, 1, member_id);
+    sqlite3_bind_int64(stmt, 2, due_at);
+    int rc = sqlite3_step(stmt);
+    sqlite3_finalize(stmt);
+    if (rc != SQLITE_DONE) return 1;
+    return sqlite3_changes(db) == 1 ? 0 : 2;
+}
+
+// ============================================
+// Transactions
+// ============================================
+
+int db_begin() {
+    return sqlite3_exec(db, "BEGIN IMMEDIATE;", 0, 0, 0) == SQLITE_OK ? 0 : 1;
+}
+
+int db_commit() {
+    return sqlite3_exec(db, "COMMIT;", 0, 0, 0) == SQLITE_OK ? 0 : 1;
+}
+
+void db_rollback() {
+    sqlite3_exec(db, "ROLLBACK;", 0, 0, 0);
+}
+
 // Assign a trainer to a member
 int db_assign_trainer(int member_id, int trainer_id) {
     char sql[256];
     snprintf(sql, sizeof(sql), "UPDATE Members SET trainer_id=%d WHERE member_id=%d;", trainer_id, member_id);
-    return sqlite3_exec(db, sql, 0, 0, 0);
+    int rc = sqlite3_exec(db, sql, 0, 0, 0);
+    if (rc == SQLITE_OK) eventlog_append(EVENT_TRAINER_ASSIGNED, member_id, trainer_id, NULL);
+    return rc;
+}
+
+// ============================================
+// Attendance Functions
+// ============================================
+
+// Record today's check-in (once per day) and count it towards the
+// occupancy statistics. Returns 0 on a new check-in, 2 if the member had
+// already checked in today.
+int db_check_in(int member_id, const char *zone) {
+    char *zone_sql = sqlite3_mprintf("%Q", zone && zone[0] ? zone : NULL);
+    long long now = (long long)time(NULL);
+    char sql[1536];
+    snprintf(sql, sizeof(sql),
+        "INSERT INTO Attendance (member_id, date, status, checked_in_at, zone) "
+        "VALUES (%d, date(%lld, 'unixepoch', 'localtime'), 'PRESENT', %lld, %s);"
+        "INSERT INTO OccupancyStats (dow, hour, visits) VALUES ("
+        "CAST(strftime('%%w', %lld, 'unixepoch', 'localtime') AS INTEGER),"
+        "CAST(strftime('%%H', %lld, 'unixepoch', 'localtime') AS INTEGER), 1) "
+        "ON CONFLICT(dow, hour) DO UPDATE SET visits=visits+1;"
+        "INSERT INTO OccupancyDays (dow, days, last_date) VALUES ("
+        "CAST(strftime('%%w', %lld, 'unixepoch', 'localtime') AS INTEGER), 1, date(%lld, 'unixepoch', 'localtime')) "
+        "ON CONFLICT(dow) DO UPDATE SET days=days+1, last_date=excluded.last_date "
+        "WHERE last_date IS NOT excluded.last_date;",
+        member_id, now, now, zone_sql, now, now, now, now);
+    sqlite3_free(zone_sql);
+
+    // Test inside the write transaction, so two terminals checking the same
+    // member in at once cannot both pass it; the unique index backs this up
+    if (db_begin() != 0) return 1;
+    if (db_is_checked_in_today(member_id)) {
+        db_rollback();
+        return 2;
+    }
+    int rc = sqlite3_exec(db, sql, 0, 0, 0);
+    if (rc != SQLITE_OK) {
+        db_rollback();
+        return rc == SQLITE_CONSTRAINT ? 2 : 1;     // idx_attendance_member_day
+    }
+    if (db_commit() != 0) {
+        db_rollback();
+        return 1;
+    }
+    return 0;
+}
+
+// Record today's check-out and return the zone the member was in.
+// Returns 0 on a check-out, 2 if the member is not in the building.
+int db_check_out(int member_id, char *zone, size_t size) {
+    const char *sql =
+        "UPDATE Attendance SET checked_out_at=strftime('%s','now') "
+        "WHERE member_id=?1 AND date=date('now','localtime') AND checked_out_at IS NULL "
+        "RETURNING IFNULL(zone, '');";
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, 0) != SQLITE_OK) return 1;
+    sqlite3_bind_int(stmt, 1, member_id);
+
+    int result = 2;
+    int rc = sqlite3_step(stmt);
+    if (rc == SQLITE_ROW) {
+        snprintf(zone, size, "%s", (const char*)sqlite3_column_text(stmt, 0));
+        result = 0;
+    } else if (rc != SQLITE_DONE) {
+        result = 1;
+    }
+    sqlite3_finalize(stmt);
+    return result;
+}
+
+// Is the member checked in today and not yet checked out?
+int db_is_in_building(int member_id) {
+    char sql[256];
+    snprintf(sql, sizeof(sql),
+        "SELECT 1 FROM Attendance WHERE member_id=%d AND date=date('now','localtime') "
+        "AND checked_out_at IS NULL LIMIT 1;", member_id);
+
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, 0) != SQLITE_OK) return 0;
+    int found = sqlite3_step(stmt) == SQLITE_ROW;
+    sqlite3_finalize(stmt);
+    return found;
+}
+
+// Visit today's visitors still in the building, grouped by (time slot, zone)
+int db_for_each_present_group(PresentGroupCallback callback, void *ctx) {
+    const char *sql =
+        "SELECT IFNULL(m.time_slot, ''), IFNULL(a.zone, ''), COUNT(*) "
+        "FROM Attendance a LEFT JOIN Members m ON m.member_id = a.member_id "
+        "WHERE a.date=date('now','localtime') AND a.checked_out_at IS NULL "
+        "GROUP BY 1, 2;";
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, 0) != SQLITE_OK) return 1;
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        callback((const char*)sqlite3_column_text(stmt, 0), (const char*)sqlite3_column_text(stmt, 1),
+            sqlite3_column_int(stmt, 2), ctx);
+    }
+    sqlite3_finalize(stmt);
+    return 0;
+}
+
+// Replace the LiveOccupancy checkpoint in one transaction
+int db_save_live_occupancy(const OccupancyCount *counts, int count) {
+    if (db_begin() != 0) return 1;
+    sqlite3_stmt *stmt;
+    if (sqlite3_exec(db, "DELETE FROM LiveOccupancy;", 0, 0, 0) != SQLITE_OK ||
+        sqlite3_prepare_v2(db, "INSERT INTO LiveOccupancy (time_slot, zone, present, updated_at) "
+            "VALUES (?, ?, ?, strftime('%s','now'));", -1, &stmt, 0) != SQLITE_OK) {
+        db_rollback();
+        return 1;
+    }
+    int failed = 0;
+    for (int i = 0; i < count && !failed; i++) {
+        sqlite3_bind_text(stmt, 1, counts[i].time_slot, -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 2, counts[i].zone, -1, SQLITE_STATIC);
+        sqlite3_bind_int(stmt, 3, counts[i].present);
+        failed = sqlite3_step(stmt) != SQLITE_DONE;
+        sqlite3_reset(stmt);
+    }
+    sqlite3_finalize(stmt);
+    if (failed || db_commit() != 0) {
+        db_rollback();
+        return 1;
+    }
+    return 0;
+}
+
+// Load the occupancy statistics: visits per (weekday 0=Sunday, hour) and
+// the number of distinct days with check-ins per weekday
+int db_get_occupancy(int visits[7][24], int days[7]) {
+    memset(visits, 0, sizeof(int) * 7 * 24);
+    memset(days, 0, sizeof(int) * 7);
+
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(db, "SELECT dow, hour, visits FROM OccupancyStats;", -1, &stmt, 0) != SQLITE_OK) return 1;
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        int dow = sqlite3_column_int(stmt, 0), hour = sqlite3_column_int(stmt, 1);
+        if (dow >= 0 && dow < 7 && hour >= 0 && hour < 24) visits[dow][hour] = sqlite3_column_int(stmt, 2);
+    }
+    sqlite3_finalize(stmt);
+
+    if (sqlite3_prepare_v2(db, "SELECT dow, days FROM OccupancyDays;", -1, &stmt, 0) != SQLITE_OK) return 1;
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        int dow = sqlite3_column_int(stmt, 0);
+        if (dow >= 0 && dow < 7) days[dow] = sqlite3_column_int(stmt, 1);
+    }
+    sqlite3_finalize(stmt);
+    return 0;
+}
+
+// Has the member checked in today?
+int db_is_checked_in_today(int member_id) {
+    char sql[256];
+    snprintf(sql, sizeof(sql),
+        "SELECT 1 FROM Attendance WHERE member_id=%d AND date=date('now','localtime') LIMIT 1;", member_id);
+
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, 0) != SQLITE_OK) return 0;
+    int found = sqlite3_step(stmt) == SQLITE_ROW;
+    sqlite3_finalize(stmt);
+    return found;
+}
+
+// Visits and distinct members between two dates (inclusive). Archived years
+// are attached only if the range reaches back into them.
+int db_count_visits(const char *from_date, const char *to_date, long *visits, long *members) {
+    *visits = *members = 0;
+    if (archive_attach(db, current_path, from_date, to_date) < 0) return 1;
+
+    sqlite3_stmt *stmt;
+    int rc = 1;
+    if (sqlite3_prepare_v2(db, "SELECT COUNT(*), COUNT(DISTINCT member_id) FROM AttendanceAll "
+                           "WHERE date BETWEEN ? AND ?;", -1, &stmt, 0) == SQLITE_OK) {
+        sqlite3_bind_text(stmt, 1, from_date, -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 2, to_date, -1, SQLITE_STATIC);
+        if (sqlite3_step(stmt) == SQLITE_ROW) {
+            *visits = sqlite3_column_int64(stmt, 0);
+            *members = sqlite3_column_int64(stmt, 1);
+            rc = 0;
+        }
+        sqlite3_finalize(stmt);
+    }
+    archive_detach(db);
+    return rc;
 }
 
 // ============================================
@@ -258,7 +1297,7 @@ int db_assign_trainer(int member_id, int trainer_id) {
 int db_create_trainer(int user_id, const char *specialization) {
     char sql[512];
     snprintf(sql, sizeof(sql), 
-        "INSERT INTO Trainers (trainer_id, specialization, status) VALUES (%d, '%s', 'PENDING_APPROVAL');",
+        "INSERT INTO Trainers (trainer_id, specialization, status, joined_at) VALUES (%d, '%s', 'PENDING_APPROVAL', datetime('now'));",
         user_id, specialization);
     
     char *errMsg = 0;
@@ -270,13 +1309,345 @@ int db_create_trainer(int user_id, const char *specialization) {
     return 0;
 }
 
+// Get a trainer's status ("PENDING_APPROVAL" / "APPROVED")
+int db_get_trainer(int trainer_id, Trainer *trainer) {
+    char sql[256];
+    snprintf(sql, sizeof(sql), "SELECT trainer_id, specialization, status FROM Trainers WHERE trainer_id=%d;", trainer_id);
+
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, 0) != SQLITE_OK) return 1;
+
+    int result = 1;
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        trainer->trainer_id = sqlite3_column_int(stmt, 0);
+        snprintf(trainer->specialization, sizeof(trainer->specialization), "%s", sqlite3_column_text(stmt, 1) ? (const char*)sqlite3_column_text(stmt, 1) : "");
+        snprintf(trainer->status, sizeof(trainer->status), "%s", sqlite3_column_text(stmt, 2) ? (const char*)sqlite3_column_text(stmt, 2) : "");
+        result = 0;
+    }
+    sqlite3_finalize(stmt);
+    return result;
+}
+
+// Get the members assigned to a trainer, with today's check-in state.
+// Served by idx_members_trainer, so the cost is proportional to the roster.
+int db_get_trainer_roster(int trainer_id, RosterEntry *entries, int *count) {
+    const char *sql =
+        "SELECT m.member_id, u.name, u.email, p.name, m.time_slot, m.status, "
+        "EXISTS(SELECT 1 FROM Attendance a WHERE a.member_id = m.member_id AND a.date = date('now','localtime')), "
+        "IFNULL(mp.template_id, 0) "
+        "FROM Members m JOIN Users u ON m.member_id = u.user_id LEFT JOIN Plans p ON m.plan_id = p.plan_id "
+        "LEFT JOIN MemberPrograms mp ON mp.member_id = m.member_id "
+        "WHERE m.trainer_id = ? ORDER BY u.name;";
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, 0) != SQLITE_OK) return 1;
+    sqlite3_bind_int(stmt, 1, trainer_id);
+
+    int i = 0;
+    while (i < *count && sqlite3_step(stmt) == SQLITE_ROW) {
+        entries[i].member_id = sqlite3_column_int(stmt, 0);
+        snprintf(entries[i].name, sizeof(entries[i].name), "%s", sqlite3_column_text(stmt, 1));
+        snprintf(entries[i].email, sizeof(entries[i].email), "%s", sqlite3_column_text(stmt, 2));
+        snprintf(entries[i].plan_name, sizeof(entries[i].plan_name), "%s", sqlite3_column_text(stmt, 3) ? (const char*)sqlite3_column_text(stmt, 3) : "None");
+        snprintf(entries[i].time_slot, sizeof(entries[i].time_slot), "%s", sqlite3_column_text(stmt, 4) ? (const char*)sqlite3_column_text(stmt, 4) : "");
+        snprintf(entries[i].status, sizeof(entries[i].status), "%s", sqlite3_column_text(stmt, 5) ? (const char*)sqlite3_column_text(stmt, 5) : "");
+        entries[i].checked_in_today = sqlite3_column_int(stmt, 6);
+        entries[i].template_id = sqlite3_column_int(stmt, 7);
+        i++;
+    }
+    *count = i;
+    sqlite3_finalize(stmt);
+    return 0;
+}
+
+// ============================================
+// Workout Programs
+// ============================================
+
+// Walk every template day and its exercises in template, weekday and
+// position order. Training days without exercises come through once with
+// a NULL exercise.
+int db_for_each_program_row(ProgramRowCallback callback, void *ctx) {
+    const char *sql =
+        "SELECT t.template_id, t.name, d.weekday, d.focus, e.name, x.sets, x.reps "
+        "FROM WorkoutTemplates t "
+        "JOIN TemplateDays d ON d.template_id = t.template_id "
+        "LEFT JOIN TemplateExercises x ON x.template_id = d.template_id AND x.weekday = d.weekday "
+        "LEFT JOIN Exercises e ON e.exercise_id = x.exercise_id "
+        "ORDER BY t.template_id, d.weekday, x.position;";
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, 0) != SQLITE_OK) return 1;
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        callback(sqlite3_column_int(stmt, 0), (const char*)sqlite3_column_text(stmt, 1),
+            sqlite3_column_int(stmt, 2), (const char*)sqlite3_column_text(stmt, 3),
+            (const char*)sqlite3_column_text(stmt, 4), sqlite3_column_int(stmt, 5),
+            sqlite3_column_int(stmt, 6), ctx);
+    }
+    sqlite3_finalize(stmt);
+    return 0;
+}
+
+// Get a member's assigned template (primary-key lookup); 0 if none
+int db_get_member_program(int member_id, int *template_id) {
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(db, "SELECT template_id FROM MemberPrograms WHERE member_id=?;", -1, &stmt, 0) != SQLITE_OK) return 1;
+    sqlite3_bind_int(stmt, 1, member_id);
+    *template_id = sqlite3_step(stmt) == SQLITE_ROW ? sqlite3_column_int(stmt, 0) : 0;
+    sqlite3_finalize(stmt);
+    return 0;
+}
+
+// Assign a template to a member, replacing any earlier one
+int db_assign_program(int member_id, int template_id, int assigned_by) {
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(db,
+        "INSERT INTO MemberPrograms (member_id, template_id, assigned_by, assigned_at) "
+        "VALUES (?1, ?2, ?3, strftime('%s','now')) "
+        "ON CONFLICT(member_id) DO UPDATE SET template_id=?2, assigned_by=?3, assigned_at=strftime('%s','now');",
+        -1, &stmt, 0) != SQLITE_OK) return 1;
+    sqlite3_bind_int(stmt, 1, member_id);
+    sqlite3_bind_int(stmt, 2, template_id);
+    sqlite3_bind_int(stmt, 3, assigned_by);
+    int rc = sqlite3_step(stmt) == SQLITE_DONE ? 0 : 1;
+    sqlite3_finalize(stmt);
+    if (rc == 0) eventlog_append(EVENT_PROGRAM_ASSIGNED, member_id, template_id, NULL);
+    return rc;
+}
+
+// ============================================
+// Payments
+// ============================================
+
+// Append one payment to the ledger
+int db_insert_payment(int member_id, int plan_id, int amount_cents, int day, long long paid_at, const char *kind) {
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(db,
+        "INSERT INTO Payments (member_id, plan_id, amount_cents, day, paid_at, kind) VALUES (?, ?, ?, ?, ?, ?);",
+        -1, &stmt, 0) != SQLITE_OK) return 1;
+    sqlite3_bind_int(stmt, 1, member_id);
+    sqlite3_bind_int(stmt, 2, plan_id);
+    sqlite3_bind_int(stmt, 3, amount_cents);
+    sqlite3_bind_int(stmt, 4, day);
+    sqlite3_bind_int64(stmt, 5, paid_at);
+    sqlite3_bind_text(stmt, 6, kind, -1, SQLITE_STATIC);
+    int rc = sqlite3_step(stmt) == SQLITE_DONE ? 0 : 1;
+    sqlite3_finalize(stmt);
+    return rc;
+}
+
+// Visit the payments after `after_id` summed per (plan, day), and report
+// the highest payment id seen (unchanged if there were none)
+int db_for_each_payment_day(long long after_id, PaymentDayCallback callback, void *ctx, long long *last_id) {
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(db,
+        "SELECT plan_id, day, SUM(amount_cents), COUNT(*), MAX(payment_id) FROM Payments "
+        "WHERE payment_id > ? GROUP BY plan_id, day;", -1, &stmt, 0) != SQLITE_OK) return 1;
+    sqlite3_bind_int64(stmt, 1, after_id);
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        callback(sqlite3_column_int(stmt, 0), sqlite3_column_int(stmt, 1), sqlite3_column_int64(stmt, 2),
+            sqlite3_column_int(stmt, 3), ctx);
+        long long max_id = sqlite3_column_int64(stmt, 4);
+        if (max_id > *last_id) *last_id = max_id;
+    }
+    sqlite3_finalize(stmt);
+    return rc == SQLITE_DONE ? 0 : 1;
+}
+
+// Every visit above after_id of a current member as (member, day). The
+// first build passes with_archives to read the yearly archive files too.
+int db_for_each_visit(long long after_id, int with_archives, VisitDayCallback callback, void *ctx, long long *last_id) {
+    if (with_archives && archive_attach(db, current_path, NULL, NULL) < 0) return 1;
+
+    char sql[256];
+    snprintf(sql, sizeof(sql),
+        "SELECT attendance_id, member_id, CAST(julianday(date) - 2440587.5 AS INTEGER) FROM %s "
+        "WHERE attendance_id > ? AND julianday(date) IS NOT NULL "
+        "AND +member_id IN (SELECT member_id FROM Members);",
+        with_archives ? "AttendanceAll" : "Attendance");
+    sqlite3_stmt *stmt;
+    int rc = SQLITE_ERROR;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, 0) == SQLITE_OK) {
+        sqlite3_bind_int64(stmt, 1, after_id);
+        while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+            long long id = sqlite3_column_int64(stmt, 0);
+            callback(sqlite3_column_int(stmt, 1), sqlite3_column_int(stmt, 2), ctx);
+            if (id > *last_id) *last_id = id;
+        }
+        sqlite3_finalize(stmt);
+    }
+    if (with_archives) archive_detach(db);
+    return rc == SQLITE_DONE ? 0 : 1;
+}
+
+// Load the saved bitmaps; *last_id is -1 if none were ever saved
+int db_load_visit_maps(VisitMapCallback callback, void *ctx, long long *last_id) {
+    *last_id = -1;
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(db, "SELECT last_attendance_id FROM VisitMapState WHERE id=1;", -1, &stmt, 0) != SQLITE_OK) {
+        return 1;
+    }
+    if (sqlite3_step(stmt) == SQLITE_ROW) *last_id = sqlite3_column_int64(stmt, 0);
+    sqlite3_finalize(stmt);
+    if (*last_id < 0) return 0;
+
+    if (sqlite3_prepare_v2(db, "SELECT member_id, first_word, bits FROM VisitMaps;", -1, &stmt, 0) != SQLITE_OK) {
+        return 1;
+    }
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        callback(sqlite3_column_int(stmt, 0), sqlite3_column_int(stmt, 1), sqlite3_column_blob(stmt, 2),
+            sqlite3_column_bytes(stmt, 2), ctx);
+    }
+    sqlite3_finalize(stmt);
+    return rc == SQLITE_DONE ? 0 : 1;
+}
+
+// Replace the given bitmaps and the folded-in watermark in one transaction
+int db_save_visit_maps(const VisitMapRow *rows, int count, long long last_id) {
+    if (db_begin() != 0) return 1;
+    sqlite3_stmt *upsert, *remove;
+    if (sqlite3_prepare_v2(db, "INSERT OR REPLACE INTO VisitMaps (member_id, first_word, bits) VALUES (?, ?, ?);",
+                           -1, &upsert, 0) != SQLITE_OK) {
+        db_rollback();
+        return 1;
+    }
+    if (sqlite3_prepare_v2(db, "DELETE FROM VisitMaps WHERE member_id=?;", -1, &remove, 0) != SQLITE_OK) {
+        sqlite3_finalize(upsert);
+        db_rollback();
+        return 1;
+    }
+    int failed = 0;
+    for (int i = 0; i < count && !failed; i++) {
+        sqlite3_stmt *stmt = rows[i].size > 0 ? upsert : remove;
+        sqlite3_bind_int(stmt, 1, rows[i].member_id);
+        if (rows[i].size > 0) {
+            sqlite3_bind_int(stmt, 2, rows[i].first_word);
+            sqlite3_bind_blob(stmt, 3, rows[i].bits, rows[i].size, SQLITE_STATIC);
+        }
+        failed = sqlite3_step(stmt) != SQLITE_DONE;
+        sqlite3_reset(stmt);
+    }
+    sqlite3_finalize(upsert);
+    sqlite3_finalize(remove);
+
+    char sql[192];
+    snprintf(sql, sizeof(sql),
+        "INSERT INTO VisitMapState (id, last_attendance_id) VALUES (1, %lld) "
+        "ON CONFLICT(id) DO UPDATE SET last_attendance_id=excluded.last_attendance_id;", last_id);
+    if (!failed) failed = sqlite3_exec(db, sql, 0, 0, 0) != SQLITE_OK;
+    if (failed || db_commit() != 0) {
+        db_rollback();
+        return 1;
+    }
+    return 0;
+}
+
+// ============================================
+// Member Card Functions
+// ============================================
+
+// Issue a card to a member. A revoked card can be issued again; one that
+// still opens the gate for someone is refused.
+int db_issue_card(const char *card_id, int member_id, long long issued_at) {
+    const char *sql =
+        "INSERT INTO MemberCards (card_id, member_id, issued_at, seq) "
+        "VALUES (?1, ?2, ?3, " CARD_NEXT_SEQ ") "
+        "ON CONFLICT(card_id) DO UPDATE SET member_id=excluded.member_id, issued_at=excluded.issued_at, "
+        "revoked_at=NULL, seq=excluded.seq WHERE revoked_at IS NOT NULL;";
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, 0) != SQLITE_OK) return 1;
+    sqlite3_bind_text(stmt, 1, card_id, -1, SQLITE_STATIC);
+    sqlite3_bind_int(stmt, 2, member_id);
+    sqlite3_bind_int64(stmt, 3, issued_at);
+    int rc = sqlite3_step(stmt);
+    sqlite3_finalize(stmt);
+    return rc == SQLITE_DONE && sqlite3_changes(db) == 1 ? 0 : 1;
+}
+
+// Stop a card from opening the gate. Returns 1 if it was not active.
+int db_revoke_card(const char *card_id, long long revoked_at) {
+    const char *sql =
+        "UPDATE MemberCards SET revoked_at=?2, seq=" CARD_NEXT_SEQ " "
+        "WHERE card_id=?1 AND revoked_at IS NULL;";
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, 0) != SQLITE_OK) return 1;
+    sqlite3_bind_text(stmt, 1, card_id, -1, SQLITE_STATIC);
+    sqlite3_bind_int64(stmt, 2, revoked_at);
+    int rc = sqlite3_step(stmt);
+    sqlite3_finalize(stmt);
+    return rc == SQLITE_DONE && sqlite3_changes(db) == 1 ? 0 : 1;
+}
+
+// Most recently issued cards with their holders
+int db_get_cards(CardDetail *cards, int *count) {
+    const char *sql =
+        "SELECT c.card_id, c.member_id, IFNULL(u.name, ''), IFNULL(u.email, ''), c.issued_at, "
+        "c.revoked_at IS NOT NULL FROM MemberCards c LEFT JOIN Users u ON u.user_id = c.member_id "
+        "ORDER BY c.issued_at DESC, c.card_id LIMIT ?;";
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, 0) != SQLITE_OK) return 1;
+    sqlite3_bind_int(stmt, 1, *count);
+
+    int i = 0;
+    while (sqlite3_step(stmt) == SQLITE_ROW && i < *count) {
+        snprintf(cards[i].card_id, sizeof(cards[i].card_id), "%s", sqlite3_column_text(stmt, 0));
+        cards[i].member_id = sqlite3_column_int(stmt, 1);
+        snprintf(cards[i].name, sizeof(cards[i].name), "%s", sqlite3_column_text(stmt, 2));
+        snprintf(cards[i].email, sizeof(cards[i].email), "%s", sqlite3_column_text(stmt, 3));
+        cards[i].issued_at = sqlite3_column_int64(stmt, 4);
+        cards[i].revoked = sqlite3_column_int(stmt, 5);
+        i++;
+    }
+    *count = i;
+    sqlite3_finalize(stmt);
+    return 0;
+}
+
+// Visit every card changed after `after_seq`, revoked ones included
+int db_for_each_card(long long after_seq, CardCallback callback, void *ctx, long long *last_seq) {
+    const char *sql =
+        "SELECT card_id, member_id, revoked_at IS NOT NULL, seq FROM MemberCards WHERE seq > ? ORDER BY seq;";
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, 0) != SQLITE_OK) return 1;
+    sqlite3_bind_int64(stmt, 1, after_seq);
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        callback((const char*)sqlite3_column_text(stmt, 0), sqlite3_column_int(stmt, 1),
+            sqlite3_column_int(stmt, 2), ctx);
+        *last_seq = sqlite3_column_int64(stmt, 3);
+    }
+    sqlite3_finalize(stmt);
+    return rc == SQLITE_DONE ? 0 : 1;
+}
+
+// Membership of one member, or of every member holding an active card
+// when member_id is 0. A member with no row is not visited.
+int db_for_each_gate_member(int member_id, GateMemberCallback callback, void *ctx) {
+    const char *sql = member_id > 0 ?
+        "SELECT member_id, IFNULL(plan_id, 0), IFNULL(time_slot, ''), status='ACTIVE', IFNULL(renews_at, 0), "
+        "IFNULL(auto_renew, 0) FROM Members WHERE member_id=?;" :
+        "SELECT member_id, IFNULL(plan_id, 0), IFNULL(time_slot, ''), status='ACTIVE', IFNULL(renews_at, 0), "
+        "IFNULL(auto_renew, 0) FROM Members "
+        "WHERE member_id IN (SELECT member_id FROM MemberCards WHERE revoked_at IS NULL);";
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, 0) != SQLITE_OK) return 1;
+    if (member_id > 0) sqlite3_bind_int(stmt, 1, member_id);
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        callback(sqlite3_column_int(stmt, 0), sqlite3_column_int(stmt, 1), (const char*)sqlite3_column_text(stmt, 2),
+            sqlite3_column_int(stmt, 3), sqlite3_column_int64(stmt, 4), sqlite3_column_int(stmt, 5), ctx);
+    }
+    sqlite3_finalize(stmt);
+    return rc == SQLITE_DONE ? 0 : 1;
+}
+
 // ============================================
 // Data Retrieval Functions
 // ============================================
 
 // Get all available plans
 int db_get_plans(Plan *plans, int *count) {
-    const char *sql = "SELECT * FROM Plans;";
+    const char *sql = "SELECT plan_id, name, IFNULL(price_cents, 0), time_slot FROM Plans;";
     sqlite3_stmt *stmt;
     if (sqlite3_prepare_v2(db, sql, -1, &stmt, 0) != SQLITE_OK) return 1;
     
@@ -284,7 +1655,7 @@ int db_get_plans(Plan *plans, int *count) {
     while (sqlite3_step(stmt) == SQLITE_ROW && i < *count) {
         plans[i].plan_id = sqlite3_column_int(stmt, 0);
         snprintf(plans[i].name, sizeof(plans[i].name), "%s", sqlite3_column_text(stmt, 1));
-        plans[i].price = sqlite3_column_double(stmt, 2);
+        plans[i].price_cents = sqlite3_column_int(stmt, 2);
         snprintf(plans[i].time_slot, sizeof(plans[i].time_slot), "%s", sqlite3_column_text(stmt, 3));
         i++;
     }
@@ -342,17 +1713,40 @@ int db_get_pending_trainers(TrainerDetail *trainers, int *count) {
 int db_approve_trainer(int trainer_id) {
     char sql[256];
     snprintf(sql, sizeof(sql), "UPDATE Trainers SET status='APPROVED' WHERE trainer_id=%d;", trainer_id);
-    return sqlite3_exec(db, sql, 0, 0, 0);
+    int rc = sqlite3_exec(db, sql, 0, 0, 0);
+    if (rc == SQLITE_OK) eventlog_append(EVENT_TRAINER_APPROVED, trainer_id, 0, NULL);
+    return rc;
+}
+
+// Delete a trainer's Trainers and Users rows and unassign their members in
+// one transaction, recording why once it commits
+static int db_remove_trainer(int trainer_id, EventType reason) {
+    char sql[256];
+    snprintf(sql, sizeof(sql),
+        "UPDATE Members SET trainer_id=NULL WHERE trainer_id=%d; "
+        "DELETE FROM Trainers WHERE trainer_id=%d; "
+        "DELETE FROM Users WHERE user_id=%d;",
+        trainer_id, trainer_id, trainer_id);
+
+    if (db_begin() != 0) return 1;
+    char *errMsg = 0;
+    if (sqlite3_exec(db, sql, 0, 0, &errMsg) != SQLITE_OK) {
+        fprintf(stderr, "SQL error (Remove Trainer): %s\n", errMsg);
+        sqlite3_free(errMsg);
+        db_rollback();
+        return 1;
+    }
+    if (db_commit() != 0) {
+        db_rollback();
+        return 1;
+    }
+    eventlog_append(reason, trainer_id, 0, NULL);
+    return 0;
 }
 
 // Reject a trainer application (deletes user)
 int db_reject_trainer(int trainer_id) {
-    // Delete from Trainers and Users
-    char sql[256];
-    snprintf(sql, sizeof(sql), "DELETE FROM Trainers WHERE trainer_id=%d;", trainer_id);
-    sqlite3_exec(db, sql, 0, 0, 0);
-    snprintf(sql, sizeof(sql), "DELETE FROM Users WHERE user_id=%d;", trainer_id);
-    return sqlite3_exec(db, sql, 0, 0, 0);
+    return db_remove_trainer(trainer_id, EVENT_TRAINER_REJECTED);
 }
 
 // Get all members with details
@@ -395,16 +1789,165 @@ int db_get_all_trainers_detail(TrainerDetail *trainers, int *count) {
     return 0;
 }
 
+// ============================================
+// Paginated Listings
+// ============================================
+
+// Sort key and tiebreaker for one listing order. The expressions must match
+// the indexes created in db_init() so every page is a single index seek.
+typedef struct {
+    const char *key;
+    const char *id;
+    int numeric;
+} SortSpec;
+
+static const SortSpec member_sorts[] = {
+    [LIST_SORT_NAME]   = {"u.name", "u.user_id", 0},
+    [LIST_SORT_PLAN]   = {"IFNULL(m.plan_id, 0)", "m.member_id", 1},
+    [LIST_SORT_STATUS] = {"IFNULL(m.status, '')", "m.member_id", 0},
+    [LIST_SORT_JOINED] = {"IFNULL(m.joined_at, '')", "m.member_id", 0},
+};
+
+static const SortSpec trainer_sorts[] = {
+    [LIST_SORT_NAME]   = {"u.name", "u.user_id", 0},
+    [LIST_SORT_PLAN]   = {"IFNULL(t.specialization, '')", "t.trainer_id", 0},
+    [LIST_SORT_STATUS] = {"IFNULL(t.status, '')", "t.trainer_id", 0},
+    [LIST_SORT_JOINED] = {"IFNULL(t.joined_at, '')", "t.trainer_id", 0},
+};
+
+// Prepare a keyset page query. The sort key is appended as the last column.
+static sqlite3_stmt* prepare_page(const char *columns, const char *from, const SortSpec *spec,
+                                  PageDirection dir, const PageCursor *anchor, int limit) {
+    int has_anchor = anchor && anchor->valid;
+    const char *op = dir == PAGE_PREV ? "<" : (dir == PAGE_FROM ? ">=" : ">");
+    const char *order = dir == PAGE_PREV ? "DESC" : "ASC";
+
+    // The redundant single-column bound lets SQLite seek expression indexes,
+    // which it will not do from a row-value comparison alone.
+    char where[512] = "";
+    if (has_anchor) {
+        snprintf(where, sizeof(where), " WHERE %s %s ?1 AND (%s, %s) %s (?1, ?2)",
+            spec->key, dir == PAGE_PREV ? "<=" : ">=", spec->key, spec->id, op);
+    }
+
+    char sql[1024];
+    snprintf(sql, sizeof(sql), "SELECT %s, %s FROM %s%s ORDER BY %s %s, %s %s LIMIT ?3;",
+        columns, spec->key, from, where, spec->key, order, spec->id, order);
+
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, 0) != SQLITE_OK) {
+        fprintf(stderr, "Error preparing page query: %s\n", sqlite3_errmsg(db));
+        return NULL;
+    }
+    if (has_anchor) {
+        if (spec->numeric) {
+            sqlite3_bind_int(stmt, 1, atoi(anchor->key));
+        } else {
+            sqlite3_bind_text(stmt, 1, anchor->key, -1, SQLITE_TRANSIENT);
+        }
+        sqlite3_bind_int(stmt, 2, anchor->id);
+    }
+    sqlite3_bind_int(stmt, 3, limit);
+    return stmt;
+}
+
+// Remember the sort key of a fetched row so the next query can resume after it
+static void set_cursor(PageCursor *cursor, sqlite3_stmt *stmt, int key_col, int id) {
+    cursor->valid = 1;
+    cursor->id = id;
+    snprintf(cursor->key, sizeof(cursor->key), "%s",
+        sqlite3_column_text(stmt, key_col) ? (const char*)sqlite3_column_text(stmt, key_col) : "");
+}
+
+// PAGE_PREV walks the index backwards; flip rows and cursors into display order
+static void reverse_page(void *rows, size_t row_size, int count, PageCursor *first, PageCursor *last) {
+    char *base = rows;
+    for (int i = 0, j = count - 1; i < j; i++, j--) {
+        char *a = base + i * row_size, *b = base + j * row_size;
+        for (size_t k = 0; k < row_size; k++) {
+            char tmp = a[k];
+            a[k] = b[k];
+            b[k] = tmp;
+        }
+    }
+    PageCursor swap = *first;
+    *first = *last;
+    *last = swap;
+}
+
+// Get one page of members in the given order, relative to an anchor row
+int db_get_members_page(ListSort sort, PageDirection dir, const PageCursor *anchor,
+                        MemberDetail *members, int *count, PageCursor *first, PageCursor *last) {
+    sqlite3_stmt *stmt = prepare_page("m.member_id, u.name, u.email, p.name, m.status",
+        "Members m JOIN Users u ON m.member_id = u.user_id LEFT JOIN Plans p ON m.plan_id = p.plan_id",
+        &member_sorts[sort], dir, anchor, *count);
+    if (!stmt) return 1;
+
+    first->valid = last->valid = 0;
+    int i = 0;
+    while (i < *count && sqlite3_step(stmt) == SQLITE_ROW) {
+        members[i].member_id = sqlite3_column_int(stmt, 0);
+        snprintf(members[i].name, sizeof(members[i].name), "%s", sqlite3_column_text(stmt, 1));
+        snprintf(members[i].email, sizeof(members[i].email), "%s", sqlite3_column_text(stmt, 2));
+        snprintf(members[i].plan_name, sizeof(members[i].plan_name), "%s", sqlite3_column_text(stmt, 3) ? (const char*)sqlite3_column_text(stmt, 3) : "None");
+        snprintf(members[i].status, sizeof(members[i].status), "%s", sqlite3_column_text(stmt, 4) ? (const char*)sqlite3_column_text(stmt, 4) : "");
+        if (i == 0) set_cursor(first, stmt, 5, members[i].member_id);
+        set_cursor(last, stmt, 5, members[i].member_id);
+        i++;
+    }
+    *count = i;
+    sqlite3_finalize(stmt);
+
+    if (dir == PAGE_PREV) reverse_page(members, sizeof(MemberDetail), i, first, last);
+    return 0;
+}
+
+// Get one page of trainers in the given order, relative to an anchor row
+int db_get_trainers_page(ListSort sort, PageDirection dir, const PageCursor *anchor,
+                         TrainerDetail *trainers, int *count, PageCursor *first, PageCursor *last) {
+    sqlite3_stmt *stmt = prepare_page("t.trainer_id, u.name, u.email, t.specialization, t.status",
+        "Trainers t JOIN Users u ON t.trainer_id = u.user_id AND u.role = 'Trainer'",
+        &trainer_sorts[sort], dir, anchor, *count);
+    if (!stmt) return 1;
+
+    first->valid = last->valid = 0;
+    int i = 0;
+    while (i < *count && sqlite3_step(stmt) == SQLITE_ROW) {
+        trainers[i].trainer_id = sqlite3_column_int(stmt, 0);
+        snprintf(trainers[i].name, sizeof(trainers[i].name), "%s", sqlite3_column_text(stmt, 1));
+        snprintf(trainers[i].email, sizeof(trainers[i].email), "%s", sqlite3_column_text(stmt, 2));
+        snprintf(trainers[i].specialization, sizeof(trainers[i].specialization), "%s", sqlite3_column_text(stmt, 3) ? (const char*)sqlite3_column_text(stmt, 3) : "");
+        snprintf(trainers[i].status, sizeof(trainers[i].status), "%s", sqlite3_column_text(stmt, 4) ? (const char*)sqlite3_column_text(stmt, 4) : "");
+        if (i == 0) set_cursor(first, stmt, 5, trainers[i].trainer_id);
+        set_cursor(last, stmt, 5, trainers[i].trainer_id);
+        i++;
+    }
+    *count = i;
+    sqlite3_finalize(stmt);
+
+    if (dir == PAGE_PREV) reverse_page(trainers, sizeof(TrainerDetail), i, first, last);
+    return 0;
+}
+
 // Delete a member
 int db_delete_member(int member_id) {
     char sql[256];
+    snprintf(sql, sizeof(sql), "DELETE FROM MemberPrograms WHERE member_id=%d;", member_id);
+    sqlite3_exec(db, sql, 0, 0, 0);
+    db_release_bookings(member_id);
+    snprintf(sql, sizeof(sql),
+        "UPDATE MemberCards SET revoked_at=CAST(strftime('%%s','now') AS INTEGER), seq=" CARD_NEXT_SEQ " "
+        "WHERE member_id=%d AND revoked_at IS NULL;", member_id);
+    sqlite3_exec(db, sql, 0, 0, 0);
     snprintf(sql, sizeof(sql), "DELETE FROM Members WHERE member_id=%d;", member_id);
     sqlite3_exec(db, sql, 0, 0, 0);
     snprintf(sql, sizeof(sql), "DELETE FROM Users WHERE user_id=%d;", member_id);
-    return sqlite3_exec(db, sql, 0, 0, 0);
+    int rc = sqlite3_exec(db, sql, 0, 0, 0);
+    if (rc == SQLITE_OK) eventlog_append(EVENT_MEMBER_DELETED, member_id, 0, NULL);
+    return rc;
 }
 
 // Delete a trainer
 int db_delete_trainer(int trainer_id) {
-    return db_reject_trainer(trainer_id);
+    return db_remove_trainer(trainer_id, EVENT_TRAINER_DELETED);
 }
@@ -0,0 +1,504 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <ctype.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sqlite3.h>
+#include "dedup.h"
+#include "database.h"
+
+// ============================================
+// Account Table
+// ============================================
+
+// Each account's strings live back to back in one arena:
+//   raw name \0 raw email \0 normalized name \0 normalized email \0
+typedef struct {
+    int user_id;
+    unsigned int offset;
+    uint32_t name_sig;      // Bit per character class present, see char_signature()
+    uint32_t email_sig;
+    unsigned char raw_name_len;
+    unsigned char raw_email_len;
+    unsigned char name_len;
+    unsigned char email_len;
+} Account;
+
+typedef struct {
+    Account *items;
+    int count;
+    int capacity;
+    char *arena;
+    size_t arena_used;
+    size_t arena_capacity;
+} AccountTable;
+
+static const char* raw_name(const AccountTable *t, const Account *a) {
+    return t->arena + a->offset;
+}
+
+static const char* raw_email(const AccountTable *t, const Account *a) {
+    return raw_name(t, a) + a->raw_name_len + 1;
+}
+
+static const char* norm_name(const AccountTable *t, const Account *a) {
+    return raw_email(t, a) + a->raw_email_len + 1;
+}
+
+static const char* norm_email(const AccountTable *t, const Account *a) {
+    return norm_name(t, a) + a->name_len + 1;
+}
+
+static double elapsed_ms(const struct timespec *start) {
+    struct timespec now;
+    timespec_get(&now, TIME_UTC);
+    return (now.tv_sec - start->tv_sec) * 1000.0 + (now.tv_nsec - start->tv_nsec) / 1e6;
+}
+
+// Lowercase; drop dots and any +tag from the local part
+static int normalize_email(const char *in, char *out) {
+    int len = 0, in_local = 1, in_tag = 0;
+    for (const char *p = in; *p && len < DEDUP_MAX_LEN - 1; p++) {
+        char c = (char)tolower((unsigned char)*p);
+        if (isspace((unsigned char)c)) continue;
+        if (c == '@') {
+            in_local = in_tag = 0;
+        } else if (in_local) {
+            if (c == '+') in_tag = 1;
+            if (in_tag || c == '.') continue;
+        }
+        out[len++] = c;
+    }
+    out[len] = '\0';
+    return len;
+}
+
+// Lowercase letters and digits only
+static int normalize_name(const char *in, char *out) {
+    int len = 0;
+    for (const char *p = in; *p && len < DEDUP_MAX_LEN - 1; p++) {
+        if (isalnum((unsigned char)*p)) out[len++] = (char)tolower((unsigned char)*p);
+    }
+    out[len] = '\0';
+    return len;
+}
+
+// One bit per character (folded mod 32). A single edit changes at most two
+// bits, so popcount(sig_a ^ sig_b) / 2 is a lower bound on the edit distance
+// and most non-matching pairs are rejected without running the full DP.
+static uint32_t char_signature(const char *s, int len) {
+    uint32_t sig = 0;
+    for (int i = 0; i < len; i++) sig |= 1u << ((unsigned char)s[i] & 31);
+    return sig;
+}
+
+static int signature_distance(uint32_t a, uint32_t b) {
+    return (__builtin_popcount(a ^ b) + 1) / 2;
+}
+
+static int copy_clipped(const char *in, char *out) {
+    int len = (int)strnlen(in, 99);
+    memcpy(out, in, len);
+    out[len] = '\0';
+    return len;
+}
+
+static void collect_account(int user_id, const char *name, const char *email, void *ctx) {
+    AccountTable *t = ctx;
+    if (t->count == t->capacity) {
+        int capacity = t->capacity ? t->capacity * 2 : 4096;
+        Account *grown = realloc(t->items, sizeof(Account) * capacity);
+        if (!grown) return;
+        t->items = grown;
+        t->capacity = capacity;
+    }
+    size_t needed = 2 * 100 + 2 * DEDUP_MAX_LEN;
+    if (t->arena_used + needed > t->arena_capacity) {
+        size_t capacity = t->arena_capacity ? t->arena_capacity * 2 : 256 * 1024;
+        char *grown = realloc(t->arena, capacity);
+        if (!grown) return;
+        t->arena = grown;
+        t->arena_capacity = capacity;
+    }
+
+    Account *a = &t->items[t->count++];
+    char *p = t->arena + t->arena_used;
+    a->user_id = user_id;
+    a->offset = (unsigned int)t->arena_used;
+    a->raw_name_len = (unsigned char)copy_clipped(name ? name : "", p);
+    p += a->raw_name_len + 1;
+    a->raw_email_len = (unsigned char)copy_clipped(email ? email : "", p);
+    p += a->raw_email_len + 1;
+    a->name_len = (unsigned char)normalize_name(name ? name : "", p);
+    a->name_sig = char_signature(p, a->name_len);
+    p += a->name_len + 1;
+    a->email_len = (unsigned char)normalize_email(email ? email : "", p);
+    a->email_sig = char_signature(p, a->email_len);
+    p += a->email_len + 1;
+    t->arena_used = p - t->arena;
+}
+
+// ============================================
+// Bit-Parallel Edit Distance
+// ============================================
+
+// Levenshtein distance with Myers' bit-vector algorithm: one 64-bit word
+// holds a whole DP column, so each character of b costs a handful of
+// word operations. Strings longer than 64 characters are clipped.
+int dedup_edit_distance(const char *a, int a_len, const char *b, int b_len) {
+    if (a_len > 64) a_len = 64;
+    if (b_len > 64) b_len = 64;
+    if (a_len == 0) return b_len;
+    if (b_len == 0) return a_len;
+
+    // Match masks; only the entries for characters in a or b are touched
+    uint64_t peq[256];
+    for (int i = 0; i < a_len; i++) peq[(unsigned char)a[i]] = 0;
+    for (int j = 0; j < b_len; j++) peq[(unsigned char)b[j]] = 0;
+    for (int i = 0; i < a_len; i++) peq[(unsigned char)a[i]] |= 1ULL << i;
+
+    uint64_t pv = ~0ULL, mv = 0;
+    uint64_t last = 1ULL << (a_len - 1);
+    int score = a_len;
+    for (int j = 0; j < b_len; j++) {
+        uint64_t eq = peq[(unsigned char)b[j]];
+        uint64_t xv = eq | mv;
+        uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+        uint64_t ph = mv | ~(xh | pv);
+        uint64_t mh = pv & xh;
+        if (ph & last) score++;
+        else if (mh & last) score--;
+        ph = (ph << 1) | 1;
+        mh <<= 1;
+        pv = mh | ~(xv | ph);
+        mv = ph & xv;
+    }
+    return score;
+}
+
+// ============================================
+// Blocking and Comparison
+// ============================================
+
+typedef struct {
+    uint64_t key;   // First 8 bytes of the blocking string, big-endian
+    int index;
+} BlockEntry;
+
+typedef struct {
+    int a;          // Account indexes, a has the lower user id
+    int b;
+    int email_distance;
+    int name_distance;
+} Candidate;
+
+typedef struct {
+    Candidate *items;
+    int count;
+    int capacity;
+} CandidateArray;
+
+typedef enum { KEY_EMAIL, KEY_EMAIL_REVERSED, KEY_NAME, KEY_COUNT } BlockKey;
+
+static uint64_t block_key(const AccountTable *t, const Account *a, BlockKey kind) {
+    uint64_t key = 0;
+    const char *s;
+    int len;
+    if (kind == KEY_NAME) {
+        s = norm_name(t, a);
+        len = a->name_len;
+    } else {
+        s = norm_email(t, a);
+        len = a->email_len;
+    }
+
+    if (kind == KEY_EMAIL_REVERSED) {
+        // Local part read backwards, so typos near the start still block together
+        const char *at = memchr(s, '@', len);
+        int local = at ? (int)(at - s) : len;
+        for (int i = 0; i < 8; i++) key = (key << 8) | (i < local ? (unsigned char)s[local - 1 - i] : 0);
+    } else {
+        for (int i = 0; i < 8; i++) key = (key << 8) | (i < len ? (unsigned char)s[i] : 0);
+    }
+    return key;
+}
+
+static int compare_block_entry(const void *x, const void *y) {
+    const BlockEntry *a = x, *b = y;
+    if (a->key != b->key) return a->key < b->key ? -1 : 1;
+    return a->index - b->index;
+}
+
+static int compare_candidate_pair(const void *x, const void *y) {
+    const Candidate *a = x, *b = y;
+    if (a->a != b->a) return a->a - b->a;
+    return a->b - b->b;
+}
+
+static int compare_candidate_rank(const void *x, const void *y) {
+    const Candidate *a = x, *b = y;
+    int da = a->email_distance + a->name_distance, db = b->email_distance + b->name_distance;
+    if (da != db) return da - db;
+    return compare_candidate_pair(x, y);
+}
+
+static void add_candidate(CandidateArray *arr, const AccountTable *t, int i, int j, int email_d, int name_d) {
+    if (arr->count == arr->capacity) {
+        int capacity = arr->capacity ? arr->capacity * 2 : 1024;
+        Candidate *grown = realloc(arr->items, sizeof(Candidate) * capacity);
+        if (!grown) return;
+        arr->items = grown;
+        arr->capacity = capacity;
+    }
+    Candidate *c = &arr->items[arr->count++];
+    int i_first = t->items[i].user_id < t->items[j].user_id;
+    c->a = i_first ? i : j;
+    c->b = i_first ? j : i;
+    c->email_distance = email_d;
+    c->name_distance = name_d;
+}
+
+// Compare a pair; names are shorter, so they are checked first
+static long compare_accounts(const AccountTable *t, int i, int j, CandidateArray *out) {
+    const Account *a = &t->items[i], *b = &t->items[j];
+    int name_d = abs(a->name_len - b->name_len);
+    int name_bound = signature_distance(a->name_sig, b->name_sig);
+    if (name_bound > name_d) name_d = name_bound;
+    if (name_d <= DEDUP_MAX_DISTANCE) {
+        name_d = dedup_edit_distance(norm_name(t, a), a->name_len, norm_name(t, b), b->name_len);
+    }
+
+    int email_d;
+    if (name_d > DEDUP_MAX_DISTANCE) {
+        // Only the same normalized email can still make this a match
+        if (a->email_len != b->email_len || memcmp(norm_email(t, a), norm_email(t, b), a->email_len) != 0) return 1;
+        email_d = 0;
+    } else {
+        int budget = DEDUP_MAX_DISTANCE - name_d;
+        if (abs(a->email_len - b->email_len) > budget ||
+            signature_distance(a->email_sig, b->email_sig) > budget) return 1;
+        email_d = dedup_edit_distance(norm_email(t, a), a->email_len, norm_email(t, b), b->email_len);
+        if (email_d > budget) return 1;
+    }
+    add_candidate(out, t, i, j, email_d, name_d);
+    return 1;
+}
+
+// One blocking pass; passes are independent and run on their own threads
+typedef struct {
+    const AccountTable *table;
+    BlockKey kind;
+    CandidateArray found;
+    long comparisons;
+    int failed;
+} PassJob;
+
+// Sorted-neighbourhood pass over one blocking key
+static void* run_pass(void *arg) {
+    PassJob *job = arg;
+    const AccountTable *t = job->table;
+    const int block_shift = (8 - DEDUP_BLOCK_BYTES) * 8;
+
+    BlockEntry *entries = malloc(sizeof(BlockEntry) * (t->count ? t->count : 1));
+    if (!entries) {
+        job->failed = 1;
+        return NULL;
+    }
+    for (int i = 0; i < t->count; i++) {
+        entries[i].key = block_key(t, &t->items[i], job->kind);
+        entries[i].index = i;
+    }
+    qsort(entries, t->count, sizeof(BlockEntry), compare_block_entry);
+
+    for (int i = 0; i < t->count; i++) {
+        uint64_t block = entries[i].key >> block_shift;
+        if (block == 0) continue;   // Empty key, nothing to block on
+        for (int j = i + 1; j < t->count && j <= i + DEDUP_WINDOW; j++) {
+            if (entries[j].key >> block_shift != block) break;
+            job->comparisons += compare_accounts(t, entries[i].index, entries[j].index, &job->found);
+        }
+    }
+    free(entries);
+    return NULL;
+}
+
+// ============================================
+// Scan
+// ============================================
+
+// Read every member account from a connection
+static int load_accounts(sqlite3 *conn, AccountTable *table) {
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(conn, "SELECT user_id, name, email FROM Users WHERE role='Member';", -1, &stmt, 0) != SQLITE_OK) {
+        return 1;
+    }
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        collect_account(sqlite3_column_int(stmt, 0), (const char*)sqlite3_column_text(stmt, 1),
+            (const char*)sqlite3_column_text(stmt, 2), table);
+    }
+    sqlite3_finalize(stmt);
+    return rc == SQLITE_DONE ? 0 : 1;
+}
+
+// Concatenate each pass's candidates (a pass may have found none)
+static int merge_passes(PassJob *jobs, CandidateArray *found) {
+    int failed = 0;
+    for (int kind = 0; kind < KEY_COUNT; kind++) {
+        failed |= jobs[kind].failed;
+        found->capacity += jobs[kind].found.count;
+    }
+    found->items = malloc(sizeof(Candidate) * (found->capacity ? found->capacity : 1));
+    for (int kind = 0; kind < KEY_COUNT; kind++) {
+        if (found->items && jobs[kind].found.count > 0) {
+            memcpy(found->items + found->count, jobs[kind].found.items, sizeof(Candidate) * jobs[kind].found.count);
+            found->count += jobs[kind].found.count;
+        }
+        free(jobs[kind].found.items);
+    }
+    return failed || !found->items ? 1 : 0;
+}
+
+// Scan the member accounts readable through conn
+static int find_duplicates(sqlite3 *conn, DuplicatePair *pairs, int *count, DedupStats *stats) {
+    struct timespec start;
+    timespec_get(&start, TIME_UTC);
+    memset(stats, 0, sizeof(*stats));
+
+    AccountTable table = {0};
+    if (load_accounts(conn, &table) != 0) {
+        free(table.items);
+        free(table.arena);
+        *count = 0;
+        return 1;
+    }
+    stats->users = table.count;
+
+    PassJob jobs[KEY_COUNT];
+    pthread_t threads[KEY_COUNT];
+    int started[KEY_COUNT];
+    for (int kind = 0; kind < KEY_COUNT; kind++) {
+        memset(&jobs[kind], 0, sizeof(PassJob));
+        jobs[kind].table = &table;
+        jobs[kind].kind = (BlockKey)kind;
+        started[kind] = pthread_create(&threads[kind], NULL, run_pass, &jobs[kind]) == 0;
+        if (!started[kind]) run_pass(&jobs[kind]);
+    }
+    for (int kind = 0; kind < KEY_COUNT; kind++) {
+        if (started[kind]) pthread_join(threads[kind], NULL);
+        stats->comparisons += jobs[kind].comparisons;
+    }
+
+    CandidateArray found = {0};
+    if (merge_passes(jobs, &found) != 0) {
+        free(found.items);
+        free(table.items);
+        free(table.arena);
+        *count = 0;
+        return 1;
+    }
+
+    // The same pair is usually found by more than one pass
+    qsort(found.items, found.count, sizeof(Candidate), compare_candidate_pair);
+    int unique = 0;
+    for (int i = 0; i < found.count; i++) {
+        if (unique > 0 && compare_candidate_pair(&found.items[unique - 1], &found.items[i]) == 0) continue;
+        found.items[unique++] = found.items[i];
+    }
+    qsort(found.items, unique, sizeof(Candidate), compare_candidate_rank);
+    stats->pairs = unique;
+
+    int filled = unique < *count ? unique : *count;
+    for (int i = 0; i < filled; i++) {
+        const Candidate *c = &found.items[i];
+        const Account *keep = &table.items[c->a], *drop = &table.items[c->b];
+        DuplicatePair *p = &pairs[i];
+        p->keep_id = keep->user_id;
+        p->drop_id = drop->user_id;
+        snprintf(p->keep_name, sizeof(p->keep_name), "%s", raw_name(&table, keep));
+        snprintf(p->keep_email, sizeof(p->keep_email), "%s", raw_email(&table, keep));
+        snprintf(p->drop_name, sizeof(p->drop_name), "%s", raw_name(&table, drop));
+        snprintf(p->drop_email, sizeof(p->drop_email), "%s", raw_email(&table, drop));
+        p->email_distance = c->email_distance;
+        p->name_distance = c->name_distance;
+    }
+    *count = filled;
+
+    free(found.items);
+    free(table.items);
+    free(table.arena);
+    stats->ms = elapsed_ms(&start);
+    return 0;
+}
+
+// ============================================
+// Public API
+// ============================================
+
+// Find likely duplicate member accounts, best matches first, on the open
+// branch's connection. *count is the capacity of pairs on input and the
+// number filled on output.
+int dedup_find(DuplicatePair *pairs, int *count, DedupStats *stats) {
+    return find_duplicates(db_get_handle(), pairs, count, stats);
+}
+
+// ============================================
+// Background Scan
+// ============================================
+
+static struct {
+    atomic_int running;
+    int failed;
+    char db_path[256];
+    DuplicatePair pairs[MAX_DUPLICATES];
+    int count;
+    DedupStats stats;
+} scan;
+
+// Scan from its own read-only connection, so the UI keeps running
+static void* scan_main(void *arg) {
+    sqlite3 *conn = NULL;
+    scan.count = MAX_DUPLICATES;
+    scan.failed = 1;
+    if (sqlite3_open_v2(scan.db_path, &conn, SQLITE_OPEN_READONLY, NULL) == SQLITE_OK) {
+        sqlite3_busy_timeout(conn, 5000);
+        scan.failed = find_duplicates(conn, scan.pairs, &scan.count, &scan.stats) != 0;
+    }
+    sqlite3_close(conn);
+    atomic_store(&scan.running, 0);
+    return NULL;
+}
+
+// Start scanning the open branch on a background thread (1 if one is
+// already running)
+int dedup_start() {
+    int expected = 0;
+    if (!atomic_compare_exchange_strong(&scan.running, &expected, 1)) return 1;
+    snprintf(scan.db_path, sizeof(scan.db_path), "%s", db_get_path());
+
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, scan_main, NULL) != 0) {
+        atomic_store(&scan.running, 0);
+        return 1;
+    }
+    pthread_detach(thread);
+    return 0;
+}
+
+// Copy out the last background scan's results: 1 while it is still
+// running, 0 once copied, -1 if it failed
+int dedup_get_result(DuplicatePair *pairs, int *count, DedupStats *stats) {
+    if (atomic_load(&scan.running)) return 1;
+    if (scan.failed) {
+        *count = 0;
+        return -1;
+    }
+    int filled = scan.count < *count ? scan.count : *count;
+    memcpy(pairs, scan.pairs, sizeof(DuplicatePair) * filled);
+    *count = filled;
+    *stats = scan.stats;
+    return 0;
+}
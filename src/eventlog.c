@@ -0,0 +1,444 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <io.h>
+#include <windows.h>
+#else
+#include <unistd.h>
+#include <sys/file.h>
+#endif
+#include "eventlog.h"
+
+#ifndef O_BINARY
+#define O_BINARY 0
+#endif
+
+// ============================================
+// Writer State
+// ============================================
+
+#define RECORD_HEADER 8
+#define PAYLOAD_FIXED 17
+
+static char log_path[512] = "";    // Empty while no log is open
+static int log_fd = -1;
+static unsigned char buffer[EVENTLOG_BUFFER_SIZE];
+static size_t buffered = 0;
+static int pending_events = 0;
+static pthread_mutex_t log_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// ============================================
+// Encoding Helpers
+// ============================================
+
+static unsigned int crc_table[256];
+static int crc_ready = 0;
+
+// CRC-32 (IEEE 802.3, reflected)
+static unsigned int crc32_of(const unsigned char *data, size_t len) {
+    if (!crc_ready) {
+        for (unsigned int i = 0; i < 256; i++) {
+            unsigned int c = i;
+            for (int k = 0; k < 8; k++) c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            crc_table[i] = c;
+        }
+        crc_ready = 1;
+    }
+    unsigned int crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < len; i++) crc = crc_table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return crc ^ 0xFFFFFFFFu;
+}
+
+static void put_u32(unsigned char *p, unsigned int v) {
+    p[0] = v & 0xFF; p[1] = (v >> 8) & 0xFF; p[2] = (v >> 16) & 0xFF; p[3] = (v >> 24) & 0xFF;
+}
+
+static void put_u64(unsigned char *p, unsigned long long v) {
+    put_u32(p, (unsigned int)v);
+    put_u32(p + 4, (unsigned int)(v >> 32));
+}
+
+static unsigned int get_u32(const unsigned char *p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((unsigned int)p[3] << 24);
+}
+
+static unsigned long long get_u64(const unsigned char *p) {
+    return get_u32(p) | ((unsigned long long)get_u32(p + 4) << 32);
+}
+
+// Encode one event as a full record; returns its size
+static size_t encode_event(unsigned char *out, const Event *event) {
+    size_t text_len = strlen(event->text);
+    unsigned char *payload = out + RECORD_HEADER;
+    payload[0] = (unsigned char)event->type;
+    put_u64(payload + 1, (unsigned long long)event->timestamp);
+    put_u32(payload + 9, (unsigned int)event->subject_id);
+    put_u32(payload + 13, (unsigned int)event->arg);
+    memcpy(payload + PAYLOAD_FIXED, event->text, text_len);
+
+    size_t payload_len = PAYLOAD_FIXED + text_len;
+    put_u32(out, (unsigned int)payload_len);
+    put_u32(out + 4, crc32_of(payload, payload_len));
+    return RECORD_HEADER + payload_len;
+}
+
+// ============================================
+// File Locking
+// ============================================
+
+// Several app instances append to one log, so every write, repair and
+// compaction holds an exclusive lock on the file
+
+#ifdef _WIN32
+// LockFileEx locks are mandatory, so lock one byte far past any real log size
+static int lock_fd(int fd) {
+    OVERLAPPED at = {0};
+    at.Offset = 0xFFFFFFFEu;
+    return LockFileEx((HANDLE)_get_osfhandle(fd), LOCKFILE_EXCLUSIVE_LOCK, 0, 1, 0, &at) ? 0 : 1;
+}
+
+static void unlock_fd(int fd) {
+    OVERLAPPED at = {0};
+    at.Offset = 0xFFFFFFFEu;
+    UnlockFileEx((HANDLE)_get_osfhandle(fd), 0, 1, 0, &at);
+}
+
+// Windows refuses to rename a file another process has open, so the file
+// under an open descriptor is never replaced
+static int is_current(int fd, const char *path) {
+    return 1;
+}
+#else
+static int lock_fd(int fd) {
+    return flock(fd, LOCK_EX) == 0 ? 0 : 1;
+}
+
+static void unlock_fd(int fd) {
+    flock(fd, LOCK_UN);
+}
+
+// Whether fd still refers to the file at path (compaction renames a new
+// file into place)
+static int is_current(int fd, const char *path) {
+    struct stat opened, named;
+    if (fstat(fd, &opened) != 0 || stat(path, &named) != 0) return 0;
+    return opened.st_dev == named.st_dev && opened.st_ino == named.st_ino;
+}
+#endif
+
+// Open path and lock it. Compaction may replace the file while we wait for
+// the lock, so retry until the locked file is the one at path. Returns -1
+// on failure.
+static int open_locked(const char *path, int flags) {
+    for (;;) {
+        int fd = open(path, flags | O_BINARY, 0644);
+        if (fd < 0) return -1;
+        if (lock_fd(fd) != 0) {
+            close(fd);
+            return -1;
+        }
+        if (is_current(fd, path)) return fd;
+        close(fd);
+    }
+}
+
+// Write all of data; a short write only continues under the same lock
+static int write_all(int fd, const unsigned char *data, size_t len) {
+    while (len > 0) {
+        long n = (long)write(fd, data, (unsigned int)len);
+        if (n <= 0) return 1;
+        data += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+// Write the buffer out as one append under the file lock (caller holds
+// log_lock). Reopens the log first if compaction replaced it.
+static int flush_locked() {
+    int result = 0;
+    if (log_path[0] && buffered > 0) {
+        if (log_fd >= 0 && (lock_fd(log_fd) != 0 || !is_current(log_fd, log_path))) {
+            close(log_fd);
+            log_fd = -1;
+        }
+        if (log_fd < 0) log_fd = open_locked(log_path, O_WRONLY | O_APPEND | O_CREAT);
+        if (log_fd < 0 || write_all(log_fd, buffer, buffered) != 0) {
+            fprintf(stderr, "Event log write failed.\n");
+            result = 1;
+        }
+        if (log_fd >= 0) unlock_fd(log_fd);
+    }
+    buffered = 0;
+    pending_events = 0;
+    return result;
+}
+
+static int compact_locked(const char *path, int *fd, long *kept, long *dropped);
+
+// ============================================
+// Writer API
+// ============================================
+
+// Open (or create) the log for appending. Under the file lock, a torn tail
+// (e.g. after a crash mid-write) is cut so new records stay reachable, and
+// a log that has grown large is compacted.
+int eventlog_open(const char *path) {
+    eventlog_close();
+
+    int fd = open_locked(path, O_RDWR | O_APPEND | O_CREAT);
+    if (fd < 0) {
+        fprintf(stderr, "Can't open event log: %s\n", path);
+        return 1;
+    }
+    struct stat st;
+    long size = fstat(fd, &st) == 0 ? (long)st.st_size : 0;
+    long valid;
+    eventlog_replay(path, NULL, NULL, &valid);
+    if (valid < size) {
+        fprintf(stderr, "Event log %s: dropping %ld corrupt trailing bytes.\n", path, size - valid);
+#ifdef _WIN32
+        _chsize(fd, valid);
+#else
+        if (ftruncate(fd, valid) != 0) fprintf(stderr, "Can't truncate event log: %s\n", path);
+#endif
+    }
+    if (valid > EVENTLOG_COMPACT_BYTES) {
+        long kept, dropped;
+        compact_locked(path, &fd, &kept, &dropped);
+    }
+    if (fd >= 0) unlock_fd(fd);
+
+    pthread_mutex_lock(&log_lock);
+    snprintf(log_path, sizeof(log_path), "%s", path);
+    log_fd = fd;
+    pthread_mutex_unlock(&log_lock);
+    return 0;
+}
+
+// Flush outstanding events and close the log
+void eventlog_close() {
+    pthread_mutex_lock(&log_lock);
+    flush_locked();
+    if (log_fd >= 0) {
+        close(log_fd);
+        log_fd = -1;
+    }
+    log_path[0] = '\0';
+    pthread_mutex_unlock(&log_lock);
+}
+
+// Buffer one event; the buffer is written once a batch has accumulated
+void eventlog_append(EventType type, int subject_id, int arg, const char *text) {
+    Event event;
+    event.type = type;
+    event.timestamp = (long long)time(NULL);
+    event.subject_id = subject_id;
+    event.arg = arg;
+    snprintf(event.text, sizeof(event.text), "%s", text ? text : "");
+
+    pthread_mutex_lock(&log_lock);
+    if (log_path[0]) {
+        if (buffered + RECORD_HEADER + PAYLOAD_FIXED + EVENTLOG_MAX_TEXT > sizeof(buffer)) {
+            flush_locked();
+        }
+        buffered += encode_event(buffer + buffered, &event);
+        if (++pending_events >= EVENTLOG_FLUSH_BATCH) flush_locked();
+    }
+    pthread_mutex_unlock(&log_lock);
+}
+
+// Write any buffered events now
+int eventlog_flush() {
+    pthread_mutex_lock(&log_lock);
+    int result = flush_locked();
+    pthread_mutex_unlock(&log_lock);
+    return result;
+}
+
+// ============================================
+// Replay
+// ============================================
+
+// Visit every intact record in order. Stops at the first truncated or
+// corrupted record and reports how many bytes were valid.
+int eventlog_replay(const char *path, EventVisitor visit, void *ctx, long *valid_bytes) {
+    FILE *f = fopen(path, "rb");
+    if (valid_bytes) *valid_bytes = 0;
+    if (!f) return -1;
+    setvbuf(f, NULL, _IOFBF, 1 << 20);
+
+    unsigned char header[RECORD_HEADER];
+    unsigned char payload[PAYLOAD_FIXED + EVENTLOG_MAX_TEXT];
+    long offset = 0;
+    int count = 0;
+
+    while (fread(header, 1, RECORD_HEADER, f) == RECORD_HEADER) {
+        unsigned int len = get_u32(header);
+        if (len < PAYLOAD_FIXED || len > sizeof(payload)) break;
+        if (fread(payload, 1, len, f) != len) break;
+        if (crc32_of(payload, len) != get_u32(header + 4)) break;
+
+        Event event;
+        event.type = payload[0];
+        event.timestamp = (long long)get_u64(payload + 1);
+        event.subject_id = (int)get_u32(payload + 9);
+        event.arg = (int)get_u32(payload + 13);
+        memcpy(event.text, payload + PAYLOAD_FIXED, len - PAYLOAD_FIXED);
+        event.text[len - PAYLOAD_FIXED] = '\0';
+
+        offset += RECORD_HEADER + len;
+        count++;
+        if (visit && visit(&event, ctx)) break;
+    }
+
+    fclose(f);
+    if (valid_bytes) *valid_bytes = offset;
+    return count;
+}
+
+// ============================================
+// Compaction
+// ============================================
+
+typedef struct {
+    Event *events;
+    long count;
+    long capacity;
+} EventArray;
+
+static int collect_event(const Event *event, void *ctx) {
+    EventArray *arr = ctx;
+    if (arr->count == arr->capacity) {
+        long capacity = arr->capacity ? arr->capacity * 2 : 1024;
+        Event *grown = realloc(arr->events, sizeof(Event) * capacity);
+        if (!grown) return 1;
+        arr->events = grown;
+        arr->capacity = capacity;
+    }
+    arr->events[arr->count++] = *event;
+    return 0;
+}
+
+// Deletes end an entity's history (a merge deletes the duplicate); everything
+// else is keyed by (type, subject)
+static int is_delete(int type) {
+    return type == EVENT_MEMBER_DELETED || type == EVENT_TRAINER_DELETED || type == EVENT_TRAINER_REJECTED ||
+           type == EVENT_MEMBER_MERGED;
+}
+
+static unsigned long long event_key(const Event *event, int by_subject) {
+    return ((unsigned long long)(by_subject ? 0 : event->type) << 32) | (unsigned int)event->subject_id;
+}
+
+// Open-addressing map from key to the index of its latest event
+typedef struct {
+    unsigned long long *keys;
+    long *values;
+    long mask;
+} LatestMap;
+
+static long *latest_slot(LatestMap *map, unsigned long long key) {
+    long i = (long)((key * 0x9E3779B97F4A7C15ull) >> 20) & map->mask;
+    while (map->values[i] >= 0 && map->keys[i] != key) i = (i + 1) & map->mask;
+    map->keys[i] = key;
+    return &map->values[i];
+}
+
+// Rewrite the log keeping only the events that still define current state:
+// the latest event per (type, subject), and nothing before a subject's
+// deletion. The previous file is kept as <path>.old. The caller holds the
+// lock through *fd, which is closed once the file has been replaced.
+static int compact_locked(const char *path, int *fd, long *kept, long *dropped) {
+    EventArray arr = { NULL, 0, 0 };
+    *kept = *dropped = 0;
+    if (eventlog_replay(path, collect_event, &arr, NULL) < 0) return 1;
+
+    long slots = 1024;
+    while (slots < arr.count * 4) slots *= 2;
+    LatestMap latest = { calloc(slots, sizeof(unsigned long long)), malloc(slots * sizeof(long)), slots - 1 };
+    LatestMap deleted = { calloc(slots, sizeof(unsigned long long)), malloc(slots * sizeof(long)), slots - 1 };
+    if (!latest.keys || !latest.values || !deleted.keys || !deleted.values) {
+        free(latest.keys); free(latest.values); free(deleted.keys); free(deleted.values); free(arr.events);
+        return 1;
+    }
+    for (long i = 0; i < slots; i++) latest.values[i] = deleted.values[i] = -1;
+
+    for (long i = 0; i < arr.count; i++) {
+        *latest_slot(&latest, event_key(&arr.events[i], 0)) = i;
+        if (is_delete(arr.events[i].type)) *latest_slot(&deleted, event_key(&arr.events[i], 1)) = i;
+    }
+
+    char tmp_path[512], old_path[512];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+    snprintf(old_path, sizeof(old_path), "%s.old", path);
+    FILE *out = fopen(tmp_path, "wb");
+    int result = out ? 0 : 1;
+
+    unsigned char record[RECORD_HEADER + PAYLOAD_FIXED + EVENTLOG_MAX_TEXT];
+    for (long i = 0; out && i < arr.count; i++) {
+        const Event *event = &arr.events[i];
+        long last = *latest_slot(&latest, event_key(event, 0));
+        long gone = *latest_slot(&deleted, event_key(event, 1));
+        if (last != i || (gone > i)) {
+            (*dropped)++;
+            continue;
+        }
+        size_t len = encode_event(record, event);
+        if (fwrite(record, 1, len, out) != len) result = 1;
+        (*kept)++;
+    }
+
+    if (out && fclose(out) != 0) result = 1;
+    if (result == 0) {
+        remove(old_path);
+#ifdef _WIN32
+        // Our own descriptor would block the rename; if another instance
+        // has the log open the rename fails and the log is left as it was
+        close(*fd);
+        *fd = -1;
+        if (rename(path, old_path) != 0 || rename(tmp_path, path) != 0) result = 1;
+#else
+        // The name never goes missing: writers waiting on the lock see the
+        // new file once it is released and reopen it
+        if (link(path, old_path) != 0 || rename(tmp_path, path) != 0) result = 1;
+        else {
+            unlock_fd(*fd);
+            close(*fd);
+            *fd = -1;
+        }
+#endif
+    }
+    if (result != 0) remove(tmp_path);
+
+    free(latest.keys); free(latest.values); free(deleted.keys); free(deleted.values); free(arr.events);
+    return result;
+}
+
+// Compact the log at path under its file lock
+int eventlog_compact(const char *path, long *kept, long *dropped) {
+    *kept = *dropped = 0;
+    int fd = open_locked(path, O_RDWR | O_APPEND);
+    if (fd < 0) return 1;
+    int result = compact_locked(path, &fd, kept, dropped);
+    if (fd >= 0) {
+        unlock_fd(fd);
+        close(fd);
+    }
+    return result;
+}
+
+// Human-readable event type
+const char* eventlog_type_name(int type) {
+    static const char *names[EVENT_TYPE_COUNT] = {
+        "UNKNOWN", "PLAN_CHANGED", "TRAINER_ASSIGNED", "TRAINER_APPROVED", "TRAINER_REJECTED",
+        "MEMBER_DELETED", "TRAINER_DELETED", "MEMBERSHIP_RENEWED", "MEMBERSHIP_EXPIRED",
+        "MEMBER_MERGED", "LOGIN_LOCKED", "PROGRAM_ASSIGNED"
+    };
+    return type > 0 && type < EVENT_TYPE_COUNT ? names[type] : names[0];
+}
@@ -0,0 +1,429 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sqlite3.h>
+#include "export.h"
+#include "database.h"
+#include "archive.h"
+
+// ============================================
+// Table Definitions
+// ============================================
+
+#define MAX_EXPORT_COLUMNS 8
+
+// The count and the export share one FROM clause so progress totals always
+// cover exactly the rows that are written
+typedef struct {
+    const char *name;
+    const char *select_list;
+    const char *from_sql;   // FROM text, joins and filters included
+    const char *order_by;
+    int column_count;
+    const char *headers[MAX_EXPORT_COLUMNS];
+    int is_int[MAX_EXPORT_COLUMNS];
+    int archived;           // Reads AttendanceAll: the hot table plus every yearly archive
+} ExportTable;
+
+static const ExportTable export_tables[] = {
+    { "members",
+      "m.member_id, u.name, u.email, IFNULL(p.name, ''), IFNULL(m.time_slot, ''), IFNULL(m.status, ''), "
+      "IFNULL(m.trainer_id, 0), IFNULL(m.joined_at, '')",
+      "Members m JOIN Users u ON m.member_id = u.user_id LEFT JOIN Plans p ON m.plan_id = p.plan_id",
+      "m.member_id",
+      8, {"member_id", "name", "email", "plan", "time_slot", "status", "trainer_id", "joined_at"},
+      {1, 0, 0, 0, 0, 0, 1, 0} },
+    { "trainers",
+      "t.trainer_id, u.name, u.email, IFNULL(t.specialization, ''), IFNULL(t.status, ''), IFNULL(t.joined_at, '')",
+      "Trainers t JOIN Users u ON t.trainer_id = u.user_id",
+      "t.trainer_id",
+      6, {"trainer_id", "name", "email", "specialization", "status", "joined_at"},
+      {1, 0, 0, 0, 0, 0} },
+    { "attendance",
+      "attendance_id, IFNULL(member_id, 0), IFNULL(date, ''), IFNULL(status, '')",
+      "AttendanceAll",
+      "attendance_id",
+      4, {"attendance_id", "member_id", "date", "status"},
+      {1, 1, 0, 0}, 1 },
+};
+
+#define EXPORT_TABLE_COUNT ((int)(sizeof(export_tables) / sizeof(export_tables[0])))
+
+// ============================================
+// Job State
+// ============================================
+
+static struct {
+    ExportFormat format;
+    char db_path[256];
+    char directory[256];
+    atomic_int next_table;
+    atomic_long rows_done;
+    atomic_long rows_total;
+    atomic_long bytes_written;
+    atomic_int running;
+    atomic_int failed;
+    double seconds;
+    struct timespec started;
+} job;
+
+// ============================================
+// Byte Buffer
+// ============================================
+
+typedef struct {
+    unsigned char *data;
+    size_t len;
+    size_t cap;
+} ByteBuffer;
+
+static void buf_reserve(ByteBuffer *b, size_t extra) {
+    if (b->len + extra <= b->cap) return;
+    size_t cap = b->cap ? b->cap : 4096;
+    while (cap < b->len + extra) cap *= 2;
+    unsigned char *grown = realloc(b->data, cap);
+    if (!grown) abort();
+    b->data = grown;
+    b->cap = cap;
+}
+
+static void buf_put(ByteBuffer *b, const void *data, size_t len) {
+    buf_reserve(b, len);
+    memcpy(b->data + b->len, data, len);
+    b->len += len;
+}
+
+static void buf_varint(ByteBuffer *b, unsigned long long v) {
+    buf_reserve(b, 10);
+    while (v >= 0x80) {
+        b->data[b->len++] = (unsigned char)(v | 0x80);
+        v >>= 7;
+    }
+    b->data[b->len++] = (unsigned char)v;
+}
+
+static void buf_u32(ByteBuffer *b, unsigned int v) {
+    unsigned char bytes[4] = { v & 0xFF, (v >> 8) & 0xFF, (v >> 16) & 0xFF, (v >> 24) & 0xFF };
+    buf_put(b, bytes, 4);
+}
+
+// ============================================
+// CSV Encoding
+// ============================================
+
+static void csv_field(ByteBuffer *b, const char *text) {
+    if (strpbrk(text, ",\"\r\n") == NULL) {
+        buf_put(b, text, strlen(text));
+        return;
+    }
+    buf_put(b, "\"", 1);
+    for (const char *p = text; *p; p++) {
+        if (*p == '"') buf_put(b, "\"", 1);
+        buf_put(b, p, 1);
+    }
+    buf_put(b, "\"", 1);
+}
+
+// ============================================
+// Columnar Encoding
+// ============================================
+
+#define ENC_INT_DELTA 1
+#define ENC_TEXT_DICT 2
+#define ENC_TEXT_PLAIN 3
+#define DICT_MAX 256
+#define DICT_SLOTS 1024
+
+// One column of the chunk being built
+typedef struct {
+    long long *ints;
+    char **texts;
+} ColumnChunk;
+
+static unsigned int hash_text(const char *s) {
+    unsigned int h = 2166136261u;
+    while (*s) h = (h ^ (unsigned char)*s++) * 16777619u;
+    return h;
+}
+
+// Integers: first value and then deltas, zigzag + varint encoded
+static void encode_ints(ByteBuffer *out, const long long *values, int rows) {
+    long long prev = 0;
+    for (int i = 0; i < rows; i++) {
+        long long delta = values[i] - prev;
+        buf_varint(out, ((unsigned long long)delta << 1) ^ (unsigned long long)(delta >> 63));
+        prev = values[i];
+    }
+}
+
+// Text: dictionary + run-length codes when the chunk has few distinct
+// values (plans, statuses, dates), plain length-prefixed strings otherwise
+static int encode_texts(ByteBuffer *out, char **values, int rows) {
+    int slots[DICT_SLOTS];
+    const char *dict[DICT_MAX];
+    int dict_count = 0;
+    int *codes = malloc(sizeof(int) * rows);
+    memset(slots, -1, sizeof(slots));
+
+    int use_dict = codes != NULL;
+    for (int i = 0; use_dict && i < rows; i++) {
+        unsigned int h = hash_text(values[i]) & (DICT_SLOTS - 1);
+        while (slots[h] >= 0 && strcmp(dict[slots[h]], values[i]) != 0) h = (h + 1) & (DICT_SLOTS - 1);
+        if (slots[h] < 0) {
+            if (dict_count == DICT_MAX) { use_dict = 0; break; }
+            dict[dict_count] = values[i];
+            slots[h] = dict_count++;
+        }
+        codes[i] = slots[h];
+    }
+
+    if (!use_dict) {
+        for (int i = 0; i < rows; i++) {
+            size_t len = strlen(values[i]);
+            buf_varint(out, len);
+            buf_put(out, values[i], len);
+        }
+        free(codes);
+        return ENC_TEXT_PLAIN;
+    }
+
+    buf_varint(out, dict_count);
+    for (int d = 0; d < dict_count; d++) {
+        size_t len = strlen(dict[d]);
+        buf_varint(out, len);
+        buf_put(out, dict[d], len);
+    }
+    for (int i = 0; i < rows;) {
+        int run = 1;
+        while (i + run < rows && codes[i + run] == codes[i]) run++;
+        buf_varint(out, codes[i]);
+        buf_varint(out, run);
+        i += run;
+    }
+    free(codes);
+    return ENC_TEXT_DICT;
+}
+
+// Chunk layout: u32 rows, then per column: u8 encoding, u32 size, bytes
+static void encode_chunk(ByteBuffer *out, const ExportTable *table, ColumnChunk *columns, int rows) {
+    ByteBuffer col = { NULL, 0, 0 };
+    buf_u32(out, rows);
+    for (int c = 0; c < table->column_count; c++) {
+        col.len = 0;
+        unsigned char encoding;
+        if (table->is_int[c]) {
+            encode_ints(&col, columns[c].ints, rows);
+            encoding = ENC_INT_DELTA;
+        } else {
+            encoding = (unsigned char)encode_texts(&col, columns[c].texts, rows);
+        }
+        buf_put(out, &encoding, 1);
+        buf_u32(out, (unsigned int)col.len);
+        buf_put(out, col.data, col.len);
+    }
+    free(col.data);
+}
+
+// ============================================
+// Table Export
+// ============================================
+
+static int write_buffer(FILE *f, ByteBuffer *b) {
+    if (b->len == 0) return 0;
+    int ok = fwrite(b->data, 1, b->len, f) == b->len;
+    atomic_fetch_add(&job.bytes_written, (long)b->len);
+    b->len = 0;
+    return ok ? 0 : 1;
+}
+
+// Export one table from its own snapshot connection
+static int export_table(const ExportTable *table) {
+    sqlite3 *conn = NULL;
+    if (sqlite3_open_v2(job.db_path, &conn, SQLITE_OPEN_READONLY, NULL) != SQLITE_OK) {
+        sqlite3_close(conn);
+        return 1;
+    }
+    sqlite3_busy_timeout(conn, 5000);
+    if (table->archived && archive_attach(conn, job.db_path, NULL, NULL) < 0) {
+        sqlite3_close(conn);
+        return 1;
+    }
+
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s.%s", job.directory, table->name, job.format == EXPORT_CSV ? "csv" : "gcol");
+    FILE *f = fopen(path, "wb");
+    if (!f) {
+        sqlite3_close(conn);
+        return 1;
+    }
+    setvbuf(f, NULL, _IOFBF, EXPORT_WRITE_BUFFER);
+
+    // The count and the rows come from the same read transaction
+    sqlite3_exec(conn, "BEGIN;", 0, 0, 0);
+    char sql[1024];
+    sqlite3_stmt *stmt;
+    snprintf(sql, sizeof(sql), "SELECT COUNT(*) FROM %s;", table->from_sql);
+    if (sqlite3_prepare_v2(conn, sql, -1, &stmt, 0) == SQLITE_OK) {
+        if (sqlite3_step(stmt) == SQLITE_ROW) atomic_fetch_add(&job.rows_total, sqlite3_column_int64(stmt, 0));
+        sqlite3_finalize(stmt);
+    }
+
+    snprintf(sql, sizeof(sql), "SELECT %s FROM %s ORDER BY %s;", table->select_list, table->from_sql, table->order_by);
+    int result = sqlite3_prepare_v2(conn, sql, -1, &stmt, 0) == SQLITE_OK ? 0 : 1;
+    ByteBuffer out = { NULL, 0, 0 };
+    ColumnChunk columns[MAX_EXPORT_COLUMNS];
+    memset(columns, 0, sizeof(columns));
+
+    if (result == 0 && job.format == EXPORT_CSV) {
+        for (int c = 0; c < table->column_count; c++) {
+            if (c) buf_put(&out, ",", 1);
+            csv_field(&out, table->headers[c]);
+        }
+        buf_put(&out, "\n", 1);
+
+        long rows = 0;
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            for (int c = 0; c < table->column_count; c++) {
+                if (c) buf_put(&out, ",", 1);
+                csv_field(&out, (const char*)sqlite3_column_text(stmt, c));
+            }
+            buf_put(&out, "\n", 1);
+            if (++rows % 4096 == 0) {
+                atomic_fetch_add(&job.rows_done, 4096);
+                if (out.len > EXPORT_WRITE_BUFFER) result |= write_buffer(f, &out);
+            }
+        }
+        atomic_fetch_add(&job.rows_done, rows % 4096);
+    } else if (result == 0) {
+        // Header: magic, column count, then per column: u8 is_int, name
+        buf_put(&out, "GCOL1", 6);
+        buf_u32(&out, table->column_count);
+        for (int c = 0; c < table->column_count; c++) {
+            unsigned char is_int = (unsigned char)table->is_int[c];
+            buf_put(&out, &is_int, 1);
+            buf_varint(&out, strlen(table->headers[c]));
+            buf_put(&out, table->headers[c], strlen(table->headers[c]));
+        }
+        for (int c = 0; c < table->column_count; c++) {
+            if (table->is_int[c]) columns[c].ints = malloc(sizeof(long long) * EXPORT_CHUNK_ROWS);
+            else columns[c].texts = calloc(EXPORT_CHUNK_ROWS, sizeof(char*));
+        }
+
+        int rows = 0;
+        int more = 1;
+        while (more) {
+            more = sqlite3_step(stmt) == SQLITE_ROW;
+            if (more) {
+                for (int c = 0; c < table->column_count; c++) {
+                    if (table->is_int[c]) {
+                        columns[c].ints[rows] = sqlite3_column_int64(stmt, c);
+                    } else {
+                        free(columns[c].texts[rows]);
+                        columns[c].texts[rows] = strdup((const char*)sqlite3_column_text(stmt, c));
+                    }
+                }
+                rows++;
+            }
+            if (rows == EXPORT_CHUNK_ROWS || (!more && rows > 0)) {
+                encode_chunk(&out, table, columns, rows);
+                result |= write_buffer(f, &out);
+                atomic_fetch_add(&job.rows_done, rows);
+                rows = 0;
+            }
+        }
+
+        for (int c = 0; c < table->column_count; c++) {
+            if (columns[c].texts) {
+                for (int i = 0; i < EXPORT_CHUNK_ROWS; i++) free(columns[c].texts[i]);
+            }
+            free(columns[c].ints);
+            free(columns[c].texts);
+        }
+    }
+
+    result |= write_buffer(f, &out);
+    free(out.data);
+    sqlite3_finalize(stmt);
+    sqlite3_exec(conn, "COMMIT;", 0, 0, 0);
+    sqlite3_close(conn);
+    if (fclose(f) != 0) result = 1;
+    return result;
+}
+
+// ============================================
+// Worker Pool
+// ============================================
+
+static void* export_worker(void *arg) {
+    int i;
+    while ((i = atomic_fetch_add(&job.next_table, 1)) < EXPORT_TABLE_COUNT) {
+        if (export_table(&export_tables[i]) != 0) atomic_store(&job.failed, 1);
+    }
+    return NULL;
+}
+
+// Coordinator: runs the pool, then marks the job finished
+static void* export_main(void *arg) {
+    pthread_t workers[EXPORT_TABLE_COUNT];
+    int started = 0;
+    for (int i = 0; i < EXPORT_TABLE_COUNT; i++) {
+        if (pthread_create(&workers[started], NULL, export_worker, NULL) == 0) started++;
+    }
+    if (started == 0) export_worker(NULL);
+    for (int i = 0; i < started; i++) pthread_join(workers[i], NULL);
+
+    struct timespec now;
+    timespec_get(&now, TIME_UTC);
+    job.seconds = (now.tv_sec - job.started.tv_sec) + (now.tv_nsec - job.started.tv_nsec) / 1e9;
+    atomic_store(&job.running, 0);
+    return NULL;
+}
+
+// ============================================
+// Public API
+// ============================================
+
+// Start exporting the current branch into exports/<branch>-<timestamp>/
+int export_start(ExportFormat format) {
+    if (atomic_load(&job.running)) return 1;
+
+    time_t now = time(NULL);
+    char stamp[32];
+    strftime(stamp, sizeof(stamp), "%Y%m%d-%H%M%S", localtime(&now));
+    db_make_dir("exports");
+    snprintf(job.directory, sizeof(job.directory), "exports/%s-%s", db_get_branch(), stamp);
+    db_make_dir(job.directory);
+    snprintf(job.db_path, sizeof(job.db_path), "%s", db_get_path());
+
+    job.format = format;
+    atomic_store(&job.next_table, 0);
+    atomic_store(&job.rows_done, 0);
+    atomic_store(&job.rows_total, 0);
+    atomic_store(&job.bytes_written, 0);
+    atomic_store(&job.failed, 0);
+    atomic_store(&job.running, 1);
+    job.seconds = 0;
+    timespec_get(&job.started, TIME_UTC);
+
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, export_main, NULL) != 0) {
+        atomic_store(&job.running, 0);
+        return 1;
+    }
+    pthread_detach(thread);
+    return 0;
+}
+
+// Snapshot of the job's progress (safe to call from the UI thread)
+void export_get_progress(ExportProgress *progress) {
+    progress->rows_done = atomic_load(&job.rows_done);
+    progress->rows_total = atomic_load(&job.rows_total);
+    progress->bytes_written = atomic_load(&job.bytes_written);
+    progress->running = atomic_load(&job.running);
+    progress->failed = atomic_load(&job.failed);
+    progress->seconds = progress->running ? 0 : job.seconds;
+    snprintf(progress->directory, sizeof(progress->directory), "%s", job.directory);
+}
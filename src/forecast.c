@@ -0,0 +1,48 @@
+#include <stdio.h>
+#include <string.h>
+#include "forecast.h"
+#include "database.h"
+
+// ============================================
+// Forecast Queries
+// ============================================
+
+// Expected check-ins per hour: mean over the days seen for that weekday
+int forecast_load(OccupancyForecast *forecast) {
+    int visits[FORECAST_DAYS][FORECAST_HOURS];
+    memset(forecast, 0, sizeof(*forecast));
+    if (db_get_occupancy(visits, forecast->days_observed) != 0) return 1;
+
+    for (int d = 0; d < FORECAST_DAYS; d++) {
+        int days = forecast->days_observed[d];
+        for (int h = 0; h < FORECAST_HOURS; h++) {
+            forecast->total_visits += visits[d][h];
+            forecast->hourly[d][h] = days > 0 ? (double)visits[d][h] / days : 0.0;
+        }
+    }
+    return 0;
+}
+
+// Expected check-ins during a time slot on the given weekday
+double forecast_slot(const OccupancyForecast *forecast, int dow, const TimeSlot *slot) {
+    if (dow < 0 || dow >= FORECAST_DAYS) return 0.0;
+    double total = 0.0;
+    for (int h = slot->start_hour; h < slot->end_hour && h < FORECAST_HOURS; h++) {
+        if (h >= 0) total += forecast->hourly[dow][h];
+    }
+    return total;
+}
+
+// Busiest hour of the given weekday
+double forecast_peak(const OccupancyForecast *forecast, int dow, int *peak_hour) {
+    double peak = 0.0;
+    *peak_hour = 0;
+    if (dow < 0 || dow >= FORECAST_DAYS) return 0.0;
+    for (int h = 0; h < FORECAST_HOURS; h++) {
+        if (forecast->hourly[dow][h] > peak) {
+            peak = forecast->hourly[dow][h];
+            *peak_hour = h;
+        }
+    }
+    return peak;
+}
@@ -0,0 +1,120 @@
+#include <gtk/gtk.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "frametime.h"
+#include "config.h"
+
+// ============================================
+// Sample Series
+// ============================================
+
+typedef struct {
+    long long samples_us[FRAMETIME_SAMPLES];    // Ring of the most recent samples
+    long count;
+    long long total_us;
+    long long max_us;
+} Series;
+
+typedef struct {
+    char name[32];
+    Series frames;
+    Series refreshes;
+    GdkFrameClock *clock;
+    gulong before_paint_id;
+    gulong after_paint_id;
+    gint64 frame_started_us;
+} Watch;
+
+static void series_add(Series *series, long long us) {
+    series->samples_us[series->count % FRAMETIME_SAMPLES] = us;
+    series->count++;
+    series->total_us += us;
+    if (us > series->max_us) series->max_us = us;
+}
+
+static int compare_us(const void *a, const void *b) {
+    long long x = *(const long long*)a, y = *(const long long*)b;
+    return x < y ? -1 : x > y;
+}
+
+// One stderr line: mean over all samples, percentiles over the recent ones
+static void series_report(const char *kind, const char *name, const char *unit, const Series *series) {
+    if (series->count == 0) return;
+    int n = series->count < FRAMETIME_SAMPLES ? (int)series->count : FRAMETIME_SAMPLES;
+    long long sorted[FRAMETIME_SAMPLES];
+    memcpy(sorted, series->samples_us, n * sizeof(long long));
+    qsort(sorted, n, sizeof(long long), compare_us);
+
+    fprintf(stderr, "[%s %s] %ld %s  mean %.2f ms  p50 %.2f ms  p99 %.2f ms  max %.2f ms\n",
+        kind, name, series->count, unit, series->total_us / 1000.0 / series->count,
+        sorted[n / 2] / 1000.0, sorted[(n * 99) / 100] / 1000.0, series->max_us / 1000.0);
+}
+
+// ============================================
+// Frame Clock Hooks
+// ============================================
+
+static void on_before_paint(GdkFrameClock *clock, gpointer data) {
+    Watch *watch = data;
+    watch->frame_started_us = g_get_monotonic_time();
+}
+
+static void on_after_paint(GdkFrameClock *clock, gpointer data) {
+    Watch *watch = data;
+    if (watch->frame_started_us == 0) return;
+    series_add(&watch->frames, g_get_monotonic_time() - watch->frame_started_us);
+    watch->frame_started_us = 0;
+}
+
+static void on_realize(GtkWidget *window, gpointer data) {
+    Watch *watch = data;
+    watch->clock = gtk_widget_get_frame_clock(window);
+    if (!watch->clock) return;
+    watch->before_paint_id = g_signal_connect(watch->clock, "before-paint", G_CALLBACK(on_before_paint), watch);
+    watch->after_paint_id = g_signal_connect(watch->clock, "after-paint", G_CALLBACK(on_after_paint), watch);
+}
+
+// The frame clock goes away with the window's GdkWindow
+static void on_unrealize(GtkWidget *window, gpointer data) {
+    Watch *watch = data;
+    if (!watch->clock) return;
+    g_signal_handler_disconnect(watch->clock, watch->before_paint_id);
+    g_signal_handler_disconnect(watch->clock, watch->after_paint_id);
+    watch->clock = NULL;
+}
+
+static void watch_free(gpointer data) {
+    Watch *watch = data;
+    series_report("frames", watch->name, "frames", &watch->frames);
+    series_report("refresh", watch->name, "calls", &watch->refreshes);
+    g_free(watch);
+}
+
+// ============================================
+// Public API
+// ============================================
+
+// Time every frame of a window until it is destroyed
+void frametime_watch(GtkWidget *window, const char *name) {
+    if (!config_get()->frame_stats) return;
+
+    Watch *watch = g_new0(Watch, 1);
+    snprintf(watch->name, sizeof(watch->name), "%s", name);
+    g_object_set_data_full(G_OBJECT(window), "frametime", watch, watch_free);
+    g_signal_connect(window, "realize", G_CALLBACK(on_realize), watch);
+    g_signal_connect(window, "unrealize", G_CALLBACK(on_unrealize), watch);
+    if (gtk_widget_get_realized(window)) on_realize(window, watch);
+}
+
+// Start timing a piece of UI work (0 when frame stats are off)
+long long frametime_begin() {
+    return config_get()->frame_stats ? g_get_monotonic_time() : 0;
+}
+
+// Record the work started by frametime_begin() against a watched window
+void frametime_end(GtkWidget *window, long long started) {
+    if (started == 0 || !window) return;
+    Watch *watch = g_object_get_data(G_OBJECT(window), "frametime");
+    if (watch) series_add(&watch->refreshes, g_get_monotonic_time() - started);
+}
@@ -0,0 +1,298 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <ctype.h>
+#include <time.h>
+#include "gate.h"
+#include "catalog.h"
+#include "database.h"
+
+// ============================================
+// Card Table
+// ============================================
+
+typedef struct {
+    uint64_t hash;                          // 0 = empty slot
+    int member_id;
+    char card_id[GATE_CARD_MAX + 1];
+} CardSlot;
+
+typedef struct {
+    int plan_id;                            // 0 = no plan (or no Members row)
+    signed char start_hour, end_hour;       // Time slot; 0..24 when unrestricted
+    unsigned char active;
+    unsigned char auto_renew;
+    unsigned char loaded;
+    long long renews_at;
+} GateMember;
+
+static CardSlot *slots = NULL;
+static int slot_count = 0;                  // Power of two
+static int card_count = 0;
+static GateMember *members = NULL;          // Indexed by member_id
+static int member_count = 0;
+static int pending[GATE_MAX_PENDING];       // Memberships to re-read
+static int pending_count = 0;
+static long long last_seq = 0;
+static int cards_stale = 1;
+static int members_stale = 1;
+static unsigned version = 1;
+static unsigned built_version = 0;
+
+static void index_reset() {
+    free(slots);
+    free(members);
+    slots = NULL;
+    members = NULL;
+    slot_count = card_count = member_count = pending_count = 0;
+    last_seq = 0;
+}
+
+// FNV-1a; never 0, which marks an empty slot
+static uint64_t card_hash(const char *card_id) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (const unsigned char *p = (const unsigned char*)card_id; *p; p++) {
+        hash ^= *p;
+        hash *= 1099511628211ULL;
+    }
+    return hash ? hash : 1;
+}
+
+// Slot holding the card, or the empty slot where it would go
+static CardSlot* slot_find(const char *card_id, uint64_t hash) {
+    unsigned mask = (unsigned)slot_count - 1;
+    for (unsigned i = (unsigned)hash & mask; ; i = (i + 1) & mask) {
+        CardSlot *slot = &slots[i];
+        if (slot->hash == 0) return slot;
+        if (slot->hash == hash && strcmp(slot->card_id, card_id) == 0) return slot;
+    }
+}
+
+static int table_grow() {
+    int count = slot_count ? slot_count * 2 : GATE_INITIAL_SLOTS;
+    CardSlot *old = slots;
+    int old_count = slot_count;
+    slots = calloc(count, sizeof(CardSlot));
+    if (!slots) {
+        slots = old;
+        return 1;
+    }
+    slot_count = count;
+    for (int i = 0; i < old_count; i++) {
+        if (old[i].hash) *slot_find(old[i].card_id, old[i].hash) = old[i];
+    }
+    free(old);
+    return 0;
+}
+
+static void table_put(const char *card_id, int member_id) {
+    if ((card_count + 1) * 2 > slot_count && table_grow() != 0) return;
+    uint64_t hash = card_hash(card_id);
+    CardSlot *slot = slot_find(card_id, hash);
+    if (slot->hash == 0) {
+        slot->hash = hash;
+        snprintf(slot->card_id, sizeof(slot->card_id), "%s", card_id);
+        card_count++;
+    }
+    slot->member_id = member_id;
+}
+
+// Remove by shifting later entries of the probe run back, so lookups never
+// need tombstones
+static void table_remove(const char *card_id) {
+    if (slot_count == 0) return;
+    CardSlot *slot = slot_find(card_id, card_hash(card_id));
+    if (slot->hash == 0) return;
+
+    unsigned mask = (unsigned)slot_count - 1;
+    unsigned hole = (unsigned)(slot - slots);
+    for (unsigned i = (hole + 1) & mask; slots[i].hash; i = (i + 1) & mask) {
+        unsigned home = (unsigned)slots[i].hash & mask;
+        // Move it into the hole unless its home lies cyclically in (hole, i]
+        if (((i - home) & mask) >= ((i - hole) & mask)) {
+            slots[hole] = slots[i];
+            hole = i;
+        }
+    }
+    memset(&slots[hole], 0, sizeof(CardSlot));
+    card_count--;
+}
+
+// Membership of a member, growing the table if asked (NULL if unknown)
+static GateMember* member_for(int member_id, int create) {
+    if (member_id <= 0) return NULL;
+    if (member_id < member_count) return &members[member_id];
+    if (!create) return NULL;
+
+    int count = member_count ? member_count : 1024;
+    while (count <= member_id) count *= 2;
+    GateMember *grown = realloc(members, sizeof(GateMember) * count);
+    if (!grown) return NULL;
+    memset(grown + member_count, 0, sizeof(GateMember) * (count - member_count));
+    members = grown;
+    member_count = count;
+    return &members[member_id];
+}
+
+// ============================================
+// Loading
+// ============================================
+
+static void queue_member(int member_id) {
+    if (pending_count == GATE_MAX_PENDING) {
+        members_stale = 1;      // Cheaper to re-read every card holder
+        return;
+    }
+    pending[pending_count++] = member_id;
+}
+
+static void load_card(const char *card_id, int member_id, int revoked, void *ctx) {
+    if (!card_id) return;
+    if (revoked) {
+        table_remove(card_id);
+        return;
+    }
+    table_put(card_id, member_id);
+    GateMember *member = member_for(member_id, 1);
+    if (member && !member->loaded && !members_stale) queue_member(member_id);
+}
+
+static void load_member(int member_id, int plan_id, const char *time_slot, int active,
+                        long long renews_at, int auto_renew, void *ctx) {
+    GateMember *member = member_for(member_id, 1);
+    if (!member) return;
+    const TimeSlot *slot = time_slot && time_slot[0] ? catalog_find_slot(time_slot) : NULL;
+    member->plan_id = plan_id;
+    member->start_hour = slot ? slot->start_hour : 0;
+    member->end_hour = slot ? slot->end_hour : 24;
+    member->active = active != 0;
+    member->auto_renew = auto_renew != 0;
+    member->renews_at = renews_at;
+    member->loaded = 1;
+}
+
+// Re-read one membership; a member without a row is left with no plan
+static int reload_member(int member_id) {
+    GateMember *member = member_for(member_id, 0);
+    if (member) memset(member, 0, sizeof(GateMember));
+    if (db_for_each_gate_member(member_id, load_member, NULL) != 0) return 1;
+    if ((member = member_for(member_id, 1)) != NULL) member->loaded = 1;
+    return 0;
+}
+
+// Bring the index up to date: a full load after a version bump, else only
+// the card rows and memberships that changed
+static int gate_sync() {
+    if (built_version != version) {
+        index_reset();
+        cards_stale = members_stale = 1;
+        if (!db_get_handle() || table_grow() != 0) return 1;
+        built_version = version;
+    }
+    if (cards_stale) {
+        if (db_for_each_card(last_seq, load_card, NULL, &last_seq) != 0) return 1;
+        cards_stale = 0;
+    }
+    if (members_stale) {
+        if (members) memset(members, 0, sizeof(GateMember) * member_count);
+        if (db_for_each_gate_member(0, load_member, NULL) != 0) return 1;
+        members_stale = 0;
+        pending_count = 0;
+    }
+    while (pending_count > 0) {
+        if (reload_member(pending[pending_count - 1]) != 0) return 1;
+        pending_count--;
+    }
+    return 0;
+}
+
+// ============================================
+// Public API
+// ============================================
+
+// 1..GATE_CARD_MAX letters, digits or dashes
+int gate_card_valid(const char *card_id) {
+    size_t len = strlen(card_id);
+    if (len == 0 || len > GATE_CARD_MAX) return 0;
+    for (size_t i = 0; i < len; i++) {
+        if (!isalnum((unsigned char)card_id[i]) && card_id[i] != '-') return 0;
+    }
+    return 1;
+}
+
+// Local hour of `now`, calling localtime() only when the hour changes
+static int hour_of(long long now) {
+    static long long hour_start = 1, hour_end = 0;
+    static int hour = 0;
+    if (now < hour_start || now >= hour_end) {
+        time_t t = (time_t)now;
+        struct tm *local = localtime(&t);
+        hour = local->tm_hour;
+        hour_start = now - local->tm_min * 60 - local->tm_sec;
+        hour_end = hour_start + 3600;
+    }
+    return hour;
+}
+
+// Decide whether a card opens the gate at `now`
+GateResult gate_check(const char *card_id, long long now, GateDecision *decision) {
+    memset(decision, 0, sizeof(*decision));
+    if (gate_sync() != 0) return decision->result = GATE_UNAVAILABLE;
+    if (!gate_card_valid(card_id)) return decision->result = GATE_UNKNOWN_CARD;
+
+    const CardSlot *slot = slot_find(card_id, card_hash(card_id));
+    if (slot->hash == 0) return decision->result = GATE_UNKNOWN_CARD;
+    decision->member_id = slot->member_id;
+
+    const GateMember *member = member_for(slot->member_id, 0);
+    if (!member || member->plan_id <= 0) return decision->result = GATE_NO_PLAN;
+    decision->plan_id = member->plan_id;
+    decision->renews_at = member->renews_at;
+
+    // An auto-renewing membership past its deadline is only awaiting the
+    // scheduler's renewal charge
+    if (!member->active || (!member->auto_renew && member->renews_at > 0 && now >= member->renews_at)) {
+        return decision->result = GATE_EXPIRED;
+    }
+    int hour = hour_of(now);
+    if (hour < member->start_hour || hour >= member->end_hour) return decision->result = GATE_WRONG_TIME;
+    return decision->result = GATE_ALLOW;
+}
+
+const char* gate_result_name(GateResult result) {
+    switch (result) {
+        case GATE_ALLOW: return "Allowed";
+        case GATE_UNKNOWN_CARD: return "Unknown card";
+        case GATE_NO_PLAN: return "No plan";
+        case GATE_EXPIRED: return "Membership expired";
+        case GATE_WRONG_TIME: return "Outside time slot";
+        case GATE_UNAVAILABLE: return "Card index unavailable";
+    }
+    return "?";
+}
+
+// Apply pending changes now, so the next gate check reads memory only
+int gate_refresh() {
+    return gate_sync();
+}
+
+// Cards were issued or revoked; the next sync reads rows above last_seq
+void gate_mark_stale() {
+    cards_stale = 1;
+}
+
+// Another instance changed memberships; re-read every card holder
+void gate_mark_members_stale() {
+    members_stale = 1;
+}
+
+// A membership changed here (plan, renewal, expiry, merge or delete)
+void gate_member_changed(int member_id) {
+    if (member_id > 0 && !members_stale) queue_member(member_id);
+}
+
+// Invalidate the index (branch switch); the next sync reloads it
+void gate_bump_version() {
+    version++;
+}
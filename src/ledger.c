@@ -0,0 +1,264 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "ledger.h"
+#include "database.h"
+
+// ============================================
+// Revenue Index
+// ============================================
+
+// Slot 0 sums every plan; slot s > 0 belongs to plan_ids[s]
+#define LEDGER_SLOTS (LEDGER_MAX_PLANS + 1)
+
+typedef struct {
+    long long cents;
+    long payments;
+} Cell;
+
+static Cell *raw[LEDGER_SLOTS];         // Per-day totals, kept to rebuild the trees when the range grows
+static Cell *tree[LEDGER_SLOTS];        // Fenwick trees over raw; index 1 = base_day
+static int plan_ids[LEDGER_SLOTS];
+static int slot_count = 1;
+static int base_day = 0;
+static int day_capacity = 0;
+static long long last_payment_id = 0;
+static int stale = 1;
+static unsigned version = 1;
+static unsigned built_version = 0;
+
+static void index_reset() {
+    for (int s = 0; s < LEDGER_SLOTS; s++) {
+        free(raw[s]);
+        free(tree[s]);
+        raw[s] = tree[s] = NULL;
+    }
+    slot_count = 1;
+    base_day = 0;
+    day_capacity = 0;
+    last_payment_id = 0;
+}
+
+// O(n) build: every node passes its sum up to its parent once
+static void tree_build(int slot) {
+    memcpy(tree[slot], raw[slot], sizeof(Cell) * (day_capacity + 1));
+    for (int i = 1; i <= day_capacity; i++) {
+        int parent = i + (i & -i);
+        if (parent <= day_capacity) {
+            tree[slot][parent].cents += tree[slot][i].cents;
+            tree[slot][parent].payments += tree[slot][i].payments;
+        }
+    }
+}
+
+static void tree_add(int slot, int index, long long cents, long payments) {
+    for (; index <= day_capacity; index += index & -index) {
+        tree[slot][index].cents += cents;
+        tree[slot][index].payments += payments;
+    }
+}
+
+static Cell tree_prefix(int slot, int index) {
+    Cell sum = {0, 0};
+    if (index > day_capacity) index = day_capacity;
+    for (; index > 0; index -= index & -index) {
+        sum.cents += tree[slot][index].cents;
+        sum.payments += tree[slot][index].payments;
+    }
+    return sum;
+}
+
+// Re-home every slot onto [new_base, new_base + new_capacity) and rebuild
+static int index_resize(int new_base, int new_capacity) {
+    int shift = base_day - new_base;
+    for (int s = 0; s < slot_count; s++) {
+        Cell *grown = calloc(new_capacity + 1, sizeof(Cell));
+        Cell *grown_tree = malloc(sizeof(Cell) * (new_capacity + 1));
+        if (!grown || !grown_tree) {
+            free(grown);
+            free(grown_tree);
+            return 1;
+        }
+        if (raw[s]) memcpy(grown + 1 + shift, raw[s] + 1, sizeof(Cell) * day_capacity);
+        free(raw[s]);
+        free(tree[s]);
+        raw[s] = grown;
+        tree[s] = grown_tree;
+    }
+    base_day = new_base;
+    day_capacity = new_capacity;
+    for (int s = 0; s < slot_count; s++) tree_build(s);
+    return 0;
+}
+
+// Make room for `day`, doubling the covered range as needed
+static int index_ensure_day(int day) {
+    if (day_capacity == 0) return index_resize(day, LEDGER_INITIAL_DAYS);
+    if (day >= base_day && day < base_day + day_capacity) return 0;
+
+    int first = day < base_day ? day : base_day;
+    int last = day >= base_day + day_capacity ? day : base_day + day_capacity - 1;
+    int capacity = day_capacity;
+    while (capacity < last - first + 1) capacity *= 2;
+    return index_resize(first, capacity);
+}
+
+// Slot of a plan, adding one if asked (-1 if unknown or full)
+static int index_slot(int plan_id, int create) {
+    for (int s = 1; s < slot_count; s++) {
+        if (plan_ids[s] == plan_id) return s;
+    }
+    if (!create || slot_count == LEDGER_SLOTS) return -1;
+
+    raw[slot_count] = calloc(day_capacity + 1, sizeof(Cell));
+    tree[slot_count] = calloc(day_capacity + 1, sizeof(Cell));
+    if (!raw[slot_count] || !tree[slot_count]) return -1;
+    plan_ids[slot_count] = plan_id;
+    return slot_count++;
+}
+
+// Fold one (plan, day) total in; `ctx` is non-NULL while bulk loading,
+// when only the raw arrays are filled and the trees are built afterwards
+static void add_payment_day(int plan_id, int day, long long cents, int payments, void *ctx) {
+    int bulk = ctx != NULL;
+    if (index_ensure_day(day) != 0) return;
+    int index = day - base_day + 1;
+    int slots[2] = { 0, index_slot(plan_id, 1) };
+    for (int i = 0; i < 2; i++) {
+        if (slots[i] < 0) continue;
+        raw[slots[i]][index].cents += cents;
+        raw[slots[i]][index].payments += payments;
+        if (!bulk) tree_add(slots[i], index, cents, payments);
+    }
+}
+
+// Bring the trees up to date: a full build after a version bump, else just
+// the payments committed since the last sync
+static int ledger_sync() {
+    if (built_version != version) {
+        int bulk = 1;
+        index_reset();
+        if (db_get_handle() && db_for_each_payment_day(0, add_payment_day, &bulk, &last_payment_id) != 0) {
+            index_reset();
+            return 1;
+        }
+        for (int s = 0; s < slot_count && day_capacity > 0; s++) tree_build(s);
+        built_version = version;
+        stale = 0;
+    } else if (stale) {
+        if (db_for_each_payment_day(last_payment_id, add_payment_day, NULL, &last_payment_id) != 0) return 1;
+        stale = 0;
+    }
+    return 0;
+}
+
+// ============================================
+// Public API
+// ============================================
+
+// Charge a member one period of a plan at its catalog price. Call
+// ledger_mark_stale() once the transaction holding it commits.
+int ledger_charge(int member_id, int plan_id, const char *kind, long long paid_at) {
+    const Plan *plan = catalog_find_plan(plan_id);
+    if (!plan) return 1;
+    return db_insert_payment(member_id, plan_id, plan->price_cents, ledger_day(paid_at), paid_at, kind);
+}
+
+// Scheduler billing hook: one renewal payment dated at the period start
+int ledger_charge_renewal(int member_id, int plan_id, long long period_start) {
+    return ledger_charge(member_id, plan_id, LEDGER_KIND_RENEWAL, period_start);
+}
+
+// New payments were committed; the next query reads them
+void ledger_mark_stale() {
+    stale = 1;
+}
+
+// Invalidate the index; the next query rebuilds it
+void ledger_bump_version() {
+    version++;
+}
+
+// Revenue on days from..to inclusive; plan_id 0 = all plans
+int ledger_revenue(int plan_id, int from_day, int to_day, RevenueTotal *total) {
+    total->cents = 0;
+    total->payments = 0;
+    if (ledger_sync() != 0) return 1;
+
+    int slot = plan_id ? index_slot(plan_id, 0) : 0;
+    if (slot < 0 || day_capacity == 0 || from_day > to_day) return 0;
+    if (from_day < base_day) from_day = base_day;
+
+    Cell upto = tree_prefix(slot, to_day - base_day + 1);
+    Cell before = tree_prefix(slot, from_day - base_day);
+    total->cents = upto.cents - before.cents;
+    total->payments = upto.payments - before.payments;
+    return 0;
+}
+
+// ============================================
+// Calendar Days
+// ============================================
+
+// Days since 1970-01-01 of a proleptic Gregorian date
+static int days_from_civil(int y, int m, int d) {
+    y -= m <= 2;
+    int era = (y >= 0 ? y : y - 399) / 400;
+    int yoe = y - era * 400;
+    int doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+static void civil_from_days(int days, int *y, int *m, int *d) {
+    days += 719468;
+    int era = (days >= 0 ? days : days - 146096) / 146097;
+    int doe = days - era * 146097;
+    int yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    int doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    int mp = (5 * doy + 2) / 153;
+    *d = doy - (153 * mp + 2) / 5 + 1;
+    *m = mp < 10 ? mp + 3 : mp - 9;
+    *y = yoe + era * 400 + (*m <= 2);
+}
+
+// Local calendar day of a Unix time
+int ledger_day(long long unix_time) {
+    time_t t = (time_t)unix_time;
+    struct tm *local = localtime(&t);
+    return days_from_civil(local->tm_year + 1900, local->tm_mon + 1, local->tm_mday);
+}
+
+// Parse "YYYY-MM-DD"; returns 1 if it is not a real date
+int ledger_parse_day(const char *date, int *day) {
+    int y, m, d, y2, m2, d2;
+    char extra;
+    if (sscanf(date, "%d-%d-%d%c", &y, &m, &d, &extra) != 3) return 1;
+    if (y < 1970 || y > 9999 || m < 1 || m > 12 || d < 1 || d > 31) return 1;
+    *day = days_from_civil(y, m, d);
+    civil_from_days(*day, &y2, &m2, &d2);
+    return y2 == y && m2 == m && d2 == d ? 0 : 1;
+}
+
+void ledger_format_day(int day, char *buf, size_t size) {
+    int y, m, d;
+    civil_from_days(day, &y, &m, &d);
+    snprintf(buf, size, "%04d-%02d-%02d", y, m, d);
+}
+
+// "$12,345.67"
+void ledger_format_cents(long long cents, char *buf, size_t size) {
+    unsigned long long magnitude = cents < 0 ? -(unsigned long long)cents : (unsigned long long)cents;
+    char digits[32];
+    int len = snprintf(digits, sizeof(digits), "%llu", magnitude / 100);
+
+    char grouped[48];
+    int out = 0;
+    for (int i = 0; i < len; i++) {
+        if (i > 0 && (len - i) % 3 == 0) grouped[out++] = ',';
+        grouped[out++] = digits[i];
+    }
+    grouped[out] = '\0';
+    snprintf(buf, size, "%s$%s.%02llu", cents < 0 ? "-" : "", grouped, magnitude % 100);
+}
@@ -6,6 +6,12 @@
 #include "models.h"
 #include "member.h"
 #include "admin.h"
+#include "trainer.h"
+#include "scheduler.h"
+#include "occupancy.h"
+#include "ratelimit.h"
+#include "verify.h"
+#include "outbox.h"
 
 // Widgets
 static GtkWidget *window;
@@ -13,7 +19,7 @@ static GtkWidget *stack;
 static GtkWidget *login_grid, *register_grid, *verify_grid;
 
 // Login Widgets
-static GtkWidget *login_email_entry, *login_pass_entry;
+static GtkWidget *login_email_entry, *login_pass_entry, *login_branch_combo;
 
 // Register Widgets
 static GtkWidget *reg_name_entry, *reg_email_entry, *reg_pass_entry, *reg_role_combo;
@@ -28,6 +34,7 @@ void on_register_link_clicked(GtkButton *button, gpointer user_data);
 void on_register_submit_clicked(GtkButton *button, gpointer user_data);
 void on_verify_submit_clicked(GtkButton *button, gpointer user_data);
 void on_back_to_login_clicked(GtkButton *button, gpointer user_data);
+void on_resend_code_clicked(GtkButton *button, gpointer user_data);
 
 void show_message(const char *msg) {
     GtkWidget *dialog = gtk_message_dialog_new(GTK_WINDOW(window),
@@ -39,20 +46,71 @@ void show_message(const char *msg) {
     gtk_widget_destroy(dialog);
 }
 
+// Open the branch typed/selected on the login screen
+static int select_branch() {
+    gchar *branch = gtk_combo_box_text_get_active_text(GTK_COMBO_BOX_TEXT(login_branch_combo));
+    int res = db_open_branch(branch && branch[0] ? branch : DEFAULT_BRANCH);
+    g_free(branch);
+    if (res != 0) {
+        show_message("Invalid branch. Use letters, digits, '-' or '_'.");
+        return res;
+    }
+    // Pick up the renewals and live occupancy of the newly opened branch
+    // (no-op if unchanged)
+    scheduler_init();
+    occupancy_init();
+    ratelimit_init();
+    outbox_notify();
+    return 0;
+}
+
+// Send a fresh code and switch to the verification screen
+static void start_verification(const char *email, const char *name) {
+    char buf[256];
+    int rc = verify_issue(email, name);
+    if (rc == 0) {
+        snprintf(buf, sizeof(buf), "A verification code was sent to %s.", email);
+    } else if (rc == 2) {
+        snprintf(buf, sizeof(buf), "Too many codes were sent to %s. Please use the latest one or try again later.", email);
+    } else {
+        snprintf(buf, sizeof(buf), "Could not send a verification code to %s.", email);
+    }
+    show_message(buf);
+    snprintf(current_verifying_email, sizeof(current_verifying_email), "%s", email);
+    gtk_entry_set_text(GTK_ENTRY(verify_code_entry), "");
+    gtk_stack_set_visible_child(GTK_STACK(stack), verify_grid);
+}
+
 // Handle login button click
 void on_login_clicked(GtkButton *button, gpointer user_data) {
+    if (select_branch() != 0) return;
+
     const char *email = gtk_entry_get_text(GTK_ENTRY(login_email_entry));
     const char *password = gtk_entry_get_text(GTK_ENTRY(login_pass_entry));
     
+    // Refuse throttled or locked attempts before they reach the database
+    int retry_after;
+    RateLimitResult limit = ratelimit_check(email, &retry_after);
+    if (limit != RATELIMIT_ALLOWED) {
+        char buf[256];
+        if (limit == RATELIMIT_LOCKED) {
+            snprintf(buf, sizeof(buf), "Too many failed logins. This account is locked on this terminal for %d more minute(s).",
+                (retry_after + 59) / 60);
+        } else {
+            snprintf(buf, sizeof(buf), "Too many login attempts. Please wait %d second(s).", retry_after);
+        }
+        show_message(buf);
+        return;
+    }
+
     User user;
     int res = db_login_user(email, password, &user);
+    ratelimit_record(email, res == 0);
     
     if (res == 0) {
         // Check if account is verified
         if (user.verified == 0) {
-            show_message("Account not verified! Please verify.");
-            strcpy(current_verifying_email, email);
-            gtk_stack_set_visible_child(GTK_STACK(stack), verify_grid);
+            start_verification(user.email, user.name);
         } else {
             char buf[256];
             snprintf(buf, sizeof(buf), "Welcome %s!", user.name);
@@ -67,8 +125,13 @@ void on_login_clicked(GtkButton *button, gpointer user_data) {
             } else if (strcmp(user.role, "Admin") == 0) {
                 show_admin_dashboard(&user);
             } else {
-                show_message("Trainer Dashboard not implemented yet.");
-                gtk_widget_show(window);
+                Trainer trainer;
+                if (db_get_trainer(user.user_id, &trainer) == 0 && strcmp(trainer.status, "APPROVED") == 0) {
+                    show_trainer_dashboard(&user);
+                } else {
+                    show_message("Your trainer application is awaiting admin approval.");
+                    gtk_widget_show(window);
+                }
             }
         }
     } else if (res == 1) {
@@ -84,6 +147,8 @@ void on_register_link_clicked(GtkButton *button, gpointer user_data) {
 
 // Handle registration submission
 void on_register_submit_clicked(GtkButton *button, gpointer user_data) {
+    if (select_branch() != 0) return;
+
     User user;
     strncpy(user.name, gtk_entry_get_text(GTK_ENTRY(reg_name_entry)), sizeof(user.name));
     strncpy(user.email, gtk_entry_get_text(GTK_ENTRY(reg_email_entry)), sizeof(user.email));
@@ -100,21 +165,27 @@ void on_register_submit_clicked(GtkButton *button, gpointer user_data) {
         return;
     }
 
-    // Create user in database
-    if (db_create_user(&user) == 0) {
+    // Create the account and its trainer or member record together, so a
+    // failure in between cannot leave an account without one
+    int created = db_begin() == 0;
+    if (created && db_create_user(&user) == 0) {
         // If registering as trainer, create trainer record
         if (strcmp(user.role, "Trainer") == 0) {
             // For now, use a default specialization. In a real app, you'd prompt for this.
-            db_create_trainer(user.user_id, "General Fitness");
+            created = db_create_trainer(user.user_id, "General Fitness") == 0;
         } else if (strcmp(user.role, "Member") == 0) {
             // Create member record
-            db_create_member(user.user_id);
+            created = db_create_member(user.user_id) == 0;
         }
-        
-        show_message("Registration Successful! Please verify with code 1234.");
-        strcpy(current_verifying_email, user.email);
-        gtk_stack_set_visible_child(GTK_STACK(stack), verify_grid);
+        created = created && db_commit() == 0;
+    } else {
+        created = 0;
+    }
+
+    if (created) {
+        start_verification(user.email, user.name);
     } else {
+        db_rollback();
         show_message("Registration Failed. Email might be taken.");
     }
 }
@@ -123,16 +194,27 @@ void on_register_submit_clicked(GtkButton *button, gpointer user_data) {
 void on_verify_submit_clicked(GtkButton *button, gpointer user_data) {
     const char *code = gtk_entry_get_text(GTK_ENTRY(verify_code_entry));
     
-    // Check verification code (simulated - always use 1234)
-    if (strcmp(code, "1234") == 0) {
-        db_verify_user(current_verifying_email);
-        show_message("Verification Successful! Please Login.");
-        gtk_stack_set_visible_child(GTK_STACK(stack), login_grid);
-    } else {
-        show_message("Invalid Code. Use 1234.");
+    switch (verify_check(current_verifying_email, code)) {
+        case VERIFY_OK:
+            show_message("Verification Successful! Please Login.");
+            gtk_stack_set_visible_child(GTK_STACK(stack), login_grid);
+            break;
+        case VERIFY_WRONG:
+            show_message("Invalid Code. Please check the email and try again.");
+            break;
+        case VERIFY_EXPIRED:
+            show_message("This code has expired or was used too many times. Press Resend Code for a new one.");
+            break;
     }
 }
 
+// Replace the pending code with a new one
+void on_resend_code_clicked(GtkButton *button, gpointer user_data) {
+    User user;
+    if (db_get_user_by_email(current_verifying_email, &user) != 0) return;
+    start_verification(user.email, user.name);
+}
+
 void on_back_to_login_clicked(GtkButton *button, gpointer user_data) {
     gtk_stack_set_visible_child(GTK_STACK(stack), login_grid);
 }
@@ -155,6 +237,17 @@ GtkWidget* create_login_grid() {
     login_pass_entry = gtk_entry_new();
     gtk_entry_set_visibility(GTK_ENTRY(login_pass_entry), FALSE);
     
+    // Branch selector; typing a new name creates that branch's database
+    GtkWidget *lbl_branch = gtk_label_new("Branch:");
+    login_branch_combo = gtk_combo_box_text_new_with_entry();
+    char branches[MAX_BRANCHES][BRANCH_NAME_LEN];
+    int branch_count = MAX_BRANCHES;
+    db_list_branches(branches, &branch_count);
+    for (int i = 0; i < branch_count; i++) {
+        gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(login_branch_combo), branches[i]);
+    }
+    gtk_combo_box_set_active(GTK_COMBO_BOX(login_branch_combo), 0);
+
     GtkWidget *btn_login = gtk_button_new_with_label("Login");
     g_signal_connect(btn_login, "clicked", G_CALLBACK(on_login_clicked), NULL);
     
@@ -165,8 +258,10 @@ GtkWidget* create_login_grid() {
     gtk_grid_attach(GTK_GRID(grid), login_email_entry, 1, 0, 1, 1);
     gtk_grid_attach(GTK_GRID(grid), lbl_pass, 0, 1, 1, 1);
     gtk_grid_attach(GTK_GRID(grid), login_pass_entry, 1, 1, 1, 1);
-    gtk_grid_attach(GTK_GRID(grid), btn_login, 0, 2, 2, 1);
-    gtk_grid_attach(GTK_GRID(grid), btn_reg, 0, 3, 2, 1);
+    gtk_grid_attach(GTK_GRID(grid), lbl_branch, 0, 2, 1, 1);
+    gtk_grid_attach(GTK_GRID(grid), login_branch_combo, 1, 2, 1, 1);
+    gtk_grid_attach(GTK_GRID(grid), btn_login, 0, 3, 2, 1);
+    gtk_grid_attach(GTK_GRID(grid), btn_reg, 0, 4, 2, 1);
 
     return grid;
 }
@@ -221,10 +316,16 @@ GtkWidget* create_verify_grid() {
     verify_code_entry = gtk_entry_new();
     GtkWidget *btn_verify = gtk_button_new_with_label("Verify");
     g_signal_connect(btn_verify, "clicked", G_CALLBACK(on_verify_submit_clicked), NULL);
+    GtkWidget *btn_resend = gtk_button_new_with_label("Resend Code");
+    g_signal_connect(btn_resend, "clicked", G_CALLBACK(on_resend_code_clicked), NULL);
+    GtkWidget *btn_back = gtk_button_new_with_label("Back to Login");
+    g_signal_connect(btn_back, "clicked", G_CALLBACK(on_back_to_login_clicked), NULL);
 
-    gtk_grid_attach(GTK_GRID(grid), gtk_label_new("Enter Verification Code (1234):"), 0, 0, 2, 1);
+    gtk_grid_attach(GTK_GRID(grid), gtk_label_new("Enter the code from your email:"), 0, 0, 2, 1);
     gtk_grid_attach(GTK_GRID(grid), verify_code_entry, 0, 1, 2, 1);
     gtk_grid_attach(GTK_GRID(grid), btn_verify, 0, 2, 2, 1);
+    gtk_grid_attach(GTK_GRID(grid), btn_resend, 0, 3, 1, 1);
+    gtk_grid_attach(GTK_GRID(grid), btn_back, 1, 3, 1, 1);
 
     return grid;
 }
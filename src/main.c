@@ -1,9 +1,217 @@
 #include <gtk/gtk.h>
 #include <stdio.h>
+#include <string.h>
+#include <time.h>
 #include "login.h"
 #include "database.h"
+#include "scheduler.h"
+#include "eventlog.h"
+#include "backup.h"
+#include "archive.h"
+#include "visits.h"
+#include "gate.h"
+#include "occupancy.h"
+#include "config.h"
+#include "changes.h"
+#include "outbox.h"
+#include "ledger.h"
+
+// ============================================
+// Renewal Scheduler Wakeups
+// ============================================
+
+// One-shot main-loop timer armed for the scheduler's next deadline
+static guint scheduler_source = 0;
+
+static gboolean on_scheduler_due(gpointer data) {
+    scheduler_source = 0;
+    int processed = scheduler_run_due((long long)time(NULL));
+    if (processed < 0) {
+        fprintf(stderr, "Membership renewals failed, will retry.\n");
+    } else if (processed > 0) {
+        printf("Processed %d membership renewals/expiries.\n", processed);
+    }
+    return G_SOURCE_REMOVE;
+}
+
+// Re-arm the timer whenever the earliest deadline changes
+static void arm_scheduler(long long next_deadline) {
+    if (scheduler_source) {
+        g_source_remove(scheduler_source);
+        scheduler_source = 0;
+    }
+    if (next_deadline == 0) return;
+
+    // Clamp to [1s, 1 day]: never spin, and re-check at least daily
+    long long delay = next_deadline - (long long)time(NULL);
+    if (delay < 1) delay = 1;
+    if (delay > 86400) delay = 86400;
+    scheduler_source = g_timeout_add_seconds((guint)delay, on_scheduler_due, NULL);
+}
+
+// ============================================
+// Periodic Timers
+// ============================================
+
+static guint eventlog_source = 0;
+static guint occupancy_source = 0;
+static guint backup_source = 0;
+static guint archive_source = 0;
+static guint changes_source = 0;
+
+static gboolean on_eventlog_flush(gpointer data) {
+    eventlog_flush();
+    return G_SOURCE_CONTINUE;
+}
+
+// Live counters and attendance bitmaps share the checkpoint interval
+static gboolean on_occupancy_checkpoint(gpointer data) {
+    occupancy_checkpoint();
+    visits_checkpoint();
+    return G_SOURCE_CONTINUE;
+}
+
+static gboolean on_backup_due(gpointer data) {
+    backup_start_background();
+    return G_SOURCE_CONTINUE;
+}
+
+static gboolean on_archive_due(gpointer data) {
+    archive_start_background();
+    return G_SOURCE_CONTINUE;
+}
+
+static gboolean on_changes_poll(gpointer data) {
+    changes_poll();
+    return G_SOURCE_CONTINUE;
+}
+
+// Another instance checked members in or out: recount the live counters
+// and fold its check-ins into the attendance bitmaps
+static void on_attendance_changed(unsigned changed, void *ctx) {
+    occupancy_reload();
+    visits_mark_stale();
+}
+
+// Cards or memberships changed elsewhere: update the gate index now rather
+// than on the next card presented
+static void on_gate_data_changed(unsigned changed, void *ctx) {
+    gate_refresh();
+}
+
+// Memberships started, renewed or merged elsewhere: reload their deadlines
+// so renewals and expiries are not late or missed
+static void on_memberships_changed(unsigned changed, void *ctx) {
+    if (scheduler_reload() != 0) fprintf(stderr, "Failed to reload membership deadlines.\n");
+}
+
+static void replace_timer(guint *source, guint seconds, GSourceFunc callback) {
+    if (*source) g_source_remove(*source);
+    *source = g_timeout_add_seconds(seconds, callback, NULL);
+}
+
+// (Re)start the periodic timers with the intervals from the config file
+static void arm_periodic_timers() {
+    const Config *config = config_get();
+    replace_timer(&eventlog_source, config->eventlog_flush_seconds, on_eventlog_flush);
+    replace_timer(&occupancy_source, config->occupancy_checkpoint_seconds, on_occupancy_checkpoint);
+    replace_timer(&backup_source, config->backup_interval_hours * 3600, on_backup_due);
+    replace_timer(&archive_source, config->archive_interval_hours * 3600, on_archive_due);
+
+    if (changes_source) g_source_remove(changes_source);
+    changes_source = g_timeout_add(config->change_poll_ms, on_changes_poll, NULL);
+}
+
+// Apply a config file reloaded after SIGHUP. Limits and batch sizes are
+// read where they are used; pragmas and timers need to be re-applied.
+static gboolean on_config_poll(gpointer data) {
+    if (config_poll_reload()) {
+        db_apply_settings();
+        arm_periodic_timers();
+    }
+    return G_SOURCE_CONTINUE;
+}
+
+// ============================================
+// Command Line
+// ============================================
+
+// Path given with --config <file>, or the default
+static const char* config_path_arg(int argc, char *argv[]) {
+    for (int i = 1; i + 1 < argc; i++) {
+        if (strcmp(argv[i], "--config") == 0) return argv[i + 1];
+    }
+    return CONFIG_DEFAULT_PATH;
+}
+
+// Handle --backup [dest] / --restore <file> / --archive, optionally with
+// --branch <name>. Returns -1 when no such command was given and the GUI
+// should start.
+static int run_backup_command(int argc, char *argv[]) {
+    const char *command = NULL, *file = NULL, *branch = DEFAULT_BRANCH;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--branch") == 0 && i + 1 < argc) {
+            branch = argv[++i];
+        } else if (strcmp(argv[i], "--config") == 0 && i + 1 < argc) {
+            i++;
+        } else if (strcmp(argv[i], "--archive") == 0) {
+            command = argv[i];
+        } else if (strcmp(argv[i], "--backup") == 0 || strcmp(argv[i], "--restore") == 0) {
+            command = argv[i];
+            if (i + 1 < argc && strncmp(argv[i + 1], "--", 2) != 0) file = argv[++i];
+        }
+    }
+    if (!command) return -1;
+
+    if (db_open_branch(branch) != 0) {
+        fprintf(stderr, "Failed to open branch '%s'.\n", branch);
+        return 1;
+    }
+
+    if (strcmp(command, "--archive") == 0) {
+        const Config *config = config_get();
+        ArchiveReport archived;
+        int rc = archive_run(db_get_path(), config->archive_horizon_days, config->archive_batch_rows, &archived);
+        if (rc == 0) {
+            printf("Archived %ld visits before %s: %d batches over %d years in %.3f s\n",
+                archived.rows, archived.cutoff, archived.batches, archived.years, archived.seconds);
+        }
+        db_close();
+        return rc;
+    }
+
+    BackupReport report;
+    int rc;
+    if (strcmp(command, "--backup") == 0) {
+        char dest[256];
+        if (file) snprintf(dest, sizeof(dest), "%s", file);
+        else backup_default_path(dest, sizeof(dest));
+        rc = backup_run(db_get_path(), dest, config_get()->backup_step_pages, &report);
+        if (rc == 0) printf("Backed up %s to %s\n", db_get_path(), report.path);
+    } else if (!file) {
+        fprintf(stderr, "Usage: %s --restore <backup.db> [--branch <name>]\n", argv[0]);
+        rc = 1;
+    } else {
+        rc = backup_restore(file, &report);
+        if (rc == 0) printf("Restored %s from %s\n", report.path, file);
+    }
+    if (rc == 0) {
+        printf("%d pages (%.1f MB) in %.3f s: %.1f MB/s\n",
+            report.pages, report.bytes / 1e6, report.seconds, report.mb_per_s);
+    }
+
+    db_close();
+    return rc;
+}
 
 int main(int argc, char *argv[]) {
+    // Settings first: they decide where the database lives
+    config_load(config_path_arg(argc, argv));
+
+    // Command-line backup/restore/archive runs without the GUI
+    int rc = run_backup_command(argc, argv);
+    if (rc >= 0) return rc;
+
     // Initialize GTK
     gtk_init(&argc, &argv);
 
@@ -13,11 +221,41 @@ int main(int argc, char *argv[]) {
         return 1;
     }
 
+    // Start renewal scheduler (wakes only at the next due membership);
+    // every renewal is charged to the payments ledger
+    scheduler_set_wakeup_hook(arm_scheduler);
+    scheduler_set_billing_hook(ledger_charge_renewal);
+    scheduler_init();
+    changes_subscribe(CHANGE_MEMBERS, on_memberships_changed, NULL);
+
+    // Live occupancy counters start from today's open visits
+    occupancy_init();
+    changes_subscribe(CHANGE_ATTENDANCE, on_attendance_changed, NULL);
+
+    // Turnstile card index, kept current as cards and memberships change
+    gate_refresh();
+    changes_subscribe(CHANGE_MEMBERS | CHANGE_CARDS, on_gate_data_changed, NULL);
+
+    // Verification and notification mail is delivered in the background
+    if (outbox_start() != 0) fprintf(stderr, "Failed to start mail sender.\n");
+
+    // Event log flushes, occupancy checkpoints, backups, attendance
+    // archiving, change polling and config reloads
+    arm_periodic_timers();
+    config_install_reload_signal();
+    g_timeout_add_seconds(1, on_config_poll, NULL);
+
     // Show Login Window
     show_login_window();
 
     // Start Main Loop
     gtk_main();
 
+    // Flushes the event log and closes the database; queued mail stays in
+    // the outbox for the next run
+    outbox_stop();
+    occupancy_checkpoint();
+    visits_checkpoint();
+    db_close();
     return 0;
 }
@@ -1,8 +1,23 @@
 #include <gtk/gtk.h>
 #include <stdio.h>
+#include <string.h>
+#include <time.h>
 #include "member.h"
 #include "database.h"
+#include "catalog.h"
+#include "scheduler.h"
+#include "occupancy.h"
+#include "config.h"
 #include "login.h"
+#include "program.h"
+#include "booking.h"
+#include "outbox.h"
+#include "changes.h"
+#include "frametime.h"
+#include "ledger.h"
+#include "visits.h"
+#include "gate.h"
+#include "eventlog.h"
 
 // ============================================
 // Global State
@@ -13,11 +28,26 @@ static GtkWidget *stack;
 static User current_user;
 static Member current_member;
 
-// UI Grids
+// UI Grids (built once per login; refresh functions update them in place)
 static GtkWidget *plan_grid;
 static GtkWidget *time_grid;
 static GtkWidget *trainer_grid;
+static GtkWidget *trainer_list;
+static GtkWidget *no_trainers_label;
 static GtkWidget *dashboard_grid;
+static GtkWidget *welcome_label;
+static GtkWidget *plan_label;
+static GtkWidget *trainer_label;
+static GtkWidget *program_label;
+static GtkWidget *visits_label;
+static GtkWidget *day_labels[PROGRAM_DAYS];
+static GtkWidget *detail_labels[PROGRAM_DAYS];
+static GtkWidget *zone_combo;
+static GtkWidget *btn_checkin;
+static GtkWidget *btn_checkout;
+static GtkWidget *classes_box;
+static GtkWidget *classes_list;
+static int changes_subscription = 0;
 
 // User Selections
 static int selected_plan_id = 0;
@@ -25,6 +55,9 @@ static char selected_time_slot[50];
 
 // Forward declaration
 void refresh_dashboard();
+static void refresh_trainers();
+static void refresh_classes();
+static void show_member_message(const char *msg);
 
 // ============================================
 // Event Handlers
@@ -41,19 +74,34 @@ void on_time_selected(GtkButton *button, gpointer data) {
     const char *slot = (const char *)data;
     snprintf(selected_time_slot, sizeof(selected_time_slot), "%s", slot);
     
-    // Save plan and time slot to database
-    db_update_member_plan(current_member.member_id, selected_plan_id, selected_time_slot);
+    // Save plan and time slot, and charge the first period with it
+    int saved = 0;
+    if (db_begin() == 0) {
+        saved = db_update_member_plan(current_member.member_id, selected_plan_id, selected_time_slot) == 0 &&
+            ledger_charge(current_member.member_id, selected_plan_id, LEDGER_KIND_SIGNUP, (long long)time(NULL)) == 0 &&
+            db_commit() == 0;
+        if (!saved) db_rollback();
+    }
+    if (!saved) {
+        show_member_message("Could not save your plan. Please try again.");
+        gtk_stack_set_visible_child(GTK_STACK(stack), plan_grid);
+        return;
+    }
+    ledger_mark_stale();
+    eventlog_append(EVENT_PLAN_CHANGED, current_member.member_id, selected_plan_id, selected_time_slot);
+    scheduler_track(current_member.member_id, db_get_member_renewal(current_member.member_id));
+    gate_member_changed(current_member.member_id);
     
     // Refresh member data
     db_get_member(current_user.user_id, &current_member);
     
-    // Move to trainer selection
+    // Move to trainer selection, offering trainers free in the chosen slot
+    refresh_trainers();
     gtk_stack_set_visible_child(GTK_STACK(stack), trainer_grid);
 }
 
-// Handle trainer selection
-void on_trainer_selected(GtkButton *button, gpointer data) {
-    int trainer_id = GPOINTER_TO_INT(data);
+// Assign a trainer and show the dashboard
+static void select_trainer(int trainer_id) {
     db_assign_trainer(current_member.member_id, trainer_id);
     
     // Refresh member data
@@ -64,8 +112,146 @@ void on_trainer_selected(GtkButton *button, gpointer data) {
     gtk_stack_set_visible_child(GTK_STACK(stack), dashboard_grid);
 }
 
+// Handle the "Choose Trainer" button
+static void on_choose_trainer_clicked(GtkButton *button, gpointer data) {
+    GtkTreeSelection *selection = gtk_tree_view_get_selection(GTK_TREE_VIEW(trainer_list));
+    GtkTreeModel *model;
+    GtkTreeIter iter;
+    int trainer_id;
+    if (!gtk_tree_selection_get_selected(selection, &model, &iter)) return;
+    gtk_tree_model_get(model, &iter, 0, &trainer_id, -1);
+    select_trainer(trainer_id);
+}
+
+// Double-clicking a trainer chooses them
+static void on_trainer_row_activated(GtkTreeView *view, GtkTreePath *path, GtkTreeViewColumn *column, gpointer data) {
+    GtkTreeModel *model = gtk_tree_view_get_model(view);
+    GtkTreeIter iter;
+    int trainer_id;
+    if (!gtk_tree_model_get_iter(model, &iter, path)) return;
+    gtk_tree_model_get(model, &iter, 0, &trainer_id, -1);
+    select_trainer(trainer_id);
+}
+
+// Visits this month, last 30 days and the current streak
+static void update_visits_label() {
+    VisitSummary summary;
+    char buf[128];
+    if (visits_summary(current_member.member_id, ledger_day(time(NULL)), &summary) != 0) {
+        gtk_label_set_text(GTK_LABEL(visits_label), "");
+        return;
+    }
+    snprintf(buf, sizeof(buf), "Visits: %d this month, %d in the last 30 days | Streak: %d day%s",
+        summary.this_month, summary.last_30_days, summary.streak, summary.streak == 1 ? "" : "s");
+    gtk_label_set_text(GTK_LABEL(visits_label), buf);
+}
+
+// Enable the attendance buttons that make sense for today's visit
+static void update_attendance_buttons() {
+    int checked_in = db_is_checked_in_today(current_member.member_id);
+    int in_building = checked_in && db_is_in_building(current_member.member_id);
+    gtk_button_set_label(GTK_BUTTON(btn_checkin), checked_in ? "Checked In Today" : "Check-In (Attendance)");
+    gtk_widget_set_sensitive(btn_checkin, !checked_in);
+    gtk_widget_set_sensitive(zone_combo, !checked_in);
+    gtk_widget_set_sensitive(btn_checkout, in_building);
+    update_visits_label();
+}
+
+// Handle attendance check-in
+static void on_check_in_clicked(GtkButton *button, gpointer data) {
+    const char *zone = occupancy_zone_name(gtk_combo_box_get_active(GTK_COMBO_BOX(zone_combo)));
+    if (db_check_in(current_member.member_id, zone) == 0) {
+        occupancy_reload();
+        visits_record(current_member.member_id, ledger_day(time(NULL)));
+    }
+    update_attendance_buttons();
+}
+
+// Handle leaving the building
+static void on_check_out_clicked(GtkButton *button, gpointer data) {
+    char zone[50];
+    if (db_check_out(current_member.member_id, zone, sizeof(zone)) == 0) {
+        occupancy_reload();
+    }
+    update_attendance_buttons();
+}
+
+// Show message dialog on the member window
+static void show_member_message(const char *msg) {
+    GtkWidget *dialog = gtk_message_dialog_new(GTK_WINDOW(window), GTK_DIALOG_DESTROY_WITH_PARENT,
+                                               GTK_MESSAGE_INFO, GTK_BUTTONS_OK, "%s", msg);
+    gtk_dialog_run(GTK_DIALOG(dialog));
+    gtk_widget_destroy(dialog);
+}
+
+// Class id of the selected row, or 0
+static int selected_class_id() {
+    GtkTreeSelection *selection = gtk_tree_view_get_selection(GTK_TREE_VIEW(classes_list));
+    GtkTreeModel *model;
+    GtkTreeIter iter;
+    int class_id = 0;
+    if (gtk_tree_selection_get_selected(selection, &model, &iter)) {
+        gtk_tree_model_get(model, &iter, 0, &class_id, -1);
+    }
+    return class_id;
+}
+
+static void on_classes_clicked(GtkButton *button, gpointer data) {
+    refresh_classes();
+    gtk_stack_set_visible_child(GTK_STACK(stack), classes_box);
+}
+
+static void on_back_to_dashboard_clicked(GtkButton *button, gpointer data) {
+    gtk_stack_set_visible_child(GTK_STACK(stack), dashboard_grid);
+}
+
+// Book the selected class (or join its waitlist)
+static void on_book_class_clicked(GtkButton *button, gpointer data) {
+    int class_id = selected_class_id();
+    if (class_id == 0) return;
+
+    int position;
+    char buf[128];
+    switch (booking_reserve(db_get_handle(), class_id, current_member.member_id, &position, NULL)) {
+        case BOOKING_BOOKED: snprintf(buf, sizeof(buf), "You're booked in!"); break;
+        case BOOKING_WAITLISTED: snprintf(buf, sizeof(buf), "The class is full. You are #%d on the waitlist.", position); break;
+        case BOOKING_ALREADY: snprintf(buf, sizeof(buf), "You already have a place in this class."); break;
+        case BOOKING_CLOSED: snprintf(buf, sizeof(buf), "This class is no longer open for booking."); break;
+        default: snprintf(buf, sizeof(buf), "The booking system is busy. Please try again."); break;
+    }
+    show_member_message(buf);
+    refresh_classes();
+}
+
+// Cancel the selected booking; a freed seat goes to the waitlist head,
+// who is told by email
+static void on_cancel_class_clicked(GtkButton *button, gpointer data) {
+    int class_id = selected_class_id();
+    if (class_id == 0) return;
+
+    int promoted;
+    BookingResult result = booking_cancel(db_get_handle(), class_id, current_member.member_id, &promoted, NULL);
+    User user;
+    if (promoted && db_get_user(promoted, &user) == 0) {
+        char body[256];
+        snprintf(body, sizeof(body), "Hello %s,\n\nA place opened up and you are now booked into a class "
+            "you were waiting for. See the Classes screen for details.\n", user.name);
+        if (outbox_enqueue(user.email, "You're off the waitlist", body) == 0) outbox_notify();
+    }
+    if (result == BOOKING_CLOSED) show_member_message("You have no place in this class.");
+    else if (result == BOOKING_BUSY || result == BOOKING_ERROR) show_member_message("Could not cancel. Please try again.");
+    refresh_classes();
+}
+
+// Another app instance booked, cancelled or scheduled a class
+static void on_classes_changed(unsigned changed, void *ctx) {
+    refresh_classes();
+}
+
 // Handle logout
 static void on_logout_clicked(GtkButton *button, gpointer data) {
+    changes_unsubscribe(changes_subscription);
+    changes_subscription = 0;
     gtk_widget_destroy(window);
     return_to_login();
 }
@@ -85,15 +271,15 @@ GtkWidget* create_plan_grid() {
     GtkWidget *lbl = gtk_label_new("Select a Plan:");
     gtk_grid_attach(GTK_GRID(grid), lbl, 0, 0, 2, 1);
 
-    Plan plans[10];
-    int count = 10;
-    db_get_plans(plans, &count);
-
-    for (int i = 0; i < count; i++) {
-        char label[100];
-        snprintf(label, sizeof(label), "%s - $%.2f", plans[i].name, plans[i].price);
+    // Served from the in-memory catalog; no database round trip
+    const Catalog *catalog = catalog_get();
+    for (int i = 0; i < catalog->plan_count; i++) {
+        const Plan *plan = &catalog->plans[i];
+        char price[32], label[200];
+        ledger_format_cents(plan->price_cents, price, sizeof(price));
+        snprintf(label, sizeof(label), "%s - %s", plan->name, price);
         GtkWidget *btn = gtk_button_new_with_label(label);
-        g_signal_connect(btn, "clicked", G_CALLBACK(on_plan_selected), GINT_TO_POINTER(plans[i].plan_id));
+        g_signal_connect(btn, "clicked", G_CALLBACK(on_plan_selected), GINT_TO_POINTER(plan->plan_id));
         gtk_grid_attach(GTK_GRID(grid), btn, 0, i + 1, 2, 1);
     }
 
@@ -111,17 +297,18 @@ GtkWidget* create_time_grid() {
     GtkWidget *lbl = gtk_label_new("Select Time Slot:");
     gtk_grid_attach(GTK_GRID(grid), lbl, 0, 0, 1, 1);
 
-    const char *slots[] = {"Morning (6-10)", "Evening (5-9)", "Full Day"};
-    for (int i = 0; i < 3; i++) {
-        GtkWidget *btn = gtk_button_new_with_label(slots[i]);
-        g_signal_connect(btn, "clicked", G_CALLBACK(on_time_selected), (gpointer)slots[i]);
+    const Catalog *catalog = catalog_get();
+    for (int i = 0; i < catalog->slot_count; i++) {
+        const char *slot = catalog->slots[i].label;
+        GtkWidget *btn = gtk_button_new_with_label(slot);
+        g_signal_connect(btn, "clicked", G_CALLBACK(on_time_selected), (gpointer)slot);
         gtk_grid_attach(GTK_GRID(grid), btn, 0, i + 1, 1, 1);
     }
 
     return grid;
 }
 
-// Create trainer selection screen
+// Create trainer selection screen; refresh_trainers() fills the list
 GtkWidget* create_trainer_grid() {
     GtkWidget *grid = gtk_grid_new();
     gtk_grid_set_row_spacing(GTK_GRID(grid), 10);
@@ -132,75 +319,216 @@ GtkWidget* create_trainer_grid() {
     GtkWidget *lbl = gtk_label_new("Select a Trainer:");
     gtk_grid_attach(GTK_GRID(grid), lbl, 0, 0, 1, 1);
 
-    Trainer trainers[10];
-    int count = 10;
+    GtkListStore *store = gtk_list_store_new(2, G_TYPE_INT, G_TYPE_STRING);
+    trainer_list = gtk_tree_view_new_with_model(GTK_TREE_MODEL(store));
+    g_object_unref(store);
+    GtkCellRenderer *renderer = gtk_cell_renderer_text_new();
+    gtk_tree_view_append_column(GTK_TREE_VIEW(trainer_list),
+        gtk_tree_view_column_new_with_attributes("Trainer ID", renderer, "text", 0, NULL));
+    renderer = gtk_cell_renderer_text_new();
+    gtk_tree_view_append_column(GTK_TREE_VIEW(trainer_list),
+        gtk_tree_view_column_new_with_attributes("Specialization", renderer, "text", 1, NULL));
+    g_signal_connect(trainer_list, "row-activated", G_CALLBACK(on_trainer_row_activated), NULL);
+
+    GtkWidget *scroll = gtk_scrolled_window_new(NULL, NULL);
+    gtk_widget_set_size_request(scroll, 360, 240);
+    gtk_container_add(GTK_CONTAINER(scroll), trainer_list);
+    gtk_grid_attach(GTK_GRID(grid), scroll, 0, 1, 1, 1);
+
+    // Shown by refresh_trainers() only when the list is empty
+    no_trainers_label = gtk_label_new("No trainers available.");
+    gtk_widget_set_no_show_all(no_trainers_label, TRUE);
+    gtk_grid_attach(GTK_GRID(grid), no_trainers_label, 0, 2, 1, 1);
+
+    GtkWidget *btn_choose = gtk_button_new_with_label("Choose Trainer");
+    g_signal_connect(btn_choose, "clicked", G_CALLBACK(on_choose_trainer_clicked), NULL);
+    gtk_grid_attach(GTK_GRID(grid), btn_choose, 0, 3, 1, 1);
+
+    return grid;
+}
+
+// Refill the trainer list for the selected time slot
+static void refresh_trainers() {
+    long long started = frametime_begin();
+    GtkListStore *store = GTK_LIST_STORE(gtk_tree_view_get_model(GTK_TREE_VIEW(trainer_list)));
+    gtk_list_store_clear(store);
+
+    int count = config_get()->trainer_choices_max;
+    Trainer *trainers = g_new0(Trainer, count);
     db_get_available_trainers(selected_time_slot, trainers, &count);
 
-    if (count == 0) {
-        gtk_grid_attach(GTK_GRID(grid), gtk_label_new("No trainers available."), 0, 1, 1, 1);
+    for (int i = 0; i < count; i++) {
+        GtkTreeIter iter;
+        gtk_list_store_append(store, &iter);
+        gtk_list_store_set(store, &iter, 0, trainers[i].trainer_id, 1, trainers[i].specialization, -1);
     }
+    g_free(trainers);
+
+    gtk_widget_set_visible(no_trainers_label, count == 0);
+    frametime_end(window, started);
+}
+
+// Reload the upcoming classes with this member's place in each
+static void refresh_classes() {
+    long long started = frametime_begin();
+    GtkListStore *store = GTK_LIST_STORE(gtk_tree_view_get_model(GTK_TREE_VIEW(classes_list)));
+    gtk_list_store_clear(store);
+
+    ClassInfo classes[BOOKING_MAX_CLASSES];
+    int count = BOOKING_MAX_CLASSES;
+    if (booking_list_upcoming(db_get_handle(), current_member.member_id, classes, &count) != 0) count = 0;
 
     for (int i = 0; i < count; i++) {
-        char label[100];
-        snprintf(label, sizeof(label), "Trainer ID: %d (%s)", trainers[i].trainer_id, trainers[i].specialization);
-        GtkWidget *btn = gtk_button_new_with_label(label);
-        g_signal_connect(btn, "clicked", G_CALLBACK(on_trainer_selected), GINT_TO_POINTER(trainers[i].trainer_id));
-        gtk_grid_attach(GTK_GRID(grid), btn, 0, i + 1, 1, 1);
+        char starts[32], seats[32], mine[32];
+        time_t at = (time_t)classes[i].starts_at;
+        strftime(starts, sizeof(starts), "%a %d %b %H:%M", localtime(&at));
+        snprintf(seats, sizeof(seats), "%d/%d", classes[i].booked, classes[i].capacity);
+        if (classes[i].my_status == 1) snprintf(mine, sizeof(mine), "Booked");
+        else if (classes[i].my_status == 2) snprintf(mine, sizeof(mine), "Waitlist #%d", classes[i].my_position);
+        else mine[0] = '\0';
+
+        GtkTreeIter iter;
+        gtk_list_store_append(store, &iter);
+        gtk_list_store_set(store, &iter, 0, classes[i].class_id, 1, classes[i].name, 2, classes[i].trainer_name,
+            3, starts, 4, classes[i].duration_minutes, 5, seats, 6, classes[i].waitlisted, 7, mine, -1);
     }
+    frametime_end(window, started);
+}
 
-    return grid;
+// Create class booking screen
+GtkWidget* create_classes_box() {
+    GtkWidget *vbox = gtk_box_new(GTK_ORIENTATION_VERTICAL, 5);
+
+    GtkListStore *store = gtk_list_store_new(8, G_TYPE_INT, G_TYPE_STRING, G_TYPE_STRING, G_TYPE_STRING,
+        G_TYPE_INT, G_TYPE_STRING, G_TYPE_INT, G_TYPE_STRING);
+    classes_list = gtk_tree_view_new_with_model(GTK_TREE_MODEL(store));
+    g_object_unref(store);
+    static const char *titles[] = { "ID", "Class", "Trainer", "Starts", "Minutes", "Seats", "Waitlist", "You" };
+    for (int i = 0; i < 8; i++) {
+        GtkCellRenderer *renderer = gtk_cell_renderer_text_new();
+        gtk_tree_view_append_column(GTK_TREE_VIEW(classes_list),
+            gtk_tree_view_column_new_with_attributes(titles[i], renderer, "text", i, NULL));
+    }
+    GtkWidget *scroll = gtk_scrolled_window_new(NULL, NULL);
+    gtk_container_add(GTK_CONTAINER(scroll), classes_list);
+    gtk_box_pack_start(GTK_BOX(vbox), scroll, TRUE, TRUE, 0);
+
+    GtkWidget *buttons = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 5);
+    GtkWidget *btn_book = gtk_button_new_with_label("Book");
+    GtkWidget *btn_cancel = gtk_button_new_with_label("Cancel Booking");
+    GtkWidget *btn_back = gtk_button_new_with_label("Back to Dashboard");
+    g_signal_connect(btn_book, "clicked", G_CALLBACK(on_book_class_clicked), NULL);
+    g_signal_connect(btn_cancel, "clicked", G_CALLBACK(on_cancel_class_clicked), NULL);
+    g_signal_connect(btn_back, "clicked", G_CALLBACK(on_back_to_dashboard_clicked), NULL);
+    gtk_box_pack_start(GTK_BOX(buttons), btn_book, TRUE, TRUE, 0);
+    gtk_box_pack_start(GTK_BOX(buttons), btn_cancel, TRUE, TRUE, 0);
+    gtk_box_pack_start(GTK_BOX(buttons), btn_back, TRUE, TRUE, 0);
+    gtk_box_pack_start(GTK_BOX(vbox), buttons, FALSE, FALSE, 0);
+    return vbox;
 }
 
-// Create member dashboard screen
+// Create member dashboard screen; refresh_dashboard() fills in the labels
 GtkWidget* create_dashboard_grid() {
     GtkWidget *grid = gtk_grid_new();
     gtk_grid_set_row_spacing(GTK_GRID(grid), 10);
     gtk_grid_set_column_spacing(GTK_GRID(grid), 10);
     gtk_widget_set_halign(grid, GTK_ALIGN_CENTER);
     gtk_widget_set_valign(grid, GTK_ALIGN_CENTER);
+
+    welcome_label = gtk_label_new("");
+    plan_label = gtk_label_new("");
+    trainer_label = gtk_label_new("");
+    program_label = gtk_label_new("");
+    visits_label = gtk_label_new("");
+    gtk_grid_attach(GTK_GRID(grid), welcome_label, 0, 0, 2, 1);
+    gtk_grid_attach(GTK_GRID(grid), plan_label, 0, 1, 2, 1);
+    gtk_grid_attach(GTK_GRID(grid), trainer_label, 0, 2, 2, 1);
+    gtk_grid_attach(GTK_GRID(grid), visits_label, 0, 3, 2, 1);
+    gtk_grid_attach(GTK_GRID(grid), program_label, 0, 4, 2, 1);
+
+    // Weekly Workout Plan: one row per day
+    int row = 5;
+    for (int d = 0; d < PROGRAM_DAYS; d++, row++) {
+        day_labels[d] = gtk_label_new("");
+        detail_labels[d] = gtk_label_new("");
+        gtk_widget_set_halign(day_labels[d], GTK_ALIGN_START);
+        gtk_widget_set_halign(detail_labels[d], GTK_ALIGN_START);
+        gtk_grid_attach(GTK_GRID(grid), day_labels[d], 0, row, 1, 1);
+        gtk_grid_attach(GTK_GRID(grid), detail_labels[d], 1, row, 1, 1);
+    }
     
-    // Content populated in refresh_dashboard()
+    // Attendance (zone chosen at check-in)
+    zone_combo = gtk_combo_box_text_new();
+    for (int z = 0; z < OCCUPANCY_ZONE_COUNT; z++) {
+        gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(zone_combo), occupancy_zone_name(z));
+    }
+    gtk_combo_box_set_active(GTK_COMBO_BOX(zone_combo), 0);
+    gtk_grid_attach(GTK_GRID(grid), zone_combo, 0, row++, 2, 1);
+
+    btn_checkin = gtk_button_new_with_label("Check-In (Attendance)");
+    g_signal_connect(btn_checkin, "clicked", G_CALLBACK(on_check_in_clicked), NULL);
+    gtk_grid_attach(GTK_GRID(grid), btn_checkin, 0, row, 1, 1);
+
+    btn_checkout = gtk_button_new_with_label("Check-Out");
+    g_signal_connect(btn_checkout, "clicked", G_CALLBACK(on_check_out_clicked), NULL);
+    gtk_grid_attach(GTK_GRID(grid), btn_checkout, 1, row++, 1, 1);
+    
+    GtkWidget *btn_classes = gtk_button_new_with_label("Classes");
+    g_signal_connect(btn_classes, "clicked", G_CALLBACK(on_classes_clicked), NULL);
+    gtk_grid_attach(GTK_GRID(grid), btn_classes, 0, row++, 2, 1);
+
+    // Logout button
+    GtkWidget *btn_logout = gtk_button_new_with_label("Logout");
+    g_signal_connect(btn_logout, "clicked", G_CALLBACK(on_logout_clicked), NULL);
+    gtk_grid_attach(GTK_GRID(grid), btn_logout, 0, row, 2, 1);
+
     return grid;
 }
 
 // Update dashboard with current member information
 void refresh_dashboard() {
-    // Clear existing widgets
-    GList *children, *iter;
-    children = gtk_container_get_children(GTK_CONTAINER(dashboard_grid));
-    for(iter = children; iter != NULL; iter = g_list_next(iter))
-        gtk_widget_destroy(GTK_WIDGET(iter->data));
-    g_list_free(children);
-
+    long long started = frametime_begin();
     char buf[256];
     snprintf(buf, sizeof(buf), "Welcome %s!", current_user.name);
-    gtk_grid_attach(GTK_GRID(dashboard_grid), gtk_label_new(buf), 0, 0, 2, 1);
+    gtk_label_set_text(GTK_LABEL(welcome_label), buf);
     
-    snprintf(buf, sizeof(buf), "Plan ID: %d | Time: %s", current_member.plan_id, current_member.time_slot);
-    gtk_grid_attach(GTK_GRID(dashboard_grid), gtk_label_new(buf), 0, 1, 2, 1);
+    const Plan *plan = catalog_find_plan(current_member.plan_id);
+    snprintf(buf, sizeof(buf), "Plan: %s | Time: %s", plan ? plan->name : "None", current_member.time_slot);
+    gtk_label_set_text(GTK_LABEL(plan_label), buf);
     
     snprintf(buf, sizeof(buf), "Trainer ID: %d", current_member.trainer_id);
-    gtk_grid_attach(GTK_GRID(dashboard_grid), gtk_label_new(buf), 0, 2, 2, 1);
+    gtk_label_set_text(GTK_LABEL(trainer_label), buf);
+
+    // Weekly Workout Plan (assigned program, or the default one)
+    const ProgramWeek *week = program_for_member(current_member.member_id);
+    char *markup = g_markup_printf_escaped("<b>Weekly Workout: %s</b>", week ? week->name : "None");
+    gtk_label_set_markup(GTK_LABEL(program_label), markup);
+    g_free(markup);
+
+    int today = program_today();
+    for (int d = 0; d < PROGRAM_DAYS; d++) {
+        if (!week) {
+            gtk_label_set_text(GTK_LABEL(day_labels[d]), "");
+            gtk_label_set_text(GTK_LABEL(detail_labels[d]), "");
+            continue;
+        }
+        if (week->focus[d][0]) {
+            snprintf(buf, sizeof(buf), "%s: %s", program_day_name(d), week->focus[d]);
+        } else {
+            snprintf(buf, sizeof(buf), "%s: Rest", program_day_name(d));
+        }
+        if (d == today) {
+            markup = g_markup_printf_escaped("<b>%s</b>", buf);
+            gtk_label_set_markup(GTK_LABEL(day_labels[d]), markup);
+            g_free(markup);
+        } else {
+            gtk_label_set_text(GTK_LABEL(day_labels[d]), buf);
+        }
+        gtk_label_set_text(GTK_LABEL(detail_labels[d]), week->detail[d]);
+    }
 
-    // Weekly Workout Plan
-    gtk_grid_attach(GTK_GRID(dashboard_grid), gtk_label_new("<b>Weekly Workout:</b>"), 0, 3, 2, 1);
-    gtk_label_set_use_markup(GTK_LABEL(gtk_grid_get_child_at(GTK_GRID(dashboard_grid), 0, 3)), TRUE);
-    
-    gtk_grid_attach(GTK_GRID(dashboard_grid), gtk_label_new("Mon: Chest"), 0, 4, 1, 1);
-    gtk_grid_attach(GTK_GRID(dashboard_grid), gtk_label_new("Tue: Back"), 0, 5, 1, 1);
-    gtk_grid_attach(GTK_GRID(dashboard_grid), gtk_label_new("Wed: Legs"), 0, 6, 1, 1);
-    
-    // Attendance
-    GtkWidget *btn_checkin = gtk_button_new_with_label("Check-In (Attendance)");
-    // g_signal_connect(btn_checkin, "clicked", ...); // TODO
-    gtk_grid_attach(GTK_GRID(dashboard_grid), btn_checkin, 0, 7, 2, 1);
-    
-    // Logout button
-    GtkWidget *btn_logout = gtk_button_new_with_label("Logout");
-    g_signal_connect(btn_logout, "clicked", G_CALLBACK(on_logout_clicked), NULL);
-    gtk_grid_attach(GTK_GRID(dashboard_grid), btn_logout, 0, 8, 2, 1);
-    
-    gtk_widget_show_all(dashboard_grid);
+    update_attendance_buttons();
+    frametime_end(window, started);
 }
 
 // Initialize and show member dashboard
@@ -217,6 +545,7 @@ void show_member_dashboard(User *user) {
     gtk_window_set_title(GTK_WINDOW(window), "Member Dashboard");
     gtk_window_set_default_size(GTK_WINDOW(window), 600, 500);
     g_signal_connect(window, "destroy", G_CALLBACK(on_logout_clicked), NULL);
+    frametime_watch(window, "member");
 
     stack = gtk_stack_new();
     gtk_stack_set_transition_type(GTK_STACK(stack), GTK_STACK_TRANSITION_TYPE_SLIDE_LEFT_RIGHT);
@@ -225,11 +554,13 @@ void show_member_dashboard(User *user) {
     time_grid = create_time_grid();
     trainer_grid = create_trainer_grid();
     dashboard_grid = create_dashboard_grid();
+    classes_box = create_classes_box();
     
     gtk_stack_add_named(GTK_STACK(stack), plan_grid, "plan");
     gtk_stack_add_named(GTK_STACK(stack), time_grid, "time");
     gtk_stack_add_named(GTK_STACK(stack), trainer_grid, "trainer");
     gtk_stack_add_named(GTK_STACK(stack), dashboard_grid, "dashboard");
+    gtk_stack_add_named(GTK_STACK(stack), classes_box, "classes");
 
     // Determine initial view
     if (current_member.plan_id == 0) {
@@ -237,14 +568,9 @@ void show_member_dashboard(User *user) {
     } else if (strlen(current_member.time_slot) == 0) {
         gtk_stack_set_visible_child(GTK_STACK(stack), time_grid);
     } else if (current_member.trainer_id == 0) {
-        // Refresh trainer grid to ensure it uses selected time slot if we jump here
-        // But for simplicity, let's assume if time is set, we might need to select trainer.
-        // If trainer is 0, show trainer selection.
+        // Time slot chosen earlier: offer the trainers free in it
         snprintf(selected_time_slot, sizeof(selected_time_slot), "%s", current_member.time_slot);
-        // Re-create trainer grid to filter by time slot
-        gtk_container_remove(GTK_CONTAINER(stack), trainer_grid);
-        trainer_grid = create_trainer_grid();
-        gtk_stack_add_named(GTK_STACK(stack), trainer_grid, "trainer");
+        refresh_trainers();
         gtk_stack_set_visible_child(GTK_STACK(stack), trainer_grid);
     } else {
         refresh_dashboard();
@@ -253,4 +579,6 @@ void show_member_dashboard(User *user) {
 
     gtk_container_add(GTK_CONTAINER(window), stack);
     gtk_widget_show_all(window);
+
+    changes_subscription = changes_subscribe(CHANGE_CLASSES, on_classes_changed, NULL);
 }
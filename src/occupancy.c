@@ -0,0 +1,125 @@
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <stdatomic.h>
+#include "occupancy.h"
+#include "database.h"
+#include "catalog.h"
+
+// ============================================
+// Counters
+// ============================================
+
+static const char *zone_names[OCCUPANCY_ZONE_COUNT] = { "Weights", "Cardio", "Studio" };
+
+static atomic_int present[OCCUPANCY_MAX_SLOTS + 1][OCCUPANCY_ZONE_COUNT];
+static atomic_uint version = 1;     // Bumped on every change
+static unsigned checkpointed_version = 0;
+static char loaded_path[256] = "";
+static int loaded_yday = -1;
+
+static int today_yday() {
+    time_t now = time(NULL);
+    return localtime(&now)->tm_yday;
+}
+
+// Row for a member's time slot; unknown or empty slots share the last row
+static int slot_index(const char *time_slot) {
+    const Catalog *catalog = catalog_get();
+    int other = catalog->slot_count < OCCUPANCY_MAX_SLOTS ? catalog->slot_count : OCCUPANCY_MAX_SLOTS;
+    const TimeSlot *slot = time_slot ? catalog_find_slot(time_slot) : NULL;
+    int index = slot ? (int)(slot - catalog->slots) : other;
+    return index < other ? index : other;
+}
+
+// Unknown or missing zones count towards the first zone
+static int zone_index(const char *zone) {
+    for (int z = 0; zone && z < OCCUPANCY_ZONE_COUNT; z++) {
+        if (strcmp(zone, zone_names[z]) == 0) return z;
+    }
+    return 0;
+}
+
+static void add_present(const char *time_slot, const char *zone, int count, void *ctx) {
+    int (*counts)[OCCUPANCY_ZONE_COUNT] = ctx;
+    counts[slot_index(time_slot)][zone_index(zone)] += count;
+}
+
+// ============================================
+// Public API
+// ============================================
+
+// Recount from today's open visits of the current branch. The database is
+// the only source of the counts, so check-ins and check-outs made by other
+// app instances are included. Cheap no-op while the branch and the day are
+// unchanged.
+int occupancy_init() {
+    int yday = today_yday();
+    if (strcmp(loaded_path, db_get_path()) == 0 && loaded_yday == yday) return 0;
+
+    int counts[OCCUPANCY_MAX_SLOTS + 1][OCCUPANCY_ZONE_COUNT] = {{0}};
+    if (db_for_each_present_group(add_present, counts) != 0) return 1;
+    for (int s = 0; s <= OCCUPANCY_MAX_SLOTS; s++) {
+        for (int z = 0; z < OCCUPANCY_ZONE_COUNT; z++) atomic_store(&present[s][z], counts[s][z]);
+    }
+
+    snprintf(loaded_path, sizeof(loaded_path), "%s", db_get_path());
+    loaded_yday = yday;
+    atomic_fetch_add_explicit(&version, 1, memory_order_release);
+    return 0;
+}
+
+// Recount now, after this or another app instance checked members in or out
+int occupancy_reload() {
+    loaded_path[0] = '\0';
+    return occupancy_init();
+}
+
+// Changes whenever any counter changes; lets views skip redundant redraws
+unsigned occupancy_version() {
+    return atomic_load_explicit(&version, memory_order_acquire);
+}
+
+void occupancy_snapshot(OccupancySnapshot *snapshot) {
+    const Catalog *catalog = catalog_get();
+    memset(snapshot, 0, sizeof(*snapshot));
+    snapshot->version = occupancy_version();
+
+    int other = catalog->slot_count < OCCUPANCY_MAX_SLOTS ? catalog->slot_count : OCCUPANCY_MAX_SLOTS;
+    snapshot->slot_count = other + 1;
+    for (int s = 0; s <= other; s++) {
+        snapshot->slot_labels[s] = s < other ? catalog->slots[s].label : "Other";
+        for (int z = 0; z < OCCUPANCY_ZONE_COUNT; z++) {
+            snapshot->present[s][z] = atomic_load_explicit(&present[s][z], memory_order_relaxed);
+            snapshot->total += snapshot->present[s][z];
+        }
+    }
+}
+
+// Write the counters to LiveOccupancy if they changed since the last
+// checkpoint. Also starts a fresh count when the day rolls over.
+int occupancy_checkpoint() {
+    if (loaded_yday != today_yday()) occupancy_init();
+
+    OccupancySnapshot snapshot;
+    occupancy_snapshot(&snapshot);
+    if (snapshot.version == checkpointed_version) return 0;
+
+    OccupancyCount counts[(OCCUPANCY_MAX_SLOTS + 1) * OCCUPANCY_ZONE_COUNT];
+    int count = 0;
+    for (int s = 0; s < snapshot.slot_count; s++) {
+        for (int z = 0; z < OCCUPANCY_ZONE_COUNT; z++) {
+            counts[count].time_slot = snapshot.slot_labels[s];
+            counts[count].zone = zone_names[z];
+            counts[count].present = snapshot.present[s][z];
+            count++;
+        }
+    }
+    if (db_save_live_occupancy(counts, count) != 0) return 1;
+    checkpointed_version = snapshot.version;
+    return 0;
+}
+
+const char* occupancy_zone_name(int zone) {
+    return zone >= 0 && zone < OCCUPANCY_ZONE_COUNT ? zone_names[zone] : zone_names[0];
+}
@@ -0,0 +1,506 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sqlite3.h>
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netdb.h>
+#include <unistd.h>
+#endif
+#include "outbox.h"
+#include "database.h"
+#include "config.h"
+
+#ifdef _WIN32
+typedef SOCKET socket_t;
+#define INVALID_SOCK INVALID_SOCKET
+#define close_socket closesocket
+#else
+typedef int socket_t;
+#define INVALID_SOCK (-1)
+#define close_socket close
+#endif
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+// ============================================
+// Sender State
+// ============================================
+
+typedef struct {
+    long long id;
+    char *recipient;
+    char *subject;
+    char *body;
+    int attempts;       // Including this one
+    int failed;
+    char error[128];
+} Message;
+
+static struct {
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    int started;
+    atomic_int stop;
+    int pending;            // outbox_notify() since the last drain
+    char db_path[256];      // Branch to drain (set from the UI thread)
+    char last_error[128];
+    double busy_seconds;
+    atomic_long queued;
+    atomic_long sent;
+    atomic_long failed;
+    atomic_long dropped;
+    atomic_long batches;
+} sender = { .lock = PTHREAD_MUTEX_INITIALIZER, .wake = PTHREAD_COND_INITIALIZER };
+
+static double now_seconds() {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void fail_message(Message *message, const char *error) {
+    message->failed = 1;
+    snprintf(message->error, sizeof(message->error), "%s", error);
+}
+
+// ============================================
+// File Sink (mbox)
+// ============================================
+
+static void deliver_to_file(Message *batch, int count) {
+    const Config *config = config_get();
+    FILE *fp = fopen(config->mail_sink_path, "ab");
+    if (!fp) {
+        for (int i = 0; i < count; i++) fail_message(&batch[i], "cannot open mail sink");
+        return;
+    }
+
+    time_t now = time(NULL);
+    char stamp[64];
+    strftime(stamp, sizeof(stamp), "%a %b %d %H:%M:%S %Y", localtime(&now));
+    for (int i = 0; i < count; i++) {
+        if (batch[i].failed) continue;
+        fprintf(fp, "From %s %s\nFrom: %s\nTo: %s\nSubject: %s\n\n",
+            config->mail_from, stamp, config->mail_from, batch[i].recipient, batch[i].subject);
+        // mboxrd quoting: body lines starting with "From " get a '>'
+        for (const char *line = batch[i].body; *line; ) {
+            const char *end = strchr(line, '\n');
+            size_t len = end ? (size_t)(end - line) : strlen(line);
+            const char *p = line;
+            while (*p == '>') p++;
+            if (strncmp(p, "From ", 5) == 0) fputc('>', fp);
+            fwrite(line, 1, len, fp);
+            fputc('\n', fp);
+            line += len + (end ? 1 : 0);
+        }
+        fputc('\n', fp);
+    }
+    if (fclose(fp) != 0) {
+        for (int i = 0; i < count; i++) fail_message(&batch[i], "mail sink write failed");
+    }
+}
+
+// ============================================
+// SMTP Transport (plain, one session per batch)
+// ============================================
+
+typedef struct {
+    socket_t sock;
+    char buf[1024];     // Unread reply bytes
+    int len;
+    char out[4096];     // Pending output, sent as one segment before each reply
+    int out_len;
+    int broken;
+} SmtpConn;
+
+static socket_t smtp_connect(const char *host, int port) {
+    char service[16];
+    snprintf(service, sizeof(service), "%d", port);
+    struct addrinfo hints = {0}, *addrs = NULL;
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(host, service, &hints, &addrs) != 0) return INVALID_SOCK;
+
+    socket_t sock = INVALID_SOCK;
+    for (struct addrinfo *a = addrs; a && sock == INVALID_SOCK; a = a->ai_next) {
+        sock = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+        if (sock == INVALID_SOCK) continue;
+#ifdef _WIN32
+        DWORD timeout = OUTBOX_IO_TIMEOUT_SECONDS * 1000;
+#else
+        struct timeval timeout = { OUTBOX_IO_TIMEOUT_SECONDS, 0 };
+#endif
+        setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, (const char*)&timeout, sizeof(timeout));
+        setsockopt(sock, SOL_SOCKET, SO_SNDTIMEO, (const char*)&timeout, sizeof(timeout));
+        if (connect(sock, a->ai_addr, (int)a->ai_addrlen) != 0) {
+            close_socket(sock);
+            sock = INVALID_SOCK;
+        }
+    }
+    freeaddrinfo(addrs);
+    return sock;
+}
+
+static void smtp_flush(SmtpConn *conn) {
+    for (int sent = 0; sent < conn->out_len && !conn->broken; ) {
+        int n = send(conn->sock, conn->out + sent, conn->out_len - sent, MSG_NOSIGNAL);
+        if (n <= 0) conn->broken = 1;
+        else sent += n;
+    }
+    conn->out_len = 0;
+}
+
+static void smtp_write(SmtpConn *conn, const char *data, size_t len) {
+    while (len > 0 && !conn->broken) {
+        if (conn->out_len == (int)sizeof(conn->out)) smtp_flush(conn);
+        size_t chunk = sizeof(conn->out) - conn->out_len;
+        if (chunk > len) chunk = len;
+        memcpy(conn->out + conn->out_len, data, chunk);
+        conn->out_len += (int)chunk;
+        data += chunk;
+        len -= chunk;
+    }
+}
+
+// Read one (possibly multi-line) reply and return its status code, or -1
+static int smtp_reply(SmtpConn *conn) {
+    smtp_flush(conn);
+    if (conn->broken) return -1;
+    for (;;) {
+        char *eol = memchr(conn->buf, '\n', conn->len);
+        if (eol) {
+            int line_len = (int)(eol - conn->buf) + 1;
+            int code = line_len >= 4 ? atoi(conn->buf) : -1;
+            int last = line_len < 4 || conn->buf[3] != '-';
+            memmove(conn->buf, conn->buf + line_len, conn->len - line_len);
+            conn->len -= line_len;
+            if (last) return code;
+            continue;
+        }
+        if (conn->len == (int)sizeof(conn->buf)) conn->len = 0;  // Overlong line: drop it
+        int n = recv(conn->sock, conn->buf + conn->len, (int)sizeof(conn->buf) - conn->len, 0);
+        if (n <= 0) return -1;
+        conn->len += n;
+    }
+}
+
+// Send a command line and check the reply class (2 = 2xx, 3 = 3xx)
+static int smtp_command(SmtpConn *conn, int expect_class, const char *line) {
+    smtp_write(conn, line, strlen(line));
+    smtp_write(conn, "\r\n", 2);
+    int code = smtp_reply(conn);
+    return code / 100 == expect_class ? 0 : code;
+}
+
+// Message text with CRLF line endings and leading dots doubled
+static void smtp_write_data(SmtpConn *conn, const Config *config, const Message *message) {
+    time_t now = time(NULL);
+    char date[64], header[1024];
+    strftime(date, sizeof(date), "%a, %d %b %Y %H:%M:%S %z", localtime(&now));
+    snprintf(header, sizeof(header),
+        "From: %s\r\nTo: %s\r\nSubject: %s\r\nDate: %s\r\nMIME-Version: 1.0\r\n"
+        "Content-Type: text/plain; charset=UTF-8\r\n\r\n",
+        config->mail_from, message->recipient, message->subject, date);
+    smtp_write(conn, header, strlen(header));
+
+    for (const char *line = message->body; *line; ) {
+        const char *end = strchr(line, '\n');
+        size_t len = end ? (size_t)(end - line) : strlen(line);
+        size_t text_len = len > 0 && line[len - 1] == '\r' ? len - 1 : len;
+        if (line[0] == '.') smtp_write(conn, ".", 1);
+        smtp_write(conn, line, text_len);
+        smtp_write(conn, "\r\n", 2);
+        line += len + (end ? 1 : 0);
+    }
+    smtp_write(conn, ".\r\n", 3);
+}
+
+static void deliver_to_smtp(Message *batch, int count) {
+    const Config *config = config_get();
+    SmtpConn conn = { .len = 0, .out_len = 0, .broken = 0 };
+    conn.sock = smtp_connect(config->smtp_host, config->smtp_port);
+    if (conn.sock == INVALID_SOCK) {
+        for (int i = 0; i < count; i++) fail_message(&batch[i], "cannot connect to SMTP server");
+        return;
+    }
+
+    char line[512];
+    int ok = smtp_reply(&conn) / 100 == 2 && smtp_command(&conn, 2, "EHLO localhost") == 0;
+    for (int i = 0; i < count; i++) {
+        if (batch[i].failed) continue;
+        if (!ok) {
+            fail_message(&batch[i], "SMTP session failed");
+            continue;
+        }
+        int code;
+        snprintf(line, sizeof(line), "MAIL FROM:<%s>", config->mail_from);
+        if ((code = smtp_command(&conn, 2, line)) == 0) {
+            snprintf(line, sizeof(line), "RCPT TO:<%s>", batch[i].recipient);
+            code = smtp_command(&conn, 2, line);
+        }
+        if (code == 0) code = smtp_command(&conn, 3, "DATA");
+        if (code == 0) {
+            smtp_write_data(&conn, config, &batch[i]);
+            code = smtp_reply(&conn);
+            if (code / 100 == 2) continue;
+        }
+
+        snprintf(line, sizeof(line), "SMTP error %d", code);
+        fail_message(&batch[i], line);
+        // A lost connection fails the rest of the batch; a refused message
+        // only needs the transaction reset
+        ok = code > 0 && smtp_command(&conn, 2, "RSET") == 0;
+    }
+    if (ok) smtp_command(&conn, 2, "QUIT");
+    close_socket(conn.sock);
+}
+
+// ============================================
+// Batches
+// ============================================
+
+// Claim up to max due messages; the lease hides them from other senders
+static int claim_batch(sqlite3 *conn, Message *batch, int max) {
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(conn,
+        "UPDATE Outbox SET attempts=attempts+1, next_attempt_at=?1+?3 WHERE id IN ("
+        "SELECT id FROM Outbox WHERE status='QUEUED' AND next_attempt_at<=?1 ORDER BY next_attempt_at LIMIT ?2) "
+        "RETURNING id, recipient, subject, body, attempts;", -1, &stmt, 0) != SQLITE_OK) return 0;
+    sqlite3_bind_int64(stmt, 1, (long long)time(NULL));
+    sqlite3_bind_int(stmt, 2, max);
+    sqlite3_bind_int(stmt, 3, OUTBOX_LEASE_SECONDS);
+
+    int count = 0;
+    while (count < max && sqlite3_step(stmt) == SQLITE_ROW) {
+        Message *message = &batch[count++];
+        memset(message, 0, sizeof(Message));
+        message->id = sqlite3_column_int64(stmt, 0);
+        message->recipient = strdup((const char*)sqlite3_column_text(stmt, 1));
+        message->subject = strdup((const char*)sqlite3_column_text(stmt, 2));
+        message->body = strdup((const char*)sqlite3_column_text(stmt, 3));
+        message->attempts = sqlite3_column_int(stmt, 4);
+        if (!message->recipient || !message->subject || !message->body) fail_message(message, "out of memory");
+    }
+    sqlite3_finalize(stmt);
+    return count;
+}
+
+// Record the outcome of a batch in one transaction. If it cannot be
+// written the leases expire and the batch is retried later.
+static void finish_batch(sqlite3 *conn, Message *batch, int count) {
+    long long now = (long long)time(NULL);
+    sqlite3_stmt *sent = NULL, *retry = NULL;
+    if (sqlite3_exec(conn, "BEGIN IMMEDIATE;", 0, 0, 0) != SQLITE_OK) return;
+    if (sqlite3_prepare_v2(conn, "UPDATE Outbox SET status='SENT', sent_at=?, last_error=NULL WHERE id=?;",
+            -1, &sent, 0) != SQLITE_OK ||
+        sqlite3_prepare_v2(conn, "UPDATE Outbox SET status=?, next_attempt_at=?, last_error=? WHERE id=?;",
+            -1, &retry, 0) != SQLITE_OK) {
+        sqlite3_finalize(sent);
+        sqlite3_finalize(retry);
+        sqlite3_exec(conn, "ROLLBACK;", 0, 0, 0);
+        return;
+    }
+
+    int ok = 1, delivered = 0, failed = 0, dropped = 0;
+    for (int i = 0; i < count && ok; i++) {
+        Message *message = &batch[i];
+        if (!message->failed) {
+            sqlite3_bind_int64(sent, 1, now);
+            sqlite3_bind_int64(sent, 2, message->id);
+            ok = sqlite3_step(sent) == SQLITE_DONE;
+            sqlite3_reset(sent);
+            delivered++;
+            continue;
+        }
+
+        int give_up = message->attempts >= OUTBOX_MAX_ATTEMPTS;
+        long long delay = OUTBOX_RETRY_SECONDS;
+        for (int a = 1; a < message->attempts && delay < 3600; a++) delay *= 2;
+        sqlite3_bind_text(retry, 1, give_up ? "FAILED" : "QUEUED", -1, SQLITE_STATIC);
+        sqlite3_bind_int64(retry, 2, now + delay);
+        sqlite3_bind_text(retry, 3, message->error, -1, SQLITE_STATIC);
+        sqlite3_bind_int64(retry, 4, message->id);
+        ok = sqlite3_step(retry) == SQLITE_DONE;
+        sqlite3_reset(retry);
+        if (give_up) dropped++;
+        else failed++;
+
+        pthread_mutex_lock(&sender.lock);
+        snprintf(sender.last_error, sizeof(sender.last_error), "%s", message->error);
+        pthread_mutex_unlock(&sender.lock);
+    }
+    sqlite3_finalize(sent);
+    sqlite3_finalize(retry);
+    if (!ok || sqlite3_exec(conn, "COMMIT;", 0, 0, 0) != SQLITE_OK) {
+        sqlite3_exec(conn, "ROLLBACK;", 0, 0, 0);
+        return;
+    }
+    atomic_fetch_add(&sender.sent, delivered);
+    atomic_fetch_add(&sender.failed, failed);
+    atomic_fetch_add(&sender.dropped, dropped);
+}
+
+static void update_queue_depth(sqlite3 *conn) {
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(conn, "SELECT COUNT(*) FROM Outbox WHERE status='QUEUED';", -1, &stmt, 0) != SQLITE_OK) return;
+    if (sqlite3_step(stmt) == SQLITE_ROW) atomic_store(&sender.queued, sqlite3_column_int64(stmt, 0));
+    sqlite3_finalize(stmt);
+}
+
+// Deliver everything that is due, one batch at a time
+static void drain(sqlite3 *conn) {
+    int max = config_get()->mail_batch_size;
+    Message *batch = calloc(max, sizeof(Message));
+    if (!batch) return;
+
+    int count;
+    do {
+        count = claim_batch(conn, batch, max);
+        if (count == 0) break;
+
+        double started = now_seconds();
+        int sendable = 0;
+        for (int i = 0; i < count; i++) sendable |= !batch[i].failed;
+        if (sendable && strcmp(config_get()->mail_transport, "smtp") == 0) deliver_to_smtp(batch, count);
+        else if (sendable) deliver_to_file(batch, count);
+        double elapsed = now_seconds() - started;
+
+        finish_batch(conn, batch, count);
+        atomic_fetch_add(&sender.batches, 1);
+        pthread_mutex_lock(&sender.lock);
+        sender.busy_seconds += elapsed;
+        pthread_mutex_unlock(&sender.lock);
+
+        for (int i = 0; i < count; i++) {
+            free(batch[i].recipient);
+            free(batch[i].subject);
+            free(batch[i].body);
+        }
+    } while (count == max && !sender.stop);
+
+    free(batch);
+    update_queue_depth(conn);
+}
+
+static void* sender_main(void *arg) {
+    sqlite3 *conn = NULL;
+    char open_path[256] = "";
+
+    pthread_mutex_lock(&sender.lock);
+    while (!sender.stop) {
+        if (!sender.pending) {
+            struct timespec deadline;
+            timespec_get(&deadline, TIME_UTC);
+            deadline.tv_sec += OUTBOX_IDLE_SECONDS;
+            pthread_cond_timedwait(&sender.wake, &sender.lock, &deadline);
+            if (sender.stop) break;
+        }
+        sender.pending = 0;
+        char path[256];
+        snprintf(path, sizeof(path), "%s", sender.db_path);
+        pthread_mutex_unlock(&sender.lock);
+
+        // Follow branch switches
+        if (strcmp(path, open_path) != 0) {
+            sqlite3_close(conn);
+            conn = NULL;
+            open_path[0] = '\0';
+            if (sqlite3_open_v2(path, &conn, SQLITE_OPEN_READWRITE, NULL) == SQLITE_OK) {
+                sqlite3_busy_timeout(conn, config_get()->busy_timeout_ms);
+                snprintf(open_path, sizeof(open_path), "%s", path);
+            } else {
+                sqlite3_close(conn);
+                conn = NULL;
+            }
+        }
+        if (conn) drain(conn);
+
+        pthread_mutex_lock(&sender.lock);
+    }
+    pthread_mutex_unlock(&sender.lock);
+    sqlite3_close(conn);
+    return NULL;
+}
+
+// ============================================
+// Public API
+// ============================================
+
+// Queue a message on the main connection, inside the caller's transaction
+// if one is open. Addresses that could inject SMTP commands are refused.
+int outbox_enqueue(const char *recipient, const char *subject, const char *body) {
+    if (!recipient[0] || strpbrk(recipient, "\r\n<> ") || strpbrk(subject, "\r\n")) return 1;
+
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(db_get_handle(), "INSERT INTO Outbox (recipient, subject, body, created_at, next_attempt_at) "
+        "VALUES (?, ?, ?, strftime('%s','now'), strftime('%s','now'));", -1, &stmt, 0) != SQLITE_OK) return 1;
+    sqlite3_bind_text(stmt, 1, recipient, -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 2, subject, -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 3, body, -1, SQLITE_STATIC);
+    int rc = sqlite3_step(stmt) == SQLITE_DONE ? 0 : 1;
+    sqlite3_finalize(stmt);
+    return rc;
+}
+
+// Start the background sender for the open branch
+int outbox_start() {
+    if (sender.started) return 0;
+#ifdef _WIN32
+    WSADATA wsa;
+    if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0) return 1;
+#endif
+    snprintf(sender.db_path, sizeof(sender.db_path), "%s", db_get_path());
+    sender.stop = 0;
+    sender.pending = 1;
+    if (pthread_create(&sender.thread, NULL, sender_main, NULL) != 0) return 1;
+    sender.started = 1;
+    return 0;
+}
+
+// Wake the sender now (new mail queued, or another branch opened)
+void outbox_notify() {
+    pthread_mutex_lock(&sender.lock);
+    snprintf(sender.db_path, sizeof(sender.db_path), "%s", db_get_path());
+    sender.pending = 1;
+    pthread_cond_signal(&sender.wake);
+    pthread_mutex_unlock(&sender.lock);
+}
+
+// Stop after the batch in flight; undelivered mail stays queued
+void outbox_stop() {
+    if (!sender.started) return;
+    pthread_mutex_lock(&sender.lock);
+    sender.stop = 1;
+    pthread_cond_signal(&sender.wake);
+    pthread_mutex_unlock(&sender.lock);
+    pthread_join(sender.thread, NULL);
+    sender.started = 0;
+#ifdef _WIN32
+    WSACleanup();
+#endif
+}
+
+void outbox_get_stats(OutboxStats *stats) {
+    stats->queued = atomic_load(&sender.queued);
+    stats->sent = atomic_load(&sender.sent);
+    stats->failed = atomic_load(&sender.failed);
+    stats->dropped = atomic_load(&sender.dropped);
+    stats->batches = atomic_load(&sender.batches);
+    stats->running = sender.started;
+    pthread_mutex_lock(&sender.lock);
+    stats->messages_per_s = sender.busy_seconds > 0 ? stats->sent / sender.busy_seconds : 0;
+    snprintf(stats->last_error, sizeof(stats->last_error), "%s", sender.last_error);
+    pthread_mutex_unlock(&sender.lock);
+}
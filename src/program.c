@@ -0,0 +1,95 @@
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "program.h"
+#include "database.h"
+
+// ============================================
+// Compiled Templates
+// ============================================
+
+static ProgramWeek weeks[PROGRAM_MAX_TEMPLATES];
+static int week_count = 0;
+static unsigned version = 1;
+static unsigned compiled_version = 0;
+
+// Append one template row to the week being compiled
+static void compile_row(int template_id, const char *template_name, int weekday, const char *focus,
+                        const char *exercise, int sets, int reps, void *ctx) {
+    if (weekday < 1 || weekday > PROGRAM_DAYS) return;
+    if (week_count == 0 || weeks[week_count - 1].template_id != template_id) {
+        if (week_count == PROGRAM_MAX_TEMPLATES) return;
+        ProgramWeek *week = &weeks[week_count++];
+        memset(week, 0, sizeof(ProgramWeek));
+        week->template_id = template_id;
+        snprintf(week->name, sizeof(week->name), "%s", template_name);
+    }
+
+    ProgramWeek *week = &weeks[week_count - 1];
+    int day = weekday - 1;
+    snprintf(week->focus[day], sizeof(week->focus[day]), "%s", focus);
+    if (!exercise) return;
+
+    char *detail = week->detail[day];
+    size_t len = strlen(detail);
+    snprintf(detail + len, sizeof(week->detail[day]) - len, "%s%s %dx%d", len ? ", " : "", exercise, sets, reps);
+}
+
+static void program_compile() {
+    week_count = 0;
+    if (db_get_handle()) db_for_each_program_row(compile_row, NULL);
+    compiled_version = version;
+}
+
+// ============================================
+// Public API
+// ============================================
+
+// All compiled templates, rebuilding them only after a version bump
+const ProgramWeek* program_list(int *count) {
+    if (compiled_version != version) program_compile();
+    *count = week_count;
+    return weeks;
+}
+
+// Invalidate the compiled templates; the next lookup recompiles them
+void program_bump_version() {
+    version++;
+}
+
+// Find a compiled template by id (NULL if unknown)
+const ProgramWeek* program_find(int template_id) {
+    int count;
+    const ProgramWeek *list = program_list(&count);
+    for (int i = 0; i < count; i++) {
+        if (list[i].template_id == template_id) return &list[i];
+    }
+    return NULL;
+}
+
+// The week a member follows: their assignment, else the default template
+const ProgramWeek* program_for_member(int member_id) {
+    int template_id = 0;
+    db_get_member_program(member_id, &template_id);
+    const ProgramWeek *week = template_id ? program_find(template_id) : NULL;
+    return week ? week : program_find(PROGRAM_DEFAULT_TEMPLATE);
+}
+
+// Assign a template to a member (assigned_by = trainer or admin user id)
+int program_assign(int member_id, int template_id, int assigned_by) {
+    if (!program_find(template_id)) return 1;
+    return db_assign_program(member_id, template_id, assigned_by);
+}
+
+// Short day name for a day index (0 = Monday)
+const char* program_day_name(int day) {
+    static const char *names[PROGRAM_DAYS] = { "Mon", "Tue", "Wed", "Thu", "Fri", "Sat", "Sun" };
+    return day >= 0 && day < PROGRAM_DAYS ? names[day] : "";
+}
+
+// Today's day index (0 = Monday)
+int program_today() {
+    time_t now = time(NULL);
+    struct tm *local = localtime(&now);
+    return (local->tm_wday + 6) % 7;
+}
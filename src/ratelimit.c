@@ -0,0 +1,303 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+#include <unistd.h>
+#include "ratelimit.h"
+#include "database.h"
+#include "eventlog.h"
+#include "config.h"
+
+// ============================================
+// Bucket Table
+// ============================================
+
+typedef struct {
+    char key[RATELIMIT_KEY_LEN];    // "email:<address>", "terminal:<host>" or
+                                    // "lockout:<host>/<address>"; "" = empty
+    unsigned hash;
+    double tokens;
+    double refilled_at;
+    double last_seen;
+    int failures;                   // Consecutive failed logins
+    long long locked_until;         // Unix time, 0 = not locked
+    int codes;                      // Verification codes sent since codes_since
+    double codes_since;             // Start of the current hour of codes
+} Bucket;
+
+static Bucket table[RATELIMIT_SLOTS];
+static char terminal_host[64] = "";
+static char terminal_key[RATELIMIT_KEY_LEN] = "";
+static char loaded_path[256] = "";
+
+static double now_seconds() {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// FNV-1a
+static unsigned hash_key(const char *key) {
+    unsigned h = 2166136261u;
+    for (const unsigned char *p = (const unsigned char*)key; *p; p++) {
+        h = (h ^ *p) * 16777619u;
+    }
+    return h;
+}
+
+// Unlocked buckets not used for a while carry no state worth keeping
+static int is_idle(const Bucket *bucket, double now) {
+    return bucket->locked_until <= (long long)now && now - bucket->last_seen > RATELIMIT_IDLE_SECONDS;
+}
+
+// Buckets that are still counting something toward a limit: a lockout,
+// failed logins short of one, or this hour's verification codes. Evicting
+// one early would hand its key a fresh allowance.
+static int holds_limits(const Bucket *bucket, double now) {
+    return bucket->locked_until > (long long)now || bucket->failures > 0 ||
+           (bucket->codes > 0 && now - bucket->codes_since < 3600);
+}
+
+// Find a key's bucket, or claim an empty or idle slot within the probe
+// window, falling back to the least recently used bucket that holds no
+// limits. Slots are never emptied, so an empty slot ends the search.
+// Returns NULL when every slot in the window is busy counting.
+static Bucket* lookup(const char *key, int burst, double now) {
+    unsigned h = hash_key(key);
+    Bucket *victim = NULL, *oldest = NULL;
+    for (int i = 0; i < RATELIMIT_MAX_PROBE; i++) {
+        Bucket *bucket = &table[(h + i) & (RATELIMIT_SLOTS - 1)];
+        if (bucket->key[0] == '\0') {
+            if (!victim) victim = bucket;
+            break;
+        }
+        if (bucket->hash == h && strcmp(bucket->key, key) == 0) return bucket;
+        if (!victim && is_idle(bucket, now)) victim = bucket;
+        if (!holds_limits(bucket, now) && (!oldest || bucket->last_seen < oldest->last_seen)) {
+            oldest = bucket;
+        }
+    }
+    if (!victim) victim = oldest;
+    if (!victim) return NULL;
+
+    snprintf(victim->key, sizeof(victim->key), "%s", key);
+    victim->hash = h;
+    victim->tokens = burst;
+    victim->refilled_at = victim->last_seen = now;
+    victim->failures = 0;
+    victim->locked_until = 0;
+    victim->codes = 0;
+    victim->codes_since = now;
+    return victim;
+}
+
+static void refill(Bucket *bucket, int burst, int refill_seconds, double now) {
+    bucket->tokens += (now - bucket->refilled_at) / refill_seconds;
+    if (bucket->tokens > burst) bucket->tokens = burst;
+    bucket->refilled_at = now;
+    bucket->last_seen = now;
+}
+
+// Seconds until the bucket holds a whole token again
+static int seconds_to_token(const Bucket *bucket, int refill_seconds) {
+    int wait = (int)((1.0 - bucket->tokens) * refill_seconds + 0.999);
+    return wait > 0 ? wait : 1;
+}
+
+// Emails are matched case-insensitively and without surrounding spaces
+static void normalize_email(const char *email, char *out, size_t size) {
+    while (isspace((unsigned char)*email)) email++;
+    int n = snprintf(out, size, "%s", email);
+    if (n >= (int)size) n = (int)size - 1;
+    while (n > 0 && isspace((unsigned char)out[n - 1])) out[--n] = '\0';
+    for (char *p = out; *p; p++) *p = (char)tolower((unsigned char)*p);
+}
+
+static void email_key(const char *email, char *key, size_t size) {
+    char address[RATELIMIT_EMAIL_LEN];
+    normalize_email(email, address, sizeof(address));
+    snprintf(key, size, "email:%s", address);
+}
+
+static const char* get_terminal_key() {
+    if (terminal_key[0] == '\0') {
+        char host[sizeof(terminal_host)] = "";
+#ifdef _WIN32
+        const char *name = getenv("COMPUTERNAME");
+        if (name) snprintf(host, sizeof(host), "%s", name);
+#else
+        if (gethostname(host, sizeof(host)) != 0) host[0] = '\0';
+        host[sizeof(host) - 1] = '\0';
+#endif
+        snprintf(terminal_host, sizeof(terminal_host), "%s", host[0] ? host : "local");
+        snprintf(terminal_key, sizeof(terminal_key), "terminal:%s", terminal_host);
+    }
+    return terminal_key;
+}
+
+// Failures and lockouts count per (email, terminal), so someone who only
+// knows a member's address cannot lock them out at every front desk
+static void lockout_key(const char *email, char *key, size_t size) {
+    char address[RATELIMIT_EMAIL_LEN];
+    normalize_email(email, address, sizeof(address));
+    get_terminal_key();
+    snprintf(key, size, "lockout:%s/%s", terminal_host, address);
+}
+
+static void load_lockout(const char *key, int failures, long long locked_until, void *ctx) {
+    // Rows from before lockouts were per terminal no longer apply
+    if (strncmp(key, "lockout:", 8) != 0) return;
+    Bucket *bucket = lookup(key, config_get()->login_burst, *(double*)ctx);
+    if (!bucket) return;
+    bucket->failures = failures;
+    bucket->locked_until = locked_until;
+}
+
+// Another instance on this terminal may have locked the pair, or a login
+// there may have cleared the lock, since this table last saw it
+static void sync_lockout(Bucket *lock, const char *key, double now) {
+    int failures;
+    long long locked_until;
+    int rc = db_get_lockout(key, &failures, &locked_until);
+    if (rc == 0 && locked_until > lock->locked_until) {
+        lock->failures = failures;
+        lock->locked_until = locked_until;
+    } else if (rc == 2 && lock->locked_until > (long long)now) {
+        lock->failures = 0;
+        lock->locked_until = 0;
+    }
+}
+
+// ============================================
+// Public API
+// ============================================
+
+// Reset the table and reload the current branch's lockouts.
+// Cheap no-op while the branch is unchanged.
+int ratelimit_init() {
+    if (strcmp(loaded_path, db_get_path()) == 0) return 0;
+
+    memset(table, 0, sizeof(table));
+    double now = now_seconds();
+    if (db_for_each_lockout(load_lockout, &now) != 0) return 1;
+    snprintf(loaded_path, sizeof(loaded_path), "%s", db_get_path());
+    return 0;
+}
+
+// Decide whether a login attempt may go ahead, consuming one token from the
+// email's and the terminal's buckets if so. *retry_after is set in seconds
+// when the attempt is refused.
+RateLimitResult ratelimit_check(const char *email, int *retry_after) {
+    const Config *config = config_get();
+    double now = now_seconds();
+    char key[RATELIMIT_KEY_LEN], lock_key[RATELIMIT_KEY_LEN];
+    email_key(email, key, sizeof(key));
+    lockout_key(email, lock_key, sizeof(lock_key));
+    *retry_after = 0;
+
+    Bucket *lock = lookup(lock_key, config->login_burst, now);
+    if (!lock) {
+        *retry_after = config->login_refill_seconds;
+        return RATELIMIT_THROTTLED;
+    }
+    lock->last_seen = now;
+    sync_lockout(lock, lock_key, now);
+    if (lock->locked_until > (long long)now) {
+        *retry_after = (int)(lock->locked_until - (long long)now);
+        return RATELIMIT_LOCKED;
+    }
+    Bucket *account = lookup(key, config->login_burst, now);
+    if (!account) {
+        *retry_after = config->login_refill_seconds;
+        return RATELIMIT_THROTTLED;
+    }
+    Bucket *terminal = lookup(get_terminal_key(), config->terminal_burst, now);
+    if (!terminal) {
+        *retry_after = config->terminal_refill_seconds;
+        return RATELIMIT_THROTTLED;
+    }
+
+    refill(account, config->login_burst, config->login_refill_seconds, now);
+    refill(terminal, config->terminal_burst, config->terminal_refill_seconds, now);
+    if (terminal->tokens < 1.0) {
+        *retry_after = seconds_to_token(terminal, config->terminal_refill_seconds);
+        return RATELIMIT_THROTTLED;
+    }
+    if (account->tokens < 1.0) {
+        *retry_after = seconds_to_token(account, config->login_refill_seconds);
+        return RATELIMIT_THROTTLED;
+    }
+    account->tokens -= 1.0;
+    terminal->tokens -= 1.0;
+    return RATELIMIT_ALLOWED;
+}
+
+// Report the outcome of an attempt that ratelimit_check() allowed
+void ratelimit_record(const char *email, int success) {
+    const Config *config = config_get();
+    double now = now_seconds();
+    char lock_key[RATELIMIT_KEY_LEN];
+    lockout_key(email, lock_key, sizeof(lock_key));
+
+    Bucket *lock = lookup(lock_key, config->login_burst, now);
+    if (!lock) return;
+
+    if (success) {
+        // Only pairs that were locked at some point have a stored row
+        if (lock->locked_until != 0) db_clear_lockout(lock_key);
+        lock->failures = 0;
+        lock->locked_until = 0;
+
+        char key[RATELIMIT_KEY_LEN];
+        email_key(email, key, sizeof(key));
+        Bucket *account = lookup(key, config->login_burst, now);
+        if (account) account->tokens = config->login_burst;
+        return;
+    }
+
+    lock->failures++;
+    if (lock->failures < config->lockout_failures) return;
+
+    // Every failure past the threshold locks again, for twice as long
+    int repeats = lock->failures - config->lockout_failures;
+    long long minutes = config->lockout_minutes;
+    while (repeats-- > 0 && minutes < RATELIMIT_MAX_LOCKOUT_MINUTES) minutes *= 2;
+    if (minutes > RATELIMIT_MAX_LOCKOUT_MINUTES) minutes = RATELIMIT_MAX_LOCKOUT_MINUTES;
+    lock->locked_until = (long long)now + minutes * 60;
+    db_save_lockout(lock_key, lock->failures, lock->locked_until);
+
+    char address[RATELIMIT_EMAIL_LEN];
+    normalize_email(email, address, sizeof(address));
+    User user;
+    int subject = db_get_user_by_email(email, &user) == 0 ? user.user_id : 0;
+    eventlog_append(EVENT_LOGIN_LOCKED, subject, (int)minutes, address);
+}
+
+// Decide whether another verification code may be sent to an email,
+// counting it if so. Each email gets codes_per_hour codes per hour, so
+// requesting new codes cannot buy unlimited guesses or flood the outbox.
+RateLimitResult ratelimit_check_code(const char *email, int *retry_after) {
+    const Config *config = config_get();
+    double now = now_seconds();
+    char key[RATELIMIT_KEY_LEN];
+    email_key(email, key, sizeof(key));
+    *retry_after = 0;
+
+    Bucket *account = lookup(key, config->login_burst, now);
+    if (!account) {
+        *retry_after = 3600;
+        return RATELIMIT_THROTTLED;
+    }
+    account->last_seen = now;
+    if (now - account->codes_since >= 3600) {
+        account->codes = 0;
+        account->codes_since = now;
+    }
+    if (account->codes >= config->codes_per_hour) {
+        *retry_after = (int)(account->codes_since + 3600 - now) + 1;
+        return RATELIMIT_THROTTLED;
+    }
+    account->codes++;
+    return RATELIMIT_ALLOWED;
+}
@@ -0,0 +1,204 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "scheduler.h"
+#include "database.h"
+#include "config.h"
+#include "eventlog.h"
+#include "gate.h"
+#include "ledger.h"
+
+// ============================================
+// Deadline Heap
+// ============================================
+
+typedef struct {
+    long long due;
+    int member_id;
+} Deadline;
+
+static Deadline *heap = NULL;
+static int heap_size = 0;
+static int heap_capacity = 0;
+static char loaded_path[256] = "";
+
+static BillingHook billing_hook = NULL;
+static WakeupHook wakeup_hook = NULL;
+
+static void heap_swap(int a, int b) {
+    Deadline tmp = heap[a];
+    heap[a] = heap[b];
+    heap[b] = tmp;
+}
+
+static void sift_up(int i) {
+    while (i > 0 && heap[(i - 1) / 2].due > heap[i].due) {
+        heap_swap(i, (i - 1) / 2);
+        i = (i - 1) / 2;
+    }
+}
+
+static void sift_down(int i) {
+    for (;;) {
+        int smallest = i, left = 2 * i + 1, right = 2 * i + 2;
+        if (left < heap_size && heap[left].due < heap[smallest].due) smallest = left;
+        if (right < heap_size && heap[right].due < heap[smallest].due) smallest = right;
+        if (smallest == i) return;
+        heap_swap(i, smallest);
+        i = smallest;
+    }
+}
+
+// Append without restoring heap order (used for bulk loading)
+static int heap_append(int member_id, long long due) {
+    if (heap_size == heap_capacity) {
+        int capacity = heap_capacity ? heap_capacity * 2 : 256;
+        Deadline *grown = realloc(heap, sizeof(Deadline) * capacity);
+        if (!grown) return 1;
+        heap = grown;
+        heap_capacity = capacity;
+    }
+    heap[heap_size].due = due;
+    heap[heap_size].member_id = member_id;
+    heap_size++;
+    return 0;
+}
+
+static void heap_push(int member_id, long long due) {
+    if (heap_append(member_id, due) == 0) sift_up(heap_size - 1);
+}
+
+static Deadline heap_pop() {
+    Deadline top = heap[0];
+    heap[0] = heap[--heap_size];
+    sift_down(0);
+    return top;
+}
+
+static void notify_wakeup() {
+    if (wakeup_hook) wakeup_hook(scheduler_next_deadline());
+}
+
+// Put a batch back after it was rolled back
+static void requeue(const Deadline *batch, int n) {
+    for (int i = 0; i < n; i++) heap_push(batch[i].member_id, batch[i].due);
+    notify_wakeup();
+}
+
+static void load_renewal(int member_id, long long renews_at, void *ctx) {
+    heap_append(member_id, renews_at);
+}
+
+// ============================================
+// Public API
+// ============================================
+
+// Load every active membership into the heap (once per branch database)
+int scheduler_init() {
+    if (strcmp(loaded_path, db_get_path()) == 0) return 0;
+
+    heap_size = 0;
+    if (db_for_each_renewal(load_renewal, NULL) != 0) return 1;
+    for (int i = heap_size / 2 - 1; i >= 0; i--) {
+        sift_down(i);
+    }
+    snprintf(loaded_path, sizeof(loaded_path), "%s", db_get_path());
+    notify_wakeup();
+    return 0;
+}
+
+// Rebuild the heap from the database. Another instance may have started,
+// renewed, merged or cancelled memberships, and those deadlines are not in
+// this process's heap.
+int scheduler_reload() {
+    loaded_path[0] = '\0';
+    return scheduler_init();
+}
+
+// Track a new or changed deadline. Superseded entries are left in the heap;
+// the conditional updates in scheduler_run_due() skip them.
+void scheduler_track(int member_id, long long due_at) {
+    if (due_at <= 0) return;
+    long long before = scheduler_next_deadline();
+    heap_push(member_id, due_at);
+    if (before == 0 || due_at < before) notify_wakeup();
+}
+
+// Earliest pending deadline (0 if nothing is scheduled)
+long long scheduler_next_deadline() {
+    return heap_size > 0 ? heap[0].due : 0;
+}
+
+// Renew or expire every membership due at `now`, in batched transactions.
+// Returns the number of memberships changed, or -1 if a batch failed.
+int scheduler_run_due(long long now) {
+    int processed = 0;
+    int batch_size = config_get()->scheduler_batch_size;
+    Deadline batch[SCHEDULER_BATCH_SIZE];
+
+    while (heap_size > 0 && heap[0].due <= now) {
+        int n = 0;
+        while (n < batch_size && heap_size > 0 && heap[0].due <= now) {
+            batch[n++] = heap_pop();
+        }
+
+        if (db_begin() != 0) {
+            requeue(batch, n);
+            return -1;
+        }
+
+        // Renewed memberships are re-queued, and every change is logged and
+        // passed to the gate, only once the batch commits. A database error
+        // rolls the whole batch back and keeps its deadlines; only a
+        // membership that is really not eligible is expired.
+        Deadline renewed[SCHEDULER_BATCH_SIZE];
+        int renewed_plans[SCHEDULER_BATCH_SIZE];
+        int expired[SCHEDULER_BATCH_SIZE];
+        int renewed_count = 0, expired_count = 0;
+        int failed = 0;
+        for (int i = 0; i < n && !failed; i++) {
+            int plan_id;
+            long long next_due;
+            int rc = db_renew_membership(batch[i].member_id, batch[i].due, &plan_id, &next_due);
+            if (rc == 0) {
+                if (billing_hook && billing_hook(batch[i].member_id, plan_id, batch[i].due) != 0) rc = 1;
+                renewed[renewed_count].member_id = batch[i].member_id;
+                renewed[renewed_count].due = next_due;
+                renewed_plans[renewed_count] = plan_id;
+                renewed_count++;
+            } else if (rc == 2) {
+                rc = db_expire_membership(batch[i].member_id, batch[i].due);
+                if (rc == 0) expired[expired_count++] = batch[i].member_id;
+            }
+            if (rc == 1) failed = 1;
+        }
+
+        if (failed || db_commit() != 0) {
+            db_rollback();
+            requeue(batch, n);
+            return -1;
+        }
+        if (renewed_count > 0) ledger_mark_stale();
+        for (int i = 0; i < renewed_count; i++) {
+            eventlog_append(EVENT_MEMBERSHIP_RENEWED, renewed[i].member_id, renewed_plans[i], NULL);
+            gate_member_changed(renewed[i].member_id);
+            heap_push(renewed[i].member_id, renewed[i].due);
+        }
+        for (int i = 0; i < expired_count; i++) {
+            eventlog_append(EVENT_MEMBERSHIP_EXPIRED, expired[i], 0, NULL);
+            gate_member_changed(expired[i]);
+        }
+        processed += renewed_count + expired_count;
+    }
+
+    notify_wakeup();
+    return processed;
+}
+
+void scheduler_set_billing_hook(BillingHook hook) {
+    billing_hook = hook;
+}
+
+void scheduler_set_wakeup_hook(WakeupHook hook) {
+    wakeup_hook = hook;
+}
@@ -0,0 +1,263 @@
+#include <gtk/gtk.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "trainer.h"
+#include "database.h"
+#include "config.h"
+#include "catalog.h"
+#include "login.h"
+#include "changes.h"
+#include "frametime.h"
+#include "program.h"
+#include "booking.h"
+
+// ============================================
+// Global State
+// ============================================
+
+static GtkWidget *window;
+static GtkWidget *roster_list;
+static GtkWidget *today_label;
+static GtkWidget *slot_load_label;
+static GtkWidget *program_combo;
+static GtkWidget *class_name_entry;
+static GtkWidget *class_start_entry;
+static GtkWidget *class_duration_spin;
+static GtkWidget *class_capacity_spin;
+static GtkWidget *class_status_label;
+static User current_user;
+static int changes_subscription = 0;
+
+// ============================================
+// Data Refresh Functions
+// ============================================
+
+// Reload the roster and recompute today's figures from it
+void refresh_roster() {
+    long long started = frametime_begin();
+    GtkListStore *store = GTK_LIST_STORE(gtk_tree_view_get_model(GTK_TREE_VIEW(roster_list)));
+    gtk_list_store_clear(store);
+
+    int count = config_get()->roster_max;
+    RosterEntry *roster = g_new0(RosterEntry, count);
+    db_get_trainer_roster(current_user.user_id, roster, &count);
+
+    const Catalog *catalog = catalog_get();
+    int slot_load[MAX_PLANS] = {0};
+    int expected = 0, checked_in = 0;
+    int today = program_today();
+
+    for (int i = 0; i < count; i++) {
+        // The roster query already carries each assignment; the week comes
+        // from the compiled templates without another query
+        const ProgramWeek *week = roster[i].template_id ? program_find(roster[i].template_id) : NULL;
+        if (!week) week = program_find(PROGRAM_DEFAULT_TEMPLATE);
+        const char *program = week ? week->name : "";
+        const char *workout = week && week->focus[today][0] ? week->focus[today] : "Rest";
+
+        GtkTreeIter iter;
+        gtk_list_store_append(store, &iter);
+        gtk_list_store_set(store, &iter, 0, roster[i].member_id, 1, roster[i].name, 2, roster[i].plan_name,
+            3, roster[i].time_slot, 4, roster[i].status, 5, roster[i].checked_in_today ? "Yes" : "",
+            6, program, 7, workout, -1);
+
+        // Every active member is expected once a day in their slot
+        if (strcmp(roster[i].status, "ACTIVE") == 0) expected++;
+        if (roster[i].checked_in_today) checked_in++;
+        for (int s = 0; s < catalog->slot_count && s < MAX_PLANS; s++) {
+            if (strcmp(roster[i].time_slot, catalog->slots[s].label) == 0) slot_load[s]++;
+        }
+    }
+
+    char buf[256];
+    snprintf(buf, sizeof(buf), "Roster: %d | Expected today: %d | Checked in: %d", count, expected, checked_in);
+    gtk_label_set_text(GTK_LABEL(today_label), buf);
+
+    char load[512] = "Slot load:";
+    for (int s = 0; s < catalog->slot_count && s < MAX_PLANS; s++) {
+        size_t len = strlen(load);
+        snprintf(load + len, sizeof(load) - len, "  %s: %d", catalog->slots[s].label, slot_load[s]);
+    }
+    gtk_label_set_text(GTK_LABEL(slot_load_label), load);
+
+    g_free(roster);
+    frametime_end(window, started);
+}
+
+// ============================================
+// Event Handlers
+// ============================================
+
+static void on_refresh_clicked(GtkButton *button, gpointer data) {
+    refresh_roster();
+}
+
+// Give the selected roster member the chosen program
+static void on_assign_program_clicked(GtkButton *button, gpointer data) {
+    GtkTreeSelection *selection = gtk_tree_view_get_selection(GTK_TREE_VIEW(roster_list));
+    GtkTreeModel *model;
+    GtkTreeIter iter;
+    const char *template_id = gtk_combo_box_get_active_id(GTK_COMBO_BOX(program_combo));
+    if (!template_id || !gtk_tree_selection_get_selected(selection, &model, &iter)) return;
+
+    int member_id;
+    gtk_tree_model_get(model, &iter, 0, &member_id, -1);
+    program_assign(member_id, atoi(template_id), current_user.user_id);
+    refresh_roster();
+}
+
+// Schedule a class led by this trainer; the start is local time "YYYY-MM-DD HH:MM"
+static void on_schedule_class_clicked(GtkButton *button, gpointer data) {
+    const char *name = gtk_entry_get_text(GTK_ENTRY(class_name_entry));
+    const char *start = gtk_entry_get_text(GTK_ENTRY(class_start_entry));
+    struct tm tm = {0};
+    if (strlen(name) == 0) {
+        gtk_label_set_text(GTK_LABEL(class_status_label), "Enter a class name.");
+        return;
+    }
+    if (sscanf(start, "%d-%d-%d %d:%d", &tm.tm_year, &tm.tm_mon, &tm.tm_mday, &tm.tm_hour, &tm.tm_min) != 5) {
+        gtk_label_set_text(GTK_LABEL(class_status_label), "Start must be YYYY-MM-DD HH:MM.");
+        return;
+    }
+    tm.tm_year -= 1900;
+    tm.tm_mon -= 1;
+    tm.tm_isdst = -1;
+    time_t starts_at = mktime(&tm);
+    if (starts_at == (time_t)-1 || starts_at <= time(NULL)) {
+        gtk_label_set_text(GTK_LABEL(class_status_label), "The class must start in the future.");
+        return;
+    }
+
+    int class_id;
+    int duration = gtk_spin_button_get_value_as_int(GTK_SPIN_BUTTON(class_duration_spin));
+    int capacity = gtk_spin_button_get_value_as_int(GTK_SPIN_BUTTON(class_capacity_spin));
+    char buf[128];
+    if (booking_create_class(db_get_handle(), name, current_user.user_id, (long long)starts_at, duration,
+                             capacity, &class_id) == 0) {
+        snprintf(buf, sizeof(buf), "Scheduled class #%d (%d places).", class_id, capacity);
+        gtk_entry_set_text(GTK_ENTRY(class_name_entry), "");
+    } else {
+        snprintf(buf, sizeof(buf), "Could not schedule the class.");
+    }
+    gtk_label_set_text(GTK_LABEL(class_status_label), buf);
+}
+
+// Another app instance changed members, programs or check-ins
+static void on_data_changed(unsigned changed, void *ctx) {
+    refresh_roster();
+}
+
+// Handle logout
+static void on_logout_clicked(GtkButton *button, gpointer data) {
+    changes_unsubscribe(changes_subscription);
+    changes_subscription = 0;
+    gtk_widget_destroy(window);
+    return_to_login();
+}
+
+// ============================================
+// UI Creation Functions
+// ============================================
+
+// Add a column to tree view
+static void add_roster_column(const char *title, int columnId) {
+    GtkCellRenderer *renderer = gtk_cell_renderer_text_new();
+    GtkTreeViewColumn *column = gtk_tree_view_column_new_with_attributes(title, renderer, "text", columnId, NULL);
+    gtk_tree_view_append_column(GTK_TREE_VIEW(roster_list), column);
+}
+
+// Initialize and show trainer dashboard
+void show_trainer_dashboard(User *user) {
+    current_user = *user;
+
+    window = gtk_window_new(GTK_WINDOW_TOPLEVEL);
+    gtk_window_set_title(GTK_WINDOW(window), "Trainer Dashboard");
+    gtk_window_set_default_size(GTK_WINDOW(window), 900, 500);
+    g_signal_connect(window, "destroy", G_CALLBACK(on_logout_clicked), NULL);
+    frametime_watch(window, "trainer");
+
+    GtkWidget *vbox = gtk_box_new(GTK_ORIENTATION_VERTICAL, 5);
+
+    char buf[256];
+    snprintf(buf, sizeof(buf), "Welcome %s!", current_user.name);
+    gtk_box_pack_start(GTK_BOX(vbox), gtk_label_new(buf), FALSE, FALSE, 5);
+
+    today_label = gtk_label_new("");
+    slot_load_label = gtk_label_new("");
+    gtk_box_pack_start(GTK_BOX(vbox), today_label, FALSE, FALSE, 0);
+    gtk_box_pack_start(GTK_BOX(vbox), slot_load_label, FALSE, FALSE, 0);
+
+    GtkListStore *store = gtk_list_store_new(8, G_TYPE_INT, G_TYPE_STRING, G_TYPE_STRING, G_TYPE_STRING, G_TYPE_STRING,
+        G_TYPE_STRING, G_TYPE_STRING, G_TYPE_STRING);
+    roster_list = gtk_tree_view_new_with_model(GTK_TREE_MODEL(store));
+    add_roster_column("ID", 0);
+    add_roster_column("Name", 1);
+    add_roster_column("Plan", 2);
+    add_roster_column("Time Slot", 3);
+    add_roster_column("Status", 4);
+    add_roster_column("Checked In", 5);
+    add_roster_column("Program", 6);
+    add_roster_column("Today", 7);
+
+    GtkWidget *scroll = gtk_scrolled_window_new(NULL, NULL);
+    gtk_container_add(GTK_CONTAINER(scroll), roster_list);
+    gtk_box_pack_start(GTK_BOX(vbox), scroll, TRUE, TRUE, 0);
+
+    // Program assignment for the selected member
+    GtkWidget *assign_box = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 5);
+    program_combo = gtk_combo_box_text_new();
+    int program_count;
+    const ProgramWeek *programs = program_list(&program_count);
+    for (int i = 0; i < program_count; i++) {
+        char id[16];
+        snprintf(id, sizeof(id), "%d", programs[i].template_id);
+        gtk_combo_box_text_append(GTK_COMBO_BOX_TEXT(program_combo), id, programs[i].name);
+    }
+    gtk_combo_box_set_active(GTK_COMBO_BOX(program_combo), 0);
+    GtkWidget *btn_assign = gtk_button_new_with_label("Assign Program");
+    g_signal_connect(btn_assign, "clicked", G_CALLBACK(on_assign_program_clicked), NULL);
+    gtk_box_pack_start(GTK_BOX(assign_box), program_combo, TRUE, TRUE, 0);
+    gtk_box_pack_start(GTK_BOX(assign_box), btn_assign, FALSE, FALSE, 0);
+    gtk_box_pack_start(GTK_BOX(vbox), assign_box, FALSE, FALSE, 0);
+
+    // Class scheduling: members book these from their dashboard
+    GtkWidget *class_box = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 5);
+    class_name_entry = gtk_entry_new();
+    gtk_entry_set_placeholder_text(GTK_ENTRY(class_name_entry), "Class name");
+    class_start_entry = gtk_entry_new();
+    gtk_entry_set_placeholder_text(GTK_ENTRY(class_start_entry), "YYYY-MM-DD HH:MM");
+    class_duration_spin = gtk_spin_button_new_with_range(15, 240, 15);
+    gtk_spin_button_set_value(GTK_SPIN_BUTTON(class_duration_spin), 60);
+    class_capacity_spin = gtk_spin_button_new_with_range(1, 500, 1);
+    gtk_spin_button_set_value(GTK_SPIN_BUTTON(class_capacity_spin), 20);
+    GtkWidget *btn_schedule = gtk_button_new_with_label("Schedule Class");
+    g_signal_connect(btn_schedule, "clicked", G_CALLBACK(on_schedule_class_clicked), NULL);
+    gtk_box_pack_start(GTK_BOX(class_box), class_name_entry, TRUE, TRUE, 0);
+    gtk_box_pack_start(GTK_BOX(class_box), class_start_entry, FALSE, FALSE, 0);
+    gtk_box_pack_start(GTK_BOX(class_box), gtk_label_new("Minutes:"), FALSE, FALSE, 0);
+    gtk_box_pack_start(GTK_BOX(class_box), class_duration_spin, FALSE, FALSE, 0);
+    gtk_box_pack_start(GTK_BOX(class_box), gtk_label_new("Places:"), FALSE, FALSE, 0);
+    gtk_box_pack_start(GTK_BOX(class_box), class_capacity_spin, FALSE, FALSE, 0);
+    gtk_box_pack_start(GTK_BOX(class_box), btn_schedule, FALSE, FALSE, 0);
+    gtk_box_pack_start(GTK_BOX(vbox), class_box, FALSE, FALSE, 0);
+    class_status_label = gtk_label_new("");
+    gtk_box_pack_start(GTK_BOX(vbox), class_status_label, FALSE, FALSE, 0);
+
+    GtkWidget *btn_refresh = gtk_button_new_with_label("Refresh");
+    g_signal_connect(btn_refresh, "clicked", G_CALLBACK(on_refresh_clicked), NULL);
+    gtk_box_pack_start(GTK_BOX(vbox), btn_refresh, FALSE, FALSE, 0);
+
+    GtkWidget *btn_logout = gtk_button_new_with_label("Logout");
+    g_signal_connect(btn_logout, "clicked", G_CALLBACK(on_logout_clicked), NULL);
+    gtk_box_pack_start(GTK_BOX(vbox), btn_logout, FALSE, FALSE, 5);
+
+    refresh_roster();
+
+    gtk_container_add(GTK_CONTAINER(window), vbox);
+    gtk_widget_show_all(window);
+
+    changes_subscription = changes_subscribe(CHANGE_USERS | CHANGE_MEMBERS | CHANGE_PLANS | CHANGE_ATTENDANCE |
+        CHANGE_PROGRAMS, on_data_changed, NULL);
+}
@@ -0,0 +1,116 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "verify.h"
+#include "sha256.h"
+#include "outbox.h"
+#include "database.h"
+#include "config.h"
+#include "ratelimit.h"
+
+// ============================================
+// Codes and Hashes
+// ============================================
+
+#define SALT_BYTES 16
+
+// Bytes from the OS random source
+static int random_bytes(unsigned char *buf, size_t len) {
+#ifdef _WIN32
+    for (size_t i = 0; i < len; i++) {
+        unsigned int value;
+        if (rand_s(&value) != 0) return 1;
+        buf[i] = (unsigned char)value;
+    }
+    return 0;
+#else
+    FILE *fp = fopen("/dev/urandom", "rb");
+    if (!fp) return 1;
+    size_t got = fread(buf, 1, len, fp);
+    fclose(fp);
+    return got == len ? 0 : 1;
+#endif
+}
+
+// Hash of salt, email and code, so a leaked row cannot be replayed for
+// another account and codes cannot be looked up in a precomputed table
+static void hash_code(const char *salt, const char *email, const char *code, char hex[SHA256_HEX_SIZE]) {
+    char input[256];
+    int len = snprintf(input, sizeof(input), "%s:%s:%s", salt, email, code);
+    if (len >= (int)sizeof(input)) len = sizeof(input) - 1;
+    sha256_hex(input, len, hex);
+}
+
+// Compare without stopping at the first difference
+static int equal_hex(const char *a, const char *b) {
+    size_t len = strlen(a);
+    if (len != strlen(b)) return 0;
+    unsigned char diff = 0;
+    for (size_t i = 0; i < len; i++) diff |= (unsigned char)(a[i] ^ b[i]);
+    return diff == 0;
+}
+
+// ============================================
+// Public API
+// ============================================
+
+// Create a new code for an email (replacing any earlier one) and queue it
+// for delivery. Returns 0 once both are committed, 2 if the email has had
+// its codes for this hour.
+int verify_issue(const char *email, const char *name) {
+    int retry_after;
+    if (ratelimit_check_code(email, &retry_after) != RATELIMIT_ALLOWED) return 2;
+
+    unsigned char random[SALT_BYTES + 4];
+    if (random_bytes(random, sizeof(random)) != 0) return 1;
+
+    char salt[SALT_BYTES * 2 + 1], code[VERIFY_CODE_DIGITS + 1], code_hash[SHA256_HEX_SIZE];
+    for (int i = 0; i < SALT_BYTES; i++) sprintf(salt + i * 2, "%02x", random[i]);
+    unsigned long value = (unsigned long)random[SALT_BYTES] << 24 | (unsigned long)random[SALT_BYTES + 1] << 16 |
+                          (unsigned long)random[SALT_BYTES + 2] << 8 | random[SALT_BYTES + 3];
+    snprintf(code, sizeof(code), "%06lu", value % 1000000);
+    hash_code(salt, email, code, code_hash);
+
+    int minutes = config_get()->code_minutes;
+    char body[512];
+    snprintf(body, sizeof(body),
+        "Hello %s,\n\nYour GYM Management System verification code is %s.\n"
+        "It expires in %d minutes.\n\nIf you did not register, ignore this email.\n",
+        name && name[0] ? name : "there", code, minutes);
+
+    if (db_begin() != 0) return 1;
+    if (db_save_verification(email, salt, code_hash, (long long)time(NULL) + minutes * 60) != 0 ||
+        outbox_enqueue(email, "Your verification code", body) != 0) {
+        db_rollback();
+        return 1;
+    }
+    if (db_commit() != 0) {
+        db_rollback();
+        return 1;
+    }
+    outbox_notify();
+    return 0;
+}
+
+// Check a code. The right code marks the account verified and is
+// consumed; each wrong guess counts towards VERIFY_MAX_ATTEMPTS.
+VerifyResult verify_check(const char *email, const char *code) {
+    char salt[64], stored[SHA256_HEX_SIZE], given[SHA256_HEX_SIZE];
+    long long expires_at;
+    int attempts;
+    if (db_use_verification(email, salt, sizeof(salt), stored, sizeof(stored), &expires_at, &attempts) != 0) {
+        return VERIFY_EXPIRED;
+    }
+    if (expires_at <= (long long)time(NULL) || attempts >= VERIFY_MAX_ATTEMPTS) {
+        db_delete_verification(email);
+        return VERIFY_EXPIRED;
+    }
+
+    hash_code(salt, email, code, given);
+    if (!equal_hex(given, stored)) return VERIFY_WRONG;
+
+    db_delete_verification(email);
+    db_verify_user(email);
+    return VERIFY_OK;
+}
@@ -0,0 +1,333 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "visits.h"
+#include "ledger.h"
+#include "database.h"
+
+// ============================================
+// Bitmaps
+// ============================================
+
+typedef struct {
+    int first_word;         // day / 64 of words[0]
+    int word_count;
+    int capacity;
+    uint64_t *words;
+    int dirty;              // Changed since the last checkpoint (an empty map is deleted)
+} VisitMap;
+
+static VisitMap *maps;      // Indexed by member_id
+static int map_count = 0;
+static long long last_attendance_id = 0;
+static int stale = 1;
+static unsigned version = 1;
+static unsigned built_version = 0;
+
+static void maps_reset() {
+    for (int i = 0; i < map_count; i++) free(maps[i].words);
+    free(maps);
+    maps = NULL;
+    map_count = 0;
+    last_attendance_id = 0;
+}
+
+// Map of a member, growing the table if asked (NULL if unknown or out of memory)
+static VisitMap* map_for(int member_id, int create) {
+    if (member_id <= 0) return NULL;
+    if (member_id < map_count) return &maps[member_id];
+    if (!create) return NULL;
+
+    int count = map_count ? map_count : 1024;
+    while (count <= member_id) count *= 2;
+    VisitMap *grown = realloc(maps, sizeof(VisitMap) * count);
+    if (!grown) return NULL;
+    memset(grown + map_count, 0, sizeof(VisitMap) * (count - map_count));
+    maps = grown;
+    map_count = count;
+    return &maps[member_id];
+}
+
+// Make words cover word index w, keeping existing bits in place
+static int map_cover(VisitMap *map, int w) {
+    if (map->word_count == 0) map->first_word = w;
+    int first = w < map->first_word ? w : map->first_word;
+    int end = map->first_word + map->word_count;
+    if (w >= end) end = w + 1;
+    int needed = end - first;
+
+    if (needed > map->capacity) {
+        int capacity = map->capacity ? map->capacity : 4;
+        while (capacity < needed) capacity *= 2;
+        uint64_t *grown = realloc(map->words, sizeof(uint64_t) * capacity);
+        if (!grown) return 1;
+        map->words = grown;
+        map->capacity = capacity;
+    }
+    int shift = map->first_word - first;
+    if (shift > 0) {
+        memmove(map->words + shift, map->words, sizeof(uint64_t) * map->word_count);
+        memset(map->words, 0, sizeof(uint64_t) * shift);
+    }
+    memset(map->words + shift + map->word_count, 0, sizeof(uint64_t) * (needed - shift - map->word_count));
+    map->first_word = first;
+    map->word_count = needed;
+    return 0;
+}
+
+static void map_set(int member_id, int day) {
+    VisitMap *map = map_for(member_id, 1);
+    if (!map || day < 0 || map_cover(map, day >> 6) != 0) return;
+    uint64_t bit = 1ULL << (day & 63);
+    uint64_t *word = &map->words[(day >> 6) - map->first_word];
+    if (*word & bit) return;
+    *word |= bit;
+    map->dirty = 1;
+}
+
+static int map_get(const VisitMap *map, int day) {
+    int w = (day >> 6) - map->first_word;
+    if (day < 0 || w < 0 || w >= map->word_count) return 0;
+    return (map->words[w] >> (day & 63)) & 1;
+}
+
+// Days set in from..to inclusive
+static int map_count_range(const VisitMap *map, int from_day, int to_day) {
+    int first_day = map->first_word * 64;
+    int last_day = (map->first_word + map->word_count) * 64 - 1;
+    if (from_day < first_day) from_day = first_day;
+    if (to_day > last_day) to_day = last_day;
+    if (from_day > to_day) return 0;
+
+    int count = 0;
+    for (int w = from_day >> 6; w <= to_day >> 6; w++) {
+        uint64_t bits = map->words[w - map->first_word];
+        if (w == from_day >> 6) bits &= ~0ULL << (from_day & 63);
+        if (w == to_day >> 6) bits &= ~0ULL >> (63 - (to_day & 63));
+        count += __builtin_popcountll(bits);
+    }
+    return count;
+}
+
+// Consecutive days set ending at `day`, a word at a time
+static int map_run_ending(const VisitMap *map, int day) {
+    int run = 0;
+    while (day >= 0 && map_get(map, day)) {
+        int offset = day & 63;
+        // Bits up to `day` moved to the top; leading ones are the run
+        uint64_t inverted = ~(map->words[(day >> 6) - map->first_word] << (63 - offset));
+        int ones = inverted ? __builtin_clzll(inverted) : 64;
+        if (ones > offset + 1) ones = offset + 1;
+        run += ones;
+        if (ones < offset + 1) break;
+        day -= ones;
+    }
+    return run;
+}
+
+static int map_last_day(const VisitMap *map) {
+    for (int w = map->word_count - 1; w >= 0; w--) {
+        if (map->words[w]) return (map->first_word + w) * 64 + 63 - __builtin_clzll(map->words[w]);
+    }
+    return -1;
+}
+
+// ============================================
+// Loading and Saving
+// ============================================
+
+// Stored form: per non-empty word, a varint count of the empty words since
+// the previous one, then the word as 8 little-endian bytes
+static unsigned char* map_encode(const VisitMap *map, int *size) {
+    unsigned char *out = malloc((size_t)map->word_count * 13 + 1);
+    if (!out) return NULL;
+    int len = 0;
+    unsigned gap = 0;
+    for (int w = 0; w < map->word_count; w++) {
+        uint64_t bits = map->words[w];
+        if (!bits) {
+            gap++;
+            continue;
+        }
+        for (; gap >= 0x80; gap >>= 7) out[len++] = (unsigned char)(gap | 0x80);
+        out[len++] = (unsigned char)gap;
+        for (int b = 0; b < 8; b++) out[len++] = (unsigned char)(bits >> (8 * b));
+        gap = 0;
+    }
+    *size = len;
+    return out;
+}
+
+static void load_map(int member_id, int first_word, const void *data, int size, void *ctx) {
+    const unsigned char *in = data;
+    int pos = 0, w = first_word;
+    while (pos < size) {
+        unsigned gap = 0;
+        for (int shift = 0; pos < size; shift += 7) {
+            unsigned char byte = in[pos++];
+            gap |= (unsigned)(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) break;
+        }
+        if (pos + 8 > size) break;
+        uint64_t bits = 0;
+        for (int b = 0; b < 8; b++) bits |= (uint64_t)in[pos++] << (8 * b);
+        w += gap;
+
+        VisitMap *map = map_for(member_id, 1);
+        if (!map || map_cover(map, w) != 0) return;
+        map->words[w - map->first_word] |= bits;
+        w++;
+    }
+}
+
+static void add_visit(int member_id, int day, void *ctx) {
+    map_set(member_id, day);
+}
+
+// Bring the maps up to date: load and top up after a version bump, else
+// fold in just the check-ins committed since the last sync
+static int visits_sync() {
+    if (built_version != version) {
+        maps_reset();
+        long long stored = -1;
+        if (!db_get_handle() || db_load_visit_maps(load_map, NULL, &stored) != 0) {
+            maps_reset();
+            return 1;
+        }
+        // No saved state yet: read the whole history, archives included
+        last_attendance_id = stored < 0 ? 0 : stored;
+        if (db_for_each_visit(last_attendance_id, stored < 0, add_visit, NULL, &last_attendance_id) != 0) {
+            maps_reset();
+            return 1;
+        }
+        built_version = version;
+        stale = 0;
+    } else if (stale) {
+        if (db_for_each_visit(last_attendance_id, 0, add_visit, NULL, &last_attendance_id) != 0) return 1;
+        stale = 0;
+    }
+    return 0;
+}
+
+// ============================================
+// Public API
+// ============================================
+
+// A check-in was committed for `day`. Its row is read back too, so the
+// saved watermark keeps up with this instance's own check-ins.
+void visits_record(int member_id, int day) {
+    stale = 1;
+    if (visits_sync() == 0) map_set(member_id, day);
+}
+
+// The member was deleted: drop their map
+void visits_forget(int member_id) {
+    VisitMap *map = visits_sync() == 0 ? map_for(member_id, 0) : NULL;
+    if (!map || (map->word_count == 0 && !map->dirty)) return;
+    map->word_count = 0;
+    map->dirty = 1;
+}
+
+// Duplicate accounts were merged: keep_id gets every day drop_id attended
+void visits_merge(int keep_id, int drop_id) {
+    VisitMap *drop = visits_sync() == 0 ? map_for(drop_id, 0) : NULL;
+    if (!drop) return;
+    for (int w = 0; w < drop->word_count; w++) {
+        for (uint64_t bits = drop->words[w]; bits; bits &= bits - 1) {
+            map_set(keep_id, (drop->first_word + w) * 64 + __builtin_ctzll(bits));
+            drop = map_for(drop_id, 0);         // map_set may have moved the table
+        }
+    }
+    visits_forget(drop_id);
+}
+
+// Another instance checked members in; the next query reads the new rows
+void visits_mark_stale() {
+    stale = 1;
+}
+
+// Invalidate the maps (branch switch); the next query reloads them
+void visits_bump_version() {
+    version++;
+}
+
+// Write every map changed since the last checkpoint
+int visits_checkpoint() {
+    if (built_version != version) return 0;
+
+    int dirty = 0;
+    for (int i = 0; i < map_count; i++) dirty += maps[i].dirty;
+    if (dirty == 0) return 0;
+
+    VisitMapRow *rows = calloc(dirty, sizeof(VisitMapRow));
+    if (!rows) return 1;
+    int count = 0, failed = 0;
+    for (int i = 0; i < map_count && count < dirty; i++) {
+        if (!maps[i].dirty) continue;
+        rows[count].member_id = i;
+        rows[count].first_word = maps[i].first_word;
+        if (maps[i].word_count > 0) {
+            rows[count].bits = map_encode(&maps[i], &rows[count].size);
+            if (!rows[count].bits) failed = 1;
+        }
+        count++;
+    }
+    if (!failed) failed = db_save_visit_maps(rows, count, last_attendance_id);
+    if (!failed) {
+        for (int i = 0; i < map_count; i++) maps[i].dirty = 0;
+    }
+    for (int i = 0; i < count; i++) free((void*)rows[i].bits);
+    free(rows);
+    return failed;
+}
+
+// Days attended between two days inclusive
+int visits_count(int member_id, int from_day, int to_day) {
+    if (visits_sync() != 0) return 0;
+    VisitMap *map = map_for(member_id, 0);
+    return map ? map_count_range(map, from_day, to_day) : 0;
+}
+
+// Consecutive days attended up to today; a streak still counts before
+// today's check-in if it reached yesterday
+int visits_streak(int member_id, int today) {
+    if (visits_sync() != 0) return 0;
+    VisitMap *map = map_for(member_id, 0);
+    if (!map) return 0;
+    return map_run_ending(map, map_get(map, today) ? today : today - 1);
+}
+
+int visits_summary(int member_id, int today, VisitSummary *summary) {
+    memset(summary, 0, sizeof(*summary));
+    summary->last_day = -1;
+    if (visits_sync() != 0) return 1;
+    VisitMap *map = map_for(member_id, 0);
+    if (!map) return 0;
+
+    char date[16];
+    int month_start = today;
+    ledger_format_day(today, date, sizeof(date));
+    memcpy(date + 8, "01", 2);
+    ledger_parse_day(date, &month_start);
+
+    summary->this_month = map_count_range(map, month_start, today);
+    summary->last_30_days = map_count_range(map, today - 29, today);
+    summary->streak = map_run_ending(map, map_get(map, today) ? today : today - 1);
+    summary->last_day = map_last_day(map);
+    return 0;
+}
+
+// Members who have visited before but not in the `days` ending today
+int visits_inactive(int days, int today, int *member_ids, int max) {
+    if (visits_sync() != 0) return -1;
+    int count = 0;
+    for (int i = 0; i < map_count; i++) {
+        const VisitMap *map = &maps[i];
+        if (map->word_count == 0 || map_count_range(map, today - days + 1, today) > 0) continue;
+        if (map_last_day(map) < 0) continue;
+        if (count < max) member_ids[count] = i;
+        count++;
+    }
+    return count;
+}
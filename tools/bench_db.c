@@ -0,0 +1,403 @@
+// ============================================
+// Database Workload Benchmark
+// ============================================
+//
+// Usage: bench_db [--members N] [--dir path]
+//
+// Builds a scratch gym database (default 20000 members under build/bench)
+// and runs the app's hot paths against it: sign-up, login, check-in/out,
+// paged listings, occupancy, forecast, trainer balancing, duplicate
+// detection, renewals, the payments ledger, attendance bitmaps and
+// archiving, turnstile cards, event log replay, export and backup. Prints the time
+// of each phase. `make pgo` runs it to collect the training profile.
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "database.h"
+#include "catalog.h"
+#include "eventlog.h"
+#include "scheduler.h"
+#include "occupancy.h"
+#include "forecast.h"
+#include "balance.h"
+#include "dedup.h"
+#include "export.h"
+#include "backup.h"
+#include "ledger.h"
+#include "visits.h"
+#include "archive.h"
+#include "gate.h"
+
+#define BENCH_DEFAULT_MEMBERS 20000
+#define BENCH_DEFAULT_DIR "build/bench"
+#define BENCH_TRAINERS 40
+#define BENCH_PAGE_SIZE 25
+#define BENCH_PAYMENT_YEARS 5
+#define BENCH_REVENUE_QUERIES 100000
+#define BENCH_HISTORY_DAYS 180
+#define BENCH_ARCHIVE_HORIZON 90
+#define BENCH_SWEEPS 100
+#define BENCH_GATE_CHECKS 1000000
+
+static double now_seconds() {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static double phase_started;
+
+static void phase_begin() {
+    phase_started = now_seconds();
+}
+
+static void phase_end(const char *name, long ops) {
+    double seconds = now_seconds() - phase_started;
+    printf("  %-12s %8ld ops %9.1f ms", name, ops, seconds * 1000.0);
+    if (ops > 0 && seconds > 0) printf(" %12.0f ops/s", ops / seconds);
+    printf("\n");
+}
+
+// Random lowercase word; a few accounts get a near-copy to give dedup work
+static void random_word(char *out, int len) {
+    for (int i = 0; i < len; i++) out[i] = 'a' + rand() % 26;
+    out[len] = '\0';
+}
+
+// ============================================
+// Workload Phases
+// ============================================
+
+static int bench_signup(int members, int *first_member) {
+    static const char *first_names[] = { "john", "mary", "ahmed", "fatima", "li", "sara", "omar", "anna" };
+    const Catalog *catalog = catalog_get();
+    int created = 0;
+
+    phase_begin();
+    db_begin();
+    for (int i = 0; i < members; i++) {
+        User user = {0};
+        char surname[8], local[12];
+        random_word(surname, 6);
+        random_word(local, 8);
+        snprintf(user.name, sizeof(user.name), "%s %s", first_names[rand() % 8], surname);
+        snprintf(user.email, sizeof(user.email), "%s%d@mail.com", local, i);
+        if (i % 200 == 1) snprintf(user.email, sizeof(user.email), "%s%d@mail.co", local, i - 1);
+        snprintf(user.password, sizeof(user.password), "pw%d", i);
+        strcpy(user.role, "Member");
+        user.verified = 1;
+        if (db_create_user(&user) != 0) continue;
+        if (created == 0) *first_member = user.user_id;
+        db_create_member(user.user_id);
+
+        const Plan *plan = &catalog->plans[i % catalog->plan_count];
+        const TimeSlot *slot = catalog_find_slot(plan->time_slot);
+        if (db_update_member_plan(user.user_id, plan->plan_id, slot ? slot->label : plan->time_slot) == 0) {
+            eventlog_append(EVENT_PLAN_CHANGED, user.user_id, plan->plan_id, slot ? slot->label : plan->time_slot);
+        }
+        created++;
+        if (created % 500 == 0) {
+            db_commit();
+            db_begin();
+        }
+    }
+
+    for (int i = 0; i < BENCH_TRAINERS; i++) {
+        User user = {0};
+        snprintf(user.name, sizeof(user.name), "Trainer %d", i);
+        snprintf(user.email, sizeof(user.email), "trainer%d@gym.com", i);
+        strcpy(user.password, "pw");
+        strcpy(user.role, "Trainer");
+        user.verified = 1;
+        if (db_create_user(&user) != 0) continue;
+        db_create_trainer(user.user_id, i % 2 ? "Strength" : "Cardio");
+        db_approve_trainer(user.user_id);
+    }
+    db_commit();
+    phase_end("signup", created + BENCH_TRAINERS);
+    return created;
+}
+
+static void bench_login(int members) {
+    int lookups = members / 2;
+    phase_begin();
+    for (int i = 0; i < lookups; i++) {
+        char email[32];
+        User user;
+        snprintf(email, sizeof(email), "trainer%d@gym.com", i % BENCH_TRAINERS);
+        db_login_user(email, "pw", &user);
+    }
+    phase_end("login", lookups);
+}
+
+static void bench_attendance(int first_member, int members) {
+    long ops = 0;
+    phase_begin();
+    for (int i = 0; i < members; i++) {
+        if (db_check_in(first_member + i, occupancy_zone_name(i % OCCUPANCY_ZONE_COUNT)) == 0) ops++;
+    }
+    for (int i = 0; i < members; i += 2) {
+        char zone[32];
+        if (db_check_out(first_member + i, zone, sizeof(zone)) == 0) ops++;
+    }
+    phase_end("attendance", ops);
+}
+
+static void bench_pages() {
+    MemberDetail page[BENCH_PAGE_SIZE];
+    long rows = 0;
+    phase_begin();
+    for (int sort = LIST_SORT_NAME; sort <= LIST_SORT_JOINED; sort++) {
+        PageCursor first, last = {0};
+        int count;
+        do {
+            count = BENCH_PAGE_SIZE;
+            PageCursor anchor = last;
+            if (db_get_members_page(sort, PAGE_NEXT, &anchor, page, &count, &first, &last) != 0) break;
+            rows += count;
+        } while (count == BENCH_PAGE_SIZE);
+    }
+    phase_end("pages", rows);
+}
+
+static void bench_occupancy() {
+    OccupancySnapshot snapshot;
+    OccupancyForecast forecast;
+    phase_begin();
+    occupancy_init();
+    occupancy_snapshot(&snapshot);
+    occupancy_checkpoint();
+    forecast_load(&forecast);
+    phase_end("occupancy", snapshot.total);
+}
+
+static void bench_balance() {
+    BalanceResult result;
+    phase_begin();
+    balance_trainers(&result);
+    phase_end("balance", result.moved);
+}
+
+static void bench_dedup() {
+    static DuplicatePair pairs[MAX_DUPLICATES];
+    int count = MAX_DUPLICATES;
+    DedupStats stats;
+    phase_begin();
+    dedup_find(pairs, &count, &stats);
+    phase_end("dedup", stats.comparisons);
+}
+
+// Move every deadline into the past so the whole table renews in batches
+static void bench_renewals() {
+    sqlite3_exec(db_get_handle(), "UPDATE Members SET renews_at = renews_at - 31 * 86400;", 0, 0, 0);
+    phase_begin();
+    scheduler_init();
+    int renewed = scheduler_run_due((long long)time(NULL));
+    phase_end("renewals", renewed);
+}
+
+// Backfill years of monthly payments, then query revenue over random
+// date ranges and plans
+static void bench_ledger(int first_member, int members) {
+    const Catalog *catalog = catalog_get();
+    int today = ledger_day((long long)time(NULL));
+    int months = BENCH_PAYMENT_YEARS * 12;
+    long long now = (long long)time(NULL);
+    long payments = 0;
+
+    phase_begin();
+    db_begin();
+    for (int i = 0; i < members; i++) {
+        const Plan *plan = &catalog->plans[i % catalog->plan_count];
+        for (int m = i % 6; m < months; m += 6) {
+            long long paid_at = now - (long long)(months - m) * 30 * 86400 + (i % 30) * 86400;
+            db_insert_payment(first_member + i, plan->plan_id, plan->price_cents, ledger_day(paid_at), paid_at,
+                LEDGER_KIND_RENEWAL);
+            payments++;
+        }
+    }
+    db_commit();
+    ledger_mark_stale();
+    phase_end("payments", payments);
+
+    RevenueTotal total;
+    phase_begin();
+    ledger_revenue(0, 0, today, &total);
+    phase_end("ledger load", total.payments);
+
+    phase_begin();
+    for (int q = 0; q < BENCH_REVENUE_QUERIES; q++) {
+        int from = today - rand() % (BENCH_PAYMENT_YEARS * 365);
+        int to = from + rand() % 365;
+        int plan_id = q % (catalog->plan_count + 1) ? catalog->plans[q % (catalog->plan_count + 1) - 1].plan_id : 0;
+        ledger_revenue(plan_id, from, to, &total);
+    }
+    phase_end("revenue", BENCH_REVENUE_QUERIES);
+}
+
+// Half a year of visits (every fourth day; one member in ten stopped two
+// months ago), then build the attendance bitmaps, query every member,
+// sweep for inactive members and archive the older half
+static void bench_visits(int first_member, int members) {
+    char sql[768];
+    snprintf(sql, sizeof(sql),
+        "WITH RECURSIVE d(n) AS (SELECT 1 UNION ALL SELECT n + 1 FROM d WHERE n < %d) "
+        "INSERT INTO Attendance (member_id, date, status, zone) "
+        "SELECT m.member_id, date('now', 'localtime', '-' || d.n || ' days'), 'PRESENT', 'Gym' "
+        "FROM d, Members m WHERE (m.member_id + d.n) %% 4 = 0 AND NOT (m.member_id %% 10 = 0 AND d.n < 60) "
+        "ORDER BY d.n DESC, m.member_id;", BENCH_HISTORY_DAYS);
+    phase_begin();
+    sqlite3_exec(db_get_handle(), sql, 0, 0, 0);
+    phase_end("history", sqlite3_changes(db_get_handle()));
+
+    int today = ledger_day((long long)time(NULL));
+    VisitSummary summary;
+    phase_begin();
+    visits_summary(first_member, today, &summary);
+    phase_end("visits load", members);
+
+    phase_begin();
+    visits_checkpoint();
+    phase_end("visits save", members);
+
+    phase_begin();
+    for (int i = 0; i < members; i++) visits_summary(first_member + i, today, &summary);
+    phase_end("visits query", members);
+
+    // Every sweep tests each member's map
+    phase_begin();
+    for (int q = 0; q < BENCH_SWEEPS; q++) visits_inactive(VISITS_INACTIVE_DAYS, today, NULL, 0);
+    phase_end("inactive", (long)members * BENCH_SWEEPS);
+
+    ArchiveReport report;
+    phase_begin();
+    archive_run(db_get_path(), BENCH_ARCHIVE_HORIZON, ARCHIVE_BATCH_ROWS, &report);
+    phase_end("archive", report.rows);
+
+    // Reload from the saved maps plus the rows above the saved watermark
+    visits_bump_version();
+    phase_begin();
+    visits_summary(first_member, today, &summary);
+    phase_end("visits reload", members);
+}
+
+// A card per member, then the index build and turnstile checks cycling
+// through every card
+static void bench_gate(int first_member, int members) {
+    long long now = (long long)time(NULL);
+    char card_id[GATE_CARD_MAX + 1];
+    phase_begin();
+    db_begin();
+    for (int i = 0; i < members; i++) {
+        snprintf(card_id, sizeof(card_id), "CARD-%08d", first_member + i);
+        db_issue_card(card_id, first_member + i, now);
+    }
+    db_commit();
+    phase_end("cards", members);
+
+    gate_bump_version();
+    phase_begin();
+    gate_refresh();
+    phase_end("gate load", members);
+
+    GateDecision decision;
+    long allowed = 0;
+    phase_begin();
+    for (int i = 0; i < BENCH_GATE_CHECKS; i++) {
+        snprintf(card_id, sizeof(card_id), "CARD-%08d", first_member + i % members);
+        allowed += gate_check(card_id, now, &decision) == GATE_ALLOW;
+    }
+    phase_end("gate check", BENCH_GATE_CHECKS);
+    if (allowed == 0) fprintf(stderr, "gate: no card was allowed\n");
+}
+
+static int count_event(const Event *event, void *ctx) {
+    (*(long*)ctx)++;
+    return 0;
+}
+
+static void bench_eventlog() {
+    char path[256];
+    long events = 0;
+    snprintf(path, sizeof(path), "%.*s.events", (int)(strlen(db_get_path()) - 3), db_get_path());
+    phase_begin();
+    eventlog_flush();
+    eventlog_replay(path, count_event, &events, NULL);
+    phase_end("eventlog", events);
+}
+
+static void bench_export(ExportFormat format, const char *name) {
+    ExportProgress progress;
+    phase_begin();
+    if (export_start(format) != 0) return;
+    do {
+        usleep(1000);
+        export_get_progress(&progress);
+    } while (progress.running);
+    phase_end(name, progress.rows_done);
+}
+
+static void bench_backup() {
+    BackupReport report;
+    phase_begin();
+    backup_run(db_get_path(), "bench-backup.db", BACKUP_STEP_PAGES, &report);
+    phase_end("backup", report.pages);
+}
+
+// ============================================
+// Main
+// ============================================
+
+int main(int argc, char **argv) {
+    int members = BENCH_DEFAULT_MEMBERS;
+    const char *dir = BENCH_DEFAULT_DIR;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--members") == 0 && i + 1 < argc) {
+            members = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--dir") == 0 && i + 1 < argc) {
+            dir = argv[++i];
+        } else {
+            fprintf(stderr, "Usage: %s [--members N] [--dir path]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (members < 1) members = 1;
+
+    // Every file the workload writes stays inside the scratch directory.
+    // It must not exist yet, so nothing already there gets overwritten.
+    if (mkdir(dir, 0755) != 0 || chdir(dir) != 0 || mkdir("database", 0755) != 0) {
+        fprintf(stderr, "Cannot create %s: %s (pass a --dir that does not exist yet)\n", dir, strerror(errno));
+        return 1;
+    }
+    srand(42);
+    if (db_init() != 0) return 1;
+    scheduler_set_billing_hook(ledger_charge_renewal);
+
+    printf("Benchmark: %d members, %d trainers in %s\n", members, BENCH_TRAINERS, dir);
+    double started = now_seconds();
+    int first_member = 0;
+    members = bench_signup(members, &first_member);
+    bench_login(members);
+    bench_attendance(first_member, members);
+    bench_pages();
+    bench_occupancy();
+    bench_balance();
+    bench_dedup();
+    bench_renewals();
+    bench_ledger(first_member, members);
+    bench_visits(first_member, members);
+    bench_gate(first_member, members);
+    bench_eventlog();
+    bench_export(EXPORT_CSV, "export csv");
+    bench_export(EXPORT_COLUMNAR, "export gcol");
+    bench_backup();
+    printf("  %-12s %22.1f ms\n", "total", (now_seconds() - started) * 1000.0);
+
+    db_close();
+    return 0;
+}
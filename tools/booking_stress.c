@@ -0,0 +1,310 @@
+// ============================================
+// Class Booking Stress Test
+// ============================================
+//
+// Usage: booking_stress [--members N] [--capacity N] [--threads N]
+//                       [--busy-timeout ms] [--dir path]
+//
+// Opens one class and lets every member try to book it at once from
+// several threads, each with its own connection (the "opening time" rush),
+// then has half of the seat holders cancel and rebook while the others
+// keep booking. After each phase the seat counts are checked against the
+// Bookings rows: no class may hold more members than its capacity, and the
+// counters must match. Prints bookings per second, lock retries and
+// latency percentiles; exits non-zero if an invariant is broken.
+//
+// The default busy timeout of 0 leaves lock waits to booking.c's backoff;
+// pass --busy-timeout to compare with SQLite's own busy handler.
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sched.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/stat.h>
+#include <sqlite3.h>
+#include "database.h"
+#include "booking.h"
+
+#define STRESS_DEFAULT_MEMBERS 500
+#define STRESS_DEFAULT_CAPACITY 100
+#define STRESS_DEFAULT_THREADS 16
+#define STRESS_DEFAULT_DIR "build/stress"
+
+static double now_seconds() {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// ============================================
+// Worker Threads
+// ============================================
+
+typedef enum { PHASE_RUSH, PHASE_CHURN } Phase;
+
+typedef struct {
+    int index;
+    Phase phase;
+    const int *members;
+    int member_count;
+    int thread_count;
+    int class_id;
+    int busy_timeout_ms;
+    // Results
+    long results[BOOKING_ERROR + 1];
+    long retries;
+    long operations;
+    double *latencies;
+} Worker;
+
+static struct {
+    char db_path[256];
+    atomic_int ready;
+    atomic_int go;
+} shared;
+
+static void record(Worker *worker, BookingResult result, int retries, double started) {
+    worker->results[result]++;
+    worker->retries += retries;
+    worker->latencies[worker->operations++] = now_seconds() - started;
+}
+
+static void* worker_main(void *arg) {
+    Worker *worker = arg;
+    sqlite3 *conn;
+    if (sqlite3_open_v2(shared.db_path, &conn, SQLITE_OPEN_READWRITE, NULL) != SQLITE_OK) {
+        fprintf(stderr, "worker %d: cannot open %s\n", worker->index, shared.db_path);
+        atomic_fetch_add(&shared.ready, 1);
+        return NULL;
+    }
+    sqlite3_busy_timeout(conn, worker->busy_timeout_ms);
+
+    // Start together, like members hitting "Book" when a class opens
+    atomic_fetch_add(&shared.ready, 1);
+    while (!atomic_load(&shared.go)) sched_yield();
+
+    for (int i = worker->index; i < worker->member_count; i += worker->thread_count) {
+        int member_id = worker->members[i], position, promoted, retries = 0;
+        double started = now_seconds();
+        if (worker->phase == PHASE_RUSH) {
+            record(worker, booking_reserve(conn, worker->class_id, member_id, &position, &retries), retries, started);
+            continue;
+        }
+
+        // Churn: every other member gives up their place and books again
+        // (ending up at the back of the waitlist); the rest retry a booking
+        if ((i / worker->thread_count) % 2 == 0) {
+            BookingResult result = booking_cancel(conn, worker->class_id, member_id, &promoted, &retries);
+            if (result == BOOKING_BUSY || result == BOOKING_ERROR) {
+                record(worker, result, retries, started);
+                continue;
+            }
+            started = now_seconds();
+            retries = 0;
+        }
+        record(worker, booking_reserve(conn, worker->class_id, member_id, &position, &retries), retries, started);
+    }
+    sqlite3_close(conn);
+    return NULL;
+}
+
+static int compare_double(const void *a, const void *b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return x < y ? -1 : x > y;
+}
+
+// Run one phase across all threads and print its figures
+static void run_phase(const char *name, Phase phase, const int *members, int member_count,
+                      int thread_count, int class_id, int busy_timeout_ms) {
+    Worker *workers = calloc(thread_count, sizeof(Worker));
+    pthread_t *threads = calloc(thread_count, sizeof(pthread_t));
+    double *latencies = calloc(member_count, sizeof(double));
+    atomic_store(&shared.ready, 0);
+    atomic_store(&shared.go, 0);
+
+    int offset = 0;
+    for (int t = 0; t < thread_count; t++) {
+        Worker *worker = &workers[t];
+        worker->index = t;
+        worker->phase = phase;
+        worker->members = members;
+        worker->member_count = member_count;
+        worker->thread_count = thread_count;
+        worker->class_id = class_id;
+        worker->busy_timeout_ms = busy_timeout_ms;
+        worker->latencies = latencies + offset;
+        offset += (member_count - t + thread_count - 1) / thread_count;
+        pthread_create(&threads[t], NULL, worker_main, worker);
+    }
+    while (atomic_load(&shared.ready) < thread_count) sched_yield();
+    double started = now_seconds();
+    atomic_store(&shared.go, 1);
+    for (int t = 0; t < thread_count; t++) pthread_join(threads[t], NULL);
+    double seconds = now_seconds() - started;
+
+    long totals[BOOKING_ERROR + 1] = {0}, retries = 0, operations = 0;
+    for (int t = 0; t < thread_count; t++) {
+        for (int r = 0; r <= BOOKING_ERROR; r++) totals[r] += workers[t].results[r];
+        retries += workers[t].retries;
+    }
+    // Pack the per-thread latency runs and sort them for percentiles
+    double *packed = calloc(member_count, sizeof(double));
+    for (int t = 0; t < thread_count; t++) {
+        memcpy(packed + operations, workers[t].latencies, workers[t].operations * sizeof(double));
+        operations += workers[t].operations;
+    }
+    qsort(packed, operations, sizeof(double), compare_double);
+
+    printf("  %-6s %6ld ops %8.1f ms %10.0f bookings/s  retries %ld\n",
+        name, operations, seconds * 1000.0, seconds > 0 ? operations / seconds : 0.0, retries);
+    printf("         ");
+    for (int r = 0; r <= BOOKING_ERROR; r++) {
+        if (totals[r]) printf(" %s %ld", booking_result_name(r), totals[r]);
+    }
+    if (operations > 0) {
+        printf("\n         latency p50 %.2f ms  p99 %.2f ms  max %.2f ms",
+            packed[operations / 2] * 1000.0, packed[(operations * 99) / 100] * 1000.0,
+            packed[operations - 1] * 1000.0);
+    }
+    printf("\n");
+
+    free(packed);
+    free(latencies);
+    free(threads);
+    free(workers);
+}
+
+// ============================================
+// Invariants
+// ============================================
+
+static long query_long(const char *sql, int class_id) {
+    sqlite3_stmt *stmt;
+    long value = -1;
+    if (sqlite3_prepare_v2(db_get_handle(), sql, -1, &stmt, 0) != SQLITE_OK) return -1;
+    sqlite3_bind_int(stmt, 1, class_id);
+    if (sqlite3_step(stmt) == SQLITE_ROW) value = sqlite3_column_int64(stmt, 0);
+    sqlite3_finalize(stmt);
+    return value;
+}
+
+// Returns the number of violations found
+static int check_invariants(const char *after, int class_id, int capacity, int members) {
+    long booked_rows = query_long("SELECT COUNT(*) FROM Bookings WHERE class_id=? AND status='BOOKED';", class_id);
+    long waiting_rows = query_long("SELECT COUNT(*) FROM Bookings WHERE class_id=? AND status='WAITLISTED';", class_id);
+    long booked = query_long("SELECT booked FROM Classes WHERE class_id=?;", class_id);
+    long waitlisted = query_long("SELECT waitlisted FROM Classes WHERE class_id=?;", class_id);
+    long duplicate_seqs = query_long("SELECT COUNT(*) - COUNT(DISTINCT seq) FROM Bookings "
+        "WHERE class_id=? AND status='WAITLISTED';", class_id);
+    long expected = members < capacity ? members : capacity;
+
+    int violations = 0;
+    if (booked_rows > capacity) { printf("  VIOLATION: %ld members booked, capacity %d\n", booked_rows, capacity); violations++; }
+    if (booked != booked_rows) { printf("  VIOLATION: seat counter %ld, booked rows %ld\n", booked, booked_rows); violations++; }
+    if (waitlisted != waiting_rows) { printf("  VIOLATION: waitlist counter %ld, rows %ld\n", waitlisted, waiting_rows); violations++; }
+    if (duplicate_seqs != 0) { printf("  VIOLATION: %ld duplicate waitlist positions\n", duplicate_seqs); violations++; }
+    if (booked_rows + waiting_rows == members && booked_rows != expected) {
+        printf("  VIOLATION: %ld seats taken with %ld waiting, expected %ld\n", booked_rows, waiting_rows, expected);
+        violations++;
+    }
+    printf("  check  after %-6s booked %ld/%d, waitlisted %ld: %s\n",
+        after, booked_rows, capacity, waiting_rows, violations ? "FAILED" : "ok");
+    return violations;
+}
+
+// ============================================
+// Main
+// ============================================
+
+// Files a run leaves behind, relative to the scratch directory
+static const char *scratch_files[] = {
+    "database/gym.db", "database/gym.db-wal", "database/gym.db-shm",
+    "database/gym.events", "database/gym.events.tmp",
+};
+
+// Enter the scratch directory (created if missing) and clear the previous
+// run's files. Nothing else in it is touched, so a --dir pointing at a
+// directory with other contents is safe.
+static int prepare_dir(const char *dir) {
+    if (mkdir(dir, 0755) != 0 && errno != EEXIST) return 1;
+    if (chdir(dir) != 0) return 1;
+    if (mkdir("database", 0755) != 0 && errno != EEXIST) return 1;
+    for (size_t i = 0; i < sizeof(scratch_files) / sizeof(scratch_files[0]); i++) {
+        if (remove(scratch_files[i]) != 0 && errno != ENOENT) return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    int members = STRESS_DEFAULT_MEMBERS, capacity = STRESS_DEFAULT_CAPACITY;
+    int thread_count = STRESS_DEFAULT_THREADS, busy_timeout_ms = 0;
+    const char *dir = STRESS_DEFAULT_DIR;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--members") == 0 && i + 1 < argc) {
+            members = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--capacity") == 0 && i + 1 < argc) {
+            capacity = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            thread_count = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--busy-timeout") == 0 && i + 1 < argc) {
+            busy_timeout_ms = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--dir") == 0 && i + 1 < argc) {
+            dir = argv[++i];
+        } else {
+            fprintf(stderr, "Usage: %s [--members N] [--capacity N] [--threads N] [--busy-timeout ms] [--dir path]\n",
+                argv[0]);
+            return 1;
+        }
+    }
+    if (members < 1) members = 1;
+    if (capacity < 1) capacity = 1;
+    if (thread_count < 1) thread_count = 1;
+    if (thread_count > members) thread_count = members;
+
+    // Every file the test writes stays inside the scratch directory
+    if (prepare_dir(dir) != 0) {
+        fprintf(stderr, "Cannot prepare %s\n", dir);
+        return 1;
+    }
+    if (db_init() != 0) return 1;
+    snprintf(shared.db_path, sizeof(shared.db_path), "%s", db_get_path());
+
+    int *member_ids = calloc(members, sizeof(int));
+    db_begin();
+    for (int i = 0; i < members; i++) {
+        User user = {0};
+        snprintf(user.name, sizeof(user.name), "Member %d", i);
+        snprintf(user.email, sizeof(user.email), "member%d@stress.test", i);
+        strcpy(user.password, "pw");
+        strcpy(user.role, "Member");
+        user.verified = 1;
+        db_create_user(&user);
+        db_create_member(user.user_id);
+        member_ids[i] = user.user_id;
+    }
+    db_commit();
+
+    int class_id;
+    if (booking_create_class(db_get_handle(), "Opening Rush", 0, (long long)time(NULL) + 86400, 60,
+                             capacity, &class_id) != 0) {
+        fprintf(stderr, "Cannot create the class\n");
+        return 1;
+    }
+
+    printf("Booking stress: %d members, capacity %d, %d threads, busy timeout %d ms, in %s\n",
+        members, capacity, thread_count, busy_timeout_ms, dir);
+    int violations = 0;
+    run_phase("rush", PHASE_RUSH, member_ids, members, thread_count, class_id, busy_timeout_ms);
+    violations += check_invariants("rush", class_id, capacity, members);
+    run_phase("churn", PHASE_CHURN, member_ids, members, thread_count, class_id, busy_timeout_ms);
+    violations += check_invariants("churn", class_id, capacity, members);
+
+    free(member_ids);
+    db_close();
+    return violations ? 1 : 0;
+}
@@ -0,0 +1,174 @@
+// ============================================
+// Event Log Replay Tool
+// ============================================
+//
+// Usage: eventlog_replay [--dump | --summary | --compact] <file.events>
+//
+//   --dump     Print every event
+//   --summary  Rebuild the membership projection and print it (default)
+//   --compact  Drop superseded events (previous file kept as .old)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "eventlog.h"
+
+// Current state of one user id, rebuilt from events
+typedef struct {
+    int plan_id;
+    int trainer_id;
+    int approved;
+    int deleted;
+    int expired;
+} Projection;
+
+typedef struct {
+    Projection *rows;
+    int capacity;
+    long type_counts[EVENT_TYPE_COUNT];
+} ReplayState;
+
+static double now_seconds() {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static Projection* projection_for(ReplayState *state, int id) {
+    if (id < 0) return NULL;
+    if (id >= state->capacity) {
+        int capacity = state->capacity ? state->capacity : 1024;
+        while (capacity <= id) capacity *= 2;
+        Projection *grown = realloc(state->rows, sizeof(Projection) * capacity);
+        if (!grown) return NULL;
+        memset(grown + state->capacity, 0, sizeof(Projection) * (capacity - state->capacity));
+        state->rows = grown;
+        state->capacity = capacity;
+    }
+    return &state->rows[id];
+}
+
+// Apply one event to the projection
+static int apply_event(const Event *event, void *ctx) {
+    ReplayState *state = ctx;
+    if (event->type > 0 && event->type < EVENT_TYPE_COUNT) state->type_counts[event->type]++;
+
+    Projection *row = projection_for(state, event->subject_id);
+    if (!row) return 1;
+    switch (event->type) {
+        case EVENT_PLAN_CHANGED:
+        case EVENT_MEMBERSHIP_RENEWED:
+            row->plan_id = event->arg;
+            row->expired = 0;
+            break;
+        case EVENT_TRAINER_ASSIGNED:   row->trainer_id = event->arg; break;
+        case EVENT_TRAINER_APPROVED:   row->approved = 1; break;
+        case EVENT_MEMBERSHIP_EXPIRED: row->expired = 1; break;
+        case EVENT_MEMBER_MERGED: {
+            // The kept account takes over the duplicate's membership if it
+            // had none, as db_merge_members() does
+            Projection *keep = projection_for(state, event->arg);
+            if (!keep) return 1;
+            row = &state->rows[event->subject_id];     // projection_for() may have moved the rows
+            if (keep->plan_id == 0 && row->plan_id > 0) {
+                keep->plan_id = row->plan_id;
+                keep->trainer_id = row->trainer_id;
+                keep->expired = row->expired;
+            }
+            memset(row, 0, sizeof(*row));
+            row->deleted = 1;
+            break;
+        }
+        case EVENT_MEMBER_DELETED:
+        case EVENT_TRAINER_DELETED:
+        case EVENT_TRAINER_REJECTED:
+            memset(row, 0, sizeof(*row));
+            row->deleted = 1;
+            break;
+    }
+    return 0;
+}
+
+static int print_event(const Event *event, void *ctx) {
+    char when[32];
+    time_t t = (time_t)event->timestamp;
+    strftime(when, sizeof(when), "%Y-%m-%d %H:%M:%S", localtime(&t));
+    printf("%s %-20s subject=%d arg=%d %s\n", when, eventlog_type_name(event->type),
+        event->subject_id, event->arg, event->text);
+    return 0;
+}
+
+static void print_summary(const ReplayState *state) {
+    printf("\nEvents by type:\n");
+    for (int t = 1; t < EVENT_TYPE_COUNT; t++) {
+        printf("  %-20s %ld\n", eventlog_type_name(t), state->type_counts[t]);
+    }
+
+    int plan_counts[16] = {0};
+    int active = 0, expired = 0, deleted = 0, assigned = 0, approved = 0;
+    for (int id = 0; id < state->capacity; id++) {
+        const Projection *row = &state->rows[id];
+        if (row->deleted) { deleted++; continue; }
+        if (row->approved) approved++;
+        if (row->plan_id > 0) {
+            if (row->expired) expired++; else active++;
+            if (row->plan_id < 16) plan_counts[row->plan_id]++;
+        }
+        if (row->trainer_id > 0) assigned++;
+    }
+
+    printf("\nProjection:\n");
+    printf("  Active memberships   %d\n", active);
+    printf("  Expired memberships  %d\n", expired);
+    printf("  With trainer         %d\n", assigned);
+    printf("  Approved trainers    %d\n", approved);
+    printf("  Deleted users        %d\n", deleted);
+    for (int p = 1; p < 16; p++) {
+        if (plan_counts[p]) printf("  Plan %-2d members      %d\n", p, plan_counts[p]);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    const char *mode = "--summary";
+    const char *path = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--", 2) == 0) mode = argv[i]; else path = argv[i];
+    }
+    if (!path) {
+        fprintf(stderr, "Usage: %s [--dump | --summary | --compact] <file.events>\n", argv[0]);
+        return 1;
+    }
+
+    if (strcmp(mode, "--compact") == 0) {
+        long kept, dropped;
+        double start = now_seconds();
+        if (eventlog_compact(path, &kept, &dropped) != 0) {
+            fprintf(stderr, "Compaction failed.\n");
+            return 1;
+        }
+        printf("Kept %ld events, dropped %ld (%.3f s).\n", kept, dropped, now_seconds() - start);
+        return 0;
+    }
+
+    ReplayState state;
+    memset(&state, 0, sizeof(state));
+    int dump = strcmp(mode, "--dump") == 0;
+
+    long valid_bytes;
+    double start = now_seconds();
+    int count = eventlog_replay(path, dump ? print_event : apply_event, &state, &valid_bytes);
+    double elapsed = now_seconds() - start;
+    if (count < 0) {
+        fprintf(stderr, "Can't read %s\n", path);
+        return 1;
+    }
+
+    if (!dump) print_summary(&state);
+    printf("\nReplayed %d events (%ld bytes) in %.3f s", count, valid_bytes, elapsed);
+    if (elapsed > 0) printf(" - %.0f events/s, %.1f MB/s", count / elapsed, valid_bytes / elapsed / 1e6);
+    printf("\n");
+
+    free(state.rows);
+    return 0;
+}
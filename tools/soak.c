@@ -0,0 +1,565 @@
+// ============================================
+// Front-Desk Soak Test
+// ============================================
+//
+// Usage: soak [--terminals N] [--seconds N] [--members N]
+//             [--busy-timeout ms] [--seed N] [--dir path]
+//
+// Simulates N front-desk terminals sharing one gym.db for a fixed time.
+// Each terminal runs a mixed workload through the app's own database.c
+// calls: member logins, registrations (with the verification mail queued),
+// plan changes charged to the payments ledger, check-ins/outs and trainer
+// approvals, and polls for other terminals' changes like the app does.
+//
+// database.c keeps one connection per process, used by the UI thread only
+// (background threads open their own), and the caches around it are
+// per-process too. Terminals are therefore separate processes, as they are
+// at a real front desk, each with its own connection; counters come back
+// through shared memory.
+//
+// While they run, the parent checks invariants that must hold in every
+// committed snapshot (one check-in per member per day, a payment behind
+// every plan, ...). After they stop it reconciles the terminals' counts with
+// the rows in the database and runs an integrity check. Prints throughput,
+// latency percentiles and SQLITE_BUSY figures per operation; exits
+// non-zero if an invariant is broken.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sqlite3.h>
+#include "database.h"
+#include "catalog.h"
+#include "ledger.h"
+#include "verify.h"
+#include "changes.h"
+#include "config.h"
+#include "eventlog.h"
+
+#define SOAK_DEFAULT_TERMINALS 8
+#define SOAK_DEFAULT_SECONDS 30
+#define SOAK_DEFAULT_MEMBERS 2000
+#define SOAK_DEFAULT_DIR "build/soak"
+#define SOAK_PASSWORD "soak-pw"
+#define SOAK_CHECK_MS 1000
+#define SOAK_MAX_PENDING 32
+#define SOAK_LATENCY_BUCKETS 128        // Quarter powers of two of a microsecond
+
+#ifdef _WIN32
+
+int main(void) {
+    fprintf(stderr, "soak needs fork() and shared memory; run it on Linux or macOS\n");
+    return 1;
+}
+
+#else
+
+#include <errno.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+static double now_seconds() {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void sleep_ms(int ms) {
+    struct timespec ts = { ms / 1000, (ms % 1000) * 1000000L };
+    nanosleep(&ts, NULL);
+}
+
+// ============================================
+// Shared Counters
+// ============================================
+
+typedef enum { OP_LOGIN, OP_REGISTER, OP_PLAN, OP_CHECKIN, OP_APPROVE, OP_COUNT } Operation;
+
+static const char *op_names[OP_COUNT] = { "login", "register", "plan", "checkin", "approve" };
+static const int op_weights[OP_COUNT] = { 35, 10, 15, 35, 5 };
+
+typedef struct {
+    long ok[OP_COUNT];
+    long busy[OP_COUNT];                // Failed because a lock was not granted in time
+    long failed[OP_COUNT];              // Failed for any other reason
+    long latency[OP_COUNT][SOAK_LATENCY_BUCKETS];
+    double max_latency[OP_COUNT];
+    long lock_waits;                    // Busy-handler calls
+    // Rows this terminal created, for the final reconciliation
+    long users, trainers, signups, checkins;
+    int started;
+} TerminalStats;
+
+static TerminalStats *stats;            // One per terminal, in shared memory
+static volatile sig_atomic_t stopping = 0;
+
+// Four buckets per power of two: the top bit of the microseconds picks the
+// octave, the two bits below it the quarter
+static int latency_bucket(double seconds) {
+    unsigned long long us = (unsigned long long)(seconds * 1e6);
+    if (us < 1) return 0;
+    int octave = 63 - __builtin_clzll(us);
+    int quarter = octave >= 2 ? (int)(us >> (octave - 2)) & 3 : (int)(us << (2 - octave)) & 3;
+    int bucket = octave * 4 + quarter;
+    return bucket < SOAK_LATENCY_BUCKETS ? bucket : SOAK_LATENCY_BUCKETS - 1;
+}
+
+// Upper bound of a bucket in milliseconds
+static double bucket_ms(int bucket) {
+    return (double)(1ULL << (bucket / 4)) * (5 + bucket % 4) / 4.0 / 1000.0;
+}
+
+// ============================================
+// Terminal Processes
+// ============================================
+
+typedef struct {
+    int index;
+    int members;                        // Seeded members are user ids first_member..
+    int first_member;
+    int busy_timeout_ms;
+    unsigned seed;
+    long registered;
+    double busy_since;                  // Start of the current lock wait
+    int gave_up;                        // The busy handler gave up during this operation
+} Terminal;
+
+// SQLite's default busy delays, counting every wait
+static int on_busy(void *ctx, int count) {
+    static const int delays[] = { 1, 2, 5, 10, 15, 20, 25, 25, 25, 50, 50, 100 };
+    Terminal *terminal = ctx;
+    stats[terminal->index].lock_waits++;
+    double now = now_seconds();
+    if (count == 0) terminal->busy_since = now;
+    if ((now - terminal->busy_since) * 1000.0 >= terminal->busy_timeout_ms) {
+        terminal->gave_up = 1;
+        return 0;
+    }
+    int n = (int)(sizeof(delays) / sizeof(delays[0]));
+    sleep_ms(delays[count < n ? count : n - 1]);
+    return 1;
+}
+
+static int random_member(Terminal *terminal) {
+    return terminal->first_member + rand_r(&terminal->seed) % terminal->members;
+}
+
+static int run_login(Terminal *terminal) {
+    char email[100];
+    int n = random_member(terminal) - terminal->first_member;
+    snprintf(email, sizeof(email), "member%d@soak.test", n);
+
+    // The rate limiter is left out: it would throttle a terminal running
+    // this much faster than a person at the desk
+    User user;
+    if (db_login_user(email, SOAK_PASSWORD, &user) != 0) return 1;
+    Member member;
+    return db_get_member(user.user_id, &member);
+}
+
+static int run_register(Terminal *terminal) {
+    User user = {0};
+    int trainer = rand_r(&terminal->seed) % 5 == 0;
+    snprintf(user.name, sizeof(user.name), "Soak %d-%ld", terminal->index, terminal->registered);
+    snprintf(user.email, sizeof(user.email), "t%d-%ld@soak.test", terminal->index, terminal->registered);
+    strcpy(user.password, SOAK_PASSWORD);
+    strcpy(user.role, trainer ? "Trainer" : "Member");
+    terminal->registered++;
+
+    // Same transaction as the registration form
+    if (db_begin() != 0) return 1;
+    if (db_create_user(&user) != 0 ||
+        (trainer ? db_create_trainer(user.user_id, "General Fitness") : db_create_member(user.user_id)) != 0 ||
+        db_commit() != 0) {
+        db_rollback();
+        return 1;
+    }
+    stats[terminal->index].users++;
+    if (trainer) stats[terminal->index].trainers++;
+    return verify_issue(user.email, user.name) == 0 ? 0 : 1;
+}
+
+// Same steps as choosing a plan on the member dashboard
+static int run_plan(Terminal *terminal) {
+    const Catalog *catalog = catalog_get();
+    const Plan *plan = &catalog->plans[rand_r(&terminal->seed) % catalog->plan_count];
+    const TimeSlot *slot = &catalog->slots[rand_r(&terminal->seed) % catalog->slot_count];
+    int member_id = random_member(terminal);
+
+    if (db_begin() != 0) return 1;
+    if (db_update_member_plan(member_id, plan->plan_id, slot->label) != 0 ||
+        ledger_charge(member_id, plan->plan_id, LEDGER_KIND_SIGNUP, (long long)time(NULL)) != 0) {
+        db_rollback();
+        return 1;
+    }
+    if (db_commit() != 0) {
+        db_rollback();
+        return 1;
+    }
+    ledger_mark_stale();
+    eventlog_append(EVENT_PLAN_CHANGED, member_id, plan->plan_id, slot->label);
+    stats[terminal->index].signups++;
+    return 0;
+}
+
+// Check a member in, or out if they are in the building
+static int run_checkin(Terminal *terminal) {
+    int member_id = random_member(terminal);
+    if (db_is_in_building(member_id)) {
+        char zone[32];
+        return db_check_out(member_id, zone, sizeof(zone)) == 1;
+    }
+    int rc = db_check_in(member_id, "Gym");
+    if (rc == 0) stats[terminal->index].checkins++;
+    return rc == 1;
+}
+
+static int run_approve(Terminal *terminal) {
+    TrainerDetail pending[SOAK_MAX_PENDING];
+    int count = SOAK_MAX_PENDING;
+    if (db_get_pending_trainers(pending, &count) != 0) return 1;
+    if (count == 0) return 0;
+    return db_approve_trainer(pending[rand_r(&terminal->seed) % count].trainer_id) == SQLITE_OK ? 0 : 1;
+}
+
+static Operation pick_operation(Terminal *terminal) {
+    int total = 0;
+    for (int op = 0; op < OP_COUNT; op++) total += op_weights[op];
+    int r = rand_r(&terminal->seed) % total;
+    int op = 0;
+    while (r >= op_weights[op]) r -= op_weights[op++];
+    return (Operation)op;
+}
+
+static void on_stop(int sig) {
+    stopping = 1;
+}
+
+static int terminal_main(Terminal *terminal) {
+    signal(SIGTERM, on_stop);
+    if (db_init() != 0) return 1;
+    sqlite3_busy_handler(db_get_handle(), on_busy, terminal);
+    TerminalStats *mine = &stats[terminal->index];
+    mine->started = 1;
+
+    double next_poll = 0;
+    while (!stopping) {
+        double started = now_seconds();
+        if (started >= next_poll) {
+            changes_poll();
+            next_poll = started + CHANGES_POLL_MS / 1000.0;
+        }
+
+        Operation op = pick_operation(terminal);
+        terminal->gave_up = 0;
+        int rc = 1;
+        switch (op) {
+            case OP_LOGIN: rc = run_login(terminal); break;
+            case OP_REGISTER: rc = run_register(terminal); break;
+            case OP_PLAN: rc = run_plan(terminal); break;
+            case OP_CHECKIN: rc = run_checkin(terminal); break;
+            case OP_APPROVE: rc = run_approve(terminal); break;
+            default: break;
+        }
+        double seconds = now_seconds() - started;
+
+        int code = sqlite3_errcode(db_get_handle()) & 0xff;
+        if (rc == 0) {
+            mine->ok[op]++;
+        } else if (terminal->gave_up || code == SQLITE_BUSY || code == SQLITE_LOCKED) {
+            mine->busy[op]++;
+        } else {
+            mine->failed[op]++;
+        }
+        mine->latency[op][latency_bucket(seconds)]++;
+        if (seconds > mine->max_latency[op]) mine->max_latency[op] = seconds;
+    }
+    db_close();
+    return 0;
+}
+
+// ============================================
+// Invariants
+// ============================================
+
+typedef struct {
+    const char *what;
+    const char *sql;                    // Returns the number of offending rows
+} Invariant;
+
+// Must hold in every committed snapshot, even mid-run
+static const Invariant snapshot_invariants[] = {
+    { "members checked in twice on one day",
+      "SELECT COUNT(*) FROM (SELECT 1 FROM Attendance GROUP BY member_id, date HAVING COUNT(*) > 1);" },
+    { "check-outs before the check-in",
+      "SELECT COUNT(*) FROM Attendance WHERE checked_out_at < checked_in_at;" },
+    { "active plans with no payment",
+      "SELECT COUNT(*) FROM Members m WHERE m.status='ACTIVE' AND m.plan_id > 0 "
+      "AND NOT EXISTS (SELECT 1 FROM Payments p WHERE p.member_id = m.member_id);" },
+    { "members without an account",
+      "SELECT COUNT(*) FROM Members m WHERE NOT EXISTS (SELECT 1 FROM Users u WHERE u.user_id = m.member_id);" },
+    { "accounts without a member or trainer record",
+      "SELECT COUNT(*) FROM Users u WHERE u.role='Member' AND NOT EXISTS (SELECT 1 FROM Members m WHERE m.member_id = u.user_id) "
+      "OR u.role='Trainer' AND NOT EXISTS (SELECT 1 FROM Trainers t WHERE t.trainer_id = u.user_id);" },
+    { "trainers without an account",
+      "SELECT COUNT(*) FROM Trainers t WHERE NOT EXISTS (SELECT 1 FROM Users u WHERE u.user_id = t.trainer_id);" },
+    { "payments for unknown members",
+      "SELECT COUNT(*) FROM Payments p WHERE NOT EXISTS (SELECT 1 FROM Members m WHERE m.member_id = p.member_id);" },
+};
+
+static long query_long(sqlite3 *conn, const char *sql) {
+    sqlite3_stmt *stmt;
+    long value = -1;
+    if (sqlite3_prepare_v2(conn, sql, -1, &stmt, 0) != SQLITE_OK) return -1;
+    if (sqlite3_step(stmt) == SQLITE_ROW) value = sqlite3_column_int64(stmt, 0);
+    sqlite3_finalize(stmt);
+    return value;
+}
+
+// Check every snapshot invariant in one read transaction. Returns the
+// number broken; each is reported once.
+static int check_snapshot(sqlite3 *conn, double elapsed, int *reported) {
+    int violations = 0;
+    sqlite3_exec(conn, "BEGIN;", 0, 0, 0);
+    for (int i = 0; i < (int)(sizeof(snapshot_invariants) / sizeof(snapshot_invariants[0])); i++) {
+        long bad = query_long(conn, snapshot_invariants[i].sql);
+        if (bad == 0) continue;
+        violations++;
+        if (!reported[i]) {
+            printf("  VIOLATION at %.1f s: %ld %s\n", elapsed, bad, snapshot_invariants[i].what);
+            reported[i] = 1;
+        }
+    }
+    sqlite3_exec(conn, "COMMIT;", 0, 0, 0);
+    return violations;
+}
+
+static int expect(const char *what, long expected, long actual) {
+    if (expected == actual) return 0;
+    printf("  VIOLATION: %s: terminals reported %ld, database has %ld\n", what, expected, actual);
+    return 1;
+}
+
+// After the terminals stopped: their counts must match the rows written
+static int reconcile(sqlite3 *conn, const TerminalStats *totals, long seeded_users) {
+    int violations = 0;
+    violations += expect("accounts registered", totals->users,
+        query_long(conn, "SELECT COUNT(*) FROM Users WHERE email LIKE 't%@soak.test';"));
+    violations += expect("trainer applications", totals->trainers,
+        query_long(conn, "SELECT COUNT(*) FROM Trainers;"));
+    violations += expect("plan sign-ups charged", totals->signups,
+        query_long(conn, "SELECT COUNT(*) FROM Payments WHERE kind='" LEDGER_KIND_SIGNUP "';"));
+    violations += expect("check-ins", totals->checkins, query_long(conn, "SELECT COUNT(*) FROM Attendance;"));
+    violations += expect("member accounts with a Members row", totals->users - totals->trainers + seeded_users,
+        query_long(conn, "SELECT COUNT(*) FROM Users u JOIN Members m ON m.member_id = u.user_id "
+                         "WHERE u.role='Member';"));
+
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(conn, "PRAGMA integrity_check;", -1, &stmt, 0) == SQLITE_OK) {
+        if (sqlite3_step(stmt) != SQLITE_ROW || strcmp((const char*)sqlite3_column_text(stmt, 0), "ok") != 0) {
+            printf("  VIOLATION: integrity check failed\n");
+            violations++;
+        }
+        sqlite3_finalize(stmt);
+    }
+    return violations;
+}
+
+// ============================================
+// Report
+// ============================================
+
+static double percentile_ms(const long *buckets, long count, double fraction) {
+    long rank = (long)(count * fraction), seen = 0;
+    if (rank < count * fraction) rank++;
+    for (int b = 0; b < SOAK_LATENCY_BUCKETS; b++) {
+        seen += buckets[b];
+        if (seen >= rank && rank > 0) return bucket_ms(b);
+    }
+    return 0.0;
+}
+
+static void print_report(const TerminalStats *totals, double seconds) {
+    printf("  %-9s %9s %7s %7s %10s %8s %8s %9s %8s\n",
+        "op", "ok", "busy", "failed", "ops/s", "p50 ms", "p99 ms", "p99.9 ms", "max ms");
+    long all_ops = 0, all_busy = 0, all_failed = 0;
+    for (int op = 0; op < OP_COUNT; op++) {
+        long count = totals->ok[op] + totals->busy[op] + totals->failed[op];
+        all_ops += count;
+        all_busy += totals->busy[op];
+        all_failed += totals->failed[op];
+        printf("  %-9s %9ld %7ld %7ld %10.0f %8.2f %8.2f %9.2f %8.2f\n", op_names[op],
+            totals->ok[op], totals->busy[op], totals->failed[op], seconds > 0 ? count / seconds : 0.0,
+            percentile_ms(totals->latency[op], count, 0.50), percentile_ms(totals->latency[op], count, 0.99),
+            percentile_ms(totals->latency[op], count, 0.999), totals->max_latency[op] * 1000.0);
+    }
+    printf("  %-9s %9ld %7ld %7ld %10.0f\n", "total", all_ops - all_busy - all_failed, all_busy, all_failed,
+        seconds > 0 ? all_ops / seconds : 0.0);
+    printf("  SQLITE_BUSY: %ld lock waits (%.1f per 1000 ops), %ld operations gave up (%.3f%%)\n",
+        totals->lock_waits, all_ops ? totals->lock_waits * 1000.0 / all_ops : 0.0,
+        all_busy, all_ops ? all_busy * 100.0 / all_ops : 0.0);
+}
+
+// ============================================
+// Main
+// ============================================
+
+// Files a run leaves behind, relative to the scratch directory
+static const char *scratch_files[] = {
+    "database/gym.db", "database/gym.db-wal", "database/gym.db-shm",
+    "database/gym.events", "database/gym.events.tmp", "database/outbox.mbox",
+};
+
+// Enter the scratch directory (created if missing) and clear the previous
+// run's files; anything else in it is left alone
+static int prepare_dir(const char *dir) {
+    if (mkdir(dir, 0755) != 0 && errno != EEXIST) return 1;
+    if (chdir(dir) != 0) return 1;
+    if (mkdir("database", 0755) != 0 && errno != EEXIST) return 1;
+    for (size_t i = 0; i < sizeof(scratch_files) / sizeof(scratch_files[0]); i++) {
+        if (remove(scratch_files[i]) != 0 && errno != ENOENT) return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    int terminals = SOAK_DEFAULT_TERMINALS, seconds = SOAK_DEFAULT_SECONDS, members = SOAK_DEFAULT_MEMBERS;
+    int busy_timeout_ms = -1;
+    unsigned seed = (unsigned)time(NULL);
+    const char *dir = SOAK_DEFAULT_DIR;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--terminals") == 0 && i + 1 < argc) {
+            terminals = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+            seconds = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--members") == 0 && i + 1 < argc) {
+            members = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--busy-timeout") == 0 && i + 1 < argc) {
+            busy_timeout_ms = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = (unsigned)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--dir") == 0 && i + 1 < argc) {
+            dir = argv[++i];
+        } else {
+            fprintf(stderr, "Usage: %s [--terminals N] [--seconds N] [--members N] [--busy-timeout ms] "
+                "[--seed N] [--dir path]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (terminals < 1) terminals = 1;
+    if (seconds < 1) seconds = 1;
+    if (members < 1) members = 1;
+
+    // Every file the test writes stays inside the scratch directory
+    if (prepare_dir(dir) != 0) {
+        fprintf(stderr, "Cannot prepare %s\n", dir);
+        return 1;
+    }
+    if (db_init() != 0) return 1;
+    if (busy_timeout_ms < 0) busy_timeout_ms = config_get()->busy_timeout_ms;
+
+    // Seeded members (with no plan yet) that the terminals log in and check in
+    int first_member = 0;
+    db_begin();
+    for (int i = 0; i < members; i++) {
+        User user = {0};
+        snprintf(user.name, sizeof(user.name), "Member %d", i);
+        snprintf(user.email, sizeof(user.email), "member%d@soak.test", i);
+        strcpy(user.password, SOAK_PASSWORD);
+        strcpy(user.role, "Member");
+        user.verified = 1;
+        db_create_user(&user);
+        db_create_member(user.user_id);
+        if (i == 0) first_member = user.user_id;
+    }
+    db_commit();
+    char db_path[256];
+    snprintf(db_path, sizeof(db_path), "%s", db_get_path());
+    long seeded_users = members;
+    db_close();                         // Connections must not cross fork()
+
+    stats = mmap(NULL, sizeof(TerminalStats) * terminals, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (stats == MAP_FAILED) {
+        fprintf(stderr, "Cannot map shared counters\n");
+        return 1;
+    }
+    memset(stats, 0, sizeof(TerminalStats) * terminals);
+
+    printf("Soak: %d terminals, %d s, %d members, busy timeout %d ms, seed %u, in %s\n",
+        terminals, seconds, members, busy_timeout_ms, seed, dir);
+    fflush(stdout);
+
+    pid_t *pids = calloc(terminals, sizeof(pid_t));
+    for (int t = 0; t < terminals; t++) {
+        pids[t] = fork();
+        if (pids[t] == 0) {
+            Terminal terminal = { t, members, first_member, busy_timeout_ms, seed + 7919u * (unsigned)t, 0, 0, 0 };
+            _exit(terminal_main(&terminal));
+        }
+        if (pids[t] < 0) {
+            fprintf(stderr, "Cannot start terminal %d\n", t);
+            terminals = t;
+            break;
+        }
+    }
+
+    // Watch committed snapshots while the terminals run
+    sqlite3 *conn;
+    if (sqlite3_open_v2(db_path, &conn, SQLITE_OPEN_READONLY, NULL) != SQLITE_OK) {
+        fprintf(stderr, "Cannot open %s\n", db_path);
+        return 1;
+    }
+    sqlite3_busy_timeout(conn, busy_timeout_ms);
+    int reported[sizeof(snapshot_invariants) / sizeof(snapshot_invariants[0])] = {0};
+    int violations = 0, snapshots = 0;
+    double started = now_seconds();
+    while (now_seconds() - started < seconds) {
+        sleep_ms(SOAK_CHECK_MS);
+        violations += check_snapshot(conn, now_seconds() - started, reported) > 0;
+        snapshots++;
+    }
+    for (int t = 0; t < terminals; t++) kill(pids[t], SIGTERM);
+    int crashed = 0;
+    for (int t = 0; t < terminals; t++) {
+        int status;
+        waitpid(pids[t], &status, 0);
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0 || !stats[t].started) {
+            printf("  terminal %d did not finish cleanly\n", t);
+            crashed++;
+        }
+    }
+    double elapsed = now_seconds() - started;
+
+    TerminalStats totals = {0};
+    for (int t = 0; t < terminals; t++) {
+        for (int op = 0; op < OP_COUNT; op++) {
+            totals.ok[op] += stats[t].ok[op];
+            totals.busy[op] += stats[t].busy[op];
+            totals.failed[op] += stats[t].failed[op];
+            for (int b = 0; b < SOAK_LATENCY_BUCKETS; b++) totals.latency[op][b] += stats[t].latency[op][b];
+            if (stats[t].max_latency[op] > totals.max_latency[op]) totals.max_latency[op] = stats[t].max_latency[op];
+        }
+        totals.lock_waits += stats[t].lock_waits;
+        totals.users += stats[t].users;
+        totals.trainers += stats[t].trainers;
+        totals.signups += stats[t].signups;
+        totals.checkins += stats[t].checkins;
+    }
+    print_report(&totals, elapsed);
+
+    violations += check_snapshot(conn, elapsed, reported) > 0;
+    int mismatches = reconcile(conn, &totals, seeded_users);
+    printf("  check  %d snapshots with violations out of %d, %d final mismatches: %s\n",
+        violations, snapshots + 1, mismatches, violations || mismatches || crashed ? "FAILED" : "ok");
+
+    sqlite3_close(conn);
+    munmap(stats, sizeof(TerminalStats) * terminals);
+    free(pids);
+    return violations || mismatches || crashed ? 1 : 0;
+}
+
+#endif